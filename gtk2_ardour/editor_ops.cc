@@ -5647,7 +5647,8 @@ Editor::reset_point_selection ()
 {
 	for (PointSelection::iterator i = selection->points.begin(); i != selection->points.end(); ++i) {
 		ARDOUR::AutomationList::iterator j = (*i)->model ();
-		(*j)->value = (*i)->line().the_list()->descriptor ().normal;
+		std::shared_ptr<ARDOUR::AutomationList> alist = (*i)->line().the_list();
+		alist->modify (j, (*j)->when, alist->descriptor ().normal);
 	}
 }
 
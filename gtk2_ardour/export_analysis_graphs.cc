@@ -148,7 +148,7 @@ ArdourGraphs::draw_waveform (Glib::RefPtr<Pango::Context> pctx, ExportAnalysisPt
 	}
 	cr->stroke ();
 
-	// >= -1dBTP (coeff >= .89125, libs/vamp-plugins/TruePeak.cpp)
+	// >= -1dBTP (coeff >= .89125, libs/audiographer/src/general/analyser.cc)
 	cr->set_source_rgba (1.0, 0.7, 0, 0.7);
 	for (std::set<samplepos_t>::const_iterator i = p->truepeakpos[c].begin (); i != p->truepeakpos[c].end (); ++i) {
 		cr->move_to (m_l + (*i) - .5, clip_top);
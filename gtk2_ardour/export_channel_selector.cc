@@ -24,6 +24,7 @@
  */
 
 #include <algorithm>
+#include <set>
 #include <sstream>
 
 #include <gtkmm/menu.h>
@@ -40,6 +41,8 @@
 #include "ardour/session.h"
 #include "ardour/selection.h"
 
+#include "widgets/tooltips.h"
+
 #include "export_channel_selector.h"
 #include "route_sorter.h"
 
@@ -569,7 +572,11 @@ RegionExportChannelSelector::handle_selection ()
 
 TrackExportChannelSelector::TrackExportChannelSelector (ARDOUR::Session * session, ProfileManagerPtr manager)
   : ExportChannelSelector(session, manager)
-  , track_output_button(_("Apply track/bus processing"))
+  , tap_label (_("Export:"))
+  , tap_playback_button (_("Playback"))
+  , tap_prefader_button (_("Pre-Fader"))
+  , tap_postfader_button (_("Post-Fader"))
+  , track_output_button (_("Output"))
 	, _syncing_with_manager (false)
 {
 	pack_start(main_layout);
@@ -599,10 +606,20 @@ TrackExportChannelSelector::TrackExportChannelSelector (ARDOUR::Session * sessio
 		select_menu.AddMenuElem (*exclude_muted);
 	}
 
-	// Options
+	// Options, any number of points per track/bus can be exported in a single pass
+	ArdourWidgets::set_tooltip (tap_playback_button, _("Track/bus playback without any processing"));
+	ArdourWidgets::set_tooltip (tap_prefader_button, _("Track/bus signal just before the fader"));
+	ArdourWidgets::set_tooltip (tap_postfader_button, _("Track/bus signal after all processing, before panning"));
+	ArdourWidgets::set_tooltip (track_output_button, _("Track/bus output, with all processing and panning"));
+	tap_playback_button.set_active (true);
+
 	options_box.set_spacing (8);
+	options_box.pack_start (tap_label, false, false);
+	options_box.pack_start (tap_playback_button, false, false);
+	options_box.pack_start (tap_prefader_button, false, false);
+	options_box.pack_start (tap_postfader_button, false, false);
 	options_box.pack_start (track_output_button, false, false);
-	options_box.pack_start (select_menu, false, false);
+	options_box.pack_end (select_menu, false, false);
 	main_layout.pack_start (options_box, false, false);
 
 	// Track scroller
@@ -634,6 +651,9 @@ TrackExportChannelSelector::TrackExportChannelSelector (ARDOUR::Session * sessio
 	column->pack_start (*text_renderer, false);
 	column->add_attribute (text_renderer->property_text(), track_cols.label);
 
+	tap_playback_button.signal_clicked().connect (sigc::mem_fun (*this, &TrackExportChannelSelector::track_outputs_selected));
+	tap_prefader_button.signal_clicked().connect (sigc::mem_fun (*this, &TrackExportChannelSelector::track_outputs_selected));
+	tap_postfader_button.signal_clicked().connect (sigc::mem_fun (*this, &TrackExportChannelSelector::track_outputs_selected));
 	track_output_button.signal_clicked().connect (sigc::mem_fun (*this, &TrackExportChannelSelector::track_outputs_selected));
 
 	fill_list ();
@@ -672,14 +692,25 @@ TrackExportChannelSelector::sync_with_manager_state ()
 
 	PBD::Unwinder<bool> uw (_syncing_with_manager, true);
 
-	auto channel_list = statelist.front()->config->get_channels();
-	if (!channel_list.empty ()) {
-		if (std::dynamic_pointer_cast <RouteExportChannel> (channel_list.front ())) {
-			track_output_button.set_active (false);
+	bool output = false;
+	std::set<ExportTapPoint> taps;
+	for (auto const& state : statelist) {
+		auto const& channel_list = state->config->get_channels();
+		if (channel_list.empty ()) {
+			continue;
+		}
+		if (auto rec = std::dynamic_pointer_cast <RouteExportChannel> (channel_list.front ())) {
+			taps.insert (rec->tap_point ());
 		} else {
-			track_output_button.set_active (true);
+			output = true;
 		}
 	}
+	if (output || !taps.empty ()) {
+		tap_playback_button.set_active (taps.find (ExportTapPlayback) != taps.end ());
+		tap_prefader_button.set_active (taps.find (ExportTapPreFader) != taps.end ());
+		tap_postfader_button.set_active (taps.find (ExportTapPostFader) != taps.end ());
+		track_output_button.set_active (output);
+	}
 
 	if (selected > 0) {
 		/* Use Editor Selection */
@@ -873,11 +904,38 @@ TrackExportChannelSelector::add_track (std::shared_ptr<Route> route, bool select
 	row[track_cols.order_key] = route->presentation_info().order();
 }
 
+static std::string
+tap_point_suffix (ExportTapPoint tap)
+{
+	switch (tap) {
+		case ExportTapPreFader:
+			return X_("prefader");
+		case ExportTapPostFader:
+			return X_("postfader");
+		default:
+			return X_("playback");
+	}
+}
+
 void
 TrackExportChannelSelector::update_config()
 {
 	manager->clear_channel_configs();
 
+	/* all points of all selected tracks/busses are exported
+	 * in a single pass, each to its own file */
+	std::vector<ExportTapPoint> taps;
+	if (tap_playback_button.get_active ()) {
+		taps.push_back (ExportTapPlayback);
+	}
+	if (tap_prefader_button.get_active ()) {
+		taps.push_back (ExportTapPreFader);
+	}
+	if (tap_postfader_button.get_active ()) {
+		taps.push_back (ExportTapPostFader);
+	}
+	bool const multi_tap = taps.size () + (track_output_button.get_active () ? 1 : 0) > 1;
+
 	for (Gtk::ListStore::Children::iterator it = track_list->children().begin(); it != track_list->children().end(); ++it) {
 		Gtk::TreeModel::Row row = *it;
 
@@ -889,6 +947,13 @@ TrackExportChannelSelector::update_config()
 
 		std::shared_ptr<Route> route = row[track_cols.route];
 
+		std::string name;
+		if (_session->config.get_track_name_number() && route->track_number() > 0) {
+			name = string_compose ("%1-%2", route->track_number(), route->name());
+		} else {
+			name = route->name();
+		}
+
 		if (track_output_button.get_active()) {
 			uint32_t n_audio = route->n_outputs().n_audio();
 			uint32_t n_midi = route->n_outputs().n_midi();
@@ -920,24 +985,21 @@ TrackExportChannelSelector::update_config()
 					state->config->register_channel (channel);
 				}
 			}
-		} else {
+			if (state) {
+				state->config->set_name (multi_tap ? string_compose ("%1-%2", name, X_("output")) : name);
+			}
+		}
+
+		for (std::vector<ExportTapPoint>::const_iterator t = taps.begin (); t != taps.end (); ++t) {
 			std::list<ExportChannelPtr> list;
-			RouteExportChannel::create_from_route (list, route);
+			RouteExportChannel::create_from_route (list, route, *t);
 			if (list.size () == 0) {
 				continue;
 			}
 			state = manager->add_channel_config();
 			state->config->register_channels (list);
+			state->config->set_name (multi_tap ? string_compose ("%1-%2", name, tap_point_suffix (*t)) : name);
 		}
-
-		if (state) {
-			if (_session->config.get_track_name_number() && route->track_number() > 0) {
-				state->config->set_name (string_compose ("%1-%2", route->track_number(), route->name()));
-			} else {
-				state->config->set_name (route->name());
-			}
-		}
-
 	}
 
 	CriticalSelectionChanged ();
@@ -255,7 +255,10 @@ class TrackExportChannelSelector : public ExportChannelSelector
 
 	void sync_with_manager ();
 
-	bool track_output () const { return track_output_button.get_active(); }
+	/* true if only track/bus outputs (ports) are exported */
+	bool track_output () const {
+		return track_output_button.get_active() && !tap_playback_button.get_active () && !tap_prefader_button.get_active () && !tap_postfader_button.get_active ();
+	}
 	bool channel_limit_reached () const { return false; }
 
   private:
@@ -286,6 +289,10 @@ class TrackExportChannelSelector : public ExportChannelSelector
 	Gtk::ScrolledWindow          track_scroller;
 
 	Gtk::HBox                     options_box;
+	Gtk::Label                    tap_label;
+	Gtk::CheckButton              tap_playback_button;
+	Gtk::CheckButton              tap_prefader_button;
+	Gtk::CheckButton              tap_postfader_button;
 	Gtk::CheckButton              track_output_button;
 	ArdourWidgets::ArdourDropdown select_menu;
 	Gtk::CheckMenuItem*           exclude_hidden;
@@ -36,6 +36,7 @@ SessionArchiveDialog::SessionArchiveDialog ()
 	, ProgressReporter ()
 	, format_Label (ARDOUR::session_archive_suffix)
 	, only_used_checkbox (_("Exclude unused audio sources"))
+	, progress_rate (0)
 {
 	VBox* vbox = get_vbox();
 
@@ -238,18 +239,33 @@ SessionArchiveDialog::on_response (int response_id)
 	Gtk::Dialog::on_response (response_id);
 }
 
+void
+SessionArchiveDialog::set_rate (double bytes_per_sec)
+{
+	progress_rate = bytes_per_sec;
+}
+
 void
 SessionArchiveDialog::update_progress_gui (float p)
 {
 
 	progress_bar.show ();
 	if (p < 0) {
-		progress_bar.set_text (_("Archiving Session"));
+		progress_stage = _("Archiving Session");
+		progress_rate  = 0;
+		progress_bar.set_text (progress_stage);
 		return;
 	}
 	if (p > 1.0) {
-		progress_bar.set_text (_("Encoding Audio"));
+		progress_stage = _("Encoding Audio");
+		progress_rate  = 0;
+		progress_bar.set_text (progress_stage);
 		return;
 	}
+	if (progress_rate > 0) {
+		char buf[64];
+		snprintf (buf, sizeof (buf), "%.1f", progress_rate / 1048576.0);
+		progress_bar.set_text (string_compose (_("%1 (%2 MB/s)"), progress_stage, buf));
+	}
 	progress_bar.set_fraction (p);
 }
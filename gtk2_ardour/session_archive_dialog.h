@@ -48,6 +48,8 @@ public:
 	void set_compression_level (PBD::FileArchive::CompressionLevel);
 	void set_only_used_sources (bool);
 
+	void set_rate (double);
+
 protected:
 	void on_response (int);
 
@@ -60,6 +62,8 @@ private:
 	Gtk::CheckButton       only_used_checkbox;
 
 	Gtk::ProgressBar progress_bar;
+	std::string      progress_stage;
+	double           progress_rate;
 
 	void name_entry_changed ();
 	void update_progress_gui (float);
@@ -20,6 +20,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <glibmm/miscutils.h>
+
 #include <gtkmm/messagedialog.h>
 #include <gtkmm/stock.h>
 
@@ -28,6 +30,8 @@
 #include "ardour/audio_region_importer.h"
 #include "ardour/audio_playlist_importer.h"
 #include "ardour/audio_track_importer.h"
+#include "ardour/automation_list.h"
+#include "ardour/directory_names.h"
 #include "ardour/filename_extensions.h"
 #include "ardour/location_importer.h"
 #include "ardour/tempo_map_importer.h"
@@ -116,10 +120,18 @@ void
 SessionImportDialog::load_session (const string& filename)
 {
 	if (_session) {
-		if (tree.read (filename)) {
+		if (!tree.read (filename)) {
 			error << string_compose (_("Cannot load XML for session from %1"), filename) << endmsg;
 			return;
 		}
+
+		/* automation stored in sidecar files of the other session is
+		 * not available to this one, inline it before importing */
+		const std::string sidecar_dir = Glib::build_filename (Glib::path_get_dirname (filename), automation_dir_name);
+		if (AutomationList::inline_sidecar_events (*tree.root (), sidecar_dir) > 0) {
+			error << string_compose (_("Some automation data of %1 could not be read"), filename) << endmsg;
+		}
+
 		std::shared_ptr<AudioRegionImportHandler> region_handler (new AudioRegionImportHandler (tree, *_session));
 		std::shared_ptr<AudioPlaylistImportHandler> pl_handler (new AudioPlaylistImportHandler (tree, *_session, *region_handler));
 
@@ -408,6 +408,19 @@ SessionOptionEditor::SessionOptionEditor (Session* s)
 	tdo->add (Temporal::BeatTime, _("Musical (beats) time"));
 	add_option (_("Misc"), tdo);
 
+	bo = new BoolOption (
+		"automation-sidecar",
+		_("Store large automation lists in separate binary files"),
+		sigc::mem_fun (*_session_config, &SessionConfiguration::get_automation_sidecar),
+		sigc::mem_fun (*_session_config, &SessionConfiguration::set_automation_sidecar)
+		);
+
+	Gtkmm2ext::UI::instance()->set_tip (bo->tip_widget(),
+	                                    _("When enabled, dense automation is saved to the session's automation folder instead of the session file, "
+	                                      "which makes saving and loading large sessions faster.\n\n"
+	                                      "Sessions saved this way cannot be opened by older versions without losing that automation."));
+	add_option (_("Misc"), bo);
+
 #if 0
 	/* We cannot expose this option until it is possible (and sane) to
 	 * allow MIDI tracks to use audio time and audio tracks to use music time.
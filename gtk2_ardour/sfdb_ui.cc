@@ -2000,6 +2000,9 @@ SoundFileOmega::SoundFileOmega (string title, ARDOUR::Session* s,
 	str.push_back (_("Quick"));
 	str.push_back (_("Fast"));
 	str.push_back (_("Fastest"));
+	str.push_back (_("Best (zita)"));
+	str.push_back (_("Good (zita)"));
+	str.push_back (_("Fast (zita)"));
 
 	set_popdown_strings (src_combo, str);
 	src_combo.set_active_text (str.front());
@@ -2122,6 +2125,12 @@ SoundFileOmega::get_src_quality() const
 		return SrcQuick;
 	} else if (str == _("Fast")) {
 		return SrcFast;
+	} else if (str == _("Best (zita)")) {
+		return SrcZitaBest;
+	} else if (str == _("Good (zita)")) {
+		return SrcZitaGood;
+	} else if (str == _("Fast (zita)")) {
+		return SrcZitaFast;
 	} else {
 		return SrcFastest;
 	}
@@ -120,6 +120,28 @@ public:
 
 	bool operator!= (const AutomationList &) const;
 
+	/** While an instance exists, ::get_state() calls made by this thread
+	 * store the events of large lists in a binary file in @p dir and only
+	 * reference that file from the XML, and ::set_state() reads such files
+	 * from @p dir. An empty @p dir keeps all events inline.
+	 */
+	class LIBARDOUR_API SidecarScope {
+	public:
+		SidecarScope (std::string const& dir);
+		~SidecarScope ();
+
+	private:
+		std::string        _dir;
+		std::string const* _prev;
+	};
+
+	/** Replace all references to sidecar files in @p node and its
+	 * children by the events they hold, read from @p dir. Used when
+	 * state is taken from another session.
+	 * @return the number of event lists that could not be read
+	 */
+	static int inline_sidecar_events (XMLNode& node, std::string const& dir);
+
 	XMLNode* before () { XMLNode* rv = _before; _before = 0; return rv; }
 	void clear_history ();
 	void snapshot_history (bool need_lock);
@@ -133,6 +155,10 @@ private:
 	XMLNode& state (bool save_auto_state, bool need_lock) const;
 	XMLNode& serialize_events (bool need_lock) const;
 
+	bool write_sidecar (XMLNode&, std::string const& dir) const;
+	int  read_sidecar (XMLNode const&);
+	void load_deferred_events () const;
+
 	void maybe_signal_changed ();
 
 	AutoState         _state;
@@ -143,6 +169,21 @@ private:
 	bool operator== (const AutomationList&) const { /* not called */ abort(); return false; }
 	XMLNode* _before; //used for undo of touch start/stop pairs.
 
+	/* serialized events, reused by ::serialize_events() for as long as
+	 * ControlList::events_generation() does not change.
+	 */
+	mutable Glib::Threads::Mutex _events_cache_lock;
+	mutable std::string          _events_cache;
+	mutable uint64_t             _events_cache_generation;
+	mutable std::string          _sidecar_name;
+	mutable uint64_t             _sidecar_generation;
+
+	/* sidecar file the events are read from on first use */
+	mutable Glib::Threads::Mutex _deferred_lock;
+	std::string                  _deferred_path;
+
+	static thread_local std::string const* _sidecar_dir;
+
 };
 
 } // namespace
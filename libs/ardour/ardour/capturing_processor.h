@@ -34,6 +34,7 @@ public:
 
 public: // main interface
 	BufferSet const & get_capture_buffers() const { return capture_buffers; }
+	void set_latency (samplecnt_t);
 
 public: // Processor overrides
 	bool display_to_user() const { return false; }
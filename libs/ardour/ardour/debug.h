@@ -71,6 +71,7 @@ namespace PBD {
 		LIBARDOUR_API extern DebugBits Launchpad;
 		LIBARDOUR_API extern DebugBits Launchkey;
 		LIBARDOUR_API extern DebugBits Layering;
+		LIBARDOUR_API extern DebugBits LoadState;
 		LIBARDOUR_API extern DebugBits MIDISurface;
 		LIBARDOUR_API extern DebugBits MTC;
 		LIBARDOUR_API extern DebugBits MackieControl;
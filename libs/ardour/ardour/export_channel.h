@@ -233,11 +233,16 @@ public:
 	RouteExportChannel (std::shared_ptr<CapturingProcessor> processor,
 	                    DataType                            type,
 	                    size_t                              channel,
+	                    ExportTapPoint                      tap,
 	                    std::shared_ptr<ProcessorRemover>   remover);
 
 	~RouteExportChannel ();
 
-	static void create_from_route (std::list<ExportChannelPtr>& result, std::shared_ptr<Route> route);
+	/** Create channels for all inputs of an export point at the given position
+	 * of the route. Several points of a route (and several routes) can be
+	 * tapped at the same time, and are exported in a single pass.
+	 */
+	static void create_from_route (std::list<ExportChannelPtr>& result, std::shared_ptr<Route> route, ExportTapPoint tap = ExportTapPlayback);
 	static void create_from_state (std::list<ExportChannelPtr>& result, Session&, XMLNode*);
 
 public: // ExportChannel interface
@@ -251,6 +256,7 @@ public: // ExportChannel interface
 	bool midi () const;
 
 	std::shared_ptr<Route> route () const { return _remover->route (); }
+	ExportTapPoint tap_point () const { return _tap; }
 
 	std::string state_node_name () const { return "RouteExportChannel"; }
 
@@ -280,8 +286,9 @@ private:
 
 	std::shared_ptr<CapturingProcessor> _processor;
 
-	DataType _type;
-	size_t   _channel;
+	DataType       _type;
+	size_t         _channel;
+	ExportTapPoint _tap;
 
 	// Each channel keeps a ref to the remover. Last one alive
 	// will cause the processor to be removed on deletion.
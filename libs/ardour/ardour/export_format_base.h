@@ -117,7 +117,11 @@ class LIBARDOUR_API ExportFormatBase {
 		SRC_SincMedium = SRC_SINC_MEDIUM_QUALITY,
 		SRC_SincFast = SRC_SINC_FASTEST,
 		SRC_ZeroOrderHold = SRC_ZERO_ORDER_HOLD,
-		SRC_Linear = SRC_LINEAR
+		SRC_Linear = SRC_LINEAR,
+		/* zita-resampler, see AudioGrapher::SampleRateConverter::ZitaQuality */
+		SRC_ZitaBest = 100,
+		SRC_ZitaGood = 101,
+		SRC_ZitaFast = 102
 	};
 
 	/// Class for managing selection and compatibility states
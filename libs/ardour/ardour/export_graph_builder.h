@@ -25,6 +25,7 @@
 #include "ardour/export_handler.h"
 #include "ardour/export_analysis.h"
 #include "ardour/export_smf_writer.h"
+#include "ardour/export_status.h"
 
 #include "audiographer/utils/identity_vertex.h"
 
@@ -46,8 +47,12 @@ namespace AudioGrapher {
 	template <typename T> class CmdPipeWriter;
 	template <typename T> class SilenceTrimmer;
 	template <typename T> class TmpFile;
+	template <typename T> class SampleStore;
 	template <typename T> class Threader;
+	template <typename T> class AsyncSink;
+	class AsyncSinkBase;
 	template <typename T> class AllocatingProcessContext;
+	template <typename T> class ListedSource;
 }
 
 namespace ARDOUR
@@ -65,21 +70,30 @@ class LIBARDOUR_API ExportGraphBuilder
 	typedef std::shared_ptr<AudioGrapher::Sink<Sample> > FloatSinkPtr;
 	typedef std::shared_ptr<AudioGrapher::Analyser> AnalysisPtr;
 	typedef std::map<std::string, AnalysisPtr> AnalysisMap;
+	typedef std::shared_ptr<AudioGrapher::AsyncSinkBase> EncoderQueuePtr;
 
+	/* Each channel is read once per cycle. Overlapping timespans are
+	 * rendered in a single pass, and every timespan using the channel
+	 * receives only the part of the data within its own range.
+	 */
 	struct AnyExport {
-		/* Audio export */
-		AudioGrapher::IdentityVertex<Sample> audio;
-		void add_output (AudioGrapher::Source<Sample>::SinkPtr output) {
-			audio.add_output (output);
-		}
-		void process (AudioGrapher::ProcessContext<Sample> const& c) {
-			audio.process (c);
-		}
-		/* MIDI Export */
-		ExportSMFWriter midi;
-		void process (MidiBuffer const& buf, sampleoffset_t off, samplecnt_t cnt, bool last_cycle) {
-			midi.process (buf, off, cnt, last_cycle);
-		}
+		struct Span {
+			Span (samplepos_t s, samplepos_t e) : start (s), end (e) {}
+			samplepos_t start;
+			samplepos_t end;
+			/* Audio export */
+			AudioGrapher::IdentityVertex<Sample> audio;
+			/* MIDI Export */
+			ExportSMFWriter midi;
+		};
+		typedef std::shared_ptr<Span> SpanPtr;
+		typedef std::map<std::shared_ptr<ExportTimespan>, SpanPtr> SpanMap;
+
+		SpanMap spans;
+
+		SpanPtr span (std::shared_ptr<ExportTimespan>);
+		void process (Sample const* data, samplepos_t pos, samplecnt_t cnt);
+		void process (MidiBuffer const& buf, samplepos_t pos, sampleoffset_t off, samplecnt_t cnt);
 	};
 
 	typedef std::shared_ptr<AnyExport> AnyExportPtr;
@@ -87,22 +101,52 @@ class LIBARDOUR_API ExportGraphBuilder
 
   public:
 
+	/** Normalization needs the peak or loudness of the complete export.
+	 * By default the data is analyzed while it is written to an
+	 * intermediate store, and normalized when reading it back during
+	 * post-processing (SinglePass).
+	 * Alternatively the timespan is rendered twice: once only analyzing
+	 * without writing any files (AnalysisPass), and once applying the
+	 * gain while encoding (RenderPass).
+	 */
+	enum NormalizePass {
+		SinglePass,
+		AnalysisPass,
+		RenderPass
+	};
+
 	ExportGraphBuilder (Session const & session);
 	~ExportGraphBuilder ();
 
-	samplecnt_t process (samplecnt_t samples, bool last_cycle);
+	/// process \a samples of data, starting at session position \a pos
+	samplecnt_t process (samplepos_t pos, samplecnt_t samples);
 	bool post_process (); // returns true when finished
-	bool need_postprocessing () const { return !intermediates.empty(); }
+	bool need_postprocessing () const { return !intermediates.empty() || encoding (); }
+	bool normalizing () const { return !intermediates.empty(); }
+	bool encoding () const;
 	bool realtime() const { return _realtime; }
 	unsigned get_postprocessing_cycle_count() const;
+	unsigned get_encoder_backlog () const;
+	void get_encoder_status (std::vector<ExportStatus::EncoderStatus>&) const;
 
 	void reset ();
 	void cleanup (bool remove_out_files = false);
+	/// Set before adding the configs of each timespan, configs of several timespans can be rendered in one pass
 	void set_current_timespan (std::shared_ptr<ExportTimespan> span);
 	void add_config (FileSpec const & config, bool rt);
 	void get_analysis_results (AnalysisResults& results);
 
-	std::vector<std::string> exported_files () const {
+	/// Set before adding configs, analysis results are kept from the AnalysisPass for the RenderPass
+	void set_normalize_pass (NormalizePass);
+	NormalizePass normalize_pass () const { return _normalize_pass; }
+
+	struct ExportedFile {
+		ExportedFile (std::string const& p, std::shared_ptr<ExportTimespan> ts) : path (p), timespan (ts) {}
+		std::string                     path;
+		std::shared_ptr<ExportTimespan> timespan;
+	};
+
+	std::vector<ExportedFile> exported_files () const {
 		return _exported_files;
 	}
 
@@ -113,16 +157,22 @@ class LIBARDOUR_API ExportGraphBuilder
 	}
 
 	void add_export_fn (std::string const& fn) {
-		_exported_files.push_back (fn);
+		_exported_files.push_back (ExportedFile (fn, timespan));
+	}
+
+	void add_encoder_queue (EncoderQueuePtr q) {
+		encoder_queues.push_back (q);
 	}
 
-	std::vector<std::string> _exported_files;
+	std::vector<ExportedFile> _exported_files;
 
 	void add_split_config (FileSpec const & config);
 
 	class Encoder {
             public:
-		template <typename T> std::shared_ptr<AudioGrapher::Sink<T> > init (FileSpec const & new_config);
+		~Encoder ();
+		template <typename T> std::shared_ptr<AudioGrapher::Sink<T> > init (FileSpec const & new_config, samplecnt_t max_samples);
+		EncoderQueuePtr queue () const { return _queue; }
 		void add_child (FileSpec const & new_config);
 		void remove_children ();
 		void destroy_writer (bool delete_out_file);
@@ -139,6 +189,7 @@ class LIBARDOUR_API ExportGraphBuilder
 
 		template<typename T> void init_writer (std::shared_ptr<AudioGrapher::SndfileWriter<T> > & writer);
 		template<typename T> void init_writer (std::shared_ptr<AudioGrapher::CmdPipeWriter<T> > & writer);
+		template<typename T> std::shared_ptr<AudioGrapher::Sink<T> > init_queue (std::shared_ptr<AudioGrapher::Sink<T> > writer, samplecnt_t max_samples);
 
 		void copy_files (std::string orig_path);
 
@@ -153,6 +204,9 @@ class LIBARDOUR_API ExportGraphBuilder
 		IntWriterPtr   int_writer;
 		ShortWriterPtr short_writer;
 		FloatPipePtr   pipe_writer;
+
+		// Encodes in its own thread, feeds the writer
+		EncoderQueuePtr _queue;
 	};
 
 	// sample format converter
@@ -177,9 +231,14 @@ class LIBARDOUR_API ExportGraphBuilder
 		typedef std::shared_ptr<AudioGrapher::SampleFormatConverter<Sample> > FloatConverterPtr;
 		typedef std::shared_ptr<AudioGrapher::SampleFormatConverter<int> >   IntConverterPtr;
 		typedef std::shared_ptr<AudioGrapher::SampleFormatConverter<short> > ShortConverterPtr;
+		typedef std::shared_ptr<AudioGrapher::ListedSource<float> > FloatSourcePtr;
+		typedef std::pair<int, int> ConverterKey; // data width, dither type
 
+		void add_encoder (FileSpec const & new_config);
+
+		ExportGraphBuilder & parent;
 		FileSpec           config;
-		int                data_width;
+		samplecnt_t        max_samples_out;
 		boost::ptr_list<Encoder> children;
 
 		NormalizerPtr   normalizer;
@@ -188,10 +247,11 @@ class LIBARDOUR_API ExportGraphBuilder
 		ChunkerPtr      chunker;
 		AnalysisPtr     analyser;
 		bool            _analyse;
-		// Only one of these should be available at a time
-		FloatConverterPtr float_converter;
-		IntConverterPtr int_converter;
-		ShortConverterPtr short_converter;
+		FloatSourcePtr  converter_source;
+		// One converter per data width and dither type, shared by all Encoders using it
+		std::map<ConverterKey, FloatConverterPtr> float_converters;
+		std::map<ConverterKey, IntConverterPtr>   int_converters;
+		std::map<ConverterKey, ShortConverterPtr> short_converters;
 	};
 
 	class Intermediate {
@@ -211,11 +271,16 @@ class LIBARDOUR_API ExportGraphBuilder
 		typedef std::shared_ptr<AudioGrapher::PeakReader> PeakReaderPtr;
 		typedef std::shared_ptr<AudioGrapher::LoudnessReader> LoudnessReaderPtr;
 		typedef std::shared_ptr<AudioGrapher::TmpFile<Sample> > TmpFilePtr;
+		typedef std::shared_ptr<AudioGrapher::SampleStore<Sample> > SampleStorePtr;
 		typedef std::shared_ptr<AudioGrapher::Threader<Sample> > ThreaderPtr;
 		typedef std::shared_ptr<AudioGrapher::AllocatingProcessContext<Sample> > BufferPtr;
 
+		void init_store (samplecnt_t max_samples);
 		void prepare_post_processing ();
 		void start_post_processing ();
+		void store_complete ();
+		void apply_analysis (SFC&);
+		samplecnt_t samples_written () const;
 
 		ExportGraphBuilder & parent;
 
@@ -226,6 +291,7 @@ class LIBARDOUR_API ExportGraphBuilder
 		BufferPtr       buffer;
 		PeakReaderPtr   peak_reader;
 		TmpFilePtr      tmp_file;
+		SampleStorePtr  store; // used instead of tmp_file when it fits the memory budget
 		ThreaderPtr     threader;
 
 		LoudnessReaderPtr    loudness_reader;
@@ -291,6 +357,7 @@ class LIBARDOUR_API ExportGraphBuilder
 
 		ExportGraphBuilder &      parent;
 		FileSpec                  config;
+		std::shared_ptr<ExportTimespan> timespan;
 		boost::ptr_list<SilenceHandler> children;
 		InterleaverPtr            interleaver;
 		ChunkerPtr                chunker;
@@ -311,6 +378,21 @@ class LIBARDOUR_API ExportGraphBuilder
 
 	std::list<Intermediate *> intermediates;
 
+	// One per Encoder, drained during post-processing
+	std::list<EncoderQueuePtr> encoder_queues;
+
+	// Peak and loudness of each Intermediate, in order of creation, measured by the AnalysisPass
+	struct NormalizeAnalysis {
+		std::shared_ptr<AudioGrapher::PeakReader>     peak_reader;
+		std::shared_ptr<AudioGrapher::LoudnessReader> loudness_reader;
+	};
+	std::vector<NormalizeAnalysis> normalize_analysis;
+	size_t                         normalize_analysis_used;
+	NormalizePass                  _normalize_pass;
+
+	// Memory used by intermediate SampleStores
+	size_t _store_bytes;
+
 	AnalysisMap analysis_map;
 
 	bool        _realtime;
@@ -26,6 +26,8 @@
 
 #include <map>
 #include <memory>
+#include <set>
+#include <vector>
 
 #include <boost/operators.hpp>
 
@@ -144,6 +146,7 @@ class LIBARDOUR_API ExportHandler : public ExportElementFactory, public sigc::tr
 	ConfigMap          config_map;
 
 	bool               post_processing;
+	bool               analysis_pass; // normalize: analyze only, then render again
 
 	/* Timespan management */
 
@@ -159,10 +162,17 @@ class LIBARDOUR_API ExportHandler : public ExportElementFactory, public sigc::tr
 	int  process_timespan (samplecnt_t samples);
 	int  post_process ();
 	void finish_timespan ();
+	void update_encoder_status ();
+	bool use_normalize_prepass () const;
 
-	typedef std::pair<ConfigMap::iterator, ConfigMap::iterator> TimespanBounds;
-	ExportTimespanPtr     current_timespan;
-	TimespanBounds        timespan_bounds;
+	/* Overlapping timespans are rendered in a single pass */
+	typedef std::set<ExportTimespanPtr> TimespanSet;
+	TimespanSet overlapping_timespans (ExportTimespanPtr first, TimespanSet const& candidates) const;
+	bool        can_merge (ExportTimespanPtr) const;
+
+	typedef std::vector<ConfigMap::iterator> TimespanConfigs;
+	ExportTimespanPtr     current_timespan; // the range rendered in this pass
+	TimespanConfigs       timespan_configs; // configs of all timespans in this pass
 
 	PBD::ScopedConnection process_connection;
 	samplepos_t           process_position;
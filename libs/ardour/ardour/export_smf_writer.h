@@ -40,6 +40,8 @@ public:
 	void process (MidiBuffer const&, sampleoffset_t, samplecnt_t, bool);
 
 private:
+	void write (MidiBuffer const&, sampleoffset_t, samplecnt_t, bool);
+
 	std::string      _path;
 	samplepos_t      _pos;
 	samplepos_t      _last_ev_time_samples;
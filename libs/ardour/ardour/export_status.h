@@ -24,6 +24,10 @@
 #define __ardour_export_status_h__
 
 #include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <glibmm/threads.h>
 
 #include "ardour/libardour_visibility.h"
 #include "ardour/export_analysis.h"
@@ -76,6 +80,7 @@ class LIBARDOUR_API ExportStatus {
 
 	volatile samplecnt_t    total_samples;
 	volatile samplecnt_t    processed_samples;
+	volatile samplecnt_t    saved_samples; ///< not rendered, because overlapping timespans share a pass
 
 	volatile samplecnt_t    total_samples_current_timespan;
 	volatile samplecnt_t    processed_samples_current_timespan;
@@ -85,12 +90,28 @@ class LIBARDOUR_API ExportStatus {
 
 	AnalysisResults         result_map;
 
+	/* Encoder info */
+
+	struct EncoderStatus {
+		std::string name;
+		samplecnt_t samples;    ///< encoded samples per channel
+		double      throughput; ///< samples per channel and second of encoder busy time
+		uint32_t    queued;     ///< blocks waiting to be encoded
+		uint32_t    queue_size;
+	};
+
+	std::vector<EncoderStatus> encoder_status () const;
+	void set_encoder_status (std::vector<EncoderStatus> const&);
+
   private:
 	volatile bool          _aborted;
 	volatile bool          _errors;
 	volatile bool          _running;
 
 	Glib::Threads::Mutex   _run_lock;
+
+	mutable Glib::Threads::Mutex _encoder_lock;
+	std::vector<EncoderStatus>   _encoder_status;
 };
 
 } // namespace ARDOUR
@@ -33,6 +33,7 @@ namespace ARDOUR {
 	LIBARDOUR_API extern const char* const backup_suffix;
 	LIBARDOUR_API extern const char* const temp_suffix;
 	LIBARDOUR_API extern const char* const history_suffix;
+	LIBARDOUR_API extern const char* const undo_log_suffix;
 	LIBARDOUR_API extern const char* const export_preset_suffix;
 	LIBARDOUR_API extern const char* const export_format_suffix;
 	LIBARDOUR_API extern const char* const session_archive_suffix;
@@ -20,6 +20,7 @@
 //#define WITH_LUAPROC_STATS
 
 /* memory allocation system, default: ReallocPool */
+//#define USE_SLAB_POOL // use size-class SlabPool (takes precedence over USE_TLSF)
 //#define USE_TLSF // use TLSF instead of ReallocPool
 //#define USE_MALLOC // or plain OS provided realloc (no mlock) -- if USE_TLSF isn't defined
 
@@ -30,7 +31,9 @@
 #include <vector>
 #include <string>
 
-#ifdef USE_TLSF
+#ifdef USE_SLAB_POOL
+#  include "pbd/slab_pool.h"
+#elif defined USE_TLSF
 #  include "pbd/tlsf.h"
 #else
 #  include "pbd/reallocpool.h"
@@ -150,7 +153,9 @@ protected:
 	const std::string& origin() const { return _origin; }
 
 private:
-#ifdef USE_TLSF
+#ifdef USE_SLAB_POOL
+	PBD::SlabPool _mempool;
+#elif defined USE_TLSF
 	PBD::TLSF _mempool;
 #else
 	PBD::ReallocPool _mempool;
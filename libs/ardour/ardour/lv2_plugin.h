@@ -145,6 +145,7 @@ class LIBARDOUR_API LV2Plugin : public ARDOUR::Plugin, public ARDOUR::Workee
 	void set_state_dir (const std::string& d = "");
 
 	int      set_state (const XMLNode& node, int version);
+	void     restore_deferred_state ();
 	bool     load_preset (PresetRecord);
 	std::string current_preset () const;
 
@@ -366,6 +367,7 @@ class LIBARDOUR_API LV2Plugin : public ARDOUR::Plugin, public ARDOUR::Workee
 	mutable unsigned _state_version;
 
 	bool _was_activated;
+	bool _activate_pending;
 	bool _has_state_interface;
 
 	const std::string plugin_dir () const;
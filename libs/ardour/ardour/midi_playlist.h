@@ -25,6 +25,12 @@
 
 #include <vector>
 #include <list>
+#include <map>
+#include <set>
+
+#include <glibmm/threads.h>
+
+#include "pbd/id.h"
 
 #include "evoral/Parameter.h"
 
@@ -78,19 +84,46 @@ public:
 
 	void _split_region (std::shared_ptr<Region>, timepos_t const & position, ThawList& thawlist);
 
-	void set_note_mode (NoteMode m) { _note_mode = m; }
+	void set_note_mode (NoteMode m);
 
 	std::set<Evoral::Parameter> contained_automation();
 
 	std::shared_ptr<Region> combine (const RegionList&, std::shared_ptr<Track>);
 	void uncombine (std::shared_ptr<Region>);
 
+  protected:
+	bool region_changed (const PBD::PropertyChange&, std::shared_ptr<Region>);
+
   private:
 	void dump () const;
 
 	NoteMode     _note_mode;
 
 	RTMidiBuffer _rendered;
+
+	/* ::render() keeps the (sorted) output of each region it rendered,
+	 * and only asks regions that changed since then (or that were added)
+	 * to render again. The whole cache is dropped if the tempo map, the
+	 * note mode or the channel filter configuration changes.
+	 *
+	 * _render_cache_lock is held by ::render() while it uses the cache,
+	 * _render_lock guards what invalidation records for the next render,
+	 * so that invalidating never waits for a render to finish.
+	 */
+	typedef std::map<PBD::ID, std::shared_ptr<RTMidiBuffer> > RenderCache;
+
+	RenderCache          _render_cache;
+	uint64_t             _render_tempo_generation;
+	uint32_t             _render_filter_config;
+	Glib::Threads::Mutex _render_cache_lock;
+
+	std::set<PBD::ID>    _render_dirty;
+	bool                 _render_flush;
+	Glib::Threads::Mutex _render_lock;
+
+	void init_render_cache ();
+	void invalidate_render (std::weak_ptr<Region>);
+	std::shared_ptr<RTMidiBuffer> cached_render (std::shared_ptr<MidiRegion>, MidiChannelFilter*);
 };
 
 } /* namespace ARDOUR */
@@ -35,6 +35,12 @@ extern "C" {
 
 LIBARDOUR_API void x86_sse_find_peaks              (float const* buf, uint32_t nsamples, float* min, float* max);
 
+#ifdef __SSE2__
+/* SSE2 export sample format conversion */
+LIBARDOUR_API void x86_sse2_float_to_int16         (int16_t* dst, float const* src, uint32_t nframes, float const* noise);
+LIBARDOUR_API void x86_sse2_float_to_int24         (int32_t* dst, float const* src, uint32_t nframes, float const* noise);
+#endif
+
 extern "C" {
 /* AVX functions */
 	LIBARDOUR_API float x86_sse_avx_compute_peak          (float const* buf, uint32_t nsamples, float current);
@@ -50,6 +56,10 @@ extern "C" {
 LIBARDOUR_API void x86_sse_avx_find_peaks               (float const* buf, uint32_t nsamples, float* min, float* max);
 #endif
 
+/* AVX export sample format conversion */
+LIBARDOUR_API void  x86_sse_avx_float_to_int16          (int16_t* dst, float const* src, uint32_t nframes, float const* noise);
+LIBARDOUR_API void  x86_sse_avx_float_to_int24          (int32_t* dst, float const* src, uint32_t nframes, float const* noise);
+
 /* FMA functions */
 #ifdef FPU_AVX_FMA_SUPPORT
 LIBARDOUR_API void  x86_fma_mix_buffers_with_gain       (float* dst, float const* src, uint32_t nframes, float gain);
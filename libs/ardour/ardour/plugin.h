@@ -88,6 +88,13 @@ public:
 	virtual void set_insert_id (PBD::ID id) {}
 	virtual void set_state_dir (const std::string& d = "") {}
 
+	/** Complete a state restore that set_state() handed to
+	 * Session::defer_plugin_restore() while the session was loading.
+	 * Called from a worker thread, concurrently with other plugins
+	 * (but never with instances of the same plugin).
+	 */
+	virtual void restore_deferred_state () {}
+
 	void set_insert (PlugInsertBase* pib, uint32_t num) {
 		_pib = pib;
 		_num = num;
@@ -29,6 +29,8 @@
 #include <string>
 #include <vector>
 
+#include <glibmm/threads.h>
+
 #include "pbd/stack_allocator.h"
 #include "pbd/timing.h"
 
@@ -315,6 +317,18 @@ private:
 	bool _custom_cfg;
 	bool _maps_from_state;
 
+	/* hash of the plugin state last saved or restored, the ID of the
+	 * insert that state belongs to, and whether the plugin was modified
+	 * since (set from the process thread)
+	 */
+	mutable Glib::Threads::Mutex _plugin_state_lock;
+	mutable std::string          _plugin_state_hash;
+	mutable PBD::ID              _plugin_state_origin;
+	mutable std::atomic<bool>    _plugin_state_dirty;
+
+	void plugin_state_modified ();
+	std::string state_hash (XMLNode const&) const;
+
 	Match private_can_support_io_configuration (ChanCount const &, ChanCount &) const;
 	Match internal_can_support_io_configuration (ChanCount const &, ChanCount &) const;
 	Match automatic_can_support_io_configuration (ChanCount const &, ChanCount &) const;
@@ -191,6 +191,9 @@ public:
 	/** reset port-buffers. e.g. after freewheeling */
 	void reinit (bool with_ratio = false);
 
+	/** drop port maps that are no longer used by the process thread */
+	void reclaim_ports () { _ports.reclaim (); }
+
 	void clear_pending_port_deletions ();
 
 	virtual void add_pending_port_deletion (Port*) = 0;
@@ -278,7 +281,7 @@ public:
 protected:
 	std::shared_ptr<AudioBackend> _backend;
 
-	SerializedRCUManager<Ports> _ports;
+	EpochRCUManager<Ports> _ports;
 
 	bool                   _port_remove_in_progress;
 	PBD::RingBuffer<Port*> _port_deletions_pending;
@@ -287,7 +290,7 @@ protected:
 	void                    port_registration_failure (const std::string& portname);
 
 	/** List of ports to be used between \ref cycle_start() and \ref cycle_end() */
-	std::shared_ptr<Ports const> _cycle_ports;
+	EpochRCUManager<Ports>::ReadPtr _cycle_ports;
 
 	void silence (pframes_t nframes, Session* s = 0);
 	void silence_outputs (pframes_t nframes);
@@ -28,6 +28,10 @@
 #include "ardour/types.h"
 #include "ardour/importable_source.h"
 
+namespace ArdourZita {
+	class Resampler;
+}
+
 namespace ARDOUR {
 
 class LIBARDOUR_API ResampledImportableSource : public ImportableSource
@@ -53,12 +57,18 @@ class LIBARDOUR_API ResampledImportableSource : public ImportableSource
 	static const uint32_t blocksize;
 
    private:
+	samplecnt_t read_zita (Sample* buffer, samplecnt_t nframes);
+
 	std::shared_ptr<ImportableSource> source;
 	float*          _input;
 	int             _src_type;
 	SRC_STATE*      _src_state;
 	SRC_DATA        _src_data;
 	bool            _end_of_input;
+
+	ArdourZita::Resampler* _zita;
+	samplecnt_t     _zita_in;  // frames
+	samplecnt_t     _zita_out; // frames
 };
 
 }
@@ -283,7 +283,7 @@ public:
 	void add_send_to_internal_return (InternalSend *);
 	void remove_send_from_internal_return (InternalSend *);
 	void listen_position_changed ();
-	std::shared_ptr<CapturingProcessor> add_export_point(/* Add some argument for placement later */);
+	std::shared_ptr<CapturingProcessor> add_export_point (ExportTapPoint point = ExportTapPlayback);
 
 	/** A record of the stream configuration at some point in the processor list.
 	 * Used to return where and why an processor list configuration request failed.
@@ -784,7 +784,8 @@ private:
 
 	friend class ProcessorState;
 
-	std::shared_ptr<CapturingProcessor> _capturing_processor;
+	typedef std::map<ExportTapPoint, std::shared_ptr<CapturingProcessor> > CapturingProcessorMap;
+	CapturingProcessorMap _capturing_processors;
 
 	int64_t _track_number;
 	bool    _strict_io;
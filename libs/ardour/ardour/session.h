@@ -57,6 +57,7 @@
 #include "pbd/error.h"
 #include "pbd/event_loop.h"
 #include "pbd/file_archive.h"
+#include "pbd/microseconds.h"
 #include "pbd/rcu.h"
 #include "pbd/statefuldestructible.h"
 #include "pbd/signals.h"
@@ -112,6 +113,7 @@ namespace PBD {
 class Controllable;
 class Progress;
 class Command;
+class Timing;
 }
 
 namespace luabridge {
@@ -161,6 +163,7 @@ class MidiSource;
 class MidiTrack;
 class MixerScene;
 class Playlist;
+class Plugin;
 class PluginInsert;
 class PluginInfo;
 class Port;
@@ -330,8 +333,19 @@ public:
 	void butler_transport_work (bool have_process_lock = false);
 
 	void refresh_disk_space ();
+	/** drop route lists and port maps replaced since realtime readers last used them */
+	void reclaim_rcu ();
 
 	int load_routes (const XMLNode&, int);
+
+	/** Plugins can postpone expensive parts of restoring their state
+	 * while the session is loading. Once all routes are loaded,
+	 * Plugin::restore_deferred_state() is called for each of them
+	 * using several threads.
+	 */
+	void defer_plugin_restore (Plugin*);
+	void cancel_plugin_restore (Plugin*);
+
 	std::shared_ptr<RouteList const> get_routes() const {
 		return routes.reader ();
 	}
@@ -627,6 +641,7 @@ public:
 	int save_template (const std::string& template_name, const std::string& description = "", bool replace_existing = false);
 	int save_history (std::string snapshot_name = "");
 	int restore_history (std::string snapshot_name);
+	PBD::UndoTransaction* undo_transaction_factory (XMLNode const&);
 	void remove_state (std::string snapshot_name);
 	void rename_state (std::string old_name, std::string new_name);
 	void remove_pending_capture_state ();
@@ -635,6 +650,12 @@ public:
 	void set_nsm_state (bool state) { _under_nsm_control = state; }
 	bool save_default_options ();
 
+	/** Wall-clock time spent in each phase of the last ::set_state(),
+	 * in the order the phases ran.
+	 */
+	typedef std::vector<std::pair<std::string, PBD::microseconds_t> > LoadPhaseTimes;
+	LoadPhaseTimes const & load_phase_times () const { return _load_phase_times; }
+
 	PBD::Signal1<void,std::string> StateSaved;
 	PBD::Signal0<void> StateReady;
 
@@ -1721,6 +1742,7 @@ private:
 	int  post_engine_init ();
 	int  immediately_post_engine ();
 	void remove_empty_sounds ();
+	void remove_unused_automation_sidecars ();
 
 	void session_loaded ();
 
@@ -1968,7 +1990,7 @@ private:
 
 	/* routes stuff */
 
-	SerializedRCUManager<RouteList>  routes;
+	EpochRCUManager<RouteList> routes;
 
 	void add_routes (RouteList&, bool input_auto_connect, bool output_auto_connect, PresentationInfo::order_t);
 	void add_routes_inner (RouteList&, bool input_auto_connect, bool output_auto_connect, PresentationInfo::order_t);
@@ -2050,6 +2072,8 @@ private:
 	SourceMap sources;
 
 	int load_sources (const XMLNode& node);
+	void preload_sources (XMLNodeList const&, std::vector<std::shared_ptr<Source> >&);
+	void restore_deferred_plugins ();
 	XMLNode& get_sources_as_xml ();
 
 	std::shared_ptr<Source> XMLSourceFactory (const XMLNode&);
@@ -2167,6 +2191,9 @@ private:
 
 	XMLNode& get_state () const;
 	int      set_state (const XMLNode& node, int version); // not idempotent
+
+	LoadPhaseTimes _load_phase_times;
+	void load_phase_done (char const*, PBD::Timing&);
 	XMLNode& get_template ();
 
 	bool maybe_copy_midifile (snapshot_t, std::shared_ptr<Source> src, XMLNode*);
@@ -2260,6 +2287,7 @@ private:
 	XMLNode& get_control_protocol_state () const;
 
 	void set_history_depth (uint32_t depth);
+	void setup_undo_log ();
 
 	static bool _disable_all_loaded_plugins;
 	static bool _bypass_all_loaded_plugins;
@@ -2355,6 +2383,9 @@ private:
 	std::shared_ptr<RTTaskList> _rt_tasklist;
 	std::shared_ptr<IOTaskList> _io_tasklist;
 
+	Glib::Threads::Mutex _deferred_plugin_lock;
+	std::vector<Plugin*> _deferred_plugins;
+
 	/* Scene Changing */
 	SceneChanger* _scene_changer;
 
@@ -66,6 +66,7 @@ CONFIG_VARIABLE (bool, midi_copy_is_fork, "midi-copy-is-fork", true)
 CONFIG_VARIABLE (bool, tracks_follow_session_time, "tracks-follow-session-time", false)
 CONFIG_VARIABLE (bool, realtime_export, "realtime-export", false)
 CONFIG_VARIABLE (bool, use_surround_master, "use-surround-master", false)
+CONFIG_VARIABLE (bool, automation_sidecar, "automation-sidecar", false)
 
 /* Video-settings are saved with the session and belong to the session.
  * headless ardour could remote control xjadeo for example.
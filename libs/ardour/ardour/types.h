@@ -230,6 +230,12 @@ enum DiskIOPoint {
 	DiskIOCustom,   /* up to the user. Caveat Emptor! */
 };
 
+enum ExportTapPoint {
+	ExportTapPlayback,  /* after the disk-reader (or bus return), before any processing */
+	ExportTapPreFader,  /* just before the fader */
+	ExportTapPostFader, /* before the main outs, after all processing */
+};
+
 enum MeterType {
 	MeterMaxSignal = 0x0001,
 	MeterMaxPeak   = 0x0002,
@@ -666,7 +672,10 @@ enum SrcQuality {
 	SrcGood,
 	SrcQuick,
 	SrcFast,
-	SrcFastest
+	SrcFastest,
+	SrcZitaBest,
+	SrcZitaGood,
+	SrcZitaFast
 };
 
 typedef std::list<samplepos_t> AnalysisFeatureList;
@@ -71,6 +71,7 @@ DEFINE_ENUM_CONVERT(ARDOUR::AutoReturnTarget)
 DEFINE_ENUM_CONVERT(ARDOUR::MeterType)
 DEFINE_ENUM_CONVERT(ARDOUR::MeterPoint)
 DEFINE_ENUM_CONVERT(ARDOUR::DiskIOPoint)
+DEFINE_ENUM_CONVERT(ARDOUR::ExportTapPoint)
 DEFINE_ENUM_CONVERT(ARDOUR::NoteMode)
 DEFINE_ENUM_CONVERT(ARDOUR::ChannelMode)
 DEFINE_ENUM_CONVERT(ARDOUR::MonitorChoice)
@@ -149,7 +149,7 @@ AudioEngine::split_cycle (pframes_t nframes)
 {
 	/* caller must hold process lock */
 
-	std::shared_ptr<Ports const> p = _ports.reader();
+	EpochRCUManager<Ports>::ReadPtr p (_ports);
 
 	/* This is mainly for the benefit of rt-control ports (MTC, MClk)
 	 *
@@ -296,6 +296,8 @@ AudioEngine::process_callback (pframes_t nframes)
 		Temporal::TempoMap::set (current_map);
 	}
 
+	Temporal::TempoMap::begin_conversion_cycle ();
+
 	/* This is for JACK, where the latency callback arrives in sync with
 	 * port registration (usually while ardour holds the process-lock
 	 * or with _adding_routes_in_progress or _route_deletion_in_progress set,
@@ -22,15 +22,23 @@
  */
 
 #include <set>
+#include <cinttypes>
 #include <climits>
+#include <cstring>
 #include <float.h>
 #include <cmath>
 #include <sstream>
 #include <algorithm>
 
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+
 #include "temporal/types_convert.h"
 
 #include "ardour/automation_list.h"
+#include "ardour/debug.h"
 #include "ardour/event_type_map.h"
 #include "ardour/parameter_descriptor.h"
 #include "ardour/parameter_types.h"
@@ -50,6 +58,74 @@ using namespace ARDOUR;
 using namespace PBD;
 
 PBD::Signal1<void,AutomationList *> AutomationList::AutomationListCreated;
+thread_local std::string const*     AutomationList::_sidecar_dir = 0;
+
+/* Binary sidecar files for event data.
+ *
+ * Lists with at least sidecar_min_events events are stored in a file in
+ * the session's automation folder when a SidecarScope is active. The file
+ * is named after the checksum of its payload, so unchanged lists map to the
+ * same file and snapshots sharing a list share the file. All values are
+ * little-endian, the layout can be used as-is from a memory map:
+ *
+ *   char     magic[8]     "ArdrAEvt"
+ *   uint32_t version      1
+ *   uint32_t time domain  0: audio (superclock), 1: beats (ticks)
+ *   uint64_t n_events
+ *   uint64_t checksum     FNV-1a 64 of the payload
+ *   n_events * { int64_t when, double value }
+ */
+static const char     sidecar_magic[8]    = { 'A', 'r', 'd', 'r', 'A', 'E', 'v', 't' };
+static const uint32_t sidecar_version     = 1;
+static const size_t   sidecar_header_size = 32;
+static const size_t   sidecar_event_size  = 16;
+static const size_t   sidecar_min_events  = 256;
+
+static uint64_t
+sidecar_checksum (uint8_t const* data, size_t len)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (size_t n = 0; n < len; ++n) {
+		h ^= data[n];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static void
+sidecar_put (uint8_t* dst, uint64_t v)
+{
+	v = GUINT64_TO_LE (v);
+	memcpy (dst, &v, sizeof (v));
+}
+
+static uint64_t
+sidecar_get (uint8_t const* src)
+{
+	uint64_t v;
+	memcpy (&v, src, sizeof (v));
+	return GUINT64_FROM_LE (v);
+}
+
+static std::string
+sidecar_hex (uint64_t v)
+{
+	char buf[17];
+	snprintf (buf, sizeof (buf), "%016" PRIx64, v);
+	return buf;
+}
+
+AutomationList::SidecarScope::SidecarScope (std::string const& dir)
+	: _dir (dir)
+	, _prev (_sidecar_dir)
+{
+	_sidecar_dir = &_dir;
+}
+
+AutomationList::SidecarScope::~SidecarScope ()
+{
+	_sidecar_dir = _prev;
+}
 
 #if 0
 static void dumpit (const AutomationList& al, string prefix = "")
@@ -64,6 +140,8 @@ static void dumpit (const AutomationList& al, string prefix = "")
 AutomationList::AutomationList (const Evoral::Parameter& id, const Evoral::ParameterDescriptor& desc, Temporal::TimeDomainProvider const & tdp)
 	: ControlList(id, desc, tdp)
 	, _before (0)
+	, _events_cache_generation (0)
+	, _sidecar_generation (0)
 {
 	_state = Off;
 	_touching.store (0);
@@ -71,6 +149,9 @@ AutomationList::AutomationList (const Evoral::Parameter& id, const Evoral::Param
 
 	create_curve_if_necessary();
 
+	/* the GUI redraws the whole line on change */
+	StateChanged.set_cross_thread_coalescing (true);
+
 	assert(_parameter.type() != NullAutomation);
 	AutomationListCreated(this);
 }
@@ -78,6 +159,8 @@ AutomationList::AutomationList (const Evoral::Parameter& id, const Evoral::Param
 AutomationList::AutomationList (const Evoral::Parameter& id, Temporal::TimeDomainProvider const & tdp)
 	: ControlList(id, ARDOUR::ParameterDescriptor(id), tdp)
 	, _before (0)
+	, _events_cache_generation (0)
+	, _sidecar_generation (0)
 {
 	_state = Off;
 	_touching.store (0);
@@ -85,6 +168,8 @@ AutomationList::AutomationList (const Evoral::Parameter& id, Temporal::TimeDomai
 
 	create_curve_if_necessary();
 
+	StateChanged.set_cross_thread_coalescing (true);
+
 	assert(_parameter.type() != NullAutomation);
 	AutomationListCreated(this);
 }
@@ -93,12 +178,16 @@ AutomationList::AutomationList (const AutomationList& other)
 	: ControlList(other)
 	, StatefulDestructible()
 	, _before (0)
+	, _events_cache_generation (0)
+	, _sidecar_generation (0)
 {
 	_state = other._state;
 	_touching.store (other.touching());
 
 	create_curve_if_necessary();
 
+	StateChanged.set_cross_thread_coalescing (true);
+
 	assert(_parameter.type() != NullAutomation);
 	AutomationListCreated(this);
 }
@@ -106,12 +195,16 @@ AutomationList::AutomationList (const AutomationList& other)
 AutomationList::AutomationList (const AutomationList& other, timepos_t const & start, timepos_t const & end)
 	: ControlList(other, start, end)
 	, _before (0)
+	, _events_cache_generation (0)
+	, _sidecar_generation (0)
 {
 	_state = other._state;
 	_touching.store (other.touching());
 
 	create_curve_if_necessary();
 
+	StateChanged.set_cross_thread_coalescing (true);
+
 	assert(_parameter.type() != NullAutomation);
 	AutomationListCreated(this);
 }
@@ -122,6 +215,8 @@ AutomationList::AutomationList (const AutomationList& other, timepos_t const & s
 AutomationList::AutomationList (const XMLNode& node, Evoral::Parameter id)
 	: ControlList(id, ARDOUR::ParameterDescriptor(id), Temporal::TimeDomainProvider (Temporal::AudioTime)) /* domain may change in ::set_state */
 	, _before (0)
+	, _events_cache_generation (0)
+	, _sidecar_generation (0)
 {
 	_touching.store (0);
 	_interpolation = default_interpolation ();
@@ -135,6 +230,8 @@ AutomationList::AutomationList (const XMLNode& node, Evoral::Parameter id)
 
 	create_curve_if_necessary();
 
+	StateChanged.set_cross_thread_coalescing (true);
+
 	assert(_parameter.type() != NullAutomation);
 	AutomationListCreated(this);
 }
@@ -214,6 +311,9 @@ AutomationList::automation_state() const
 void
 AutomationList::set_automation_state (AutoState s)
 {
+	/* the process thread must never be the first to use the list */
+	ensure_events ();
+
 	{
 		Glib::Threads::RWLock::ReaderLock lm (Evoral::ControlList::_lock);
 
@@ -346,7 +446,7 @@ AutomationList::state (bool save_auto_state, bool need_lock) const
 		if (_state != Write) {
 			root->set_property ("state", _state);
 		} else {
-			if (_events.empty ()) {
+			if (empty ()) {
 				root->set_property ("state", Off);
 			} else {
 				root->set_property ("state", Touch);
@@ -357,7 +457,7 @@ AutomationList::state (bool save_auto_state, bool need_lock) const
 		root->set_property ("state", Off);
 	}
 
-	if (!_events.empty()) {
+	if (!empty ()) {
 		root->add_child_nocopy (serialize_events (need_lock));
 	}
 
@@ -368,32 +468,331 @@ XMLNode&
 AutomationList::serialize_events (bool need_lock) const
 {
 	XMLNode* node = new XMLNode (X_("events"));
-	stringstream str;
 
 	Glib::Threads::RWLock::ReaderLock lm (Evoral::ControlList::_lock, Glib::Threads::NOT_LOCK);
 	if (need_lock) {
 		lm.acquire ();
 	}
-	for (const_iterator xx = _events.begin(); xx != _events.end(); ++xx) {
-		str << PBD::to_string ((*xx)->when);
-		str << ' ';
-		str << PBD::to_string ((*xx)->value);
-		str << '\n';
+
+	/* formatting the events dominates saving sessions with dense
+	 * automation, and most lists are unchanged between two saves.
+	 * Only re-format when the list was modified since the last time.
+	 */
+	Glib::Threads::Mutex::Lock cl (_events_cache_lock);
+
+	if (_events_deferred.load (std::memory_order_acquire)) {
+		/* not loaded since the session was, refer to the same file */
+		if (_sidecar_dir && Glib::build_filename (*_sidecar_dir, _sidecar_name) == _deferred_path) {
+			node->set_property (X_("sidecar"), _sidecar_name);
+			node->set_property (X_("count"), (uint64_t) _deferred_size);
+			return *node;
+		}
+		ensure_events ();
+	}
+
+	if (_sidecar_dir && !_sidecar_dir->empty () && _events.size () >= sidecar_min_events) {
+		if (write_sidecar (*node, *_sidecar_dir)) {
+			return *node;
+		}
+	}
+
+	if (_events_cache_generation != events_generation ()) {
+		stringstream str;
+		for (const_iterator xx = _events.begin(); xx != _events.end(); ++xx) {
+			str << PBD::to_string ((*xx)->when);
+			str << ' ';
+			str << PBD::to_string ((*xx)->value);
+			str << '\n';
+		}
+		_events_cache = str.str ();
+		_events_cache_generation = events_generation ();
 	}
 
 	/* XML is a bit weird */
 
 	XMLNode* content_node = new XMLNode (X_("foo")); /* it gets renamed by libxml when we set content */
-	content_node->set_content (str.str());
+	content_node->set_content (_events_cache);
 
 	node->add_child_nocopy (*content_node);
 
 	return *node;
 }
 
+/** Store the events in a sidecar file in @p dir and reference it from
+ * @p node. Called with the list's lock and the cache lock held.
+ * @return false if the file could not be written, the caller then stores
+ * the events inline.
+ */
+bool
+AutomationList::write_sidecar (XMLNode& node, std::string const& dir) const
+{
+	if (_sidecar_generation != events_generation () || !Glib::file_test (Glib::build_filename (dir, _sidecar_name), Glib::FILE_TEST_EXISTS)) {
+
+		const bool beats = time_domain () == Temporal::BeatTime;
+		std::vector<uint8_t> buf (sidecar_header_size + _events.size () * sidecar_event_size);
+		uint8_t* p = &buf[sidecar_header_size];
+
+		for (const_iterator xx = _events.begin(); xx != _events.end(); ++xx) {
+			int64_t when = beats ? (*xx)->when.ticks () : (*xx)->when.superclocks ();
+			double  val  = (*xx)->value;
+			uint64_t bits;
+			memcpy (&bits, &val, sizeof (bits));
+			sidecar_put (p, (uint64_t) when);
+			sidecar_put (p + 8, bits);
+			p += sidecar_event_size;
+		}
+
+		const uint64_t checksum = sidecar_checksum (&buf[sidecar_header_size], buf.size () - sidecar_header_size);
+		const uint32_t header[2] = { GUINT32_TO_LE (sidecar_version), GUINT32_TO_LE (beats ? 1 : 0) };
+
+		memcpy (&buf[0], sidecar_magic, sizeof (sidecar_magic));
+		memcpy (&buf[8], header, sizeof (header));
+		sidecar_put (&buf[16], _events.size ());
+		sidecar_put (&buf[24], checksum);
+
+		const std::string name = sidecar_hex (checksum) + X_(".events");
+		const std::string path = Glib::build_filename (dir, name);
+
+		if (!Glib::file_test (path, Glib::FILE_TEST_EXISTS)) {
+			if (g_mkdir_with_parents (dir.c_str (), 0755) < 0) {
+				error << string_compose (_("Could not create automation folder %1 (%2)"), dir, strerror (errno)) << endmsg;
+				return false;
+			}
+
+			/* write to a temporary file first, a session must never
+			 * reference a partially written sidecar
+			 */
+			const std::string tmp_path = path + X_(".tmp");
+			FILE* f = g_fopen (tmp_path.c_str (), "wb");
+			if (!f) {
+				error << string_compose (_("Could not open %1 to store automation data (%2)"), tmp_path, strerror (errno)) << endmsg;
+				return false;
+			}
+			const bool ok = fwrite (&buf[0], 1, buf.size (), f) == buf.size ();
+			if (fclose (f) != 0 || !ok || g_rename (tmp_path.c_str (), path.c_str ()) != 0) {
+				error << string_compose (_("Could not write automation data to %1 (%2)"), path, strerror (errno)) << endmsg;
+				::g_unlink (tmp_path.c_str ());
+				return false;
+			}
+		}
+
+		_sidecar_name       = name;
+		_sidecar_generation = events_generation ();
+	}
+
+	node.set_property (X_("sidecar"), _sidecar_name);
+	node.set_property (X_("count"), (uint64_t) _events.size ());
+
+	return true;
+}
+
+/** Map the sidecar file at @p path and validate its header against the
+ * @p name and @p count it is referenced by. The payload checksum is only
+ * verified if @p verify is set, i.e. when the events are decoded.
+ * @return the mapped file or NULL
+ */
+static GMappedFile*
+map_sidecar (std::string const& path, std::string const& name, uint64_t count, bool verify, bool& beats)
+{
+	GError* err = 0;
+	GMappedFile* mf = g_mapped_file_new (path.c_str (), false, &err);
+
+	if (!mf) {
+		error << string_compose (_("automation list: cannot open %1 (%2)"), path, err ? err->message : "") << endmsg;
+		if (err) {
+			g_error_free (err);
+		}
+		return 0;
+	}
+
+	uint8_t const* data = (uint8_t const*) g_mapped_file_get_contents (mf);
+	const size_t   size = g_mapped_file_get_length (mf);
+	bool           ok   = false;
+
+	if (size >= sidecar_header_size && memcmp (data, sidecar_magic, sizeof (sidecar_magic)) == 0) {
+		uint32_t header[2];
+		memcpy (header, data + 8, sizeof (header));
+		const uint64_t n_events = sidecar_get (data + 16);
+		const uint64_t checksum = sidecar_get (data + 24);
+		beats = GUINT32_FROM_LE (header[1]) == 1;
+
+		ok = GUINT32_FROM_LE (header[0]) == sidecar_version
+			&& n_events == count
+			&& size == sidecar_header_size + n_events * sidecar_event_size
+			&& name == sidecar_hex (checksum) + X_(".events")
+			&& (!verify || checksum == sidecar_checksum (data + sidecar_header_size, size - sidecar_header_size));
+	}
+
+	if (!ok) {
+		g_mapped_file_unref (mf);
+		error << string_compose (_("automation list: %1 is damaged, all points ignored"), path) << endmsg;
+		return 0;
+	}
+
+	return mf;
+}
+
+/** Reference the sidecar file named by @p node. Unless the list may be
+ * evaluated by the process thread right away, the events are only
+ * decoded when the list is first used, see ::load_deferred_events().
+ */
+int
+AutomationList::read_sidecar (XMLNode const& node)
+{
+	std::string name;
+	uint64_t    count = 0;
+
+	node.get_property (X_("sidecar"), name);
+	node.get_property (X_("count"), count);
+
+	if (!_sidecar_dir || _sidecar_dir->empty ()) {
+		error << string_compose (_("automation list: no folder to load event data from %1"), name) << endmsg;
+		return -1;
+	}
+
+	const std::string path = Glib::build_filename (*_sidecar_dir, name);
+	bool beats = false;
+
+	GMappedFile* mf = map_sidecar (path, name, count, false, beats);
+	if (!mf) {
+		return -1;
+	}
+	g_mapped_file_unref (mf);
+
+	ControlList::freeze ();
+	clear ();
+
+	_deferred_path = path;
+	_deferred_size = count;
+	_events_deferred.store (true, std::memory_order_release);
+
+	/* region gain envelope and fades are used by the process thread
+	 * regardless of automation state. */
+	const bool rt_use = automation_playback ()
+		|| _parameter.type () == EnvelopeAutomation
+		|| _parameter.type () == FadeInAutomation
+		|| _parameter.type () == FadeOutAutomation;
+
+	if (rt_use) {
+		ensure_events ();
+	}
+
+	maybe_signal_changed ();
+	thaw ();
+
+	/* the file on disk matches the list, no need to write it again */
+	Glib::Threads::Mutex::Lock cl (_events_cache_lock);
+	_sidecar_name       = name;
+	_sidecar_generation = events_generation ();
+
+	return 0;
+}
+
+void
+AutomationList::load_deferred_events () const
+{
+	Glib::Threads::Mutex::Lock lm (_deferred_lock);
+
+	if (!_events_deferred.load (std::memory_order_acquire)) {
+		/* loaded by another thread meanwhile */
+		return;
+	}
+
+	DEBUG_TRACE (DEBUG::Automation, string_compose ("%1: loading %2 deferred events from %3\n", this, _deferred_size, _deferred_path));
+
+	/* Nothing could have used the (empty) event list yet, all access
+	 * goes through ensure_events(). _events is filled directly, calling
+	 * any ControlList method here would recurse.
+	 */
+	AutomationList* self = const_cast<AutomationList*> (this);
+	const std::string name = Glib::path_get_basename (_deferred_path);
+	bool beats = false;
+
+	GMappedFile* mf = map_sidecar (_deferred_path, name, _deferred_size, true, beats);
+
+	if (mf) {
+		uint8_t const* data = (uint8_t const*) g_mapped_file_get_contents (mf);
+		const size_t   size = g_mapped_file_get_length (mf);
+
+		for (uint8_t const* p = data + sidecar_header_size; p < data + size; p += sidecar_event_size) {
+			const int64_t  when = (int64_t) sidecar_get (p);
+			const uint64_t bits = sidecar_get (p + 8);
+			double y;
+			memcpy (&y, &bits, sizeof (y));
+			y = std::min ((double)_desc.upper, std::max ((double)_desc.lower, y));
+			self->_events.push_back (new Evoral::ControlEvent (beats ? timepos_t::from_ticks (when) : timepos_t::from_superclock (when), y));
+		}
+
+		g_mapped_file_unref (mf);
+	}
+
+	/* lookup caches still point to end(), which remains valid. The
+	 * generation is left alone, the events did not change.
+	 */
+	_events_deferred.store (false, std::memory_order_release);
+}
+
+int
+AutomationList::inline_sidecar_events (XMLNode& node, std::string const& dir)
+{
+	int failed = 0;
+
+	if (node.name () == X_("events") && node.property (X_("sidecar"))) {
+		std::string name;
+		uint64_t    count = 0;
+		bool        beats = false;
+
+		node.get_property (X_("sidecar"), name);
+		node.get_property (X_("count"), count);
+
+		GMappedFile* mf = map_sidecar (Glib::build_filename (dir, name), name, count, true, beats);
+
+		if (!mf) {
+			return 1;
+		}
+
+		uint8_t const* data = (uint8_t const*) g_mapped_file_get_contents (mf);
+		const size_t   size = g_mapped_file_get_length (mf);
+
+		stringstream str;
+		for (uint8_t const* p = data + sidecar_header_size; p < data + size; p += sidecar_event_size) {
+			const int64_t  when = (int64_t) sidecar_get (p);
+			const uint64_t bits = sidecar_get (p + 8);
+			double y;
+			memcpy (&y, &bits, sizeof (y));
+			str << PBD::to_string (beats ? timepos_t::from_ticks (when) : timepos_t::from_superclock (when));
+			str << ' ';
+			str << PBD::to_string (y);
+			str << '\n';
+		}
+
+		g_mapped_file_unref (mf);
+
+		node.remove_property (X_("sidecar"));
+		node.remove_property (X_("count"));
+
+		XMLNode* content_node = new XMLNode (X_("foo"));
+		content_node->set_content (str.str ());
+		node.add_child_nocopy (*content_node);
+
+		return 0;
+	}
+
+	XMLNodeList const& children (node.children ());
+	for (XMLNodeConstIterator i = children.begin (); i != children.end (); ++i) {
+		failed += inline_sidecar_events (**i, dir);
+	}
+
+	return failed;
+}
+
 int
 AutomationList::deserialize_events (const XMLNode& node)
 {
+	if (node.property (X_("sidecar"))) {
+		return read_sidecar (node);
+	}
+
 	if (node.children().empty()) {
 		return -1;
 	}
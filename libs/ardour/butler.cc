@@ -358,6 +358,7 @@ Butler::thread_work ()
 		DEBUG_TRACE (DEBUG::Butler, "butler emptying pool trash\n");
 		empty_pool_trash ();
 		process_delegated_work ();
+		_session.reclaim_rcu ();
 	}
 
 	return (0);
@@ -38,6 +38,14 @@ CapturingProcessor::~CapturingProcessor()
 {
 }
 
+void
+CapturingProcessor::set_latency (samplecnt_t latency)
+{
+	_latency = latency;
+	_delaybuffers.set (_configured_output, _latency);
+	_delaybuffers.flush ();
+}
+
 int
 CapturingProcessor::set_block_size (pframes_t nframes)
 {
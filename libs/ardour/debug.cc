@@ -66,6 +66,7 @@ PBD::DebugBits PBD::DEBUG::LaunchControlXL = PBD::new_debug_bit("launchcontrolxl
 PBD::DebugBits PBD::DEBUG::Launchpad = PBD::new_debug_bit ("launchpad");
 PBD::DebugBits PBD::DEBUG::Launchkey = PBD::new_debug_bit ("launchkey");
 PBD::DebugBits PBD::DEBUG::Layering = PBD::new_debug_bit ("layering");
+PBD::DebugBits PBD::DEBUG::LoadState = PBD::new_debug_bit ("loadstate");
 PBD::DebugBits PBD::DEBUG::MIDISurface = PBD::new_debug_bit ("midisurface");
 PBD::DebugBits PBD::DEBUG::MTC = PBD::new_debug_bit ("mtc");
 PBD::DebugBits PBD::DEBUG::MackieControl = PBD::new_debug_bit ("mackiecontrol");
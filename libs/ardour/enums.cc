@@ -69,6 +69,7 @@ setup_enum_writer ()
 	AlignChoice _AlignChoice;
 	MeterPoint _MeterPoint;
 	DiskIOPoint _DiskIOPoint;
+	ExportTapPoint _ExportTapPoint;
 	MeterType _MeterType;
 	TrackMode _TrackMode;
 	RecordMode _RecordMode;
@@ -251,6 +252,11 @@ setup_enum_writer ()
 	REGISTER_ENUM (DiskIOCustom);
 	REGISTER (_DiskIOPoint);
 
+	REGISTER_ENUM (ExportTapPlayback);
+	REGISTER_ENUM (ExportTapPreFader);
+	REGISTER_ENUM (ExportTapPostFader);
+	REGISTER (_ExportTapPoint);
+
 	REGISTER_ENUM (MeterMaxSignal);
 	REGISTER_ENUM (MeterMaxPeak);
 	REGISTER_ENUM (MeterPeak);
@@ -719,6 +725,9 @@ setup_enum_writer ()
 	REGISTER_CLASS_ENUM (ExportFormatBase, SRC_SincFast);
 	REGISTER_CLASS_ENUM (ExportFormatBase, SRC_ZeroOrderHold);
 	REGISTER_CLASS_ENUM (ExportFormatBase, SRC_Linear);
+	REGISTER_CLASS_ENUM (ExportFormatBase, SRC_ZitaBest);
+	REGISTER_CLASS_ENUM (ExportFormatBase, SRC_ZitaGood);
+	REGISTER_CLASS_ENUM (ExportFormatBase, SRC_ZitaFast);
 	REGISTER (_ExportFormatBase_SRCQuality);
 
 	REGISTER_CLASS_ENUM (ExportProfileManager, Timecode);
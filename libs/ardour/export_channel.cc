@@ -32,6 +32,7 @@
 #include "ardour/export_failed.h"
 #include "ardour/midi_port.h"
 #include "ardour/session.h"
+#include "ardour/types_convert.h"
 
 #include "pbd/error.h"
 
@@ -351,10 +352,12 @@ RegionExportChannelFactory::update_buffers (samplecnt_t samples)
 RouteExportChannel::RouteExportChannel (std::shared_ptr<CapturingProcessor> processor,
                                         DataType                            type,
                                         size_t                              channel,
+                                        ExportTapPoint                      tap,
                                         std::shared_ptr<ProcessorRemover>   remover)
 	: _processor (processor)
 	, _type (type)
 	, _channel (channel)
+	, _tap (tap)
 	, _remover (remover)
 {
 }
@@ -364,9 +367,9 @@ RouteExportChannel::~RouteExportChannel ()
 }
 
 void
-RouteExportChannel::create_from_route (std::list<ExportChannelPtr>& result, std::shared_ptr<Route> route)
+RouteExportChannel::create_from_route (std::list<ExportChannelPtr>& result, std::shared_ptr<Route> route, ExportTapPoint tap)
 {
-	std::shared_ptr<CapturingProcessor> processor = route->add_export_point ();
+	std::shared_ptr<CapturingProcessor> processor = route->add_export_point (tap);
 	uint32_t                            n_audio   = processor->input_streams ().n_audio ();
 	uint32_t                            n_midi    = processor->input_streams ().n_midi ();
 
@@ -375,10 +378,10 @@ RouteExportChannel::create_from_route (std::list<ExportChannelPtr>& result, std:
 	std::shared_ptr<ProcessorRemover> remover (new ProcessorRemover (route, processor));
 	result.clear ();
 	for (uint32_t i = 0; i < n_audio; ++i) {
-		result.push_back (ExportChannelPtr (new RouteExportChannel (processor, DataType::AUDIO, i, remover)));
+		result.push_back (ExportChannelPtr (new RouteExportChannel (processor, DataType::AUDIO, i, tap, remover)));
 	}
 	for (uint32_t i = 0; i < n_midi; ++i) {
-		result.push_back (ExportChannelPtr (new RouteExportChannel (processor, DataType::MIDI, i, remover)));
+		result.push_back (ExportChannelPtr (new RouteExportChannel (processor, DataType::MIDI, i, tap, remover)));
 	}
 }
 
@@ -398,9 +401,12 @@ RouteExportChannel::create_from_state (std::list<ExportChannelPtr>& result, Sess
 	if (!xml_route->get_property ("id", rid)) {
 		return;
 	}
+	ExportTapPoint tap = ExportTapPlayback;
+	xml_route->get_property ("tap", tap);
+
 	std::shared_ptr<Route> rt = s.route_by_id (rid);
 	if (rt) {
-		create_from_route (result, rt);
+		create_from_route (result, rt, tap);
 	}
 }
 
@@ -437,6 +443,7 @@ RouteExportChannel::get_state (XMLNode* node) const
 {
 	XMLNode* n = node->add_child ("Route");
 	n->set_property ("id", route()->id ().to_s ());
+	n->set_property ("tap", _tap);
 }
 
 void
@@ -43,9 +43,11 @@
 #include "audiographer/general/limiter.h"
 #include "audiographer/general/normalizer.h"
 #include "audiographer/general/analyser.h"
+#include "audiographer/general/async_sink.h"
 #include "audiographer/general/peak_reader.h"
 #include "audiographer/general/loudness_reader.h"
 #include "audiographer/general/sample_format_converter.h"
+#include "audiographer/general/sample_store.h"
 #include "audiographer/general/sr_converter.h"
 #include "audiographer/general/silence_trimmer.h"
 #include "audiographer/general/threader.h"
@@ -62,6 +64,7 @@
 #include "ardour/export_graph_builder.h"
 #include "ardour/export_timespan.h"
 #include "ardour/filesystem_paths.h"
+#include "ardour/rc_configuration.h"
 #include "ardour/session_directory.h"
 #include "ardour/session_metadata.h"
 #include "ardour/sndfile_helpers.h"
@@ -71,15 +74,19 @@ using namespace AudioGrapher;
 using std::string;
 
 /*
- * The Export Graph is evaluated for each Timespan.
+ * The Export Graph is evaluated for each Timespan, overlapping
+ * Timespans are evaluated together in a single pass over their union.
  *
- *  - The Graph has at least one ChannelConfig
+ *  - The Graph has at least one ChannelConfig per Timespan,
+ *    each only receives data within its Timespan.
  *  - Each ChannnelConfig has at least one SilenceHandler.
  *  - Each SilenceHandler feeds at least one SRC.
  *  - Each SRC feeds at least one Intermediate or one SFC
  *    Intermediates and SFC children are processed sequentally.
  *  - Each Intermediate (tmp-file) runs SFC children in parallel.
  *  - Each SFC feeds at least one Encoder.
+ *  - Each Encoder queues data for its writer, which runs in a
+ *    dedicated thread. The queues are drained during post-processing.
  *
  *
  * [process callback]
@@ -145,6 +152,10 @@ using std::string;
  *      v
  * {   Encoder
  * |    |
+ * |    \-> Async Sink (queue, writer thread)
+ * |                |
+ * |    /-----------/
+ * |    |
  * |    \---+------or-------+-------or------\
  * |        v               v                v
  * |     Int Writer    Float Writer      Pipe Writer
@@ -157,6 +168,9 @@ namespace ARDOUR {
 
 ExportGraphBuilder::ExportGraphBuilder (Session const & session)
 	: session (session)
+	, normalize_analysis_used (0)
+	, _normalize_pass (SinglePass)
+	, _store_bytes (0)
 	, thread_pool (hardware_concurrency())
 {
 	process_buffer_samples = session.engine().samples_per_cycle();
@@ -167,7 +181,7 @@ ExportGraphBuilder::~ExportGraphBuilder ()
 }
 
 samplecnt_t
-ExportGraphBuilder::process (samplecnt_t samples, bool last_cycle)
+ExportGraphBuilder::process (samplepos_t pos, samplecnt_t samples)
 {
 	assert(samples <= process_buffer_samples);
 
@@ -191,18 +205,60 @@ ExportGraphBuilder::process (samplecnt_t samples, bool last_cycle)
 		MidiBuffer const*  mb;
 		if (ab) {
 			Sample const* process_buffer = ab->data ();
-			ConstProcessContext<Sample> context(&process_buffer[off], samples - off, 1);
-			if (last_cycle) { context().set_flag (ProcessContext<Sample>::EndOfInput); }
-			it->second->process (context);
+			it->second->process (&process_buffer[off], pos, samples - off);
 		}
 		if  ((mb = dynamic_cast<MidiBuffer const*> (buf))) {
-			it->second->process (*mb, off, samples - off, last_cycle);
+			it->second->process (*mb, pos, off, samples - off);
 		}
 	}
 
 	return samples - off;
 }
 
+/* AnyExport */
+
+ExportGraphBuilder::AnyExport::SpanPtr
+ExportGraphBuilder::AnyExport::span (std::shared_ptr<ExportTimespan> ts)
+{
+	SpanMap::iterator i = spans.find (ts);
+	if (i == spans.end ()) {
+		i = spans.insert (std::make_pair (ts, SpanPtr (new Span (ts->get_start (), ts->get_end ())))).first;
+	}
+	return i->second;
+}
+
+void
+ExportGraphBuilder::AnyExport::process (Sample const* data, samplepos_t pos, samplecnt_t cnt)
+{
+	for (SpanMap::const_iterator i = spans.begin (); i != spans.end (); ++i) {
+		Span& s (*i->second);
+		samplepos_t const from = std::max (pos, s.start);
+		samplepos_t const to   = std::min (pos + cnt, s.end);
+		if (to <= from) {
+			continue;
+		}
+		ConstProcessContext<Sample> context (&data[from - pos], to - from, 1);
+		if (to == s.end) {
+			context().set_flag (ProcessContext<Sample>::EndOfInput);
+		}
+		s.audio.process (context);
+	}
+}
+
+void
+ExportGraphBuilder::AnyExport::process (MidiBuffer const& buf, samplepos_t pos, sampleoffset_t off, samplecnt_t cnt)
+{
+	for (SpanMap::const_iterator i = spans.begin (); i != spans.end (); ++i) {
+		Span& s (*i->second);
+		samplepos_t const from = std::max (pos, s.start);
+		samplepos_t const to   = std::min (pos + cnt, s.end);
+		if (to <= from) {
+			continue;
+		}
+		s.midi.process (buf, off + from - pos, to - from, to == s.end);
+	}
+}
+
 bool
 ExportGraphBuilder::post_process ()
 {
@@ -214,7 +270,30 @@ ExportGraphBuilder::post_process ()
 		}
 	}
 
-	return intermediates.empty();
+	if (!intermediates.empty()) {
+		return false;
+	}
+
+	/* wait for encoders to catch up, without stalling the
+	 * freewheeling process callback for too long.
+	 */
+	for (std::list<EncoderQueuePtr>::const_iterator it = encoder_queues.begin(); it != encoder_queues.end(); ++it) {
+		if (!(*it)->wait (10000)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool
+ExportGraphBuilder::encoding () const
+{
+	for (std::list<EncoderQueuePtr>::const_iterator it = encoder_queues.begin(); it != encoder_queues.end(); ++it) {
+		if (!(*it)->idle ()) {
+			return true;
+		}
+	}
+	return false;
 }
 
 unsigned
@@ -224,9 +303,35 @@ ExportGraphBuilder::get_postprocessing_cycle_count() const
 	for (std::list<Intermediate *>::const_iterator it = intermediates.begin(); it != intermediates.end(); ++it) {
 		max = std::max(max, (*it)->get_postprocessing_cycle_count());
 	}
+	return max + get_encoder_backlog ();
+}
+
+unsigned
+ExportGraphBuilder::get_encoder_backlog () const
+{
+	unsigned max = 0;
+	for (std::list<EncoderQueuePtr>::const_iterator it = encoder_queues.begin(); it != encoder_queues.end(); ++it) {
+		max = std::max (max, (*it)->stats ().queued);
+	}
 	return max;
 }
 
+void
+ExportGraphBuilder::get_encoder_status (std::vector<ExportStatus::EncoderStatus>& status) const
+{
+	status.clear ();
+	for (std::list<EncoderQueuePtr>::const_iterator it = encoder_queues.begin(); it != encoder_queues.end(); ++it) {
+		AsyncSinkBase::Stats s ((*it)->stats ());
+		ExportStatus::EncoderStatus es;
+		es.name       = (*it)->name ();
+		es.samples    = s.samples;
+		es.throughput = s.throughput ();
+		es.queued     = s.queued;
+		es.queue_size = s.queue_size;
+		status.push_back (es);
+	}
+}
+
 void
 ExportGraphBuilder::reset ()
 {
@@ -234,10 +339,29 @@ ExportGraphBuilder::reset ()
 	channel_configs.clear ();
 	channels.clear ();
 	intermediates.clear ();
+	encoder_queues.clear ();
 	analysis_map.clear();
 	_exported_files.clear();
 	_realtime = false;
 	_master_align = 0;
+	_store_bytes = 0;
+}
+
+void
+ExportGraphBuilder::set_normalize_pass (NormalizePass pass)
+{
+	switch (pass) {
+		case AnalysisPass:
+			normalize_analysis.clear ();
+			break;
+		case RenderPass:
+			break;
+		case SinglePass:
+			normalize_analysis.clear ();
+			break;
+	}
+	normalize_analysis_used = 0;
+	_normalize_pass = pass;
 }
 
 void
@@ -342,36 +466,53 @@ ExportGraphBuilder::add_split_config (FileSpec const & config)
 
 /* Encoder */
 
+ExportGraphBuilder::Encoder::~Encoder ()
+{
+	if (_queue) {
+		_queue->stop ();
+	}
+}
+
+template<typename T>
+std::shared_ptr<AudioGrapher::Sink<T> >
+ExportGraphBuilder::Encoder::init_queue (std::shared_ptr<AudioGrapher::Sink<T> > writer, samplecnt_t max_samples)
+{
+	std::shared_ptr<AsyncSink<T> > queue (new AsyncSink<T> (max_samples, 8, Glib::path_get_basename (writer_filename), config.channel_config->get_n_chans ()));
+	queue->add_output (writer);
+	_queue = queue;
+	return queue;
+}
+
 template <>
 std::shared_ptr<AudioGrapher::Sink<Sample> >
-ExportGraphBuilder::Encoder::init (FileSpec const & new_config)
+ExportGraphBuilder::Encoder::init (FileSpec const & new_config, samplecnt_t max_samples)
 {
 	config = new_config;
 	if (config.format->format_id() == ExportFormatBase::F_FFMPEG) {
 		init_writer (pipe_writer);
-		return pipe_writer;
+		return init_queue<Sample> (pipe_writer, max_samples);
 	} else {
 		init_writer (float_writer);
-		return float_writer;
+		return init_queue<Sample> (float_writer, max_samples);
 	}
 }
 
 template <>
 std::shared_ptr<AudioGrapher::Sink<int> >
-ExportGraphBuilder::Encoder::init (FileSpec const & new_config)
+ExportGraphBuilder::Encoder::init (FileSpec const & new_config, samplecnt_t max_samples)
 {
 	config = new_config;
 	init_writer (int_writer);
-	return int_writer;
+	return init_queue<int> (int_writer, max_samples);
 }
 
 template <>
 std::shared_ptr<AudioGrapher::Sink<short> >
-ExportGraphBuilder::Encoder::init (FileSpec const & new_config)
+ExportGraphBuilder::Encoder::init (FileSpec const & new_config, samplecnt_t max_samples)
 {
 	config = new_config;
 	init_writer (short_writer);
-	return short_writer;
+	return init_queue<short> (short_writer, max_samples);
 }
 
 void
@@ -383,6 +524,11 @@ ExportGraphBuilder::Encoder::add_child (FileSpec const & new_config)
 void
 ExportGraphBuilder::Encoder::destroy_writer (bool delete_out_file)
 {
+	if (_queue) {
+		/* discard pending data, the writer must not be used concurrently */
+		_queue->stop ();
+	}
+
 	if (delete_out_file ) {
 
 		if (float_writer) {
@@ -573,10 +719,10 @@ ExportGraphBuilder::Encoder::copy_files (std::string orig_path)
 /* SFC */
 
 ExportGraphBuilder::SFC::SFC (ExportGraphBuilder &parent, FileSpec const & new_config, samplecnt_t max_samples)
-	: data_width(0)
+	: parent (parent)
+	, max_samples_out (0)
 {
 	config = new_config;
-	data_width = sndfile_data_width (Encoder::get_real_format (config));
 	unsigned channels = new_config.channel_config->get_n_chans();
 	_analyse = config.format->analyse();
 
@@ -612,12 +758,6 @@ ExportGraphBuilder::SFC::SFC (ExportGraphBuilder &parent, FileSpec const & new_c
 		intermediate = analyser;
 	}
 
-	if (config.format->format_id() == ExportFormatBase::F_None) {
-		/* do not encode result, stop after chunker/analyzer */
-		assert (_analyse || !parent.timespan->vapor().empty());
-		return;
-	}
-
 	if (config.format->demo_noise_duration () > 0 && config.format->demo_noise_interval () > 0) {
 		samplecnt_t sample_rate = parent.session.nominal_sample_rate();
 		demo_noise_adder.reset (new DemoNoiseAdder (channels));
@@ -630,23 +770,16 @@ ExportGraphBuilder::SFC::SFC (ExportGraphBuilder &parent, FileSpec const & new_c
 		intermediate = demo_noise_adder;
 	}
 
-	if (data_width == 8 || data_width == 16) {
-		short_converter = ShortConverterPtr (new SampleFormatConverter<short> (channels));
-		short_converter->init (max_samples, config.format->dither_type(), data_width);
-		add_child (config);
-		intermediate->add_output (short_converter);
-	} else if (data_width == 24 || data_width == 32) {
-		int_converter = IntConverterPtr (new SampleFormatConverter<int> (channels));
-		int_converter->init (max_samples, config.format->dither_type(), data_width);
-		add_child (config);
-		intermediate->add_output (int_converter);
-	} else {
-		int actual_data_width = 8 * sizeof(Sample);
-		float_converter = FloatConverterPtr (new SampleFormatConverter<Sample> (channels));
-		float_converter->init (max_samples, config.format->dither_type(), actual_data_width);
-		add_child (config);
-		intermediate->add_output (float_converter);
+	max_samples_out  = max_samples;
+	converter_source = intermediate;
+
+	if (config.format->format_id() == ExportFormatBase::F_None) {
+		/* do not encode result, stop after chunker/analyzer */
+		assert (_analyse || !parent.timespan->vapor().empty());
+		return;
 	}
+
+	add_encoder (config);
 }
 
 void
@@ -699,6 +832,25 @@ ExportGraphBuilder::SFC::sink ()
 
 void
 ExportGraphBuilder::SFC::add_child (FileSpec const & new_config)
+{
+	/* another file fed by the same normalizer/limiter/analyser */
+	new_config.filename->set_channel_config (new_config.channel_config);
+	std::string const fn = new_config.filename->get_path (new_config.format);
+	parent.add_export_fn (fn);
+
+	if (_analyse && new_config.format->analyse ()) {
+		parent.add_analyser (fn, analyser);
+	}
+
+	if (new_config.format->format_id() == ExportFormatBase::F_None) {
+		return;
+	}
+
+	add_encoder (new_config);
+}
+
+void
+ExportGraphBuilder::SFC::add_encoder (FileSpec const & new_config)
 {
 	for (boost::ptr_list<Encoder>::iterator it = children.begin(); it != children.end(); ++it) {
 		if (*it == new_config) {
@@ -710,13 +862,38 @@ ExportGraphBuilder::SFC::add_child (FileSpec const & new_config)
 	children.push_back (new Encoder());
 	Encoder & encoder = children.back();
 
+	unsigned const channels = config.channel_config->get_n_chans();
+	int const data_width = sndfile_data_width (Encoder::get_real_format (new_config));
+	ConverterKey const key (data_width, new_config.format->dither_type());
+
 	if (data_width == 8 || data_width == 16) {
-		short_converter->add_output (encoder.init<short> (new_config));
+		ShortConverterPtr& converter (short_converters[key]);
+		if (!converter) {
+			converter.reset (new SampleFormatConverter<short> (channels));
+			converter->init (max_samples_out, key.second, data_width);
+			converter_source->add_output (converter);
+		}
+		converter->add_output (encoder.init<short> (new_config, max_samples_out));
 	} else if (data_width == 24 || data_width == 32) {
-		int_converter->add_output (encoder.init<int> (new_config));
+		IntConverterPtr& converter (int_converters[key]);
+		if (!converter) {
+			converter.reset (new SampleFormatConverter<int> (channels));
+			converter->init (max_samples_out, key.second, data_width);
+			converter_source->add_output (converter);
+		}
+		converter->add_output (encoder.init<int> (new_config, max_samples_out));
 	} else {
-		float_converter->add_output (encoder.init<Sample> (new_config));
+		FloatConverterPtr& converter (float_converters[key]);
+		if (!converter) {
+			int actual_data_width = 8 * sizeof(Sample);
+			converter.reset (new SampleFormatConverter<Sample> (channels));
+			converter->init (max_samples_out, key.second, actual_data_width);
+			converter_source->add_output (converter);
+		}
+		converter->add_output (encoder.init<Sample> (new_config, max_samples_out));
 	}
+
+	parent.add_encoder_queue (encoder.queue ());
 }
 
 void
@@ -739,22 +916,21 @@ ExportGraphBuilder::SFC::operator== (FileSpec const& other_config) const
 	ExportFormatSpecification const& a = *config.format;
 	ExportFormatSpecification const& b = *other_config.format;
 
-	bool id;
-	if (a.analyse () || b.analyse ()) {
-		/* Show dedicated analysis result for files with different
-		 * quality or wav/bwav. This adds a dedicated SFC for each
-		 * format, rater than only running dedicated Encoders as
-		 * childs of of the same SFC.
-		 */
-		id = a == b;
-	} else {
-		/* delegate disambiguation to Encoder::operator== */
-		id = a.sample_format() == b.sample_format();
+	/* The analyser sits before dither and sample-format conversion, so
+	 * all files with the same normalization, limiter and demo-noise
+	 * settings see identical samples and share a single analysis.
+	 * Converters and Encoders are disambiguated in add_encoder ().
+	 */
+	if (b.analyse () && !_analyse) {
+		return false;
 	}
 
+	bool id = true;
+
 	if (a.normalize_loudness () == b.normalize_loudness ()) {
 		id &= a.normalize_lufs () == b.normalize_lufs ();
 		id &= a.normalize_dbtp () == b.normalize_dbtp ();
+		id &= a.use_tp_limiter () == b.use_tp_limiter ();
 	} else {
 		return false;
 	}
@@ -777,22 +953,87 @@ ExportGraphBuilder::Intermediate::Intermediate (ExportGraphBuilder & parent, Fil
 	, use_loudness (false)
 	, use_peak (false)
 {
-	std::string tmpfile_path = parent.session.session_directory().export_path();
-	tmpfile_path = Glib::build_filename(tmpfile_path, "XXXXXX");
-	std::vector<char> tmpfile_path_buf(tmpfile_path.size() + 1);
-	std::copy(tmpfile_path.begin(), tmpfile_path.end(), tmpfile_path_buf.begin());
-	tmpfile_path_buf[tmpfile_path.size()] = '\0';
-
 	config = new_config;
 	uint32_t const channels = config.channel_config->get_n_chans();
 	max_samples_out = 4086 - (4086 % channels); // TODO good chunk size
 
+	switch (parent._normalize_pass) {
+		case AnalysisPass:
+			peak_reader.reset (new PeakReader ());
+			loudness_reader.reset (new LoudnessReader (config.format->sample_rate(), channels, max_samples));
+			peak_reader->add_output (loudness_reader);
+			{
+				NormalizeAnalysis na;
+				na.peak_reader     = peak_reader;
+				na.loudness_reader = loudness_reader;
+				parent.normalize_analysis.push_back (na);
+			}
+			/* only analyze, no children */
+			add_child (new_config);
+			return;
+		case RenderPass:
+			if (parent.normalize_analysis_used < parent.normalize_analysis.size ()) {
+				NormalizeAnalysis const& na (parent.normalize_analysis[parent.normalize_analysis_used++]);
+				peak_reader     = na.peak_reader;
+				loudness_reader = na.loudness_reader;
+				threader.reset (new Threader<Sample> (parent.thread_pool));
+				add_child (new_config);
+				return;
+			}
+			/* graph does not match the analysis pass, post-process as usual */
+			break;
+		case SinglePass:
+			break;
+	}
+
 	buffer.reset (new AllocatingProcessContext<Sample> (max_samples_out, channels));
 
 	peak_reader.reset (new PeakReader ());
 	loudness_reader.reset (new LoudnessReader (config.format->sample_rate(), channels, max_samples));
 	threader.reset (new Threader<Sample> (parent.thread_pool));
 
+	init_store (max_samples);
+
+	add_child (new_config);
+
+	peak_reader->add_output (loudness_reader);
+	if (store) {
+		loudness_reader->add_output (store);
+	} else {
+		loudness_reader->add_output (tmp_file);
+	}
+}
+
+void
+ExportGraphBuilder::Intermediate::init_store (samplecnt_t max_samples)
+{
+	uint32_t const channels = config.channel_config->get_n_chans();
+
+	/* Keep data in memory if the timespan, including added silence, fits the budget.
+	 * Realtime export writes from the process thread and needs a TmpFileRt.
+	 */
+	if (!parent._realtime) {
+		samplecnt_t sample_rate = parent.session.nominal_sample_rate();
+		samplecnt_t sb = config.format->silence_beginning_at (parent.timespan->get_start(), sample_rate);
+		samplecnt_t se = config.format->silence_end_at (parent.timespan->get_end(), sample_rate);
+		samplecnt_t duration = parent.timespan->get_length () + sb + se;
+		double const bytes = ceil (duration * config.format->sample_rate () / (double) sample_rate) * channels * sizeof (Sample);
+
+		if (parent._store_bytes + bytes <= Config->get_export_memory_budget () * 1048576.0) {
+			parent._store_bytes += (size_t) bytes;
+			store.reset (new SampleStore<Sample> (channels));
+			store->InputEnded.connect_same_thread (post_processing_connection,
+			                                       boost::bind (&Intermediate::store_complete, this));
+			return;
+		}
+	}
+
+	std::string tmpfile_path = parent.session.session_directory().export_path();
+	tmpfile_path = Glib::build_filename(tmpfile_path, "XXXXXX");
+	std::vector<char> tmpfile_path_buf(tmpfile_path.size() + 1);
+	std::copy(tmpfile_path.begin(), tmpfile_path.end(), tmpfile_path_buf.begin());
+	tmpfile_path_buf[tmpfile_path.size()] = '\0';
+
 	int format = ExportFormatBase::F_RAW | ExportFormatBase::SF_Float;
 
 	if (parent._realtime) {
@@ -805,20 +1046,20 @@ ExportGraphBuilder::Intermediate::Intermediate (ExportGraphBuilder & parent, Fil
 	                                           boost::bind (&Intermediate::prepare_post_processing, this));
 	tmp_file->FileFlushed.connect_same_thread (post_processing_connection,
 	                                           boost::bind (&Intermediate::start_post_processing, this));
-
-	add_child (new_config);
-
-	peak_reader->add_output (loudness_reader);
-	loudness_reader->add_output (tmp_file);
 }
 
 ExportGraphBuilder::FloatSinkPtr
 ExportGraphBuilder::Intermediate::sink ()
 {
-	if (use_peak) {
+	if (parent._normalize_pass == RenderPass && !buffer) {
+		/* gain is known, encode right away */
+		return threader;
+	} else if (use_peak) {
 		return peak_reader;
 	} else if (use_loudness) {
 		return loudness_reader;
+	} else if (store) {
+		return store;
 	} else {
 		return tmp_file;
 	}
@@ -830,6 +1071,11 @@ ExportGraphBuilder::Intermediate::add_child (FileSpec const & new_config)
 	use_peak     |= new_config.format->normalize ();
 	use_loudness |= new_config.format->normalize_loudness ();
 
+	if (!threader) {
+		/* AnalysisPass */
+		return;
+	}
+
 	for (boost::ptr_list<SFC>::iterator it = children.begin(); it != children.end(); ++it) {
 		if (*it == new_config) {
 			it->add_child (new_config);
@@ -839,6 +1085,24 @@ ExportGraphBuilder::Intermediate::add_child (FileSpec const & new_config)
 
 	children.push_back (new SFC (parent, new_config, max_samples_out));
 	threader->add_output (children.back().sink());
+
+	if (!buffer) {
+		/* RenderPass, the analysis is complete. The analysis pass
+		 * saw the same (silence trimmed) data, as TmpFile would */
+		children.back ().set_duration (loudness_reader->get_samples_read ());
+		apply_analysis (children.back ());
+	}
+}
+
+void
+ExportGraphBuilder::Intermediate::apply_analysis (SFC& sfc)
+{
+	if (use_peak) {
+		sfc.set_peak_dbfs (peak_reader->get_peak());
+	}
+	if (use_loudness) {
+		sfc.set_peak_lufs (*loudness_reader);
+	}
 }
 
 void
@@ -858,17 +1122,28 @@ ExportGraphBuilder::Intermediate::operator== (FileSpec const & other_config) con
 	return true;
 }
 
+samplecnt_t
+ExportGraphBuilder::Intermediate::samples_written () const
+{
+	if (store) {
+		return store->get_samples_written ();
+	} else if (tmp_file) {
+		return tmp_file->get_samples_written ();
+	}
+	return 0;
+}
+
 unsigned
 ExportGraphBuilder::Intermediate::get_postprocessing_cycle_count() const
 {
-	return static_cast<unsigned>(std::ceil(static_cast<float>(tmp_file->get_samples_written()) /
+	return static_cast<unsigned>(std::ceil(static_cast<float>(samples_written ()) /
 	                                       max_samples_out));
 }
 
 bool
 ExportGraphBuilder::Intermediate::process()
 {
-	samplecnt_t samples_read = tmp_file->read (*buffer);
+	samplecnt_t samples_read = store ? store->read (*buffer) : tmp_file->read (*buffer);
 	return samples_read != buffer->samples();
 }
 
@@ -876,23 +1151,35 @@ void
 ExportGraphBuilder::Intermediate::prepare_post_processing()
 {
 	for (boost::ptr_list<SFC>::iterator i = children.begin(); i != children.end(); ++i) {
-		if (use_peak) {
-			(*i).set_peak_dbfs (peak_reader->get_peak());
-		}
-		if (use_loudness) {
-			(*i).set_peak_lufs (*loudness_reader);
-		}
+		apply_analysis (*i);
 	}
 
-	tmp_file->add_output (threader);
+	if (store) {
+		store->add_output (threader);
+	} else {
+		tmp_file->add_output (threader);
+	}
 	parent.intermediates.push_back (this);
 }
 
+void
+ExportGraphBuilder::Intermediate::store_complete ()
+{
+	/* called from the freewheeling process callback */
+	prepare_post_processing ();
+	start_post_processing ();
+}
+
 void
 ExportGraphBuilder::Intermediate::start_post_processing()
 {
 	for (boost::ptr_list<SFC>::iterator i = children.begin(); i != children.end(); ++i) {
-		(*i).set_duration (tmp_file->get_samples_written() / config.channel_config->get_n_chans());
+		(*i).set_duration (samples_written () / config.channel_config->get_n_chans());
+	}
+
+	if (store) {
+		store->rewind ();
+		return;
 	}
 
 	tmp_file->seek (0, SEEK_SET);
@@ -941,7 +1228,7 @@ ExportGraphBuilder::SRC::add_child (FileSpec const & new_config)
 {
 	if (new_config.format->normalize() || parent._realtime) {
 		add_child_to_list (new_config, intermediate_children);
-	} else {
+	} else if (parent._normalize_pass != AnalysisPass) {
 		add_child_to_list (new_config, children);
 	}
 }
@@ -1071,6 +1358,7 @@ ExportGraphBuilder::ChannelConfig::ChannelConfig (ExportGraphBuilder & parent, F
 	typedef ExportChannelConfiguration::ChannelList ChannelList;
 
 	config = new_config;
+	timespan = parent.timespan;
 
 	samplecnt_t max_samples = parent.session.engine().samples_per_cycle();
 	interleaver.reset (new Interleaver<Sample> ());
@@ -1096,15 +1384,15 @@ ExportGraphBuilder::ChannelConfig::ChannelConfig (ExportGraphBuilder & parent, F
 			assert (result_pair.second);
 			map_it = result_pair.first;
 		}
-		if ((*it)->midi ()) {
+		if ((*it)->midi () && parent._normalize_pass != AnalysisPass) {
 			config.filename->set_channel_config(config.channel_config);
 			std::string writer_filename = config.filename->get_path (ExportFormatSpecPtr ()) + ".mid";
-			map_it->second->midi.init (writer_filename, parent.timespan->get_start ());
+			map_it->second->span (timespan)->midi.init (writer_filename, timespan->get_start ());
 			parent.add_export_fn (writer_filename);
 		}
 		if ((*it)->audio ()) {
 			++n_audio;
-			map_it->second->add_output (interleaver->input (chan));
+			map_it->second->span (timespan)->audio.add_output (interleaver->input (chan));
 		}
 	}
 
@@ -1148,7 +1436,8 @@ ExportGraphBuilder::ChannelConfig::remove_children (bool remove_out_files)
 bool
 ExportGraphBuilder::ChannelConfig::operator== (FileSpec const & other_config) const
 {
-	return config.channel_config == other_config.channel_config;
+	/* configs are added for the current timespan */
+	return config.channel_config == other_config.channel_config && timespan == parent.timespan;
 }
 
 } // namespace ARDOUR
@@ -22,6 +22,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
+
 #include "pbd/gstdio_compat.h"
 #include <glibmm.h>
 #include <glibmm/convert.h>
@@ -40,6 +42,7 @@
 #include "ardour/export_status.h"
 #include "ardour/export_format_specification.h"
 #include "ardour/export_filename.h"
+#include "ardour/rc_configuration.h"
 #include "ardour/soundcloud_upload.h"
 #include "ardour/surround_return.h"
 #include "ardour/system_exec.h"
@@ -118,6 +121,7 @@ ExportHandler::ExportHandler (Session & session)
   , graph_builder (new ExportGraphBuilder (session))
   , export_status (session.get_export_status ())
   , post_processing (false)
+  , analysis_pass (false)
   , cue_tracknum (0)
   , cue_indexnum (0)
 {
@@ -204,16 +208,30 @@ ExportHandler::do_export ()
 	/* Count timespans */
 
 	export_status->init();
-	std::set<ExportTimespanPtr> timespan_set;
+	TimespanSet timespan_set;
 	for (ConfigMap::iterator it = config_map.begin(); it != config_map.end(); ++it) {
-		bool new_timespan = timespan_set.insert (it->first).second;
-		if (new_timespan) {
-			export_status->total_samples += it->first->get_length();
+		timespan_set.insert (it->first);
+	}
+
+	/* Count passes, in the same order as start_timespan () */
+	TimespanSet remaining (timespan_set);
+	while (!remaining.empty ()) {
+		TimespanSet pass = overlapping_timespans (*remaining.begin (), remaining);
+		samplepos_t start = (*pass.begin ())->get_start ();
+		samplepos_t end   = (*pass.begin ())->get_end ();
+		samplecnt_t sum   = 0;
+		for (TimespanSet::const_iterator it = pass.begin (); it != pass.end (); ++it) {
+			start = std::min (start, (*it)->get_start ());
+			end   = std::max (end, (*it)->get_end ());
+			sum  += (*it)->get_length ();
+			remaining.erase (*it);
 		}
+		export_status->total_samples += end - start;
+		export_status->saved_samples += sum - (end - start);
+		export_status->total_timespans++;
 	}
-	export_status->total_timespans = timespan_set.size();
 
-	if (export_status->total_timespans > 1) {
+	if (timespan_set.size () > 1) {
 		// always include timespan if there's more than one.
 		for (ConfigMap::iterator it = config_map.begin(); it != config_map.end(); ++it) {
 			FileSpec & spec = it->second;
@@ -224,9 +242,16 @@ ExportHandler::do_export ()
 	/* Start export */
 
 	Glib::Threads::Mutex::Lock l (export_status->lock());
+	analysis_pass = false;
 	return start_timespan ();
 }
 
+struct TimespanSortByStart {
+	bool operator() (ExportTimespanPtr const& a, ExportTimespanPtr const& b) const {
+		return *a < *b;
+	}
+};
+
 int
 ExportHandler::start_timespan ()
 {
@@ -245,12 +270,59 @@ ExportHandler::start_timespan ()
 		return -1;
 	}
 
-	export_status->timespan++;
-
-	/* finish_timespan pops the config_map entry that has been done, so
-	   this is the timespan to do this time
+	/* finish_timespan pops the config_map entries that have been done, so
+	   this is the timespan to do this time, along with all that overlap it
 	*/
-	current_timespan = config_map.begin()->first;
+	TimespanSet remaining;
+	for (ConfigMap::iterator it = config_map.begin(); it != config_map.end(); ++it) {
+		remaining.insert (it->first);
+	}
+	TimespanSet pass = overlapping_timespans (config_map.begin()->first, remaining);
+
+	timespan_configs.clear ();
+	for (ConfigMap::iterator it = config_map.begin(); it != config_map.end(); ++it) {
+		if (pass.find (it->first) != pass.end ()) {
+			timespan_configs.push_back (it);
+		}
+	}
+
+	if (pass.size () == 1) {
+		current_timespan = config_map.begin()->first;
+	} else {
+		/* render the union of all timespans */
+		current_timespan = add_timespan ();
+		samplepos_t start = (*pass.begin ())->get_start ();
+		samplepos_t end   = (*pass.begin ())->get_end ();
+		std::vector<ExportTimespanPtr> spans (pass.begin (), pass.end ());
+		std::sort (spans.begin (), spans.end (), TimespanSortByStart ());
+		std::string name;
+		for (std::vector<ExportTimespanPtr>::const_iterator it = spans.begin (); it != spans.end (); ++it) {
+			start = std::min (start, (*it)->get_start ());
+			end   = std::max (end, (*it)->get_end ());
+			name += (name.empty () ? "" : ", ") + (*it)->name ();
+		}
+		current_timespan->set_range (start, end);
+		current_timespan->set_name (name);
+		current_timespan->set_realtime ((*pass.begin ())->realtime ());
+
+		/* Filenames can be shared across timespans, but here
+		 * several are in use at the same time.
+		 */
+		for (TimespanConfigs::iterator it = timespan_configs.begin(); it != timespan_configs.end(); ++it) {
+			(*it)->second.filename = add_filename_copy ((*it)->second.filename);
+		}
+	}
+
+	if (analysis_pass) {
+		/* the analysis pass of this timespan is complete, render it */
+		analysis_pass = false;
+		graph_builder->set_normalize_pass (ExportGraphBuilder::RenderPass);
+	} else {
+		export_status->timespan++;
+		analysis_pass = use_normalize_prepass ();
+		graph_builder->set_normalize_pass (analysis_pass ? ExportGraphBuilder::AnalysisPass : ExportGraphBuilder::SinglePass);
+		export_status->current_postprocessing_cycle = 0;
+	}
 
 	export_status->total_samples_current_timespan = current_timespan->get_length();
 	export_status->timespan_name = current_timespan->name();
@@ -258,14 +330,12 @@ ExportHandler::start_timespan ()
 
 	/* Register file configurations to graph builder */
 
-	/* Here's the config_map entries that use this timespan */
-	timespan_bounds = config_map.equal_range (current_timespan);
 	graph_builder->reset ();
-	graph_builder->set_current_timespan (current_timespan);
 	handle_duplicate_format_extensions();
 	bool realtime = current_timespan->realtime ();
 	bool region_export = true;
-	for (ConfigMap::iterator it = timespan_bounds.first; it != timespan_bounds.second; ++it) {
+	for (TimespanConfigs::iterator i = timespan_configs.begin(); i != timespan_configs.end(); ++i) {
+		ConfigMap::iterator it = *i;
 		// Filenames can be shared across timespans
 		FileSpec & spec = it->second;
 		spec.filename->set_timespan (it->first);
@@ -276,6 +346,7 @@ ExportHandler::start_timespan ()
 			default:
 				break;
 		}
+		graph_builder->set_current_timespan (it->first);
 		graph_builder->add_config (spec, realtime);
 	}
 
@@ -296,13 +367,86 @@ ExportHandler::start_timespan ()
 	return session.start_audio_export (process_position, realtime, region_export);
 }
 
+bool
+ExportHandler::use_normalize_prepass () const
+{
+	/* Render twice instead of keeping the data for normalization.
+	 * This requires the session to produce identical output on each run,
+	 * which is not given for realtime export or Vapor.
+	 */
+	if (!Config->get_export_normalize_prepass ()) {
+		return false;
+	}
+	if (current_timespan->realtime () || !current_timespan->vapor ().empty ()) {
+		return false;
+	}
+	for (TimespanConfigs::const_iterator it = timespan_configs.begin(); it != timespan_configs.end(); ++it) {
+		if ((*it)->second.format->normalize ()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+ExportHandler::can_merge (ExportTimespanPtr ts) const
+{
+	/* Vapor and region export rely on being the only timespan in the pass */
+	if (!ts->vapor ().empty ()) {
+		return false;
+	}
+	std::pair<ConfigMap::const_iterator, ConfigMap::const_iterator> bounds = config_map.equal_range (ts);
+	for (ConfigMap::const_iterator it = bounds.first; it != bounds.second; ++it) {
+		if (it->second.channel_config->region_processing_type () != RegionExportChannelFactory::None) {
+			return false;
+		}
+	}
+	return true;
+}
+
+ExportHandler::TimespanSet
+ExportHandler::overlapping_timespans (ExportTimespanPtr first, TimespanSet const& candidates) const
+{
+	TimespanSet rv;
+	rv.insert (first);
+
+	if (!Config->get_export_merge_timespans () || !can_merge (first)) {
+		return rv;
+	}
+
+	samplepos_t start = first->get_start ();
+	samplepos_t end   = first->get_end ();
+
+	/* candidates are not sorted by time, repeat until the union no longer grows */
+	bool added;
+	do {
+		added = false;
+		for (TimespanSet::const_iterator it = candidates.begin (); it != candidates.end (); ++it) {
+			ExportTimespanPtr ts = *it;
+			if (rv.find (ts) != rv.end () || ts->realtime () != first->realtime ()) {
+				continue;
+			}
+			if (ts->get_start () >= end || ts->get_end () <= start || !can_merge (ts)) {
+				continue;
+			}
+			rv.insert (ts);
+			start = std::min (start, ts->get_start ());
+			end   = std::max (end, ts->get_end ());
+			added = true;
+		}
+	} while (added);
+
+	return rv;
+}
+
 void
 ExportHandler::handle_duplicate_format_extensions()
 {
 	typedef std::map<std::string, int> ExtCountMap;
 
 	ExtCountMap counts;
-	for (ConfigMap::iterator it = timespan_bounds.first; it != timespan_bounds.second; ++it) {
+	for (TimespanConfigs::iterator i = timespan_configs.begin(); i != timespan_configs.end(); ++i) {
+		ConfigMap::iterator it = *i;
 		std::string pfx;
 		if (it->second.filename->include_timespan) {
 			pfx = it->first->name();
@@ -325,9 +469,9 @@ ExportHandler::handle_duplicate_format_extensions()
 	}
 
 	// Set this always, as the filenames are shared...
-	for (ConfigMap::iterator it = timespan_bounds.first; it != timespan_bounds.second; ++it) {
-		assert (it->second.filename->include_format_name == duplicates_found);
-		it->second.filename->include_format_name = duplicates_found;
+	for (TimespanConfigs::iterator it = timespan_configs.begin(); it != timespan_configs.end(); ++it) {
+		assert ((*it)->second.filename->include_format_name == duplicates_found);
+		(*it)->second.filename->include_format_name = duplicates_found;
 	}
 }
 
@@ -370,10 +514,16 @@ ExportHandler::process_timespan (samplecnt_t samples)
 
 		export_status->stop = true;
 
+		if (analysis_pass) {
+			/* normalization gain is known, export the timespan again */
+			timespan_thread_wakeup ();
+			return 1;
+		}
+
 		/* Start post-processing/normalizing if necessary */
 		post_processing = graph_builder->need_postprocessing ();
 		if (post_processing) {
-			export_status->total_postprocessing_cycles = graph_builder->get_postprocessing_cycle_count();
+			export_status->total_postprocessing_cycles = std::max (1u, graph_builder->get_postprocessing_cycle_count());
 			export_status->current_postprocessing_cycle = 0;
 		} else {
 			finish_timespan ();
@@ -390,35 +540,71 @@ ExportHandler::process_timespan (samplecnt_t samples)
 	}
 
 	/* Do actual processing */
-	samplecnt_t ret = graph_builder->process (samples_to_read, last_cycle);
-	if (ret > 0) {
+	samplecnt_t ret = graph_builder->process (process_position, samples_to_read);
+	if (ret > 0 && analysis_pass) {
+		process_position += ret;
+		export_status->active_job = ExportStatus::Normalizing;
+		export_status->total_postprocessing_cycles = std::max<samplecnt_t> (1, current_timespan->get_length () / samples);
+		export_status->current_postprocessing_cycle++;
+	} else if (ret > 0) {
 		process_position += ret;
 		export_status->processed_samples += ret;
 		export_status->processed_samples_current_timespan += ret;
 	}
 
+	if (!graph_builder->realtime ()) {
+		update_encoder_status ();
+	}
+
 	return 0;
 }
 
 int
 ExportHandler::post_process ()
 {
-	if (graph_builder->post_process ()) {
+	bool finished;
+
+	try {
+		finished = graph_builder->post_process ();
+	} catch (std::exception& e) {
+		error << string_compose (_("Export ended unexpectedly: %1"), e.what ()) << endmsg;
+		export_status->abort (true);
+		return 0;
+	}
+
+	update_encoder_status ();
+
+	if (finished) {
 		finish_timespan ();
 		export_status->active_job = ExportStatus::Exporting;
 	} else {
-		if (graph_builder->realtime ()) {
+		if (graph_builder->realtime () || !graph_builder->normalizing ()) {
 			export_status->active_job = ExportStatus::Encoding;
 		} else {
 			export_status->active_job = ExportStatus::Normalizing;
 		}
 	}
 
-	export_status->current_postprocessing_cycle++;
+	if (graph_builder->normalizing ()) {
+		export_status->current_postprocessing_cycle++;
+	} else {
+		/* waiting for encoders to drain their queues */
+		uint32_t total   = export_status->total_postprocessing_cycles;
+		uint32_t backlog = std::min<uint32_t> (total, graph_builder->get_encoder_backlog ());
+		export_status->current_postprocessing_cycle = std::max<uint32_t> (export_status->current_postprocessing_cycle, total - backlog);
+	}
 
 	return 0;
 }
 
+void
+ExportHandler::update_encoder_status ()
+{
+	std::vector<ExportStatus::EncoderStatus> status;
+	graph_builder->get_encoder_status (status);
+	export_status->set_encoder_status (status);
+}
+
 void
 ExportHandler::command_output(std::string output, size_t size)
 {
@@ -440,36 +626,37 @@ ExportHandler::finish_timespan ()
 	 * take that into account.
 	 */
 	for (auto const& f : graph_builder->exported_files ()) {
-		Session::Exported (current_timespan->name(), f, config_map.begin()->second.format->reimport(), current_timespan->get_start ()); /* EMIT SIGNAL */
+		Session::Exported (f.timespan->name(), f.path, timespan_configs.front()->second.format->reimport(), f.timespan->get_start ()); /* EMIT SIGNAL */
 	}
 
-	while (config_map.begin() != timespan_bounds.second) {
+	for (TimespanConfigs::iterator i = timespan_configs.begin(); i != timespan_configs.end(); ++i) {
 
 		// XXX single timespan+format may produce multiple files
 		// e.g export selection == session
 		// -> TagLib::FileRef is null
 
-		FileSpec& config = config_map.begin()->second;
+		ExportTimespanPtr timespan = (*i)->first;
+		FileSpec& config = (*i)->second;
 		ExportFormatSpecPtr fmt = config.format;
+		config.filename->set_timespan (timespan);
 		config.filename->set_channel_config (config.channel_config);
 		std::string filename = config.filename->get_path (fmt);
 
 		if (fmt->type () == ExportFormatBase::T_None) {
 			graph_builder->reset ();
-			config_map.erase (config_map.begin());
 			continue;
 		}
 
 		if (fmt->with_cue()) {
-			export_cd_marker_file (current_timespan, fmt, filename, CDMarkerCUE);
+			export_cd_marker_file (timespan, fmt, filename, CDMarkerCUE);
 		}
 
 		if (fmt->with_toc()) {
-			export_cd_marker_file (current_timespan, fmt, filename, CDMarkerTOC);
+			export_cd_marker_file (timespan, fmt, filename, CDMarkerTOC);
 		}
 
 		if (fmt->with_mp4chaps()) {
-			export_cd_marker_file (current_timespan, fmt, filename, MP4Chaps);
+			export_cd_marker_file (timespan, fmt, filename, MP4Chaps);
 		}
 
 		/* close file first, otherwise TagLib enounters an ERROR_SHARING_VIOLATION
@@ -517,7 +704,7 @@ ExportHandler::finish_timespan ()
 				{'G', metadata.genre ()},
 				{'L', total_tracks.str ()},
 				{'M', metadata.mixer ()},
-				{'N', current_timespan->name()}, // =?= config_map.begin()->first->name ()
+				{'N', timespan->name()},
 				{'O', metadata.composer ()},
 				{'P', metadata.producer ()},
 				{'S', metadata.disc_subtitle ()},
@@ -575,9 +762,13 @@ ExportHandler::finish_timespan ()
 			}
 			delete soundcloud_uploader;
 		}
-		config_map.erase (config_map.begin());
 	}
 
+	for (TimespanConfigs::iterator i = timespan_configs.begin(); i != timespan_configs.end(); ++i) {
+		config_map.erase (*i);
+	}
+	timespan_configs.clear ();
+
 	/* finish timespan is called in freewheeling rt-context,
 	 * we cannot start a new export from here */
 	assert (AudioEngine::instance()->freewheeling ());
@@ -587,6 +778,7 @@ ExportHandler::finish_timespan ()
 void
 ExportHandler::reset ()
 {
+	timespan_configs.clear ();
 	config_map.clear ();
 	graph_builder->reset ();
 }
@@ -63,12 +63,39 @@ ExportSMFWriter::process (MidiBuffer const& buf, sampleoffset_t off, samplecnt_t
 	if (_path.empty ()) {
 		return;
 	}
+
+	write (buf, off, n_samples, false);
+
+	if (last_cycle) {
+		MidiBuffer mb (8192);
+		_tracker.resolve_notes (mb, n_samples);
+		/* the note-offs are at n_samples, the end of the range */
+		write (mb, 0, n_samples, true);
+		end_write (_path);
+		SMF::close ();
+		_path.clear ();
+	} else {
+		_pos += n_samples;
+	}
+}
+
+/** Append the events of @p buf in [@p off, @p off + @p n_samples) to the
+ * file, or including @p off + @p n_samples if @p include_end is set.
+ */
+void
+ExportSMFWriter::write (MidiBuffer const& buf, sampleoffset_t off, samplecnt_t n_samples, bool include_end)
+{
 	for (MidiBuffer::const_iterator i = buf.begin (); i != buf.end (); ++i) {
 		Evoral::Event<samplepos_t> ev (*i, false);
 		if (ev.time () < off) {
 			continue;
 		}
 
+		if (ev.time () > off + n_samples || (ev.time () == off + n_samples && !include_end)) {
+			/* past the given range, e.g. the end of the timespan */
+			break;
+		}
+
 		samplepos_t pos = _pos + ev.time () - off;
 		assert (pos >= _last_ev_time_samples);
 
@@ -83,15 +110,4 @@ ExportSMFWriter::process (MidiBuffer const& buf, sampleoffset_t off, samplecnt_t
 		SMF::append_event_delta (delta_time_ticks, ev.size (), ev.buffer (), 0);
 		_last_ev_time_samples = pos;
 	}
-
-	if (last_cycle) {
-		MidiBuffer mb (8192);
-		_tracker.resolve_notes (mb, n_samples);
-		process (mb, 0, n_samples, false);
-		end_write (_path);
-		SMF::close ();
-		_path.clear ();
-	} else {
-		_pos += n_samples;
-	}
 }
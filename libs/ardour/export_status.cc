@@ -45,6 +45,7 @@ ExportStatus::init ()
 
 	total_samples = 0;
 	processed_samples = 0;
+	saved_samples = 0;
 
 	total_samples_current_timespan = 0;
 	processed_samples_current_timespan = 0;
@@ -52,6 +53,9 @@ ExportStatus::init ()
 	total_postprocessing_cycles = 0;
 	current_postprocessing_cycle = 0;
 	result_map.clear();
+
+	Glib::Threads::Mutex::Lock lx (_encoder_lock);
+	_encoder_status.clear ();
 }
 
 void
@@ -71,4 +75,21 @@ ExportStatus::finish (TransportRequestSource trs)
 	Finished (trs); /* EMIT SIGNAL */
 }
 
+std::vector<ExportStatus::EncoderStatus>
+ExportStatus::encoder_status () const
+{
+	Glib::Threads::Mutex::Lock l (_encoder_lock);
+	return _encoder_status;
+}
+
+void
+ExportStatus::set_encoder_status (std::vector<EncoderStatus> const& s)
+{
+	/* called from the export thread, do not wait for a reader */
+	Glib::Threads::Mutex::Lock l (_encoder_lock, Glib::Threads::TRY_LOCK);
+	if (l.locked ()) {
+		_encoder_status = s;
+	}
+}
+
 } // namespace ARDOUR
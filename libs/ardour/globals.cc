@@ -130,6 +130,7 @@
 #include "ardour/triggerbox.h"
 #include "ardour/uri_map.h"
 
+#include "audiographer/general/analyser.h"
 #include "audiographer/routines.h"
 
 #if defined(__APPLE__)
@@ -189,6 +190,9 @@ setup_hardware_optimization (bool try_optimization)
 {
 	bool generic_mix_functions = true;
 
+	AudioGrapher::Routines::float_to_int16_t float_to_int16 = 0;
+	AudioGrapher::Routines::float_to_int24_t float_to_int24 = 0;
+
 	if (try_optimization) {
 		FPU* fpu = FPU::instance ();
 
@@ -206,6 +210,8 @@ setup_hardware_optimization (bool try_optimization)
 			mix_buffers_with_gain = x86_avx512f_mix_buffers_with_gain;
 			mix_buffers_no_gain   = x86_avx512f_mix_buffers_no_gain;
 			copy_vector           = x86_avx512f_copy_vector;
+			float_to_int16        = x86_sse_avx_float_to_int16;
+			float_to_int24        = x86_sse_avx_float_to_int24;
 
 			generic_mix_functions = false;
 
@@ -223,6 +229,8 @@ setup_hardware_optimization (bool try_optimization)
 			mix_buffers_with_gain = x86_fma_mix_buffers_with_gain;
 			mix_buffers_no_gain   = x86_sse_avx_mix_buffers_no_gain;
 			copy_vector           = x86_sse_avx_copy_vector;
+			float_to_int16        = x86_sse_avx_float_to_int16;
+			float_to_int24        = x86_sse_avx_float_to_int24;
 
 			generic_mix_functions = false;
 
@@ -238,6 +246,8 @@ setup_hardware_optimization (bool try_optimization)
 			mix_buffers_with_gain = x86_sse_avx_mix_buffers_with_gain;
 			mix_buffers_no_gain   = x86_sse_avx_mix_buffers_no_gain;
 			copy_vector           = x86_sse_avx_copy_vector;
+			float_to_int16        = x86_sse_avx_float_to_int16;
+			float_to_int24        = x86_sse_avx_float_to_int24;
 
 			generic_mix_functions = false;
 
@@ -251,6 +261,12 @@ setup_hardware_optimization (bool try_optimization)
 			mix_buffers_with_gain = x86_sse_mix_buffers_with_gain;
 			mix_buffers_no_gain   = x86_sse_mix_buffers_no_gain;
 			copy_vector           = default_copy_vector;
+#ifdef __SSE2__
+			if (fpu->has_sse2 ()) {
+				float_to_int16    = x86_sse2_float_to_int16;
+				float_to_int24    = x86_sse2_float_to_int24;
+			}
+#endif
 
 			generic_mix_functions = false;
 		}
@@ -304,6 +320,11 @@ setup_hardware_optimization (bool try_optimization)
 
 	AudioGrapher::Routines::override_compute_peak (compute_peak);
 	AudioGrapher::Routines::override_apply_gain_to_buffer (apply_gain_to_buffer);
+
+	if (float_to_int16 && float_to_int24) {
+		AudioGrapher::Routines::override_float_to_int16 (float_to_int16);
+		AudioGrapher::Routines::override_float_to_int24 (float_to_int24);
+	}
 }
 
 static void
@@ -712,6 +733,9 @@ ARDOUR::init (bool try_optimization, const char* localedir, bool with_gui)
 
 	setup_hardware_optimization (try_optimization);
 
+	/* keep measured FFTW plans of export analysis across sessions */
+	AudioGrapher::Analyser::set_fft_wisdom_file (Glib::build_filename (user_cache_directory (), "fftwf_wisdom"));
+
 	if (Config->get_cpu_dma_latency () >= 0) {
 		request_dma_latency ();
 	}
@@ -338,6 +338,7 @@ Graph::run_one ()
 	 * in the same cycle for different routes.
 	 */
 	Temporal::TempoMap::fetch ();
+	Temporal::TempoMap::begin_conversion_cycle ();
 
 	/* Process the graph-node */
 	PBD::atomic_dec_and_test (_trigger_queue_size);
@@ -2476,6 +2476,7 @@ LuaBindings::common (lua_State* L)
 
 		.beginNamespace ("SrcQuality")
 		.addConst ("SrcBest", ARDOUR::SrcQuality(SrcBest))
+		.addConst ("SrcZitaBest", ARDOUR::SrcQuality(SrcZitaBest))
 		.endNamespace ()
 
 		.beginNamespace ("SectionOperation")
@@ -48,7 +48,9 @@ LuaProc::LuaProc (AudioEngine& engine,
                   const std::string &script)
 	: Plugin (engine, session)
 	, _mempool ("LuaProc", 3145728)
-#ifdef USE_TLSF
+#ifdef USE_SLAB_POOL
+	, lua (lua_newstate (&PBD::SlabPool::lalloc, &_mempool))
+#elif defined USE_TLSF
 	, lua (lua_newstate (&PBD::TLSF::lalloc, &_mempool))
 #elif defined USE_MALLOC
 	, lua (true, true)
@@ -84,7 +86,9 @@ LuaProc::LuaProc (AudioEngine& engine,
 LuaProc::LuaProc (const LuaProc &other)
 	: Plugin (other)
 	, _mempool ("LuaProc", 3145728)
-#ifdef USE_TLSF
+#ifdef USE_SLAB_POOL
+	, lua (lua_newstate (&PBD::SlabPool::lalloc, &_mempool))
+#elif defined USE_TLSF
 	, lua (lua_newstate (&PBD::TLSF::lalloc, &_mempool))
 #elif defined USE_MALLOC
 	, lua (true, true)
@@ -131,6 +135,9 @@ LuaProc::~LuaProc () {
 				0.0001f * _stats_max[1],
 				_stats_max[1] * (float)_stats_cnt / _stats_avg[1]);
 	}
+#ifdef USE_SLAB_POOL
+	_mempool.printstats ();
+#endif
 #endif
 	lua.collect_garbage ();
 	delete (_lua_dsp);
@@ -407,6 +407,7 @@ struct LV2Plugin::Impl {
 	       , work_iface(0)
 	       , opts_iface(0)
 	       , state(0)
+	       , restore_state(0)
 	       , block_length(0)
 	       , options(0)
 #ifdef LV2_EXTENDED
@@ -429,6 +430,7 @@ struct LV2Plugin::Impl {
 	const LV2_Worker_Interface*  work_iface;
 	const LV2_Options_Interface* opts_iface;
 	LilvState*                   state;
+	LilvState*                   restore_state; ///< deferred, see set_state()
 	LV2_Atom_Forge               forge;
 	LV2_Atom_Forge               ui_forge;
 	int32_t                      block_length;
@@ -518,6 +520,7 @@ LV2Plugin::init(const void* c_plugin, samplecnt_t rate)
 	_seq_size               = _engine.raw_buffer_size(DataType::MIDI);
 	_state_version          = 0;
 	_was_activated          = false;
+	_activate_pending       = false;
 	_has_state_interface    = false;
 	_can_write_automation   = false;
 #ifdef LV2_EXTENDED
@@ -1071,6 +1074,11 @@ LV2Plugin::~LV2Plugin ()
 {
 	DEBUG_TRACE(DEBUG::LV2, string_compose("%1 destroy\n", name()));
 
+	if (_impl->restore_state) {
+		_session.cancel_plugin_restore (this);
+		lilv_state_free (_impl->restore_state);
+	}
+
 	deactivate();
 	cleanup();
 
@@ -1492,7 +1500,10 @@ LV2Plugin::add_state(XMLNode* root) const
 		root->set_property("template-dir", _plugin_state_dir);
 	}
 
-	if (_has_state_interface) {
+	if (_has_state_interface && _impl->restore_state) {
+		// Restore is still pending, the state on disk is current
+		root->set_property("state-dir", string("state") + PBD::to_string (_state_version));
+	} else if (_has_state_interface) {
 		// Provisionally increment state version and create directory
 		const std::string new_dir = state_dir(++_state_version);
 		// and keep track of it (for templates & archive)
@@ -2354,9 +2365,19 @@ LV2Plugin::set_state(const XMLNode& node, int version)
 		LilvState* state = lilv_state_new_from_file(
 			_world.world, _uri_map.urid_map(), NULL, state_file.c_str());
 
-		lilv_state_restore(state, _impl->instance, NULL, NULL, 0, NULL);
-		lilv_state_free(_impl->state);
-		_impl->state = state;
+		if (state && _session.loading () && _plugin_state_dir.empty ()) {
+			/* Restoring may take a while (plugins may load samples, IRs etc),
+			 * let the session do it in parallel with other plugins, once all
+			 * routes are loaded. see ::restore_deferred_state()
+			 */
+			lilv_state_free (_impl->restore_state);
+			_impl->restore_state = state;
+			_session.defer_plugin_restore (this);
+		} else {
+			lilv_state_restore(state, _impl->instance, NULL, NULL, 0, NULL);
+			lilv_state_free(_impl->state);
+			_impl->state = state;
+		}
 	}
 
 	if (!_plugin_state_dir.empty ()) {
@@ -2374,13 +2395,38 @@ LV2Plugin::set_state(const XMLNode& node, int version)
 	 * but NOT when copying the state from a plugin to another (active) plugin
 	 * instance.
 	 */
-	if (_session.loading ()) {
+	if (_session.loading () && !_impl->restore_state) {
 		latency_compute_run();
 	}
 
 	return Plugin::set_state(node, version);
 }
 
+void
+LV2Plugin::restore_deferred_state ()
+{
+	if (!_impl->restore_state) {
+		return;
+	}
+
+	DEBUG_TRACE(DEBUG::LV2, string_compose("%1 restore deferred state\n", name()));
+
+	lilv_state_restore(_impl->restore_state, _impl->instance, NULL, NULL, 0, NULL);
+	lilv_state_free(_impl->state);
+	_impl->state = _impl->restore_state;
+	_impl->restore_state = NULL;
+
+	/* latency_compute_run() resets it */
+	const bool activate_pending = _activate_pending;
+
+	/* the session is still loading, see ::set_state() */
+	latency_compute_run();
+
+	if (activate_pending) {
+		activate();
+	}
+}
+
 int
 LV2Plugin::get_parameter_descriptor(uint32_t which, ParameterDescriptor& desc) const
 {
@@ -2636,6 +2682,12 @@ LV2Plugin::activate()
 {
 	DEBUG_TRACE(DEBUG::LV2, string_compose("%1 activate\n", name()));
 
+	if (_impl->restore_state) {
+		/* activate after the state has been restored */
+		_activate_pending = true;
+		return;
+	}
+
 	if (!_was_activated) {
 		lilv_instance_activate(_impl->instance);
 		_was_activated = true;
@@ -2647,6 +2699,8 @@ LV2Plugin::deactivate()
 {
 	DEBUG_TRACE(DEBUG::LV2, string_compose("%1 deactivate\n", name()));
 
+	_activate_pending = false;
+
 	if (_was_activated) {
 		lilv_instance_deactivate(_impl->instance);
 		_was_activated = false;
@@ -29,6 +29,7 @@
 #include "evoral/Control.h"
 
 #include "ardour/debug.h"
+#include "ardour/midi_buffer.h"
 #include "ardour/midi_model.h"
 #include "ardour/midi_playlist.h"
 #include "ardour/midi_region.h"
@@ -50,6 +51,9 @@ using namespace std;
 MidiPlaylist::MidiPlaylist (Session& session, const XMLNode& node, bool hidden)
 	: Playlist (session, node, DataType::MIDI, hidden)
 	, _note_mode(Sustained)
+	, _render_tempo_generation (0)
+	, _render_filter_config (0)
+	, _render_flush (true)
 {
 #ifndef NDEBUG
 	XMLProperty const * prop = node.property("type");
@@ -63,18 +67,27 @@ MidiPlaylist::MidiPlaylist (Session& session, const XMLNode& node, bool hidden)
 	in_set_state--;
 
 	relayer ();
+	init_render_cache ();
 }
 
 MidiPlaylist::MidiPlaylist (Session& session, string name, bool hidden)
 	: Playlist (session, name, DataType::MIDI, hidden)
 	, _note_mode(Sustained)
+	, _render_tempo_generation (0)
+	, _render_filter_config (0)
+	, _render_flush (true)
 {
+	init_render_cache ();
 }
 
 MidiPlaylist::MidiPlaylist (std::shared_ptr<const MidiPlaylist> other, string name, bool hidden)
 	: Playlist (other, name, hidden)
 	, _note_mode(other->_note_mode)
+	, _render_tempo_generation (0)
+	, _render_filter_config (0)
+	, _render_flush (true)
 {
+	init_render_cache ();
 }
 
 MidiPlaylist::MidiPlaylist (std::shared_ptr<const MidiPlaylist> other,
@@ -84,7 +97,11 @@ MidiPlaylist::MidiPlaylist (std::shared_ptr<const MidiPlaylist> other,
                             bool                                  hidden)
 	: Playlist (other, start, dur, name, hidden)
 	, _note_mode(other->_note_mode)
+	, _render_tempo_generation (0)
+	, _render_filter_config (0)
+	, _render_flush (true)
 {
+	init_render_cache ();
 }
 
 MidiPlaylist::~MidiPlaylist ()
@@ -108,6 +125,90 @@ struct EventsSortByTimeAndType {
 	}
 };
 
+/** Append all events of `src' (which are in playback order) to `dst' */
+static void
+copy_rendered (RTMidiBuffer& src, Evoral::EventSink<samplepos_t>& dst)
+{
+	for (size_t n = 0; n < src.size (); ++n) {
+		RTMidiBuffer::Item const& item (src[n]);
+		uint32_t                  size;
+		uint8_t const*            buf = src.bytes (item, size);
+		dst.write (item.timestamp, Evoral::MIDI_EVENT, size, buf);
+	}
+}
+
+struct RenderedHead {
+	samplepos_t time;
+	uint8_t     status;
+	size_t      src;
+	size_t      pos;
+};
+
+/* heap order for merge_rendered(): the event to be written next is the
+ * "largest". Simultaneous events use the same rule as
+ * EventsSortByTimeAndType, and otherwise retain the order of their sources.
+ */
+struct RenderedHeadIsLater {
+	bool operator() (RenderedHead const& a, RenderedHead const& b) const
+	{
+		if (a.time != b.time) {
+			return a.time > b.time;
+		}
+		if (MidiBuffer::second_simultaneous_midi_byte_is_first (a.status, b.status)) {
+			return true;
+		}
+		if (MidiBuffer::second_simultaneous_midi_byte_is_first (b.status, a.status)) {
+			return false;
+		}
+		return a.src > b.src;
+	}
+};
+
+/** Merge the (individually ordered) events of all `srcs' into `dst'.
+ * This yields the same order as sorting the concatenation of `srcs'.
+ */
+static void
+merge_rendered (std::vector<std::shared_ptr<RTMidiBuffer> > const& srcs, RTMidiBuffer& dst)
+{
+	std::vector<RenderedHead> heads;
+	RenderedHeadIsLater       later;
+
+	heads.reserve (srcs.size ());
+
+	for (size_t s = 0; s < srcs.size (); ++s) {
+		if (srcs[s]->empty ()) {
+			continue;
+		}
+		RTMidiBuffer::Item const& item ((*srcs[s])[0]);
+		uint32_t                  size;
+		RenderedHead              h = { item.timestamp, srcs[s]->bytes (item, size)[0], s, 0 };
+		heads.push_back (h);
+	}
+
+	std::make_heap (heads.begin (), heads.end (), later);
+
+	while (!heads.empty ()) {
+		std::pop_heap (heads.begin (), heads.end (), later);
+		RenderedHead& h (heads.back ());
+		RTMidiBuffer& src (*srcs[h.src]);
+
+		RTMidiBuffer::Item const& item (src[h.pos]);
+		uint32_t                  size;
+		uint8_t const*            buf = src.bytes (item, size);
+		dst.write (item.timestamp, Evoral::MIDI_EVENT, size, buf);
+
+		if (++h.pos == src.size ()) {
+			heads.pop_back ();
+			continue;
+		}
+
+		RTMidiBuffer::Item const& next (src[h.pos]);
+		h.time   = next.timestamp;
+		h.status = src.bytes (next, size)[0];
+		std::push_heap (heads.begin (), heads.end (), later);
+	}
+}
+
 int
 MidiPlaylist::set_state (const XMLNode& node, int version)
 {
@@ -269,10 +370,87 @@ MidiPlaylist::contained_automation()
 	return ret;
 }
 
+void
+MidiPlaylist::init_render_cache ()
+{
+	/* a region may have been modified while it was not part of this
+	 * playlist, so never trust a render from before it was (re-)added
+	 */
+	RegionAdded.connect_same_thread (*this, boost::bind (&MidiPlaylist::invalidate_render, this, _1));
+}
+
+void
+MidiPlaylist::invalidate_render (std::weak_ptr<Region> wr)
+{
+	std::shared_ptr<Region> region (wr.lock ());
+
+	if (!region) {
+		return;
+	}
+
+	Glib::Threads::Mutex::Lock lm (_render_lock);
+	_render_dirty.insert (region->id ());
+}
+
+bool
+MidiPlaylist::region_changed (const PropertyChange& what_changed, std::shared_ptr<Region> region)
+{
+	/* position, trim, mute, model contents (MidiModel diffs arrive as
+	 * Properties::contents) .. any of them changes what the region renders
+	 */
+	invalidate_render (region);
+	return Playlist::region_changed (what_changed, region);
+}
+
+void
+MidiPlaylist::set_note_mode (NoteMode m)
+{
+	Glib::Threads::Mutex::Lock lm (_render_lock);
+
+	if (_note_mode != m) {
+		_render_flush = true;
+	}
+
+	_note_mode = m;
+}
+
+/* called by ::render() with _render_cache_lock held */
+std::shared_ptr<RTMidiBuffer>
+MidiPlaylist::cached_render (std::shared_ptr<MidiRegion> mr, MidiChannelFilter* filter)
+{
+	RenderCache::const_iterator i = _render_cache.find (mr->id ());
+
+	if (i != _render_cache.end ()) {
+		DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("re-use render of %1\n", mr->name()));
+		return i->second;
+	}
+
+	DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("render from %1\n", mr->name()));
+
+	Evoral::EventList<samplepos_t> evlist;
+	mr->render (evlist, 0, _note_mode, filter);
+
+	EventsSortByTimeAndType<samplepos_t> cmp;
+	evlist.sort (cmp);
+
+	std::shared_ptr<RTMidiBuffer> rendered (new RTMidiBuffer);
+	rendered->resize (evlist.size () + 4);
+
+	for (Evoral::EventList<samplepos_t>::iterator e = evlist.begin(); e != evlist.end(); ++e) {
+		Evoral::Event<samplepos_t>* ev (*e);
+		rendered->write (ev->time(), ev->event_type(), ev->size(), ev->buffer());
+		delete ev;
+	}
+
+	_render_cache[mr->id ()] = rendered;
+	return rendered;
+}
+
 void
 MidiPlaylist::render (MidiChannelFilter* filter)
 {
 	Playlist::RegionReadLock rl (this);
+	Glib::Threads::Mutex::Lock cl (_render_cache_lock);
 
 	DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("---- MidiPlaylist::render (regions: %1)-----\n", regions.size()));
 
@@ -298,6 +476,52 @@ MidiPlaylist::render (MidiChannelFilter* filter)
 		regs.push_back (mr);
 	}
 
+	uint32_t filter_config = ~0;
+
+	if (filter) {
+		ChannelMode mode;
+		uint16_t    mask;
+		filter->get_mode_and_mask (&mode, &mask);
+		filter_config = ((uint32_t) mode << 16) | mask;
+	}
+
+	/* event times depend on the tempo map; an unpublished map has no
+	 * generation, and is never trusted to match a previous render.
+	 */
+	const uint64_t tmap_generation = Temporal::TempoMap::use ()->generation ();
+
+	{
+		Glib::Threads::Mutex::Lock lm (_render_lock);
+
+		if (_render_flush || tmap_generation == 0 || tmap_generation != _render_tempo_generation || filter_config != _render_filter_config) {
+			_render_cache.clear ();
+		} else {
+			for (auto const& id : _render_dirty) {
+				_render_cache.erase (id);
+			}
+		}
+
+		_render_dirty.clear ();
+		_render_flush            = false;
+		_render_tempo_generation = tmap_generation;
+		_render_filter_config    = filter_config;
+	}
+
+	/* forget regions that are no longer rendered (removed or muted) */
+	if (!_render_cache.empty ()) {
+		std::set<PBD::ID> present;
+		for (auto const& mr : regs) {
+			present.insert (mr->id ());
+		}
+		for (RenderCache::iterator i = _render_cache.begin (); i != _render_cache.end ();) {
+			if (present.find (i->first) == present.end ()) {
+				i = _render_cache.erase (i);
+			} else {
+				++i;
+			}
+		}
+	}
+
 	/* RAII */
 	RTMidiBuffer::WriteProtectRender wpr (_rendered);
 
@@ -309,17 +533,16 @@ MidiPlaylist::render (MidiChannelFilter* filter)
 	}
 
 	if (regs.size() == 1) {
+		std::shared_ptr<RTMidiBuffer> src = cached_render (regs.front (), filter);
 		wpr.acquire ();
 		_rendered.clear ();
-		std::shared_ptr<MidiRegion> mr = regs.front ();
-		DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("render from %1\n", mr->name()));
-		mr->render (_rendered, 0, _note_mode, filter);
+		_rendered.resize (src->size () + 4);
+		copy_rendered (*src, _rendered);
 		DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("---- End MidiPlaylist::render, events: %1\n", _rendered.size()));
 		return;
 	}
 
-	RegionSortByLayer cmp;
-	regs.sort (cmp);
+	regs.sort (RegionSortByLayer ());
 
 	bool all_transparent = true;
 	bool no_layers = true;
@@ -340,84 +563,91 @@ MidiPlaylist::render (MidiChannelFilter* filter)
 		}
 	}
 
-	Evoral::EventList<samplepos_t> evlist;
-
 	if (all_transparent || no_layers) {
 
 		DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("\t%1 regions to read\n", regs.size()));
 
+		std::vector<std::shared_ptr<RTMidiBuffer> > srcs;
+		size_t total = 0;
+
 		for (auto i = regs.rbegin(); i != regs.rend(); ++i) {
-			std::shared_ptr<MidiRegion> mr = *i;
-			DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("render from %1\n", mr->name()));
-			mr->render (evlist, 0, _note_mode, filter);
+			srcs.push_back (cached_render (*i, filter));
+			total += srcs.back ()->size ();
 		}
-		EventsSortByTimeAndType<samplepos_t> cmp;
-		evlist.sort (cmp);
-
-	} else {
 
-		DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("\t%1 layered regions to read\n", regs.size()));
+		wpr.acquire ();
+		_rendered.clear ();
+		_rendered.resize (total + 4);
+		merge_rendered (srcs, _rendered);
 
-		bool top = true;
-		std::vector<samplepos_t> bounds;
-		EventsSortByTimeAndType<samplepos_t> cmp;
+		DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("---- End MidiPlaylist::render, events: %1\n", _rendered.size()));
+		return;
+	}
 
-		/* iterate, top-most region first */
-		for (auto i = regs.rbegin(); i != regs.rend(); ++i) {
-			std::shared_ptr<MidiRegion> mr = *i;
-			DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("maybe render from %1\n", mr->name()));
+	DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("\t%1 layered regions to read\n", regs.size()));
 
-			if (top) {
-				/* render topmost region as-is */
-				mr->render (evlist, 0, _note_mode, filter);
-				top = false;
-			} else {
-				Evoral::EventList<samplepos_t> tmp;
-				mr->render (tmp, 0, _note_mode, filter);
+	Evoral::EventList<samplepos_t> evlist;
 
-				/* insert region-bound markers of opaque regions above */
-				for (auto const& p : bounds) {
-					tmp.write (p, Evoral::NO_EVENT, 0, 0);
-				}
-				tmp.sort (cmp);
-
-				MidiStateTracker mtr;
-				Evoral::EventList<samplepos_t> const slist (evlist);
-
-				for (Evoral::EventList<samplepos_t>::iterator e = tmp.begin(); e != tmp.end(); ++e) {
-					Evoral::Event<samplepos_t>* ev (*e);
-					timepos_t t (ev->time());
-
-					if (ev->event_type () == Evoral::NO_EVENT) {
-						/* reached region bound of an opaque region above this region. */
-						mtr.resolve_state (evlist, slist, ev->time());
-					} else if (region_is_audible_at (mr, t)) {
-						/* no opaque region above this event */
-						uint8_t* evbuf = ev->buffer();
-						if (3 == ev->size() && (evbuf[0] & 0xf0) == MIDI_CMD_NOTE_OFF && !mtr.active (evbuf[1], evbuf[0] & 0x0f)) {
-							; /* skip note off */
-						} else {
-							evlist.write (ev->time(), ev->event_type(), ev->size(), evbuf);
-							mtr.track (evbuf);
-						}
+	bool top = true;
+	std::vector<samplepos_t> bounds;
+	EventsSortByTimeAndType<samplepos_t> cmp;
+
+	/* iterate, top-most region first */
+	for (auto i = regs.rbegin(); i != regs.rend(); ++i) {
+		std::shared_ptr<MidiRegion> mr = *i;
+		DEBUG_TRACE (DEBUG::MidiPlaylistIO, string_compose ("maybe render from %1\n", mr->name()));
+
+		if (top) {
+			/* render topmost region as-is */
+			copy_rendered (*cached_render (mr, filter), evlist);
+			top = false;
+		} else {
+			Evoral::EventList<samplepos_t> tmp;
+			copy_rendered (*cached_render (mr, filter), tmp);
+
+			/* insert region-bound markers of opaque regions above */
+			for (auto const& p : bounds) {
+				tmp.write (p, Evoral::NO_EVENT, 0, 0);
+			}
+			tmp.sort (cmp);
+
+			MidiStateTracker mtr;
+			Evoral::EventList<samplepos_t> const slist (evlist);
+
+			for (Evoral::EventList<samplepos_t>::iterator e = tmp.begin(); e != tmp.end(); ++e) {
+				Evoral::Event<samplepos_t>* ev (*e);
+				timepos_t t (ev->time());
+
+				if (ev->event_type () == Evoral::NO_EVENT) {
+					/* reached region bound of an opaque region above this region. */
+					mtr.resolve_state (evlist, slist, ev->time());
+				} else if (region_is_audible_at (mr, t)) {
+					/* no opaque region above this event */
+					uint8_t* evbuf = ev->buffer();
+					if (3 == ev->size() && (evbuf[0] & 0xf0) == MIDI_CMD_NOTE_OFF && !mtr.active (evbuf[1], evbuf[0] & 0x0f)) {
+						; /* skip note off */
 					} else {
-						/* there is an opaque region above this event, skip this event. */
+						evlist.write (ev->time(), ev->event_type(), ev->size(), evbuf);
+						mtr.track (evbuf);
 					}
-					delete ev;
+				} else {
+					/* there is an opaque region above this event, skip this event. */
 				}
+				delete ev;
 			}
+		}
 
-			if (mr->opaque ()) {
-				bounds.push_back (mr->position ().samples ());
-			}
-
-			EventsSortByTimeAndType<samplepos_t> cmp;
-			evlist.sort (cmp);
+		if (mr->opaque ()) {
+			bounds.push_back (mr->position ().samples ());
 		}
+
+		EventsSortByTimeAndType<samplepos_t> cmp;
+		evlist.sort (cmp);
 	}
 
 	wpr.acquire ();
 	_rendered.clear ();
+	_rendered.resize (evlist.size () + 4);
 
 	/* Copy ordered events from event list to _rendered. */
 	for (Evoral::EventList<samplepos_t>::iterator e = evlist.begin(); e != evlist.end(); ++e) {
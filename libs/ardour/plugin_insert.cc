@@ -30,6 +30,7 @@
 
 #include "pbd/assert.h"
 #include "pbd/failed_constructor.h"
+#include "pbd/md5.h"
 #include "pbd/xml++.h"
 #include "pbd/types_convert.h"
 
@@ -67,6 +68,7 @@ PluginInsert::PluginInsert (Session& s, Temporal::TimeDomainProvider const & tdp
 	, _strict_io (false)
 	, _custom_cfg (false)
 	, _maps_from_state (false)
+	, _plugin_state_dirty (true)
 	, _latency_changed (false)
 	, _bypass_port (UINT32_MAX)
 	, _inverted_bypass_enable (false)
@@ -2619,7 +2621,21 @@ PluginInsert::state () const
 	}
 
 	_plugins[0]->set_insert_id(this->id());
-	node.add_child_nocopy (_plugins[0]->get_state());
+
+	/* Remember what was saved, restoring the same state later on
+	 * (undo, snapshot, mixer-scene) can then skip the plugin.
+	 * The flag is reset first, a concurrent change sets it again.
+	 */
+	{
+		Glib::Threads::Mutex::Lock lm (_plugin_state_lock);
+		_plugin_state_dirty = false;
+		XMLNode& pnode (_plugins[0]->get_state());
+		node.add_child_nocopy (pnode);
+
+		_plugin_state_hash   = state_hash (pnode);
+		_plugin_state_origin = id ();
+		node.set_property ("state-hash", _plugin_state_hash);
+	}
 
 	for (Controls::const_iterator c = controls().begin(); c != controls().end(); ++c) {
 		std::shared_ptr<AutomationControl> ac = std::dynamic_pointer_cast<AutomationControl> ((*c).second);
@@ -2645,6 +2661,7 @@ PluginInsert::set_state(const XMLNode& node, int version)
 	}
 
 	bool any_vst = false;
+	bool fresh   = _plugins.empty ();
 	uint32_t count = 1;
 	node.get_property ("count", count);
 
@@ -2691,7 +2708,27 @@ PluginInsert::set_state(const XMLNode& node, int version)
 
 	node.get_property ("id", old_id);
 
-	for (niter = nlist.begin(); niter != nlist.end(); ++niter) {
+	/* When restoring the state of an existing instance which has not
+	 * been modified since that very state was saved, there is nothing
+	 * to do for the plugin itself. This saves re-loading plugin-state
+	 * (e.g. samples, IRs) when e.g. switching mixer scenes or undo.
+	 */
+	std::string hash;
+	bool        reuse_instance = false;
+
+	if (node.get_property ("state-hash", hash) && !hash.empty ()
+	    && !fresh && !regenerate_xml_or_string_ids () && new_id == old_id) {
+		/* state copied from another insert may refer to that insert's
+		 * files, even if the XML is identical.
+		 */
+		Glib::Threads::Mutex::Lock lm (_plugin_state_lock);
+		if (hash == _plugin_state_hash && old_id == _plugin_state_origin && !_plugin_state_dirty) {
+			DEBUG_TRACE (DEBUG::Processors, string_compose ("%1: plugin state unchanged, keep instance state\n", name ()));
+			reuse_instance = true;
+		}
+	}
+
+	for (niter = nlist.begin(); niter != nlist.end() && !reuse_instance; ++niter) {
 		/* find the node with the type-specific node name ("lv2", "ladspa", etc)
 		 * and set all plugins to the same state.
 		 */
@@ -2731,6 +2768,13 @@ PluginInsert::set_state(const XMLNode& node, int version)
 				}
 			}
 
+			/* hash may be empty (older sessions) */
+			{
+				Glib::Threads::Mutex::Lock lm (_plugin_state_lock);
+				_plugin_state_hash   = hash;
+				_plugin_state_origin = old_id;
+				_plugin_state_dirty  = hash.empty ();
+			}
 			break;
 		}
 	}
@@ -2830,6 +2874,49 @@ PluginInsert::set_state(const XMLNode& node, int version)
 	return 0;
 }
 
+void
+PluginInsert::plugin_state_modified ()
+{
+	/* may be called from the process thread */
+	_plugin_state_dirty = true;
+}
+
+static void
+flatten_state (XMLNode const& node, std::string& s)
+{
+	s += node.name ();
+	if (node.is_content ()) {
+		s += node.content ();
+	}
+	XMLPropertyList const& pl (node.properties ());
+	for (XMLPropertyConstIterator i = pl.begin (); i != pl.end (); ++i) {
+		s += ' ';
+		s += (*i)->name ();
+		s += '=';
+		s += (*i)->value ();
+	}
+	XMLNodeList const& nl (node.children ());
+	for (XMLNodeConstIterator i = nl.begin (); i != nl.end (); ++i) {
+		s += '<';
+		flatten_state (**i, s);
+		s += '>';
+	}
+}
+
+std::string
+PluginInsert::state_hash (XMLNode const& node) const
+{
+	/* content only, the hash is saved with the session and must be
+	 * stable across saves and processes.
+	 */
+	std::string s;
+	flatten_state (node, s);
+
+	MD5 md5;
+	md5.digestMemory ((uint8_t const*) s.data (), s.size ());
+	return md5.digestChars;
+}
+
 void
 PluginInsert::update_id (PBD::ID id)
 {
@@ -3023,6 +3110,8 @@ PluginInsert::add_plugin (std::shared_ptr<Plugin> plugin)
 		plugin->ParameterChangedExternally.connect_same_thread (*this, boost::bind (&PluginInsert::parameter_changed_externally, this, _1, _2));
 		plugin->StartTouch.connect_same_thread (*this, boost::bind (&PluginInsert::start_touch, this, _1));
 		plugin->EndTouch.connect_same_thread (*this, boost::bind (&PluginInsert::end_touch, this, _1));
+		plugin->PresetDirty.connect_same_thread (*this, boost::bind (&PluginInsert::plugin_state_modified, this));
+		plugin->PresetLoaded.connect_same_thread (*this, boost::bind (&PluginInsert::plugin_state_modified, this));
 		_custom_sinks = plugin->get_info()->n_inputs;
 		// cache sidechain port count
 		_cached_sidechain_pins.reset ();
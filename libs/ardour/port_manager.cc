@@ -1264,7 +1264,7 @@ PortManager::cycle_start (pframes_t nframes, Session* s)
 	Port::set_global_port_buffer_offset (0);
 	Port::set_cycle_samplecnt (nframes);
 
-	_cycle_ports = _ports.reader ();
+	_cycle_ports.reset (_ports);
 
 	/* pre-calc/cache value */
 	falloff_cache.calc (nframes, s ? s->nominal_sample_rate () : 0);
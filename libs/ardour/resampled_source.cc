@@ -24,6 +24,8 @@
 #include "ardour/resampled_source.h"
 #include "pbd/failed_constructor.h"
 
+#include "zita-resampler/resampler.h"
+
 #include "pbd/i18n.h"
 
 using namespace ARDOUR;
@@ -38,9 +40,14 @@ const uint32_t ResampledImportableSource::blocksize = 16384U;
 ResampledImportableSource::ResampledImportableSource (std::shared_ptr<ImportableSource> src, samplecnt_t rate, SrcQuality srcq)
 	: source (src)
 	, _src_state (0)
+	, _zita (0)
+	, _zita_in (0)
+	, _zita_out (0)
 {
 	_src_type = SRC_SINC_BEST_QUALITY;
 
+	unsigned int hlen = 0;
+
 	switch (srcq) {
 	case SrcBest:
 		_src_type = SRC_SINC_BEST_QUALITY;
@@ -57,6 +64,24 @@ ResampledImportableSource::ResampledImportableSource (std::shared_ptr<Importable
 	case SrcFastest:
 		_src_type = SRC_LINEAR;
 		break;
+	case SrcZitaBest:
+		hlen = 96;
+		break;
+	case SrcZitaGood:
+		hlen = 48;
+		break;
+	case SrcZitaFast:
+		hlen = 16;
+		break;
+	}
+
+	if (hlen > 0) {
+		_zita = new ArdourZita::Resampler ();
+		if (_zita->setup (source->samplerate (), rate, source->channels (), hlen)) {
+			/* unsupported ratio */
+			delete _zita;
+			_zita = 0;
+		}
 	}
 
 	_input = new float[blocksize];
@@ -69,12 +94,17 @@ ResampledImportableSource::ResampledImportableSource (std::shared_ptr<Importable
 ResampledImportableSource::~ResampledImportableSource ()
 {
 	_src_state = src_delete (_src_state) ;
+	delete _zita;
 	delete [] _input;
 }
 
 samplecnt_t
 ResampledImportableSource::read (Sample* output, samplecnt_t nframes)
 {
+	if (_zita) {
+		return read_zita (output, nframes);
+	}
+
 	int err;
 	size_t bs = floor ((float)(blocksize / source->channels())) *  source->channels();
 
@@ -122,11 +152,75 @@ ResampledImportableSource::read (Sample* output, samplecnt_t nframes)
 	return _src_data.output_frames_gen * source->channels();
 }
 
+samplecnt_t
+ResampledImportableSource::read_zita (Sample* output, samplecnt_t nframes)
+{
+	uint32_t const nchn = source->channels ();
+	samplecnt_t const bs = (blocksize / nchn) * nchn;
+	samplecnt_t const want = nframes / nchn;
+	samplecnt_t done = 0;
+
+	while (done < want) {
+		if (_zita->inp_count == 0 && !_end_of_input) {
+			samplecnt_t n = source->read (_input, bs);
+			if (n < bs) {
+				_end_of_input = true;
+			}
+			_zita->inp_count = n / nchn;
+			_zita->inp_data  = _input;
+			_zita_in += n / nchn;
+		}
+
+		_zita->out_data = output + done * nchn;
+
+		if (_zita->inp_count > 0) {
+			_zita->out_count = want - done;
+			_zita->process ();
+			done = want - _zita->out_count;
+			continue;
+		}
+
+		/* end of input, flush the filter with silence until
+		 * the output has the expected length */
+		samplecnt_t const remain = (samplecnt_t) llrint (_zita_in * _src_data.src_ratio) - _zita_out - done;
+		if (remain <= 0) {
+			break;
+		}
+		samplecnt_t const n = std::min (want - done, remain);
+		_zita->out_count = n;
+		_zita->inp_data  = 0;
+		while (_zita->out_count > 0) {
+			_zita->inp_count = _zita->inpsize ();
+			_zita->process ();
+		}
+		_zita->inp_count = 0;
+		done += n;
+	}
+
+	_zita_out += done;
+	return done * nchn;
+}
+
 void
 ResampledImportableSource::seek (samplepos_t pos)
 {
 	source->seek (pos);
 
+	_end_of_input = false;
+
+	if (_zita) {
+		_zita->reset ();
+		/* pre-fill with silence, to align output with input */
+		_zita->inp_count = _zita->inpsize () / 2 - 1;
+		_zita->out_count = _zita->inpsize ();
+		_zita->process ();
+		_zita->inp_count = 0;
+		_zita->out_count = 0;
+		_zita_in  = 0;
+		_zita_out = 0;
+		return;
+	}
+
 	/* and reset things so that we start from scratch with the conversion */
 
 	if (_src_state) {
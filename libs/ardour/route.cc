@@ -1482,18 +1482,21 @@ Route::is_internal_processor (std::shared_ptr<Processor> p) const
 int
 Route::remove_processor (std::shared_ptr<Processor> processor, ProcessorStreams* err, bool need_process_lock)
 {
-	// TODO once the export point can be configured properly, do something smarter here
-	if (processor == _capturing_processor) {
+	for (CapturingProcessorMap::iterator i = _capturing_processors.begin (); i != _capturing_processors.end (); ++i) {
+		if (processor != i->second) {
+			continue;
+		}
 		Glib::Threads::Mutex::Lock lx (AudioEngine::instance()->process_lock (), Glib::Threads::NOT_LOCK);
 		if (need_process_lock) {
 			lx.acquire();
 		}
 
-		_capturing_processor.reset();
+		_capturing_processors.erase (i);
 
 		if (need_process_lock) {
 			lx.release();
 		}
+		break;
 	}
 
 	/* these can never be removed */
@@ -4420,22 +4423,35 @@ Route::listen_position_changed ()
 }
 
 std::shared_ptr<CapturingProcessor>
-Route::add_export_point()
+Route::add_export_point (ExportTapPoint point)
 {
-	assert (!_capturing_processor);
+	assert (_capturing_processors.find (point) == _capturing_processors.end ());
 
 	Glib::Threads::Mutex::Lock lx (AudioEngine::instance()->process_lock ());
 	Glib::Threads::RWLock::WriterLock lw (_processor_lock);
 
-	/* Align all tracks for stem-export w/o processing.
-	 * Compensate for all plugins between the this route's disk-reader
+	std::shared_ptr<CapturingProcessor> cp (new CapturingProcessor (_session, 0));
+	_capturing_processors[point] = cp;
+	configure_processors_unlocked (0, &lw);
+
+	/* Align all taps for stem-export.
+	 * Compensate for all plugins between the tap-point of this route
 	 * and the common final downstream output (ie alignment point for playback).
 	 */
-	_capturing_processor.reset (new CapturingProcessor (_session, playback_latency (true)));
-	configure_processors_unlocked (0, &lw);
-	_capturing_processor->activate ();
+	samplecnt_t latency = 0;
+	bool        downstream = false;
+	for (ProcessorList::const_iterator i = _processors.begin (); i != _processors.end (); ++i) {
+		if (downstream && (*i)->active ()) {
+			latency += (*i)->effective_latency ();
+		}
+		if (*i == cp) {
+			downstream = true;
+		}
+	}
+	cp->set_latency (latency + _output->connected_latency (true));
+	cp->activate ();
 
-	return _capturing_processor;
+	return cp;
 }
 
 samplecnt_t
@@ -5496,21 +5512,34 @@ Route::setup_invisible_processors ()
 		}
 	}
 
-	/* EXPORT PROCESSOR */
-	if (_capturing_processor) {
-		assert (!_capturing_processor->display_to_user ());
+	/* EXPORT PROCESSORS */
+	for (CapturingProcessorMap::const_iterator c = _capturing_processors.begin (); c != _capturing_processors.end (); ++c) {
+		std::shared_ptr<CapturingProcessor> const& cp (c->second);
+		assert (!cp->display_to_user ());
 		ProcessorList::iterator capture_pos;
+		switch (c->first) {
+			case ExportTapPreFader:
+				/* just before the fader (and after a pre-fader meter) */
+				new_processors.insert (find (new_processors.begin(), new_processors.end(), _amp), cp);
+				continue;
+			case ExportTapPostFader:
+				/* just before the main outs, like a post-fader meter */
+				new_processors.insert (find (new_processors.begin(), new_processors.end(), _main_outs), cp);
+				continue;
+			case ExportTapPlayback:
+				break;
+		}
 		if (_triggerbox && (capture_pos = find (new_processors.begin(), new_processors.end(), _triggerbox)) != new_processors.end ()) {
 			/* insert after triggerbox (which is just after disk-reader) */
-			new_processors.insert (++capture_pos, _capturing_processor);
+			new_processors.insert (++capture_pos, cp);
 		} else if ((capture_pos = find (new_processors.begin(), new_processors.end(), _disk_reader)) != new_processors.end ()) {
 			/* insert after disk-reader */
-			new_processors.insert (++capture_pos, _capturing_processor);
+			new_processors.insert (++capture_pos, cp);
 		} else if ((capture_pos = find (new_processors.begin(), new_processors.end(), _intreturn)) != new_processors.end ()) {
 			/* insert after return (busses) */
-				new_processors.insert (++capture_pos, _capturing_processor);
+			new_processors.insert (++capture_pos, cp);
 		} else {
-			new_processors.push_front (_capturing_processor);
+			new_processors.push_front (cp);
 		}
 	}
 
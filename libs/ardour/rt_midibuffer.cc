@@ -55,7 +55,7 @@ RTMidiBuffer::resize (size_t size)
 {
 	if (_data && size < _capacity) {
 
-		if (_size < size) {
+		if (size < _size) {
 			/* truncate */
 			_size = size;
 		}
@@ -23,6 +23,7 @@
 #include "pbd/error.h"
 #include "pbd/pthread_utils.h"
 
+#include "ardour/audioengine.h"
 #include "ardour/butler.h"
 #include "ardour/disk_reader.h"
 #include "ardour/route.h"
@@ -130,3 +131,10 @@ Session::capture_load ()
 {
 	return (uint32_t) _capture_load.load ();
 }
+
+void
+Session::reclaim_rcu ()
+{
+	routes.reclaim ();
+	AudioEngine::instance ()->reclaim_ports ();
+}
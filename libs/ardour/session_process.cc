@@ -132,7 +132,7 @@ Session::process (pframes_t nframes)
 	bool one_or_more_routes_declicking = false;
 	{
 		ProcessorChangeBlocker pcb (this);
-		std::shared_ptr<RouteList const> r = routes.reader ();
+		EpochRCUManager<RouteList>::ReadPtr r (routes);
 		for (auto const& i : *r) {
 			if (i->apply_processor_changes_rt()) {
 				_rt_emit_pending = true;
@@ -144,7 +144,7 @@ Session::process (pframes_t nframes)
 	}
 
 	if (_update_send_delaylines) {
-		std::shared_ptr<RouteList const> r = routes.reader ();
+		EpochRCUManager<RouteList>::ReadPtr r (routes);
 		for (auto const& i : *r) {
 			i->update_send_delaylines ();
 		}
@@ -203,7 +203,7 @@ Session::no_roll (pframes_t nframes)
 
 	samplepos_t end_sample = _transport_sample + floor (nframes * _transport_fsm->transport_speed());
 	int ret = 0;
-	std::shared_ptr<RouteList const> r = routes.reader ();
+	EpochRCUManager<RouteList>::ReadPtr r (routes);
 
 	if (_click_io) {
 		_click_io->silence (nframes);
@@ -248,7 +248,7 @@ int
 Session::process_routes (pframes_t nframes, bool& need_butler)
 {
 	TimerRAII tr (dsp_stats[Roll]);
-	std::shared_ptr<RouteList const> r = routes.reader ();
+	EpochRCUManager<RouteList>::ReadPtr r (routes);
 
 	const samplepos_t start_sample = _transport_sample;
 	const samplepos_t end_sample = _transport_sample + floor (nframes * _transport_fsm->transport_speed());
@@ -346,7 +346,7 @@ Session::compute_audible_delta (samplepos_t& pos_and_delta) const
 samplecnt_t
 Session::calc_preroll_subcycle (samplecnt_t ns) const
 {
-	std::shared_ptr<RouteList const> r = routes.reader ();
+	EpochRCUManager<RouteList>::ReadPtr r (routes);
 	for (auto const& i : *r) {
 		if (!i->active ()) {
 			continue;
@@ -760,7 +760,7 @@ void
 Session::process_audition (pframes_t nframes)
 {
 	SessionEvent* ev;
-	std::shared_ptr<RouteList const> r = routes.reader ();
+	EpochRCUManager<RouteList>::ReadPtr r (routes);
 
 	std::shared_ptr<GraphChain> graph_chain = _graph_chain;
 	if (graph_chain) {
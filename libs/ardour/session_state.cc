@@ -35,7 +35,9 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <atomic>
 #include <string>
+#include <tuple>
 #include <cerrno>
 #include <cstdio> /* snprintf(3) ... grrr */
 #include <cmath>
@@ -78,6 +80,7 @@
 #include "evoral/SMF.h"
 
 #include "pbd/basename.h"
+#include "pbd/cpus.h"
 #include "pbd/debug.h"
 #include "pbd/enumwriter.h"
 #include "pbd/error.h"
@@ -86,6 +89,7 @@
 #include "pbd/pthread_utils.h"
 #include "pbd/progress.h"
 #include "pbd/scoped_file_descriptor.h"
+#include "pbd/timing.h"
 #include "pbd/types_convert.h"
 #include "pbd/localtime_r.h"
 #include "pbd/unwind.h"
@@ -98,6 +102,7 @@
 #include "ardour/audioregion.h"
 #include "ardour/auditioner.h"
 #include "ardour/automation_control.h"
+#include "ardour/automation_list.h"
 #include "ardour/boost_debug.h"
 #include "ardour/butler.h"
 #include "ardour/control_protocol_manager.h"
@@ -117,6 +122,7 @@
 #include "ardour/mixer_scene.h"
 #include "ardour/playlist_factory.h"
 #include "ardour/playlist_source.h"
+#include "ardour/plugin.h"
 #include "ardour/port.h"
 #include "ardour/processor.h"
 #include "ardour/profile.h"
@@ -196,6 +202,7 @@ Session::pre_engine_init (string fullpath)
 	last_rr_session_dir = session_dirs.begin();
 
 	set_history_depth (Config->get_history_depth());
+	setup_undo_log ();
 
 	/* default: assume simple stereo speaker configuration */
 
@@ -700,6 +707,80 @@ Session::remove_pending_capture_state ()
 #endif
 }
 
+static bool
+accept_sidecar_referrers (const string& path, void* /*arg*/)
+{
+	if (!Glib::file_test (path, Glib::FILE_TEST_IS_REGULAR)) {
+		return false;
+	}
+	/* snapshots, pending state and their backups (foo.ardour.bak) */
+	const string name = Glib::path_get_basename (path);
+	return name.find (statefile_suffix) != string::npos
+		|| name.find (pending_suffix) != string::npos;
+}
+
+/** Remove automation sidecar files that no session file in the session
+ * folder or its backup folder refers to any longer, e.g. after a list
+ * was thinned below the sidecar threshold or its route was removed.
+ */
+void
+Session::remove_unused_automation_sidecars ()
+{
+	const string dir = automation_dir ();
+
+	if (!Glib::file_test (dir, Glib::FILE_TEST_IS_DIR)) {
+		return;
+	}
+
+	vector<string> sidecars;
+	find_files_matching_pattern (sidecars, dir, X_("*.events*"));
+
+	if (sidecars.empty ()) {
+		return;
+	}
+
+	Searchpath sp (_session_dir->root_path ());
+	sp.add_directory (_session_dir->backup_path ());
+
+	vector<string> referrers;
+	find_files_matching_filter (referrers, sp, accept_sidecar_referrers, 0, true, true, false);
+
+	set<string> used;
+
+	for (vector<string>::const_iterator i = referrers.begin (); i != referrers.end (); ++i) {
+		string content;
+		try {
+			content = Glib::file_get_contents (*i);
+		} catch (Glib::FileError const& e) {
+			/* rather keep a few stale files than lose automation */
+			warning << string_compose (_("Cannot check %1 for automation data in use (%2)"), *i, e.what ()) << endmsg;
+			return;
+		}
+
+		static const string key (X_("sidecar=\""));
+		for (string::size_type pos = content.find (key); pos != string::npos; pos = content.find (key, pos)) {
+			pos += key.length ();
+			const string::size_type end = content.find ('"', pos);
+			if (end == string::npos) {
+				break;
+			}
+			used.insert (content.substr (pos, end - pos));
+		}
+	}
+
+	for (vector<string>::const_iterator i = sidecars.begin (); i != sidecars.end (); ++i) {
+		const string name = Glib::path_get_basename (*i);
+		/* left-over temporary files are never referenced */
+		if (used.find (name) != used.end ()) {
+			continue;
+		}
+		DEBUG_TRACE (DEBUG::SaveState, string_compose ("removing unused automation data %1\n", *i));
+		if (::g_unlink (i->c_str ()) != 0) {
+			error << string_compose (_("Could not remove unused automation data \"%1\" (%2)"), *i, g_strerror (errno)) << endmsg;
+		}
+	}
+}
+
 /** Rename a state file.
  *  @param old_name Old snapshot name.
  *  @param new_name New snapshot name.
@@ -835,6 +916,8 @@ Session::save_state (string snapshot_name, bool pending, bool switch_to_snapshot
 		mark_as_clean = false;
 		tree.set_root (&get_template());
 	} else {
+		/* archives must be self-contained, keep all automation inline there */
+		AutomationList::SidecarScope sidecar (config.get_automation_sidecar () && !for_archive ? automation_dir () : std::string ());
 		tree.set_root (&state (false, fork_state, for_archive, only_used_assets));
 	}
 
@@ -940,6 +1023,7 @@ Session::save_state (string snapshot_name, bool pending, bool switch_to_snapshot
 
 	if (!pending && !for_archive && ! template_only) {
 		remove_pending_capture_state ();
+		remove_unused_automation_sidecars ();
 	}
 
 	return 0;
@@ -1702,6 +1786,12 @@ Session::set_state (const XMLNode& node, int version)
 	XMLNodeList nlist;
 	XMLNode* child;
 	int ret = -1;
+	PBD::Timing phase_timer;
+
+	_load_phase_times.clear ();
+
+	/* automation event data may be stored next to the session file */
+	AutomationList::SidecarScope sidecar (automation_dir ());
 
 	_state_of_the_state = StateOfTheState (_state_of_the_state | CannotSave);
 
@@ -1766,6 +1856,9 @@ Session::set_state (const XMLNode& node, int version)
 		Temporal::set_sample_rate (_base_sample_rate);
 	}
 
+	/* do not account for time spent asking about the sample-rate */
+	phase_timer.start ();
+
 	/* need the tempo map setup ASAP */
 
 	if ((child = find_named_node (node, "TempoMap")) == 0) {
@@ -1782,6 +1875,8 @@ Session::set_state (const XMLNode& node, int version)
 		}
 	}
 
+	load_phase_done ("tempo map", phase_timer);
+
 
 	created_with = "unknown";
 	if ((child = find_named_node (node, "ProgramVersion")) != 0) {
@@ -1866,6 +1961,8 @@ Session::set_state (const XMLNode& node, int version)
 		_speakers->set_state (*child, version);
 	}
 
+	load_phase_done ("configuration", phase_timer);
+
 	if ((child = find_named_node (node, "Sources")) == 0) {
 		error << _("Session: XML state has no 'Sources' section") << endmsg;
 		goto out;
@@ -1874,6 +1971,8 @@ Session::set_state (const XMLNode& node, int version)
 		goto out;
 	}
 
+	load_phase_done ("sources", phase_timer);
+
 	if ((child = find_named_node (node, "Locations")) == 0) {
 		error << _("Session: XML state has no 'Locations' section") << endmsg;
 		goto out;
@@ -1896,6 +1995,8 @@ Session::set_state (const XMLNode& node, int version)
 		goto out;
 	}
 
+	load_phase_done ("locations and regions", phase_timer);
+
 	if ((child = find_named_node (node, "Playlists")) == 0) {
 		error << _("Session: XML state has no 'Playlists' section") << endmsg;
 		goto out;
@@ -1918,6 +2019,8 @@ Session::set_state (const XMLNode& node, int version)
 		}
 	}
 
+	load_phase_done ("playlists", phase_timer);
+
 	if (version >= 3000) {
 		if ((child = find_named_node (node, "Bundles")) == 0) {
 			warning << _("Session: XML state has no 'Bundles' section") << endmsg;
@@ -1997,6 +2100,8 @@ Session::set_state (const XMLNode& node, int version)
 		}
 	}
 
+	load_phase_done ("whole-file regions", phase_timer);
+
 	if ((child = find_named_node (node, "Routes")) == 0) {
 		error << _("Session: XML state has no 'Routes' section") << endmsg;
 		goto out;
@@ -2005,6 +2110,10 @@ Session::set_state (const XMLNode& node, int version)
 		goto out;
 	}
 
+	restore_deferred_plugins ();
+
+	load_phase_done ("routes", phase_timer);
+
 	/* Now that we Tracks have been loaded and playlists are assigned */
 	_playlists->update_tracking ();
 
@@ -2110,6 +2219,11 @@ Session::set_state (const XMLNode& node, int version)
 	update_route_record_state ();
 	sync_cues ();
 
+	/* I/O plugins */
+	restore_deferred_plugins ();
+
+	load_phase_done ("groups, scenes, surfaces and I/O plugins", phase_timer);
+
 	/* here beginneth the second phase ... */
 	set_snapshot_name (_current_snapshot_name);
 
@@ -2125,6 +2239,14 @@ out:
 	return ret;
 }
 
+void
+Session::load_phase_done (char const* phase, PBD::Timing& timer)
+{
+	const PBD::microseconds_t elapsed = timer.get_interval ();
+	_load_phase_times.push_back (std::make_pair (std::string (phase), elapsed));
+	DEBUG_TRACE (DEBUG::LoadState, string_compose ("load phase '%1' took %2 ms\n", phase, elapsed / 1000.0));
+}
+
 int
 Session::load_routes (const XMLNode& node, int version)
 {
@@ -2700,6 +2822,151 @@ Session::reset_write_sources (bool mark_write_complete, bool force)
 	}
 }
 
+/** Create the plain audio and MIDI file sources described by \p nodes
+ * using a few worker threads. Most of the time spent creating a source is
+ * in locating, opening and probing its file (and peak-file), which
+ * parallelizes well on large sessions.
+ *
+ * Sources are not announced, that is left to the caller, so that they are
+ * added to the session in order. Nodes for which creation fails (e.g.
+ * missing files) leave an empty entry, to be handled by ::load_sources()
+ * with the usual user interaction. Playlist sources create playlists and
+ * regions, and are always created by the caller.
+ */
+void
+Session::preload_sources (XMLNodeList const& nodes, std::vector<std::shared_ptr<Source> >& preloaded)
+{
+	std::vector<XMLNode const*> todo;
+	std::vector<size_t>         slot;
+
+	preloaded.clear ();
+	preloaded.resize (nodes.size ());
+
+	size_t n = 0;
+	for (XMLNodeConstIterator i = nodes.begin (); i != nodes.end (); ++i, ++n) {
+		if ((*i)->name () != X_("Source") || (*i)->property (X_("playlist"))) {
+			continue;
+		}
+		todo.push_back (*i);
+		slot.push_back (n);
+	}
+
+	/* not worth the overhead for a handful of sources */
+	const size_t n_threads = std::min<size_t> (std::min<uint32_t> (hardware_concurrency (), 8), todo.size () / 16);
+
+	if (n_threads < 2) {
+		return;
+	}
+
+	std::atomic<size_t> next (0);
+
+	boost::function<void ()> work = [&] () {
+		/* source state may contain musical time */
+		(void) Temporal::TempoMap::fetch ();
+		for (size_t i = next.fetch_add (1); i < todo.size (); i = next.fetch_add (1)) {
+			try {
+				preloaded[slot[i]] = SourceFactory::create (*this, *todo[i], true, false);
+			} catch (...) {
+				/* retried by ::load_sources() */
+			}
+		}
+	};
+
+	std::vector<PBD::Thread*> threads;
+
+	for (size_t t = 1; t < n_threads; ++t) {
+		PBD::Thread* thread = PBD::Thread::create (work, string_compose ("SourceLoader-%1", t));
+		if (thread) {
+			threads.push_back (thread);
+		}
+	}
+
+	/* the calling thread takes part, too */
+	work ();
+
+	for (auto& t : threads) {
+		t->join ();
+		delete t;
+	}
+
+	DEBUG_TRACE (DEBUG::LoadState, string_compose ("pre-loaded %1 sources using %2 threads\n", todo.size (), threads.size () + 1));
+}
+
+void
+Session::defer_plugin_restore (Plugin* p)
+{
+	assert (loading ());
+	Glib::Threads::Mutex::Lock lm (_deferred_plugin_lock);
+	if (std::find (_deferred_plugins.begin (), _deferred_plugins.end (), p) == _deferred_plugins.end ()) {
+		_deferred_plugins.push_back (p);
+	}
+}
+
+void
+Session::cancel_plugin_restore (Plugin* p)
+{
+	Glib::Threads::Mutex::Lock lm (_deferred_plugin_lock);
+	_deferred_plugins.erase (std::remove (_deferred_plugins.begin (), _deferred_plugins.end (), p), _deferred_plugins.end ());
+}
+
+void
+Session::restore_deferred_plugins ()
+{
+	std::vector<Plugin*> plugins;
+	{
+		Glib::Threads::Mutex::Lock lm (_deferred_plugin_lock);
+		plugins.swap (_deferred_plugins);
+	}
+
+	if (plugins.empty ()) {
+		return;
+	}
+
+	/* Instances of the same plugin are restored in sequence by the same
+	 * thread, plugins may share data between instances.
+	 */
+	std::map<std::string, std::vector<Plugin*> > by_id;
+	for (auto const& p : plugins) {
+		by_id[p->unique_id ()].push_back (p);
+	}
+
+	std::vector<std::vector<Plugin*> const*> todo;
+	for (auto const& i : by_id) {
+		todo.push_back (&i.second);
+	}
+
+	const size_t n_threads = std::min<size_t> (std::min<uint32_t> (hardware_concurrency (), 8), todo.size ());
+
+	std::atomic<size_t> next (0);
+
+	boost::function<void ()> work = [&] () {
+		(void) Temporal::TempoMap::fetch ();
+		for (size_t i = next.fetch_add (1); i < todo.size (); i = next.fetch_add (1)) {
+			for (auto const& p : *todo[i]) {
+				p->restore_deferred_state ();
+			}
+		}
+	};
+
+	std::vector<PBD::Thread*> threads;
+
+	for (size_t t = 1; t < n_threads; ++t) {
+		PBD::Thread* thread = PBD::Thread::create (work, string_compose ("PluginRestore-%1", t));
+		if (thread) {
+			threads.push_back (thread);
+		}
+	}
+
+	work ();
+
+	for (auto& t : threads) {
+		t->join ();
+		delete t;
+	}
+
+	DEBUG_TRACE (DEBUG::LoadState, string_compose ("restored state of %1 plugins using %2 threads\n", plugins.size (), threads.size () + 1));
+}
+
 int
 Session::load_sources (const XMLNode& node)
 {
@@ -2716,11 +2983,22 @@ Session::load_sources (const XMLNode& node)
 	set_dirty();
 	std::map<std::string, std::string> relocation;
 
-	for (niter = nlist.begin(); niter != nlist.end(); ++niter) {
+	std::vector<std::shared_ptr<Source> > preloaded;
+	preload_sources (nlist, preloaded);
+
+	size_t n = 0;
+
+	for (niter = nlist.begin(); niter != nlist.end(); ++niter, ++n) {
 #ifdef PLATFORM_WINDOWS
 		int old_mode = 0;
 #endif
 
+		if (preloaded[n]) {
+			/* announce in session order */
+			SourceFactory::SourceCreated (preloaded[n]); /* EMIT SIGNAL */
+			continue;
+		}
+
 		XMLNode srcnode (**niter);
 		bool try_replace_abspath = true;
 
@@ -4203,8 +4481,6 @@ Session::instant_xml (const string& node_name)
 int
 Session::save_history (string snapshot_name)
 {
-	XMLTree tree;
-
 	if (!_writable) {
 	        return 0;
 	}
@@ -4230,9 +4506,8 @@ Session::save_history (string snapshot_name)
 		return 0;
 	}
 
-	tree.set_root (&_history.get_state (Config->get_saved_history_depth()));
-
-	if (!tree.write (xml_path))
+	/* spilled transactions are copied from the undo log as they are */
+	if (!_history.write_state (xml_path, Config->get_saved_history_depth()))
 	{
 		error << string_compose (_("history could not be saved to %1"), xml_path) << endmsg;
 
@@ -4251,6 +4526,92 @@ Session::save_history (string snapshot_name)
 	return 0;
 }
 
+/** Re-create an undo transaction from its state, as written by
+ * UndoTransaction::get_state(). Used when loading the history file and
+ * when paging transactions back in from the undo log.
+ */
+UndoTransaction*
+Session::undo_transaction_factory (XMLNode const& t)
+{
+	std::string name;
+	int64_t tv_sec;
+	int64_t tv_usec;
+
+	if (!t.get_property ("name", name) || !t.get_property ("tv-sec", tv_sec) ||
+	    !t.get_property ("tv-usec", tv_usec)) {
+		return 0;
+	}
+
+	UndoTransaction* ut = new UndoTransaction ();
+	ut->set_name (name);
+
+	struct timeval tv;
+	tv.tv_sec = tv_sec;
+	tv.tv_usec = tv_usec;
+	ut->set_timestamp(tv);
+
+	for (XMLNodeConstIterator child_it  = t.children().begin();
+	     child_it != t.children().end(); child_it++)
+	{
+		XMLNode *n = *child_it;
+		Command *c;
+
+		if (n->name() == "MementoCommand" ||
+		    n->name() == "MementoUndoCommand" ||
+		    n->name() == "MementoRedoCommand") {
+
+			if ((c = memento_command_factory(n))) {
+				ut->add_command(c);
+			}
+
+		} else if (n->name() == "TempoCommand") {
+
+			ut->add_command (new TempoCommand (*n));
+
+		} else if (n->name() == "NoteDiffCommand") {
+			PBD::ID id (n->property("midi-source")->value());
+			std::shared_ptr<MidiSource> midi_source =
+				std::dynamic_pointer_cast<MidiSource, Source>(source_by_id(id));
+			if (midi_source) {
+				ut->add_command (new MidiModel::NoteDiffCommand(midi_source->model(), *n));
+			} else {
+				error << _("Failed to downcast MidiSource for NoteDiffCommand") << endmsg;
+			}
+
+		} else if (n->name() == "SysExDiffCommand") {
+
+			PBD::ID id (n->property("midi-source")->value());
+			std::shared_ptr<MidiSource> midi_source =
+				std::dynamic_pointer_cast<MidiSource, Source>(source_by_id(id));
+			if (midi_source) {
+				ut->add_command (new MidiModel::SysExDiffCommand (midi_source->model(), *n));
+			} else {
+				error << _("Failed to downcast MidiSource for SysExDiffCommand") << endmsg;
+			}
+
+		} else if (n->name() == "PatchChangeDiffCommand") {
+
+			PBD::ID id (n->property("midi-source")->value());
+			std::shared_ptr<MidiSource> midi_source =
+				std::dynamic_pointer_cast<MidiSource, Source>(source_by_id(id));
+			if (midi_source) {
+				ut->add_command (new MidiModel::PatchChangeDiffCommand (midi_source->model(), *n));
+			} else {
+				error << _("Failed to downcast MidiSource for PatchChangeDiffCommand") << endmsg;
+			}
+
+		} else if (n->name() == "StatefulDiffCommand") {
+			if ((c = stateful_diff_command_factory (n))) {
+				ut->add_command (c);
+			}
+		} else {
+			error << string_compose(_("Couldn't figure out how to make a Command out of a %1 XMLNode."), n->name()) << endmsg;
+		}
+	}
+
+	return ut;
+}
+
 int
 Session::restore_history (string snapshot_name)
 {
@@ -4282,86 +4643,10 @@ Session::restore_history (string snapshot_name)
 
 	try {
 		for (XMLNodeConstIterator it  = tree.root()->children().begin(); it != tree.root()->children().end(); ++it) {
-
-			XMLNode *t = *it;
-
-			std::string name;
-			int64_t tv_sec;
-			int64_t tv_usec;
-
-			if (!t->get_property ("name", name) || !t->get_property ("tv-sec", tv_sec) ||
-			    !t->get_property ("tv-usec", tv_usec)) {
-				continue;
+			UndoTransaction* ut = undo_transaction_factory (**it);
+			if (ut) {
+				_history.add (ut);
 			}
-
-			UndoTransaction* ut = new UndoTransaction ();
-			ut->set_name (name);
-
-			struct timeval tv;
-			tv.tv_sec = tv_sec;
-			tv.tv_usec = tv_usec;
-			ut->set_timestamp(tv);
-
-			for (XMLNodeConstIterator child_it  = t->children().begin();
-			     child_it != t->children().end(); child_it++)
-			{
-				XMLNode *n = *child_it;
-				Command *c;
-
-				if (n->name() == "MementoCommand" ||
-				    n->name() == "MementoUndoCommand" ||
-				    n->name() == "MementoRedoCommand") {
-
-					if ((c = memento_command_factory(n))) {
-						ut->add_command(c);
-					}
-
-				} else if (n->name() == "TempoCommand") {
-
-					ut->add_command (new TempoCommand (*n));
-
-				} else if (n->name() == "NoteDiffCommand") {
-					PBD::ID id (n->property("midi-source")->value());
-					std::shared_ptr<MidiSource> midi_source =
-						std::dynamic_pointer_cast<MidiSource, Source>(source_by_id(id));
-					if (midi_source) {
-						ut->add_command (new MidiModel::NoteDiffCommand(midi_source->model(), *n));
-					} else {
-						error << _("Failed to downcast MidiSource for NoteDiffCommand") << endmsg;
-					}
-
-				} else if (n->name() == "SysExDiffCommand") {
-
-					PBD::ID id (n->property("midi-source")->value());
-					std::shared_ptr<MidiSource> midi_source =
-						std::dynamic_pointer_cast<MidiSource, Source>(source_by_id(id));
-					if (midi_source) {
-						ut->add_command (new MidiModel::SysExDiffCommand (midi_source->model(), *n));
-					} else {
-						error << _("Failed to downcast MidiSource for SysExDiffCommand") << endmsg;
-					}
-
-				} else if (n->name() == "PatchChangeDiffCommand") {
-
-					PBD::ID id (n->property("midi-source")->value());
-					std::shared_ptr<MidiSource> midi_source =
-						std::dynamic_pointer_cast<MidiSource, Source>(source_by_id(id));
-					if (midi_source) {
-						ut->add_command (new MidiModel::PatchChangeDiffCommand (midi_source->model(), *n));
-					} else {
-						error << _("Failed to downcast MidiSource for PatchChangeDiffCommand") << endmsg;
-					}
-
-				} else if (n->name() == "StatefulDiffCommand") {
-					if ((c = stateful_diff_command_factory (n))) {
-						ut->add_command (c);
-					}
-				} else {
-					error << string_compose(_("Couldn't figure out how to make a Command out of a %1 XMLNode."), n->name()) << endmsg;
-				}
-			}
-
-			_history.add (ut);
 		}
 
 	} catch (std::exception const & e) {
@@ -4538,6 +4823,8 @@ Session::config_changed (std::string p, bool ours)
 		setup_fpu ();
 	} else if (p == "history-depth") {
 		set_history_depth (Config->get_history_depth());
+	} else if (p == "history-ram-depth") {
+		setup_undo_log ();
 	} else if (p == "remote-model") {
 		/* XXX DO SOMETHING HERE TO TELL THE GUI THAT WE NEED
 		   TO SET REMOTE ID'S
@@ -4656,6 +4943,15 @@ Session::set_history_depth (uint32_t d)
 	_history.set_depth (d);
 }
 
+/** Keep only the most recent part of the undo history in memory, see
+ * PBD::UndoHistory::set_spill().
+ */
+void
+Session::setup_undo_log ()
+{
+	_history.set_spill (Glib::build_filename (_path, legalize_for_path (_name) + undo_log_suffix), std::max (0, Config->get_history_ram_depth ()), boost::bind (&Session::undo_transaction_factory, this, _1));
+}
+
 /** Connect things to the MMC object */
 void
 Session::setup_midi_machine_control ()
@@ -5655,6 +5951,139 @@ Session::save_as (SaveAs& saveas)
 	return 0;
 }
 
+namespace {
+
+struct ArchiveEncodeJob {
+	ArchiveEncodeJob (std::shared_ptr<AudioFileSource> s, std::string const& p, int dup = -1)
+		: afs (s)
+		, new_path (p)
+		, dup_of (dup)
+		, encoded (false)
+		, failed (false)
+		, gain (1.f)
+		, file_size (0)
+	{}
+
+	std::shared_ptr<AudioFileSource> afs;
+	std::string new_path;
+	int         dup_of;  ///< index of the job that encodes the same file and channel
+	bool        encoded;
+	bool        failed;
+	float       gain;
+	off_t       file_size;
+};
+
+/* Progress of a single job, read by the thread that reports overall progress */
+class ArchiveEncodeProgress : public Progress
+{
+public:
+	ArchiveEncodeProgress () : _p (0) {}
+	float progress () const { return _p.load (std::memory_order_relaxed); }
+
+private:
+	void set_overall_progress (float p) { _p.store (p, std::memory_order_relaxed); }
+	std::atomic<float> _p;
+};
+
+/* Encode sources concurrently. The calling thread reports progress,
+ * which must not be done by the worker threads (it may call into the GUI).
+ */
+int
+encode_for_archive (Session& session, std::vector<ArchiveEncodeJob>& jobs, bool use16bits, Progress* progress)
+{
+	std::vector<size_t> todo;
+	for (size_t i = 0; i < jobs.size (); ++i) {
+		if (jobs[i].dup_of < 0) {
+			todo.push_back (i);
+			GStatBuf statbuf;
+			if (g_stat (jobs[i].afs->path ().c_str (), &statbuf) == 0) {
+				jobs[i].file_size = statbuf.st_size;
+			}
+		}
+	}
+
+	if (todo.empty ()) {
+		return 0;
+	}
+
+	std::vector<ArchiveEncodeProgress> job_progress (todo.size ());
+	std::atomic<size_t> next (0);
+	std::atomic<size_t> finished (0);
+	std::atomic<bool>   failed (false);
+	std::atomic<bool>   stop (false);
+
+	boost::function<void ()> work = [&] () {
+		for (size_t i = next.fetch_add (1); i < todo.size () && !stop.load (); i = next.fetch_add (1)) {
+			ArchiveEncodeJob& j (jobs[todo[i]]);
+			try {
+				SndFileSource* ns = new SndFileSource (session, *(j.afs.get()), j.new_path, use16bits, &job_progress[i]);
+				j.gain    = ns->gain ();
+				j.encoded = true;
+				delete ns;
+			} catch (...) {
+				j.failed = true;
+				failed   = true;
+				stop     = true;
+			}
+		}
+		finished.fetch_add (1);
+	};
+
+	const size_t n_threads = std::min<size_t> (std::min<uint32_t> (hardware_concurrency (), 8), todo.size ());
+
+	std::vector<PBD::Thread*> threads;
+	for (size_t t = 0; t < n_threads; ++t) {
+		PBD::Thread* thread = PBD::Thread::create (work, string_compose ("ArchiveEncoder-%1", t));
+		if (thread) {
+			threads.push_back (thread);
+		}
+	}
+
+	if (threads.empty ()) {
+		work ();
+	} else {
+		samplecnt_t total_samples = 0;
+		for (auto const& i : todo) {
+			total_samples += jobs[i].afs->readable_length_samples ();
+		}
+
+		const int64_t start = g_get_monotonic_time ();
+
+		while (finished.load () < threads.size ()) {
+			Glib::usleep (100000);
+			if (!progress) {
+				continue;
+			}
+			double done_samples = 0;
+			double done_bytes   = 0;
+			for (size_t i = 0; i < todo.size (); ++i) {
+				done_samples += job_progress[i].progress () * jobs[todo[i]].afs->readable_length_samples ();
+				done_bytes   += job_progress[i].progress () * jobs[todo[i]].file_size;
+			}
+			progress->set_progress (total_samples > 0 ? done_samples / total_samples : 0);
+			progress->set_rate (done_bytes * 1e6 / std::max<int64_t> (1, g_get_monotonic_time () - start));
+			if (progress->cancelled ()) {
+				stop = true;
+			}
+		}
+
+		for (auto& t : threads) {
+			t->join ();
+			delete t;
+		}
+	}
+
+	for (auto const& i : todo) {
+		if (jobs[i].failed) {
+			error << "failed to encode " << jobs[i].afs->path() << " to " << jobs[i].new_path << endmsg;
+		}
+	}
+
+	return failed ? -1 : 0;
+}
+
+} // anonymous namespace
+
 int
 Session::archive_session (const std::string& dest,
                           const std::string& name,
@@ -5732,6 +6161,7 @@ Session::archive_session (const std::string& dest,
 	do_not_copy_extensions.push_back (backup_suffix);
 	do_not_copy_extensions.push_back (temp_suffix);
 	do_not_copy_extensions.push_back (history_suffix);
+	do_not_copy_extensions.push_back (undo_log_suffix);
 	do_not_copy_extensions.push_back (".DS_Store");
 
 	vector<string> blacklist_dirs;
@@ -5752,10 +6182,9 @@ Session::archive_session (const std::string& dest,
 		collect_sources_of_this_snapshot (sources_used_by_this_snapshot, false);
 	}
 
-	/* collect audio sources for this session, calc total size for encoding
+	/* collect audio sources for this session, which are copied as-is
 	 * add option to only include *used* sources (see Session::cleanup_sources)
 	 */
-	size_t total_size = 0;
 	{
 		Glib::Threads::Mutex::Lock lm (source_lock);
 
@@ -5800,9 +6229,7 @@ Session::archive_session (const std::string& dest,
 
 			std::string from = afs->path();
 
-			if (compress_audio != NO_ENCODE) {
-				total_size += afs->readable_length_samples ();
-			} else {
+			if (compress_audio == NO_ENCODE) {
 				/* copy files as-is */
 				if (!afs->within_session()) {
 					string to = Glib::path_get_basename (from);
@@ -5851,69 +6278,83 @@ Session::archive_session (const std::string& dest,
 			progress->set_progress (0);
 		}
 
-		Glib::Threads::Mutex::Lock lm (source_lock);
-		for (SourceMap::const_iterator i = sources.begin(); i != sources.end(); ++i) {
-			if (std::dynamic_pointer_cast<SilentFileSource> (i->second)) {
-				continue;
-			}
-			std::shared_ptr<AudioFileSource> afs = std::dynamic_pointer_cast<AudioFileSource> (i->second);
-			if (!afs || afs->length ().is_zero ()) {
-				continue;
-			}
+		std::vector<ArchiveEncodeJob> jobs;
+		{
+			Glib::Threads::Mutex::Lock lm (source_lock);
 
-			if (only_used_sources) {
-				if (!afs->used()) {
+			/* sources using the same file, channel and gain are encoded once */
+			typedef std::tuple<std::string, uint16_t, float> EncodeKey;
+			std::map<EncodeKey, size_t> encoded;
+			std::set<std::string> new_paths;
+
+			for (SourceMap::const_iterator i = sources.begin(); i != sources.end(); ++i) {
+				if (std::dynamic_pointer_cast<SilentFileSource> (i->second)) {
 					continue;
 				}
-				if (sources_used_by_this_snapshot.find (afs) == sources_used_by_this_snapshot.end ()) {
+				std::shared_ptr<AudioFileSource> afs = std::dynamic_pointer_cast<AudioFileSource> (i->second);
+				if (!afs || afs->length ().is_zero ()) {
 					continue;
 				}
-			}
 
-			orig_sources[afs] = afs->path();
-			orig_gain[afs]    = afs->gain();
-			orig_channel[afs] = afs->channel();
+				if (only_used_sources) {
+					if (!afs->used()) {
+						continue;
+					}
+					if (sources_used_by_this_snapshot.find (afs) == sources_used_by_this_snapshot.end ()) {
+						continue;
+					}
+				}
 
-			std::string new_path = make_new_media_path (afs->path (), to_dir, name);
+				orig_sources[afs] = afs->path();
+				orig_gain[afs]    = afs->gain();
+				orig_channel[afs] = afs->channel();
 
-			std::string channelsuffix = "";
-			if (afs->channel() > 0) {  /* n_channels() is /wrongly/ 1. */
-				/* embedded external multi-channel files are converted to multiple-mono */
-				channelsuffix = string_compose ("-c%1", afs->channel ());
-			}
-			new_path = Glib::build_filename (Glib::path_get_dirname (new_path), PBD::basename_nosuffix (new_path) + channelsuffix + ".flac");
-			g_mkdir_with_parents (Glib::path_get_dirname (new_path).c_str (), 0755);
+				EncodeKey key (afs->path (), afs->channel (), afs->gain ());
+				std::map<EncodeKey, size_t>::const_iterator e = encoded.find (key);
+				if (e != encoded.end ()) {
+					jobs.push_back (ArchiveEncodeJob (afs, jobs[e->second].new_path, e->second));
+					continue;
+				}
 
-			/* avoid name collisions of external files with same name */
-			if (Glib::file_test (new_path, Glib::FILE_TEST_EXISTS)) {
-				new_path = Glib::build_filename (Glib::path_get_dirname (new_path), PBD::basename_nosuffix (new_path) + channelsuffix + "-1.flac");
-			}
-			while (Glib::file_test (new_path, Glib::FILE_TEST_EXISTS)) {
-				new_path = bump_name_once (new_path, '-');
-			}
+				std::string new_path = make_new_media_path (afs->path (), to_dir, name);
 
-			if (progress) {
-				progress->descend ((float)afs->readable_length_samples () / total_size);
-			}
+				std::string channelsuffix = "";
+				if (afs->channel() > 0) {  /* n_channels() is /wrongly/ 1. */
+					/* embedded external multi-channel files are converted to multiple-mono */
+					channelsuffix = string_compose ("-c%1", afs->channel ());
+				}
+				new_path = Glib::build_filename (Glib::path_get_dirname (new_path), PBD::basename_nosuffix (new_path) + channelsuffix + ".flac");
+				g_mkdir_with_parents (Glib::path_get_dirname (new_path).c_str (), 0755);
 
-			try {
-				SndFileSource* ns = new SndFileSource (*this, *(afs.get()), new_path, compress_audio == FLAC_16BIT, progress);
-				afs->replace_file (new_path);
-				afs->set_gain (ns->gain(), true);
-				afs->set_channel (0);
-				delete ns;
-			} catch (...) {
-				error << "failed to encode " << afs->path() << " to " << new_path << endmsg;
-				rv = -1;
-				break;
+				/* avoid name collisions of external files with same name,
+				 * files are only created later, when encoding.
+				 */
+				if (Glib::file_test (new_path, Glib::FILE_TEST_EXISTS) || new_paths.find (new_path) != new_paths.end ()) {
+					new_path = Glib::build_filename (Glib::path_get_dirname (new_path), PBD::basename_nosuffix (new_path) + channelsuffix + "-1.flac");
+				}
+				while (Glib::file_test (new_path, Glib::FILE_TEST_EXISTS) || new_paths.find (new_path) != new_paths.end ()) {
+					new_path = bump_name_once (new_path, '-');
+				}
+				new_paths.insert (new_path);
+
+				encoded[key] = jobs.size ();
+				jobs.push_back (ArchiveEncodeJob (afs, new_path));
 			}
+		}
 
-			if (progress) {
-				progress->ascend ();
-				if (progress->cancelled ()) {
-					break;
-				}
+		rv = encode_for_archive (*this, jobs, compress_audio == FLAC_16BIT, progress);
+
+		for (auto& j : jobs) {
+			if (!j.encoded && j.dup_of < 0) {
+				continue;
+			}
+			ArchiveEncodeJob const& src (j.dup_of < 0 ? j : jobs[j.dup_of]);
+			if (!src.encoded) {
+				continue;
 			}
+			j.afs->replace_file (src.new_path);
+			j.afs->set_gain (src.gain, true);
+			j.afs->set_channel (0);
 		}
 	}
 
@@ -6002,6 +6443,7 @@ Session::archive_session (const std::string& dest,
 	/* collect session-state files */
 	do_not_copy_extensions.clear ();
 	do_not_copy_extensions.push_back (history_suffix);
+	do_not_copy_extensions.push_back (undo_log_suffix);
 
 	blacklist_dirs.clear ();
 	blacklist_dirs.push_back (string (externals_dir_name) + G_DIR_SEPARATOR);
@@ -6050,7 +6492,7 @@ out:
 	}
 
 	if (0 == rv && !(progress && progress->cancelled ())) {
-		rv = ar.create (filemap, compression_level);
+		rv = ar.create (filemap, compression_level, true);
 		if (rv) {
 			error << string_compose(_("Session archive failed write output: `%1'"), archive) << endmsg;
 		}
@@ -169,7 +169,7 @@ SourceFactory::createSilent (Session& s, const XMLNode& node, samplecnt_t nframe
 }
 
 std::shared_ptr<Source>
-SourceFactory::create (Session& s, const XMLNode& node, bool defer_peaks)
+SourceFactory::create (Session& s, const XMLNode& node, bool defer_peaks, bool announce)
 {
 	DataType           type = DataType::AUDIO;
 	XMLProperty const* prop = node.property ("type");
@@ -191,7 +191,9 @@ SourceFactory::create (Session& s, const XMLNode& node, bool defer_peaks)
 
 				ap->check_for_analysis_data_on_disk ();
 
-				SourceCreated (ap);
+				if (announce) {
+					SourceCreated (ap);
+				}
 				return ap;
 
 			} catch (failed_constructor&) {
@@ -207,7 +209,9 @@ SourceFactory::create (Session& s, const XMLNode& node, bool defer_peaks)
 					throw failed_constructor ();
 				}
 				ret->check_for_analysis_data_on_disk ();
-				SourceCreated (ret);
+				if (announce) {
+					SourceCreated (ret);
+				}
 				return ret;
 			} catch (failed_constructor& err) {
 			}
@@ -223,7 +227,9 @@ SourceFactory::create (Session& s, const XMLNode& node, bool defer_peaks)
 				}
 
 				ret->check_for_analysis_data_on_disk ();
-				SourceCreated (ret);
+				if (announce) {
+					SourceCreated (ret);
+				}
 				return ret;
 			} catch (...) {
 			}
@@ -237,7 +243,9 @@ SourceFactory::create (Session& s, const XMLNode& node, bool defer_peaks)
 			std::shared_ptr<SMFSource> src (new SMFSource (s, node));
 			BOOST_MARK_SOURCE (src);
 			src->check_for_analysis_data_on_disk ();
-			SourceCreated (src);
+			if (announce) {
+				SourceCreated (src);
+			}
 			return src;
 		} catch (...) {
 		}
@@ -44,14 +44,18 @@ SrcFileSource::SrcFileSource (Session& s, std::shared_ptr<AudioFileSource> src,
 
 	int src_type = SRC_SINC_BEST_QUALITY;
 
+	/* mono, on demand: zita-resampler qualities use the libsamplerate equivalent */
 	switch (srcq) {
 		case SrcBest:
+		case SrcZitaBest:
 			src_type = SRC_SINC_BEST_QUALITY;
 			break;
 		case SrcGood:
+		case SrcZitaGood:
 			src_type = SRC_SINC_MEDIUM_QUALITY;
 			break;
 		case SrcQuick:
+		case SrcZitaFast:
 			src_type = SRC_SINC_FASTEST;
 			break;
 		case SrcFast:
@@ -18,6 +18,12 @@
  */
 
 #include <xmmintrin.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <cmath>
+
+#include "ardour/mix.h"
 #include "ardour/types.h"
 
 void
@@ -114,5 +120,74 @@ x86_sse_find_peaks(const ARDOUR::Sample* buf, ARDOUR::pframes_t nframes, float *
 	_mm_store_ss(max, work);
 }
 
+#ifdef __SSE2__
+
+/* export sample format conversion, see AudioGrapher::Routines
+ * values are clipped before conversion, since an out-of-range
+ * _mm_cvtps_epi32() yields INT_MIN regardless of the sign.
+ */
+
+void
+x86_sse2_float_to_int16 (int16_t* dst, float const* src, uint32_t nframes, float const* noise)
+{
+	__m128 const scale = _mm_set1_ps (32768.f);
+	__m128 const lo    = _mm_set1_ps (-32768.f);
+	__m128 const hi    = _mm_set1_ps (32767.f);
+
+	while (nframes >= 8) {
+		__m128 a = _mm_mul_ps (_mm_loadu_ps (src), scale);
+		__m128 b = _mm_mul_ps (_mm_loadu_ps (src + 4), scale);
+		if (noise) {
+			a = _mm_sub_ps (a, _mm_loadu_ps (noise));
+			b = _mm_sub_ps (b, _mm_loadu_ps (noise + 4));
+			noise += 8;
+		}
+		a = _mm_min_ps (_mm_max_ps (a, lo), hi);
+		b = _mm_min_ps (_mm_max_ps (b, lo), hi);
+		_mm_storeu_si128 ((__m128i*) dst, _mm_packs_epi32 (_mm_cvtps_epi32 (a), _mm_cvtps_epi32 (b)));
+		src += 8;
+		dst += 8;
+		nframes -= 8;
+	}
+
+	for (uint32_t i = 0; i < nframes; ++i) {
+		float s = src[i] * 32768.f;
+		if (noise) {
+			s -= noise[i];
+		}
+		long r = lrintf (s);
+		dst[i] = (int16_t) (r > 32767 ? 32767 : (r < -32768 ? -32768 : r));
+	}
+}
+
+void
+x86_sse2_float_to_int24 (int32_t* dst, float const* src, uint32_t nframes, float const* noise)
+{
+	__m128 const scale = _mm_set1_ps (8388608.f);
+	__m128 const lo    = _mm_set1_ps (-8388608.f);
+	__m128 const hi    = _mm_set1_ps (8388607.f);
+
+	while (nframes >= 4) {
+		__m128 a = _mm_mul_ps (_mm_loadu_ps (src), scale);
+		if (noise) {
+			a = _mm_sub_ps (a, _mm_loadu_ps (noise));
+			noise += 4;
+		}
+		__m128i r = _mm_cvtps_epi32 (_mm_min_ps (_mm_max_ps (a, lo), hi));
+		_mm_storeu_si128 ((__m128i*) dst, _mm_slli_epi32 (r, 8));
+		src += 4;
+		dst += 4;
+		nframes -= 4;
+	}
 
+	for (uint32_t i = 0; i < nframes; ++i) {
+		float s = src[i] * 8388608.f;
+		if (noise) {
+			s -= noise[i];
+		}
+		long r = lrintf (s);
+		dst[i] = (int32_t) (r > 8388607 ? 8388607 : (r < -8388608 ? -8388608 : r)) * 256;
+	}
+}
 
+#endif
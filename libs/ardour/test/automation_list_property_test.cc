@@ -180,3 +180,107 @@ AutomationListPropertyTest::undoTest ()
 	write_automation_list_xml (&sheila->get_state(), test_data_filename);
 	check_xml (&sheila->get_state(), test_data_file4, ignore_properties);
 }
+
+static std::string
+events_content (AutomationList const& al)
+{
+	XMLNode& node (al.get_state ());
+	XMLNode const* events = node.child (X_("events"));
+	CPPUNIT_ASSERT (events);
+	std::string content = events->children ().front ()->content ();
+	delete &node;
+	return content;
+}
+
+/** Check that re-using the serialized events does not hide later edits */
+void
+AutomationListPropertyTest::cachedStateTest ()
+{
+	AutomationList al (Evoral::Parameter (GainAutomation), Temporal::TimeDomainProvider (Temporal::AudioTime));
+
+	al.add (timepos_t (0), 0.5, false, false);
+	al.add (timepos_t (100), 1.0, false, false);
+
+	std::string const first = events_content (al);
+	CPPUNIT_ASSERT_EQUAL (first, events_content (al));
+
+	al.add (timepos_t (200), 0.25, false, false);
+	std::string const second = events_content (al);
+	CPPUNIT_ASSERT (first != second);
+	CPPUNIT_ASSERT_EQUAL (events_content (AutomationList (al)), second);
+
+	al.modify (al.begin (), timepos_t (0), 0.75);
+	CPPUNIT_ASSERT (second != events_content (al));
+	CPPUNIT_ASSERT_EQUAL (events_content (AutomationList (al)), events_content (al));
+
+	al.freeze ();
+	al.clear ();
+	al.add (timepos_t (0), 0.5, false, false);
+	al.add (timepos_t (100), 1.0, false, false);
+	al.thaw ();
+	CPPUNIT_ASSERT_EQUAL (first, events_content (al));
+}
+
+/** Round-trip a large list through a binary sidecar file */
+void
+AutomationListPropertyTest::sidecarTest ()
+{
+	std::string const dir = new_test_output_dir ("automation_sidecar");
+
+	AutomationList al (Evoral::Parameter (GainAutomation), Temporal::TimeDomainProvider (Temporal::AudioTime));
+
+	for (int i = 0; i < 1000; ++i) {
+		al.fast_simple_add (timepos_t (samplepos_t (i) * 64), (i % 100) / 100.0);
+	}
+
+	std::string const inline_events = events_content (al);
+
+	XMLNode* state;
+	{
+		AutomationList::SidecarScope sidecar (dir);
+		state = &al.get_state ();
+	}
+
+	XMLNode const* events = state->child (X_("events"));
+	CPPUNIT_ASSERT (events);
+	CPPUNIT_ASSERT (events->children ().empty ());
+
+	std::string name;
+	CPPUNIT_ASSERT (events->get_property (X_("sidecar"), name));
+	CPPUNIT_ASSERT (Glib::file_test (Glib::build_filename (dir, name), Glib::FILE_TEST_EXISTS));
+
+	AutomationList copy (Evoral::Parameter (GainAutomation), Temporal::TimeDomainProvider (Temporal::AudioTime));
+	{
+		AutomationList::SidecarScope sidecar (dir);
+		CPPUNIT_ASSERT_EQUAL (0, copy.set_state (*state, Stateful::loading_state_version));
+	}
+
+	/* events are only read on first use */
+	CPPUNIT_ASSERT (copy.events_deferred ());
+	CPPUNIT_ASSERT_EQUAL ((size_t) 1000, copy.size ());
+
+	/* saving an unused list refers to the same file */
+	XMLNode* resaved;
+	{
+		AutomationList::SidecarScope sidecar (dir);
+		resaved = &copy.get_state ();
+	}
+	CPPUNIT_ASSERT (copy.events_deferred ());
+
+	std::string rename;
+	CPPUNIT_ASSERT (resaved->child (X_("events"))->get_property (X_("sidecar"), rename));
+	CPPUNIT_ASSERT_EQUAL (name, rename);
+
+	CPPUNIT_ASSERT_EQUAL (inline_events, events_content (copy));
+	CPPUNIT_ASSERT (!copy.events_deferred ());
+	CPPUNIT_ASSERT_EQUAL ((size_t) 1000, copy.size ());
+
+	/* state taken to another session carries the events inline */
+	XMLNode imported (*state);
+	CPPUNIT_ASSERT_EQUAL (0, AutomationList::inline_sidecar_events (imported, dir));
+	CPPUNIT_ASSERT (!imported.child (X_("events"))->property (X_("sidecar")));
+	CPPUNIT_ASSERT_EQUAL (inline_events, imported.child (X_("events"))->children ().front ()->content ());
+
+	delete resaved;
+	delete state;
+}
@@ -0,0 +1,123 @@
+#include <cmath>
+#include <iostream>
+#include <cstdlib>
+
+#include "pbd/timing.h"
+
+#include "evoral/ControlList.h"
+
+#include "ardour/ardour.h"
+#include "ardour/audioengine.h"
+
+#include "test_ui.h"
+#include "test_util.h"
+
+using namespace std;
+using namespace ARDOUR;
+using namespace Temporal;
+
+static const char* localedir = LOCALEDIR;
+
+static std::shared_ptr<Evoral::ControlList>
+make_list (int n_points, Evoral::ControlList::InterpolationStyle style)
+{
+	Evoral::ParameterDescriptor desc;
+	desc.upper  = 1.0;
+	desc.normal = 0.5;
+
+	std::shared_ptr<Evoral::ControlList> cl (new Evoral::ControlList (Evoral::Parameter (0), desc, TimeDomainProvider (AudioTime)));
+	cl->set_interpolation (style);
+
+	/* dense, touch-pass like data: one point every 64 samples */
+	for (int i = 0; i < n_points; ++i) {
+		cl->fast_simple_add (timepos_t (samplepos_t (i) * 64), 0.5 + 0.5 * sin (i / 1000.0));
+	}
+
+	return cl;
+}
+
+static void
+report (char const* what, PBD::Timing& t, int n)
+{
+	t.update ();
+	cout << what << ": " << t.elapsed_msecs () << " ms (" << (double) t.elapsed () * 1000.0 / n << " ns/op)\n";
+}
+
+int
+main (int argc, char* argv[])
+{
+	int n_points = 1000000;
+
+	if (argc > 1) {
+		n_points = atoi (argv[1]);
+	}
+
+	ARDOUR::init (true, localedir);
+	TestUI* test_ui = new TestUI();
+	create_and_start_dummy_backend ();
+
+	cout << "INFO: " << n_points << " points per list\n";
+
+	{
+		PBD::Timing t;
+		std::shared_ptr<Evoral::ControlList> cl = make_list (n_points, Evoral::ControlList::Linear);
+		report ("populate", t, n_points);
+
+		/* sequential eval, as done during playback */
+		const samplepos_t end = samplepos_t (n_points) * 64;
+		double sum = 0;
+		int n = 0;
+
+		t.start ();
+		for (samplepos_t s = 0; s < end; s += 32, ++n) {
+			sum += cl->unlocked_eval (timepos_t (s));
+		}
+		report ("eval (linear, sequential)", t, n);
+
+		cl->set_interpolation (Evoral::ControlList::Discrete);
+
+		n = 0;
+		t.start ();
+		for (samplepos_t s = 0; s < end; s += 32, ++n) {
+			sum += cl->unlocked_eval (timepos_t (s));
+		}
+		report ("eval (discrete, sequential)", t, n);
+
+		/* discrete event lookup, as done by automation playback */
+		timepos_t x;
+		double y;
+		n = 0;
+
+		t.start ();
+		for (timepos_t pos; cl->rt_safe_earliest_event_discrete_unlocked (pos, x, y, false); pos = x, ++n) {
+			sum += y;
+		}
+		report ("earliest event (discrete)", t, n);
+
+		cerr << "(" << sum << ")\n";
+
+		t.start ();
+		cl->thin (20.0);
+		report ("thin", t, n_points);
+		cout << "INFO: " << cl->size () << " points after thinning\n";
+	}
+
+	{
+		std::shared_ptr<Evoral::ControlList> cl  = make_list (n_points, Evoral::ControlList::Linear);
+		std::shared_ptr<Evoral::ControlList> src = make_list (n_points / 10, Evoral::ControlList::Linear);
+
+		PBD::Timing t;
+		cl->paste (*src, timepos_t (samplepos_t (n_points) * 32));
+		report ("paste", t, n_points / 10);
+
+		t.start ();
+		cl.reset ();
+		src.reset ();
+		report ("destroy", t, n_points + n_points / 10);
+	}
+
+	stop_and_destroy_backend ();
+	delete test_ui;
+	ARDOUR::cleanup ();
+	return 0;
+}
@@ -41,6 +41,15 @@ int main (int argc, char* argv[])
 		exit (EXIT_FAILURE);
 	}
 
+	PBD::microseconds_t total = 0;
+
+	for (auto const& p : s->load_phase_times ()) {
+		cout << p.first << ": " << p.second / 1000.0 << " ms\n";
+		total += p.second;
+	}
+
+	cout << "total: " << total / 1000.0 << " ms\n";
+
 	AudioEngine::instance()->remove_session ();
 	delete s;
 	AudioEngine::instance()->stop ();
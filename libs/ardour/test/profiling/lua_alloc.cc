@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+#include "pbd/reallocpool.h"
+#include "pbd/slab_pool.h"
+#include "pbd/timing.h"
+#include "pbd/tlsf.h"
+
+#include "lua/luastate.h"
+
+using namespace std;
+
+/* allocation pattern of a DSP script: short-lived tables and strings
+ * every cycle, a few longer-lived ones, and an incremental GC step
+ * after each cycle (as done by LuaProc::connect_and_run).
+ */
+static const char* churn_script =
+	"local keep = {}\n"
+	"function dsp_run (n)\n"
+	"  local t = {}\n"
+	"  for i = 1, 64 do\n"
+	"    t[i] = { i, i * 2, tostring (i) .. 'x' }\n"
+	"  end\n"
+	"  local s = ''\n"
+	"  for i = 1, 8 do s = s .. string.format ('%d,', n + i) end\n"
+	"  keep[n % 512] = { s = s, v = t[n % 64 + 1] }\n"
+	"end\n";
+
+static void
+report (PBD::ReallocPool&)
+{
+}
+
+static void
+report (PBD::TLSF& pool)
+{
+	cout << "INFO: used " << pool.get_used_size () << " bytes, peak " << pool.get_max_size () << " bytes\n";
+}
+
+static void
+report (PBD::SlabPool& pool)
+{
+	PBD::SlabPool::Stats s (pool.stats ());
+	cout << "INFO: used " << s.used << " bytes, peak " << s.peak_used << " bytes, reserved " << s.reserved
+	     << " bytes, fragmentation " << 100.f * s.fragmentation () << "%, failed " << s.n_failed << "\n";
+}
+
+template <class Pool>
+static void
+run (char const* what, Pool& pool, int n_cycles)
+{
+	LuaState lua (lua_newstate (&Pool::lalloc, &pool));
+	lua.do_command (churn_script);
+
+	lua_State* L = lua.getState ();
+
+	PBD::Timing t;
+	for (int i = 0; i < n_cycles; ++i) {
+		lua_getglobal (L, "dsp_run");
+		lua_pushinteger (L, i);
+		if (lua_pcall (L, 1, 0, 0)) {
+			cout << what << ": failed after " << i << " cycles: " << lua_tostring (L, -1) << "\n";
+			lua_pop (L, 1);
+			n_cycles = std::max (1, i);
+			break;
+		}
+		lua.collect_garbage_step ();
+	}
+	t.update ();
+
+	cout << what << ": " << t.elapsed_msecs () << " ms (" << (double) t.elapsed () / n_cycles << " us/cycle)\n";
+	report (pool);
+}
+
+int
+main (int argc, char* argv[])
+{
+	int n_cycles = 20000;
+
+	if (argc > 1) {
+		n_cycles = atoi (argv[1]);
+	}
+
+	cout << "INFO: " << n_cycles << " cycles\n";
+
+	{
+		PBD::ReallocPool pool ("ReallocPool", 3145728);
+		run ("ReallocPool", pool, n_cycles);
+	}
+	{
+		PBD::TLSF pool ("TLSF", 3145728);
+		run ("TLSF", pool, n_cycles);
+	}
+	{
+		PBD::SlabPool pool ("SlabPool", 3145728);
+		run ("SlabPool", pool, n_cycles);
+	}
+
+	return 0;
+}
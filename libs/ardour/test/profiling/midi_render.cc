@@ -0,0 +1,83 @@
+#include <iostream>
+#include <cstdlib>
+
+#include "pbd/timing.h"
+
+#include "ardour/ardour.h"
+#include "ardour/midi_playlist.h"
+#include "ardour/midi_region.h"
+#include "ardour/midi_track.h"
+#include "ardour/session.h"
+
+#include "test_ui.h"
+#include "test_util.h"
+
+using namespace std;
+using namespace ARDOUR;
+using namespace Temporal;
+
+static const char* localedir = LOCALEDIR;
+
+static void
+render (char const* what, std::shared_ptr<MidiPlaylist> playlist)
+{
+	PBD::Timing t;
+	playlist->render (0);
+	t.update ();
+	cout << what << ": " << t.elapsed_msecs () << " ms, " << playlist->rendered ()->size () << " events\n";
+}
+
+int
+main (int argc, char* argv[])
+{
+	int n_copies = 1000;
+
+	if (argc > 1) {
+		n_copies = atoi (argv[1]);
+	}
+
+	ARDOUR::init (true, localedir);
+	TestUI* test_ui = new TestUI();
+	create_and_start_dummy_backend ();
+	Session* session = load_session ("../libs/ardour/test/profiling/sessions/1region", "1region");
+
+	{
+		std::shared_ptr<MidiTrack> track = std::dynamic_pointer_cast<MidiTrack> (session->get_routes()->back());
+		assert (track);
+
+		std::shared_ptr<MidiPlaylist> playlist = std::dynamic_pointer_cast<MidiPlaylist> (track->playlist ());
+		assert (playlist);
+
+		std::shared_ptr<MidiRegion> region = std::dynamic_pointer_cast<MidiRegion> (playlist->region_list_property().rlist().front());
+		assert (region);
+
+		timepos_t pos (region->last_sample() + 1);
+		playlist->duplicate (region, pos, n_copies);
+
+		cout << "INFO: " << playlist->n_regions () << " regions\n";
+
+		render ("initial render", playlist);
+		render ("render, unchanged", playlist);
+
+		/* a small edit: move one region by a few samples */
+		std::shared_ptr<Region> r = playlist->region_list_property().rlist().back();
+		r->set_position (r->position () + timecnt_t (64));
+		render ("render, one region moved", playlist);
+
+		r->set_muted (true);
+		render ("render, one region muted", playlist);
+
+		r->set_muted (false);
+		render ("render, one region unmuted", playlist);
+
+		/* the regions share one model, so this edit affects all of them */
+		region->model()->ContentsChanged (); /* EMIT SIGNAL */
+		render ("render, model changed", playlist);
+	}
+
+	delete session;
+	stop_and_destroy_backend ();
+	delete test_ui;
+	ARDOUR::cleanup ();
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "pbd/fpu.h"
+#include "pbd/timing.h"
+
+#include "ardour/mix.h"
+
+#include "audiographer/general/sample_format_converter.h"
+#include "audiographer/routines.h"
+#include "audiographer/sink.h"
+
+using namespace std;
+using namespace AudioGrapher;
+
+/* throughput of the export sample format conversion,
+ * for each available conversion routine, output format and dither type.
+ */
+
+template <typename T>
+class LastSink : public Sink<T>
+{
+  public:
+	LastSink () : samples (0) {}
+	void process (ProcessContext<T> const& c) {
+		samples += c.samples ();
+		data.assign (c.data (), c.data () + c.samples ());
+	}
+	using Sink<T>::process;
+	samplecnt_t samples;
+	vector<T>   data;
+};
+
+static char const* dither_name[] = { "none", "rect", "tri " };
+
+template <typename T>
+static vector<T>
+run (char const* what, int type, int width, uint32_t channels, int seconds, vector<float> const& data)
+{
+	samplecnt_t const block = data.size ();
+
+	std::shared_ptr<LastSink<T> > sink (new LastSink<T>);
+	SampleFormatConverter<T> sfc (channels);
+	sfc.init (block, type, width);
+	sfc.add_output (sink);
+
+	samplecnt_t const n_blocks = seconds * 48000 / 1024;
+
+	PBD::Timing t;
+	for (samplecnt_t i = 0; i < n_blocks; ++i) {
+		ProcessContext<float> const c (&data[0], block, channels);
+		sfc.process (c);
+	}
+	t.update ();
+
+	double const sec = t.elapsed () / 1e6;
+	cout << what << " " << width << " bit " << dither_name[type] << ": "
+	     << t.elapsed_msecs () << " ms, " << seconds / sec << "x realtime, "
+	     << n_blocks * block / sec / 1e6 << " Msamples/s\n";
+
+	return sink->data;
+}
+
+static bool
+run_all (char const* what, uint32_t channels, int seconds, vector<float> const& data, vector<int16_t>& ref16, vector<int32_t>& ref24)
+{
+	bool ok = true;
+	for (int type = D_None; type <= D_Tri; ++type) {
+		vector<int16_t> o16 = run<int16_t> (what, type, 16, channels, seconds, data);
+		vector<int32_t> o24 = run<int32_t> (what, type, 24, channels, seconds, data);
+		if (type != D_None) {
+			continue;
+		}
+		/* undithered conversion is exact, compare to the generic routines */
+		if (ref16.empty ()) {
+			ref16 = o16;
+			ref24 = o24;
+		} else if (o16 != ref16 || o24 != ref24) {
+			cout << "ERROR: " << what << " does not match the generic conversion\n";
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+int
+main (int argc, char* argv[])
+{
+	uint32_t channels = 64;
+	int      seconds  = 10;
+
+	if (argc > 1) {
+		channels = atoi (argv[1]);
+	}
+	if (argc > 2) {
+		seconds = atoi (argv[2]);
+	}
+
+	cout << "INFO: " << channels << " channels, " << seconds << " sec\n";
+
+	samplecnt_t const block = 1024 * channels;
+	vector<float> data (block);
+	for (samplecnt_t i = 0; i < block; ++i) {
+		/* include some overs, to exercise clipping */
+		data[i] = 2.2f * ((rand () / (float) RAND_MAX) - .5f);
+	}
+
+	vector<int16_t> ref16;
+	vector<int32_t> ref24;
+	bool ok = run_all ("generic", channels, seconds, data, ref16, ref24);
+
+#if defined(ARCH_X86) && defined(BUILD_SSE_OPTIMIZATIONS)
+	PBD::FPU* fpu = PBD::FPU::instance ();
+#ifdef __SSE2__
+	if (fpu->has_sse2 ()) {
+		Routines::override_float_to_int16 (x86_sse2_float_to_int16);
+		Routines::override_float_to_int24 (x86_sse2_float_to_int24);
+		ok &= run_all ("SSE2   ", channels, seconds, data, ref16, ref24);
+	}
+#endif
+	if (fpu->has_avx ()) {
+		Routines::override_float_to_int16 (x86_sse_avx_float_to_int16);
+		Routines::override_float_to_int24 (x86_sse_avx_float_to_int24);
+		ok &= run_all ("AVX    ", channels, seconds, data, ref16, ref24);
+	}
+#endif
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <samplerate.h>
+
+#include "pbd/timing.h"
+
+#include "audiographer/general/sr_converter.h"
+#include "audiographer/sink.h"
+
+using namespace std;
+using namespace AudioGrapher;
+
+/* throughput of the export sample-rate converter,
+ * multi-channel material as produced by a stem export.
+ */
+
+class NullSink : public Sink<float>
+{
+  public:
+	NullSink () : samples (0) {}
+	void process (ProcessContext<float> const& c) { samples += c.samples (); }
+	using Sink<float>::process;
+	samplecnt_t samples;
+};
+
+static void
+run (char const* what, int quality, samplecnt_t in_rate, samplecnt_t out_rate, uint32_t channels, int seconds)
+{
+	samplecnt_t const block = 1024 * channels;
+	vector<float> data (block);
+	for (samplecnt_t i = 0; i < block; ++i) {
+		data[i] = (rand () / (float) RAND_MAX) - .5f;
+	}
+
+	std::shared_ptr<NullSink> sink (new NullSink);
+	SampleRateConverter src (channels);
+	src.init (in_rate, out_rate, quality);
+	src.allocate_buffers (block);
+	src.add_output (sink);
+
+	samplecnt_t const n_blocks = seconds * in_rate / 1024;
+
+	PBD::Timing t;
+	for (samplecnt_t i = 0; i < n_blocks; ++i) {
+		ProcessContext<float> c (&data[0], block, channels);
+		if (i + 1 == n_blocks) {
+			c.set_flag (ProcessContext<float>::EndOfInput);
+		}
+		src.process (c);
+	}
+	t.update ();
+
+	double const sec = t.elapsed () / 1e6;
+	cout << in_rate << " -> " << out_rate << " " << what << ": "
+	     << t.elapsed_msecs () << " ms, " << seconds / sec << "x realtime, "
+	     << n_blocks * 1024 * channels / sec / 1e6 << " Msamples/s\n";
+}
+
+int
+main (int argc, char* argv[])
+{
+	uint32_t channels = 64;
+	int      seconds  = 10;
+
+	if (argc > 1) {
+		channels = atoi (argv[1]);
+	}
+	if (argc > 2) {
+		seconds = atoi (argv[2]);
+	}
+
+	cout << "INFO: " << channels << " channels, " << seconds << " sec\n";
+
+	samplecnt_t const rates[][2] = { { 48000, 44100 }, { 96000, 48000 } };
+
+	for (size_t r = 0; r < 2; ++r) {
+		run ("libsamplerate best  ", SRC_SINC_BEST_QUALITY,          rates[r][0], rates[r][1], channels, seconds);
+		run ("libsamplerate medium", SRC_SINC_MEDIUM_QUALITY,        rates[r][0], rates[r][1], channels, seconds);
+		run ("libsamplerate fast  ", SRC_SINC_FASTEST,               rates[r][0], rates[r][1], channels, seconds);
+		run ("zita best           ", SampleRateConverter::ZitaBest, rates[r][0], rates[r][1], channels, seconds);
+		run ("zita good           ", SampleRateConverter::ZitaGood, rates[r][0], rates[r][1], channels, seconds);
+		run ("zita fast           ", SampleRateConverter::ZitaFast, rates[r][0], rates[r][1], channels, seconds);
+	}
+
+	return 0;
+}
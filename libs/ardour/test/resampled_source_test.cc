@@ -1,3 +1,6 @@
+#include <cmath>
+#include <cstring>
+
 #include "test_util.h"
 
 #include "pbd/file_utils.h"
@@ -40,3 +43,38 @@ ResampledSourceTest::seekTest ()
 		CPPUNIT_ASSERT (A[i] == B[i]);
 	}
 }
+
+void
+ResampledSourceTest::zitaTest ()
+{
+	std::string test_file_path;
+	const string test_filename = "test.wav";
+
+	CPPUNIT_ASSERT (find_file (test_search_path (), test_filename, test_file_path));
+
+	std::shared_ptr<SndFileImportableSource> s (new SndFileImportableSource (test_file_path));
+	ResampledImportableSource r (s, 96000, SrcZitaGood);
+
+	uint32_t const nchn = s->channels ();
+	samplecnt_t const expected = llrint (s->length () * 96000.0 / s->samplerate ()) * nchn;
+
+	/* read everything, output length matches the ratio */
+	Sample A[1024];
+	Sample B[1024];
+	samplecnt_t total = 0;
+	samplecnt_t n;
+	while ((n = r.read (B, 1024 - 1024 % nchn)) > 0) {
+		if (total == 0) {
+			memcpy (A, B, n * sizeof (Sample));
+		}
+		total += n;
+	}
+	CPPUNIT_ASSERT_EQUAL (expected, total);
+
+	/* same output after seek (0) */
+	r.seek (0);
+	n = r.read (B, 1024 - 1024 % nchn);
+	for (samplecnt_t i = 0; i < n; ++i) {
+		CPPUNIT_ASSERT (A[i] == B[i]);
+	}
+}
@@ -5,8 +5,10 @@ class ResampledSourceTest : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE (ResampledSourceTest);
 	CPPUNIT_TEST (seekTest);
+	CPPUNIT_TEST (zitaTest);
 	CPPUNIT_TEST_SUITE_END ();
 
 public:
 	void seekTest ();
+	void zitaTest ();
 };
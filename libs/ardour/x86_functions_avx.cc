@@ -0,0 +1,105 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ardour/mix.h"
+
+#include <cmath>
+
+#include <immintrin.h>
+#include <xmmintrin.h>
+
+#ifndef __AVX__
+#error "__AVX__ must be enabled for this module to work"
+#endif
+
+/* export sample format conversion, see AudioGrapher::Routines
+ *
+ * Values are clipped before conversion, since an out-of-range
+ * _mm256_cvtps_epi32() yields INT_MIN regardless of the sign.
+ * AVX lacks 256 bit integer operations, packing to 16 bit is
+ * done per 128 bit lane, shifting 24 bit into the upper bits
+ * of the 32 bit word is done by rounding and scaling in float,
+ * which is exact.
+ */
+
+void
+x86_sse_avx_float_to_int16 (int16_t* dst, float const* src, uint32_t nframes, float const* noise)
+{
+	__m256 const scale = _mm256_set1_ps (32768.f);
+	__m256 const lo    = _mm256_set1_ps (-32768.f);
+	__m256 const hi    = _mm256_set1_ps (32767.f);
+
+	while (nframes >= 16) {
+		__m256 a = _mm256_mul_ps (_mm256_loadu_ps (src), scale);
+		__m256 b = _mm256_mul_ps (_mm256_loadu_ps (src + 8), scale);
+		if (noise) {
+			a = _mm256_sub_ps (a, _mm256_loadu_ps (noise));
+			b = _mm256_sub_ps (b, _mm256_loadu_ps (noise + 8));
+			noise += 16;
+		}
+		__m256i ia = _mm256_cvtps_epi32 (_mm256_min_ps (_mm256_max_ps (a, lo), hi));
+		__m256i ib = _mm256_cvtps_epi32 (_mm256_min_ps (_mm256_max_ps (b, lo), hi));
+		_mm_storeu_si128 ((__m128i*) dst,       _mm_packs_epi32 (_mm256_castsi256_si128 (ia), _mm256_extractf128_si256 (ia, 1)));
+		_mm_storeu_si128 ((__m128i*) (dst + 8), _mm_packs_epi32 (_mm256_castsi256_si128 (ib), _mm256_extractf128_si256 (ib, 1)));
+		src += 16;
+		dst += 16;
+		nframes -= 16;
+	}
+
+	_mm256_zeroupper ();
+
+	for (uint32_t i = 0; i < nframes; ++i) {
+		float s = src[i] * 32768.f;
+		if (noise) {
+			s -= noise[i];
+		}
+		long r = lrintf (s);
+		dst[i] = (int16_t) (r > 32767 ? 32767 : (r < -32768 ? -32768 : r));
+	}
+}
+
+void
+x86_sse_avx_float_to_int24 (int32_t* dst, float const* src, uint32_t nframes, float const* noise)
+{
+	__m256 const scale = _mm256_set1_ps (8388608.f);
+	__m256 const lo    = _mm256_set1_ps (-8388608.f);
+	__m256 const hi    = _mm256_set1_ps (8388607.f);
+	__m256 const shift = _mm256_set1_ps (256.f);
+
+	while (nframes >= 8) {
+		__m256 a = _mm256_mul_ps (_mm256_loadu_ps (src), scale);
+		if (noise) {
+			a = _mm256_sub_ps (a, _mm256_loadu_ps (noise));
+			noise += 8;
+		}
+		a = _mm256_round_ps (_mm256_min_ps (_mm256_max_ps (a, lo), hi), _MM_FROUND_CUR_DIRECTION);
+		_mm256_storeu_si256 ((__m256i*) dst, _mm256_cvtps_epi32 (_mm256_mul_ps (a, shift)));
+		src += 8;
+		dst += 8;
+		nframes -= 8;
+	}
+
+	_mm256_zeroupper ();
+
+	for (uint32_t i = 0; i < nframes; ++i) {
+		float s = src[i] * 8388608.f;
+		if (noise) {
+			s -= noise[i];
+		}
+		long r = lrintf (s);
+		dst[i] = (int32_t) (r > 8388607 ? 8388607 : (r < -8388608 ? -8388608 : r)) * 256;
+	}
+}
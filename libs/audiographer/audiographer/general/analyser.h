@@ -19,7 +19,11 @@
 #ifndef AUDIOGRAPHER_ANALYSER_H
 #define AUDIOGRAPHER_ANALYSER_H
 
+#include <string>
+#include <vector>
+
 #include <fftw3.h>
+
 #include "loudness_reader.h"
 #include "ardour/export_analysis.h"
 
@@ -43,11 +47,20 @@ class LIBAUDIOGRAPHER_API Analyser : public LoudnessReader
 
 	static const float fft_range_db;
 
+	/** Load and store FFTW wisdom in the given file.
+	 * Plans are shared by all Analysers of the same FFT size,
+	 * wisdom additionally skips measuring them in later sessions.
+	 */
+	static void set_fft_wisdom_file (std::string const& path);
+
 	using Sink<float>::process;
 
 	private:
 	float fft_power_at_bin (const uint32_t b, const float norm) const;
 
+	static fftwf_plan acquire_fft_plan (uint32_t size, float* in, float* out, float const*& window);
+	static void       release_fft_plan (uint32_t size);
+
 	ARDOUR::ExportAnalysisPtr _rp;
 	ARDOUR::ExportAnalysis& _result;
 
@@ -56,13 +69,19 @@ class LIBAUDIOGRAPHER_API Analyser : public LoudnessReader
 	samplecnt_t   _spp;
 	samplecnt_t   _fpp;
 
-	float*     _hann_window;
+	std::vector<samplecnt_t> _truepeak_pos[2];
+
+	float const* _hann_window;
 	uint32_t   _fft_data_size;
 	double     _fft_freq_per_bin;
 	float*     _fft_data_in;
 	float*     _fft_data_out;
 	float*     _fft_power;
 	fftwf_plan _fft_plan;
+
+	/* spectrum image rows [y0, y1) covered by each FFT bin */
+	std::vector<uint32_t> _fft_bin_y0;
+	std::vector<uint32_t> _fft_bin_y1;
 };
 
 } // namespace
@@ -0,0 +1,298 @@
+#ifndef AUDIOGRAPHER_ASYNC_SINK_H
+#define AUDIOGRAPHER_ASYNC_SINK_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/function.hpp>
+
+#include <glib.h>
+#include <glibmm/threads.h>
+
+#include "pbd/pthread_utils.h"
+
+#include "audiographer/visibility.h"
+#include "audiographer/source.h"
+#include "audiographer/sink.h"
+#include "audiographer/exception.h"
+#include "audiographer/general/threader.h"
+#include "audiographer/utils/listed_source.h"
+
+namespace AudioGrapher
+{
+
+/// Type independent interface of an AsyncSink, to query and drain a set of sinks
+class /*LIBAUDIOGRAPHER_API*/ AsyncSinkBase
+{
+  public:
+	struct Stats {
+		Stats () : samples (0), busy_usec (0), queued (0), queue_size (0), max_queued (0) {}
+
+		samplecnt_t samples;    ///< samples per channel passed on to the outputs
+		int64_t     busy_usec;  ///< time the worker spent in the outputs' process ()
+		unsigned    queued;     ///< currently queued blocks
+		unsigned    queue_size;
+		unsigned    max_queued; ///< maximum of queued
+
+		/// samples per channel and second of worker busy time
+		double throughput () const {
+			return busy_usec > 0 ? samples * 1e6 / busy_usec : 0;
+		}
+	};
+
+	virtual ~AsyncSinkBase () {}
+
+	virtual std::string const& name () const = 0;
+	virtual Stats stats () const = 0;
+
+	/// Returns true if all queued data was processed \n Not RT safe
+	virtual bool idle () const = 0;
+
+	/** Waits until all queued data was processed \n Not RT safe
+	  * \param timeout_usec maximum time to wait, negative to wait without limit
+	  * \return true when the sink is idle
+	  * \throw ThreaderException if an output failed to process a block
+	  */
+	virtual bool wait (int64_t timeout_usec = -1) = 0;
+
+	/// Discards queued data and terminates the worker \n Not RT safe
+	virtual void stop () = 0;
+};
+
+/** A sink that decouples its outputs from the caller.
+  * Data is copied into a bounded queue and processed by a dedicated thread,
+  * so that process() returns as soon as there is space in the queue.
+  * When the queue is full, process() blocks until the worker catches up.
+  *
+  * Exceptions thrown by the outputs are passed on by the next call
+  * to process() or wait().
+  */
+template <typename T = DefaultSampleType>
+class /*LIBAUDIOGRAPHER_API*/ AsyncSink
+  : public ListedSource<T>
+  , public Sink<T>
+  , public AsyncSinkBase
+{
+  public:
+	/** Constructor
+	  * \n Not RT safe
+	  * \param max_samples maximum number of samples in a queued block, larger contexts are split
+	  * \param queue_size number of blocks that can be queued
+	  * \param name name of the worker thread
+	  * \param channels number of interleaved channels, a block holds at least one frame
+	  */
+	AsyncSink (samplecnt_t max_samples, unsigned queue_size = 8, std::string const & name = "AsyncSink", ChannelCount channels = 1)
+	  : _name (name)
+	  , _max_samples (std::max<samplecnt_t> (max_samples, std::max<ChannelCount> (1, channels)))
+	  , _blocks (std::max (1u, queue_size))
+	  , _head (0)
+	  , _tail (0)
+	  , _queued (0)
+	  , _stop (false)
+	  , _synchronous (false)
+	  , _thread (0)
+	{
+		for (typename std::vector<Block>::iterator i = _blocks.begin (); i != _blocks.end (); ++i) {
+			i->data = new T[_max_samples];
+		}
+		_stats.queue_size = _blocks.size ();
+		_thread = PBD::Thread::create (boost::bind (&AsyncSink::run, this), _name);
+		_synchronous = _thread == 0;
+	}
+
+	~AsyncSink ()
+	{
+		stop ();
+		for (typename std::vector<Block>::iterator i = _blocks.begin (); i != _blocks.end (); ++i) {
+			delete [] i->data;
+		}
+	}
+
+	/// Queues a copy of \a c, blocks while the queue is full \n Not RT safe
+	void process (ProcessContext<T> const & c)
+	{
+		if (_synchronous) {
+			/* no worker, process in the caller's thread */
+			int64_t start = g_get_monotonic_time ();
+			ListedSource<T>::output (c);
+			Glib::Threads::Mutex::Lock lm (_lock);
+			_stats.samples   += c.samples_per_channel ();
+			_stats.busy_usec += g_get_monotonic_time () - start;
+			return;
+		}
+
+		samplecnt_t const chunk = _max_samples - (_max_samples % c.channels ());
+		samplecnt_t       pos   = 0;
+
+		if (chunk == 0) {
+			throw Exception (*this, boost::str (boost::format
+				("AsyncSink: %1% channels do not fit in a block of %2% samples")
+				% c.channels () % _max_samples));
+		}
+
+		do {
+			samplecnt_t const n = std::min (chunk, c.samples () - pos);
+
+			Glib::Threads::Mutex::Lock lm (_lock);
+			while (_queued == _blocks.size () && !_stop && !_exception) {
+				_cond.wait (_lock);
+			}
+			if (_exception) {
+				throw *_exception;
+			}
+			if (_stop) {
+				return;
+			}
+
+			Block& b (_blocks[_head]);
+			lm.release ();
+
+			/* the worker does not touch this block until it is queued */
+			TypeUtils<T>::copy (&c.data ()[pos], b.data, n);
+			b.samples  = n;
+			b.channels = c.channels ();
+			b.flags    = c.flags ();
+			pos       += n;
+			if (pos < c.samples ()) {
+				b.flags.remove (ProcessContext<T>::EndOfInput);
+			}
+
+			lm.acquire ();
+			_head = (_head + 1) % _blocks.size ();
+			++_queued;
+			_stats.max_queued = std::max (_stats.max_queued, _queued);
+			_cond.broadcast ();
+		} while (pos < c.samples ());
+	}
+
+	using Sink<T>::process;
+
+	std::string const& name () const { return _name; }
+
+	Stats stats () const
+	{
+		Glib::Threads::Mutex::Lock lm (_lock);
+		Stats s (_stats);
+		s.queued = _queued;
+		return s;
+	}
+
+	bool idle () const
+	{
+		Glib::Threads::Mutex::Lock lm (_lock);
+		return _queued == 0;
+	}
+
+	bool wait (int64_t timeout_usec = -1)
+	{
+		Glib::Threads::Mutex::Lock lm (_lock);
+		gint64 end_time = g_get_monotonic_time () + timeout_usec;
+		while (_queued > 0 && !_exception) {
+			if (timeout_usec < 0) {
+				_cond.wait (_lock);
+			} else if (!_cond.wait_until (_lock, end_time)) {
+				break;
+			}
+		}
+		if (_exception) {
+			throw *_exception;
+		}
+		return _queued == 0;
+	}
+
+	void stop ()
+	{
+		{
+			Glib::Threads::Mutex::Lock lm (_lock);
+			_stop = true;
+			_cond.broadcast ();
+		}
+		if (_thread) {
+			_thread->join ();
+			delete _thread;
+			_thread = 0;
+		}
+		Glib::Threads::Mutex::Lock lm (_lock);
+		_queued = 0;
+		_cond.broadcast ();
+	}
+
+  private:
+	struct Block {
+		Block () : data (0), samples (0), channels (1) {}
+
+		T*           data;
+		samplecnt_t  samples;
+		ChannelCount channels;
+		FlagField    flags;
+	};
+
+	void run ()
+	{
+		Glib::Threads::Mutex::Lock lm (_lock);
+
+		while (true) {
+			while (_queued == 0 && !_stop) {
+				_cond.wait (_lock);
+			}
+			if (_stop) {
+				break;
+			}
+
+			/* the block stays queued while it is being processed */
+			Block& b (_blocks[_tail]);
+			bool const failed = _exception.get () != 0;
+			lm.release ();
+
+			int64_t start = g_get_monotonic_time ();
+
+			if (!failed) {
+				ProcessContext<T> c (b.data, b.samples, b.channels);
+				for (FlagField::iterator i = b.flags.begin (); i != b.flags.end (); ++i) {
+					c.set_flag (*i);
+				}
+				try {
+					ListedSource<T>::output (c);
+				} catch (std::exception const & e) {
+					lm.acquire ();
+					_exception.reset (new ThreaderException (*this, e));
+					lm.release ();
+				}
+			}
+
+			int64_t elapsed = g_get_monotonic_time () - start;
+
+			lm.acquire ();
+			if (!failed) {
+				_stats.samples   += b.samples / b.channels;
+				_stats.busy_usec += elapsed;
+			}
+			_tail = (_tail + 1) % _blocks.size ();
+			--_queued;
+			_cond.broadcast ();
+		}
+	}
+
+	std::string          _name;
+	samplecnt_t          _max_samples;
+	std::vector<Block>   _blocks;
+	unsigned             _head;
+	unsigned             _tail;
+	unsigned             _queued;
+	bool                 _stop;
+	bool                 _synchronous;
+	Stats                _stats;
+
+	mutable Glib::Threads::Mutex _lock;
+	Glib::Threads::Cond          _cond;
+	PBD::Thread*                 _thread;
+
+	std::shared_ptr<ThreaderException> _exception;
+};
+
+} // namespace
+
+#endif // AUDIOGRAPHER_ASYNC_SINK_H
@@ -0,0 +1,153 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AUDIOGRAPHER_LOUDNESS_METER_H
+#define AUDIOGRAPHER_LOUDNESS_METER_H
+
+#include <cstdint>
+
+#include "audiographer/visibility.h"
+#include "audiographer/types.h"
+
+namespace AudioGrapher
+{
+
+/** EBU R128 / ITU-R BS.1770-4 loudness and true-peak meter.
+ *
+ * Channels are processed side by side: the filter and oversampling state
+ * of all channels is kept in lanes (padded to a multiple of four), so that
+ * the per-sample loops run over channels and vectorize, regardless of how
+ * many channels there are.
+ *
+ * Loudness is computed in 100ms fragments. Momentary (400ms) and short-term
+ * (3s) loudness is updated with every fragment, the integrated loudness is
+ * gated (-70 LUFS absolute, -10 LU relative) using a histogram of momentary
+ * blocks, so memory use does not grow with the duration.
+ *
+ * True-peak is measured with a 48 tap polyphase FIR, oversampling 4x up to
+ * 48kHz, and 2x at higher rates.
+ *
+ * process() is realtime-safe.
+ */
+class LIBAUDIOGRAPHER_API LoudnessMeter
+{
+  public:
+	LoudnessMeter (float sample_rate, unsigned int channels);
+	~LoudnessMeter ();
+
+	void reset ();
+
+	/** Set the gain applied to the power of a channel.
+	 * The default is 1.0 for all channels, except for 5 channels (L R C Ls Rs)
+	 * and 6 channels (L R C LFE Ls Rs) where surround channels use 1.41 and
+	 * the LFE channel is ignored.
+	 */
+	void set_channel_weight (unsigned int chn, float weight);
+
+	/** Analyze interleaved data
+	 * @param n_samples number of samples per channel
+	 */
+	void process (float const* data, samplecnt_t n_samples);
+
+	/** Analyze non-interleaved data
+	 * @param n_samples number of samples per channel
+	 * @param offset offset into each channel's buffer
+	 */
+	void process (float const* const* data, samplecnt_t n_samples, samplecnt_t offset = 0);
+
+	unsigned int channels () const { return _n_channels; }
+
+	float integrated () const;     ///< gated integrated loudness [LUFS], -200 if not available
+	float loudness_range () const; ///< EBU Tech 3342 loudness range [LU]
+
+	float momentary () const { return _loudness_M; }  ///< loudness of the last 400ms [LUFS]
+	float short_term () const { return _loudness_S; } ///< loudness of the last 3s [LUFS]
+	float max_momentary () const { return _max_M; }
+	float max_short_term () const { return _max_S; }
+
+	float true_peak () const;                       ///< maximum of all channels [coefficient]
+	float true_peak (unsigned int chn) const;       ///< [coefficient]
+	float last_true_peak (unsigned int chn) const;  ///< maximum during the last call to process()
+
+	/** Histogram of short-term loudness, values are counted every 100ms.
+	 * Bins are 0.1 LU wide, bin \a n is centered at (n - 700) / 10 LUFS.
+	 */
+	uint32_t const* short_term_histogram () const { return _hist_S; }
+
+	static const int hist_size = 751; ///< -70 .. +5 LUFS
+
+  private:
+	LoudnessMeter (LoudnessMeter const&);
+
+	enum {
+		block_size = 64,
+		tp_taps    = 48,
+	};
+
+	void init_filter ();
+	void run (samplecnt_t n);
+	void end_fragment ();
+	float sum_fragments (unsigned int n) const;
+
+	static int   hist_bin (float lufs);
+	static float hist_bin_power (int bin);
+
+	float        _sample_rate;
+	unsigned int _n_channels;
+	unsigned int _n_lanes;
+	samplecnt_t  _frag_len;
+	bool         _upsample_x4;
+
+	/* K-weighting filter coefficients */
+	float _a0, _a1, _a2;
+	float _b1, _b2;
+	float _c3, _c4;
+
+	/* per lane */
+	float* _mem;
+	float* _weight;
+	float* _z1;
+	float* _z2;
+	float* _z3;
+	float* _z4;
+	float* _pwr;
+	float* _tp;
+	float* _tp_last;
+	float* _tp_hist; // [lanes / 4][2 * tp_taps][4]
+	float* _buf;     // [block_size][lanes]
+
+	unsigned int _tp_pos;
+
+	/* fragments */
+	samplecnt_t _frag_pos;
+	float       _frag_pwr[32];
+	unsigned    _frag_idx;
+	uint64_t    _frag_cnt;
+
+	float _loudness_M;
+	float _loudness_S;
+	float _max_M;
+	float _max_S;
+
+	/* gating */
+	uint32_t _hist_M[hist_size];
+	double   _hist_M_pwr[hist_size];
+	uint32_t _hist_S[hist_size];
+};
+
+} // namespace
+
+#endif // AUDIOGRAPHER_LOUDNESS_METER_H
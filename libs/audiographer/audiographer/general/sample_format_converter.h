@@ -20,6 +20,8 @@ enum /*LIBAUDIOGRAPHER_API*/ DitherType
 
 /** Sample format converter that does dithering.
   * This class can only convert floats to either \a float, \a int32_t, \a int16_t, or \a uint8_t
+  * 16 and 24 bit output without noise shaping uses the (possibly vectorized) conversion
+  * from \a Routines, everything else is handled by gdither.
   */
 template <typename TOut>
 class LIBAUDIOGRAPHER_API SampleFormatConverter
@@ -56,6 +58,9 @@ class LIBAUDIOGRAPHER_API SampleFormatConverter
 	void reset();
 	void init_common (samplecnt_t max_samples); // not-template-specialized part of init
 	void check_sample_and_channel_count (samplecnt_t samples, ChannelCount channels_);
+	void init_routines (samplecnt_t max_samples, int type);
+	void convert_routines (float const * data, samplecnt_t samples);
+	float const * dither_noise (samplecnt_t samples);
 
 	ChannelCount channels;
 	GDither      dither;
@@ -64,6 +69,13 @@ class LIBAUDIOGRAPHER_API SampleFormatConverter
 
 	bool         clip_floats;
 
+	/* Routines based conversion, see init_routines() */
+	bool         use_routines;
+	int          dither_type;
+	float *      noise;     // dither noise for the current cycle
+	float *      tri_noise; // previous white noise per channel, followed by the current cycle
+	uint32_t     rnd[8];    // interleaved lanes of the gdither random number generator
+
 };
 
 } // namespace
@@ -0,0 +1,141 @@
+#ifndef AUDIOGRAPHER_SAMPLE_STORE_H
+#define AUDIOGRAPHER_SAMPLE_STORE_H
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "pbd/signals.h"
+
+#include "audiographer/visibility.h"
+#include "audiographer/sink.h"
+#include "audiographer/exception.h"
+#include "audiographer/throwing.h"
+#include "audiographer/type_utils.h"
+#include "audiographer/utils/listed_source.h"
+
+namespace AudioGrapher
+{
+
+/** In-memory replacement for a TmpFile.
+  * Data is appended to a list of fixed size chunks, so that the
+  * store never has to move data that was already written.
+  * After the input has ended, the data can be read back from the start.
+  */
+template<typename T = DefaultSampleType>
+class /*LIBAUDIOGRAPHER_API*/ SampleStore
+  : public ListedSource<T>
+  , public Sink<T>
+  , public Throwing<>
+{
+  public:
+	/** Constructor \n Not RT safe
+	  * \param channels number of interleaved channels
+	  */
+	SampleStore (ChannelCount channels)
+	  : _channels (channels)
+	  , _chunk_size (chunk_samples - (chunk_samples % channels))
+	  , _written (0)
+	  , _read_pos (0)
+	{
+	}
+
+	~SampleStore ()
+	{
+		for (typename std::vector<T*>::iterator i = _chunks.begin (); i != _chunks.end (); ++i) {
+			delete [] *i;
+		}
+	}
+
+	/** Appends data, emits InputEnded at the end of input
+	  * \n RT safe as long as no new chunk needs to be allocated
+	  */
+	void process (ProcessContext<T> const & c)
+	{
+		if (throw_level (ThrowStrict) && c.channels () != _channels) {
+			throw Exception (*this, boost::str (boost::format
+				("Wrong number of channels given to process(), %1% instead of %2%")
+				% c.channels () % _channels));
+		}
+
+		samplecnt_t pos = 0;
+		while (pos < c.samples ()) {
+			const size_t      chunk  = _written / _chunk_size;
+			const samplecnt_t offset = _written % _chunk_size;
+			if (chunk == _chunks.size ()) {
+				_chunks.push_back (new T[_chunk_size]);
+			}
+			const samplecnt_t n = std::min (c.samples () - pos, _chunk_size - offset);
+			TypeUtils<T>::copy (&c.data ()[pos], &_chunks[chunk][offset], n);
+			pos      += n;
+			_written += n;
+		}
+
+		if (c.has_flag (ProcessContext<T>::EndOfInput)) {
+			InputEnded ();
+		}
+	}
+
+	using Sink<T>::process;
+
+	/// Total number of samples (all channels) in the store
+	samplecnt_t get_samples_written () const { return _written; }
+
+	/// Bytes allocated for storing data
+	size_t size_in_bytes () const { return _chunks.size () * _chunk_size * sizeof (T); }
+
+	/// Start reading from the beginning \n RT safe
+	void rewind () { _read_pos = 0; }
+
+	/** Read data into buffer in \a context, only the data is modified (not sample count)
+	 *  The data read is output to the outputs, as well as read into the context.
+	 *  The last context carries the EndOfInput flag. \n RT safe
+	 *  \return number of samples read
+	 */
+	samplecnt_t read (ProcessContext<T> & context)
+	{
+		if (throw_level (ThrowStrict) && context.channels () != _channels) {
+			throw Exception (*this, boost::str (boost::format
+				("Wrong number of channels given to read(), %1% instead of %2%")
+				% context.channels () % _channels));
+		}
+
+		samplecnt_t const to_read = std::min (context.samples (), _written - _read_pos);
+		samplecnt_t       pos     = 0;
+
+		while (pos < to_read) {
+			const size_t      chunk  = _read_pos / _chunk_size;
+			const samplecnt_t offset = _read_pos % _chunk_size;
+			const samplecnt_t n      = std::min (to_read - pos, _chunk_size - offset);
+			TypeUtils<T>::copy (&_chunks[chunk][offset], &context.data ()[pos], n);
+			pos       += n;
+			_read_pos += n;
+		}
+
+		ProcessContext<T> c_out = context.beginning (to_read);
+		if (to_read < context.samples ()) {
+			c_out.set_flag (ProcessContext<T>::EndOfInput);
+		}
+		this->output (c_out);
+		return to_read;
+	}
+
+	/// Emitted when the input ended, in the thread calling process()
+	PBD::Signal0<void> InputEnded;
+
+  private:
+	static const samplecnt_t chunk_samples = 262144; // 1 MB of float
+
+	SampleStore (SampleStore const &);
+
+	ChannelCount       _channels;
+	samplecnt_t        _chunk_size;
+	samplecnt_t        _written;
+	samplecnt_t        _read_pos;
+	std::vector<T*>    _chunks;
+};
+
+} // namespace
+
+#endif // AUDIOGRAPHER_SAMPLE_STORE_H
@@ -10,6 +10,10 @@
 #include "audiographer/types.h"
 #include "audiographer/utils/listed_source.h"
 
+namespace ArdourZita {
+	class Resampler;
+}
+
 namespace AudioGrapher
 {
 
@@ -21,6 +25,18 @@ class LIBAUDIOGRAPHER_API SampleRateConverter
   , public Throwing<>
 {
   public:
+	/** Quality presets using zita-resampler instead of libsamplerate.
+	 * Any other quality value is a libsamplerate converter type.
+	 * zita-resampler is considerably faster with many channels,
+	 * but only supports ratios of common sample rates. Other ratios
+	 * fall back to SRC_SINC_BEST_QUALITY.
+	 */
+	enum ZitaQuality {
+		ZitaBest = 100, ///< filter length 96
+		ZitaGood = 101, ///< filter length 48
+		ZitaFast = 102  ///< filter length 16
+	};
+
 	/// Constructor. \n RT safe
 	SampleRateConverter (uint32_t channels);
 	~SampleRateConverter ();
@@ -42,6 +58,7 @@ class LIBAUDIOGRAPHER_API SampleRateConverter
   private:
 
 	void set_end_of_input (ProcessContext<float> const & c);
+	void process_zita (ProcessContext<float> const & c);
 	void reset ();
 
 	bool           active;
@@ -57,6 +74,10 @@ class LIBAUDIOGRAPHER_API SampleRateConverter
 
 	SRC_DATA       src_data;
 	SRC_STATE*     src_state;
+
+	ArdourZita::Resampler* zita;
+	samplecnt_t    zita_in;  // frames
+	samplecnt_t    zita_out; // frames
 };
 
 } // namespace
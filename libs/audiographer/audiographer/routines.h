@@ -18,9 +18,13 @@ class LIBAUDIOGRAPHER_API Routines
 
 	typedef float (*compute_peak_t)          (float const *, uint_type, float);
 	typedef void  (*apply_gain_to_buffer_t)  (float *, uint_type, float);
+	typedef void  (*float_to_int16_t)        (int16_t *, float const *, uint_type, float const *);
+	typedef void  (*float_to_int24_t)        (int32_t *, float const *, uint_type, float const *);
 
 	static void override_compute_peak         (compute_peak_t func)         { _compute_peak = func; }
 	static void override_apply_gain_to_buffer (apply_gain_to_buffer_t func) { _apply_gain_to_buffer = func; }
+	static void override_float_to_int16       (float_to_int16_t func)       { _float_to_int16 = func; }
+	static void override_float_to_int24       (float_to_int24_t func)       { _float_to_int24 = func; }
 
 	/** Computes peak in float buffer
 	  * \n RT safe
@@ -45,6 +49,30 @@ class LIBAUDIOGRAPHER_API Routines
 		(*_apply_gain_to_buffer) (data, samples, gain);
 	}
 
+	/** Converts float to 16 bit signed integer, with clipping
+	 * \n RT safe
+	 * \param dst output buffer
+	 * \param src input buffer, nominally in [-1, 1]
+	 * \param samples length of \a src and \a dst
+	 * \param noise dither noise in LSB units, subtracted before rounding, may be NULL
+	 */
+	static inline void float_to_int16 (int16_t * dst, float const * src, uint_type samples, float const * noise)
+	{
+		(*_float_to_int16) (dst, src, samples, noise);
+	}
+
+	/** Converts float to 24 bit signed integer in the upper 24 bits of a 32 bit word, with clipping
+	 * \n RT safe
+	 * \param dst output buffer
+	 * \param src input buffer, nominally in [-1, 1]
+	 * \param samples length of \a src and \a dst
+	 * \param noise dither noise in LSB units, subtracted before rounding, may be NULL
+	 */
+	static inline void float_to_int24 (int32_t * dst, float const * src, uint_type samples, float const * noise)
+	{
+		(*_float_to_int24) (dst, src, samples, noise);
+	}
+
   private:
 	static inline float default_compute_peak (float const * data, uint_type samples, float current_peak)
 	{
@@ -62,8 +90,30 @@ class LIBAUDIOGRAPHER_API Routines
 		}
 	}
 
+	static inline void default_float_to_int16 (int16_t * dst, float const * src, uint_type samples, float const * noise)
+	{
+		for (uint_type i = 0; i < samples; ++i) {
+			float s = src[i] * 32768.f;
+			if (noise) { s -= noise[i]; }
+			long r = lrintf (s);
+			dst[i] = (int16_t) (r > 32767 ? 32767 : (r < -32768 ? -32768 : r));
+		}
+	}
+
+	static inline void default_float_to_int24 (int32_t * dst, float const * src, uint_type samples, float const * noise)
+	{
+		for (uint_type i = 0; i < samples; ++i) {
+			float s = src[i] * 8388608.f;
+			if (noise) { s -= noise[i]; }
+			long r = lrintf (s);
+			dst[i] = (int32_t) (r > 8388607 ? 8388607 : (r < -8388608 ? -8388608 : r)) * 256;
+		}
+	}
+
 	static compute_peak_t          _compute_peak;
 	static apply_gain_to_buffer_t  _apply_gain_to_buffer;
+	static float_to_int16_t        _float_to_int16;
+	static float_to_int24_t        _float_to_int24;
 };
 
 } // namespace
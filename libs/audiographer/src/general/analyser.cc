@@ -16,6 +16,10 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <map>
+
+#include <glibmm/threads.h>
+
 #include "audiographer/general/analyser.h"
 #include "pbd/fastlog.h"
 
@@ -23,6 +27,88 @@ using namespace AudioGrapher;
 
 const float Analyser::fft_range_db (120); // dB
 
+namespace {
+	/* FFTW plans are read-only once created and can be executed
+	 * concurrently on different (equally aligned) buffers, so all
+	 * Analysers of the same FFT size share one plan and window.
+	 */
+	struct SharedFFTPlan {
+		fftwf_plan   plan;
+		float*       window;
+		unsigned int refcnt;
+	};
+
+	Glib::Threads::Mutex              fft_plan_lock;
+	std::map<uint32_t, SharedFFTPlan> fft_plans;
+	std::string                       fft_wisdom_file;
+	bool                              fft_wisdom_loaded = false;
+}
+
+void
+Analyser::set_fft_wisdom_file (std::string const& path)
+{
+	Glib::Threads::Mutex::Lock lm (fft_plan_lock);
+	fft_wisdom_file   = path;
+	fft_wisdom_loaded = false;
+}
+
+fftwf_plan
+Analyser::acquire_fft_plan (uint32_t size, float* in, float* out, float const*& window)
+{
+	Glib::Threads::Mutex::Lock lm (fft_plan_lock);
+
+	std::map<uint32_t, SharedFFTPlan>::iterator i = fft_plans.find (size);
+	if (i != fft_plans.end ()) {
+		++i->second.refcnt;
+		window = i->second.window;
+		return i->second.plan;
+	}
+
+	if (!fft_wisdom_loaded && !fft_wisdom_file.empty ()) {
+		fftwf_import_wisdom_from_filename (fft_wisdom_file.c_str ());
+		fft_wisdom_loaded = true;
+	}
+
+	SharedFFTPlan p;
+	p.plan   = fftwf_plan_r2r_1d (size, in, out, FFTW_R2HC, FFTW_MEASURE);
+	p.window = (float *) malloc (sizeof (float) * size);
+	p.refcnt = 1;
+
+	double sum = 0.0;
+	for (uint32_t i = 0; i < size; ++i) {
+		p.window[i] = 0.5f - (0.5f * (float) cos (2.0f * M_PI * (float)i / (float)(size)));
+		sum += p.window[i];
+	}
+	const double isum = 2.0 / sum;
+	for (uint32_t i = 0; i < size; ++i) {
+		p.window[i] *= isum;
+	}
+
+	if (!fft_wisdom_file.empty ()) {
+		fftwf_export_wisdom_to_filename (fft_wisdom_file.c_str ());
+	}
+
+	fft_plans[size] = p;
+	window = p.window;
+	return p.plan;
+}
+
+void
+Analyser::release_fft_plan (uint32_t size)
+{
+	Glib::Threads::Mutex::Lock lm (fft_plan_lock);
+
+	std::map<uint32_t, SharedFFTPlan>::iterator i = fft_plans.find (size);
+	assert (i != fft_plans.end ());
+	if (--i->second.refcnt > 0) {
+		return;
+	}
+	/* in-process wisdom is retained, re-planning this size is cheap */
+	fftwf_destroy_plan (i->second.plan);
+	free (i->second.window);
+	fft_plans.erase (i);
+}
+
 Analyser::Analyser (float sample_rate, unsigned int channels, samplecnt_t bufsize, samplecnt_t n_samples, size_t width, size_t bins)
 	: LoudnessReader (sample_rate, channels, bufsize)
 	, _rp (ARDOUR::ExportAnalysisPtr (new ARDOUR::ExportAnalysis (width, bins)))
@@ -45,6 +131,9 @@ Analyser::Analyser (float sample_rate, unsigned int channels, samplecnt_t bufsiz
 	_fft_data_out = (float *) fftwf_malloc (sizeof (float) * _bufsize);
 	_fft_power    = (float *) malloc (sizeof (float) * _fft_data_size);
 
+	/* planning may overwrite the buffers, do this before clearing them */
+	_fft_plan = acquire_fft_plan (_bufsize, _fft_data_in, _fft_data_out, _hann_window);
+
 	for (uint32_t i = 0; i < _fft_data_size; ++i) {
 		_fft_power[i] = 0;
 	}
@@ -67,18 +156,21 @@ Analyser::Analyser (float sample_rate, unsigned int channels, samplecnt_t bufsiz
 	_result.freq[4] = YPOS (5000);
 	_result.freq[5] = YPOS (10000);
 
-	_fft_plan = fftwf_plan_r2r_1d (_bufsize, _fft_data_in, _fft_data_out, FFTW_R2HC, FFTW_MEASURE);
-
-	_hann_window = (float *) malloc (sizeof (float) * _bufsize);
-	double sum = 0.0;
-
-	for (uint32_t i = 0; i < _bufsize; ++i) {
-		_hann_window[i] = 0.5f - (0.5f * (float) cos (2.0f * M_PI * (float)i / (float)(_bufsize)));
-		sum += _hann_window[i];
-	}
-	const double isum = 2.0 / sum;
-	for (uint32_t i = 0; i < _bufsize; ++i) {
-		_hann_window[i] *= isum;
+	_fft_bin_y0.resize (_fft_data_size);
+	_fft_bin_y1.resize (_fft_data_size);
+	for (uint32_t i = 0; i < _fft_data_size; ++i) {
+#if 0 // linear
+		const uint32_t y0 = floor (i * (float) height / _fft_data_size);
+		uint32_t y1 = ceil ((i + 1.0) * (float) height / _fft_data_size);
+#else // logscale
+		const uint32_t y0 = floor (height * logf (1.f + .1f * i) / logf (1.f + .1f * _fft_data_size));
+		uint32_t y1 = ceilf (height * logf (1.f + .1f * (i + 1.f)) / logf (1.f + .1f * _fft_data_size));
+#endif
+		assert (y0 < height);
+		assert (y1 > 0 && y1 <= height);
+		if (y0 == y1) y1 = y0 + 1;
+		_fft_bin_y0[i] = y0;
+		_fft_bin_y1[i] = y1;
 	}
 
 	if (channels == 2) {
@@ -90,11 +182,10 @@ Analyser::Analyser (float sample_rate, unsigned int channels, samplecnt_t bufsiz
 
 Analyser::~Analyser ()
 {
-	fftwf_destroy_plan (_fft_plan);
+	release_fft_plan (_bufsize);
 	fftwf_free (_fft_data_in);
 	fftwf_free (_fft_data_out);
 	free (_fft_power);
-	free (_hann_window);
 }
 
 void
@@ -135,9 +226,6 @@ Analyser::process (ProcessContext<float> const & ctx)
 		for (unsigned int c = 0; c < _channels; ++c) {
 			const float v = *d;
 			if (fabsf(v) > _result.peak) { _result.peak = fabsf(v); }
-			if (c < _result.n_channels) {
-				_bufs[c][s] = v;
-			}
 			const unsigned int cc = c & cmask;
 			if (_result.peaks[cc][pbin].min > v) { _result.peaks[cc][pbin].min = *d; }
 			if (_result.peaks[cc][pbin].max < v) { _result.peaks[cc][pbin].max = *d; }
@@ -148,35 +236,39 @@ Analyser::process (ProcessContext<float> const & ctx)
 
 	for (; s < _bufsize; ++s) {
 		_fft_data_in[s] = 0;
-		for (unsigned int c = 0; c < _result.n_channels; ++c) {
-			_bufs[c][s] = 0.f;
-		}
 	}
 
-	if (_ebur_plugin) {
-		Vamp::Plugin::FeatureSet features = _ebur_plugin->process (_bufs, Vamp::RealTime::fromSeconds ((double) _pos / _sample_rate));
-		if (!features.empty ()) {
-			const samplecnt_t p0 = _pos / _spp;
-			const samplecnt_t p1 = (_pos + n_samples -1) / _spp;
-			for (samplecnt_t p = p0; p <= p1; ++p) {
-				assert (p >= 0 && p < (samplecnt_t) _result.width);
-				_result.lgraph_i[p] = features[0][0].values[0];
-				_result.lgraph_s[p] = features[0][1].values[0];
-				_result.lgraph_m[p] = features[0][2].values[0];
+	/* loudness and true-peak, note positions at or above -1dBTP,
+	 * at most one per pixel */
+	for (samplecnt_t off = 0; off < n_samples; off += 48) {
+		const samplecnt_t n = std::min<samplecnt_t> (48, n_samples - off);
+		_meter.process (&ctx.data ()[off * _channels], n);
+		for (unsigned int c = 0; c < _channels; ++c) {
+			if (_meter.last_true_peak (c) < .89125f) {
+				continue;
+			}
+			std::vector<samplecnt_t>& tp (_truepeak_pos[c & cmask]);
+			const samplecnt_t pos = _pos + off + n;
+			if (tp.empty () || tp.back () / _spp != pos / _spp) {
+				tp.push_back (pos);
 			}
-			_result.have_lufs_graph = true;
 		}
 	}
 
-	float const * const data = ctx.data ();
-	for (unsigned int c = 0; c < _channels && c < _dbtp_plugins.size (); ++c) {
-		for (s = 0; s < n_samples; ++s) {
-			_bufs[0][s] = data[s * _channels + c];
+	{
+		const float lufs_i = _meter.integrated ();
+		const samplecnt_t p0 = _pos / _spp;
+		const samplecnt_t p1 = (_pos + n_samples -1) / _spp;
+		for (samplecnt_t p = p0; p <= p1; ++p) {
+			assert (p >= 0 && p < (samplecnt_t) _result.width);
+			_result.lgraph_i[p] = lufs_i;
+			_result.lgraph_s[p] = _meter.short_term ();
+			_result.lgraph_m[p] = _meter.momentary ();
 		}
-		_dbtp_plugins.at(c)->process (_bufs, Vamp::RealTime::fromSeconds ((double) _pos / _sample_rate));
+		_result.have_lufs_graph = true;
 	}
 
-	fftwf_execute (_fft_plan);
+	fftwf_execute_r2r (_fft_plan, _fft_data_in, _fft_data_out);
 
 	_fft_power[0] = _fft_data_out[0] * _fft_data_out[0];
 #define FRe (_fft_data_out[i])
@@ -196,16 +288,8 @@ Analyser::process (ProcessContext<float> const & ctx)
 		const float level = fft_power_at_bin (i, i);
 		if (level < -fft_range_db) continue;
 		const float pk = level > 0.0 ? 1.0 : (fft_range_db + level) / fft_range_db;
-#if 0 // linear
-		const uint32_t y0 = floor (i * (float) height / _fft_data_size);
-		uint32_t y1 = ceil ((i + 1.0) * (float) height / _fft_data_size);
-#else // logscale
-		const uint32_t y0 = floor (height * logf (1.f + .1f * i) / logf (1.f + .1f * _fft_data_size));
-		uint32_t y1 = ceilf (height * logf (1.f + .1f * (i + 1.f)) / logf (1.f + .1f * _fft_data_size));
-#endif
-		assert (y0 < height);
-		assert (y1 > 0 && y1 <= height);
-		if (y0 == y1) y1 = y0 + 1;
+		const uint32_t y0 = _fft_bin_y0[i];
+		const uint32_t y1 = _fft_bin_y1[i];
 		for (int x = x0; x < x1; ++x) {
 			for (uint32_t y = y0; y < y1 && y < height; ++y) {
 				uint32_t yy = height - 1 - y;
@@ -264,39 +348,28 @@ Analyser::result (bool ptr_only)
 		}
 	}
 
-	if (_ebur_plugin) {
-		Vamp::Plugin::FeatureSet features = _ebur_plugin->getRemainingFeatures ();
-		if (!features.empty () && features.size () == 3) {
-			_result.integrated_loudness    = features[0][0].values[0];
-			_result.max_loudness_short     = features[0][1].values[0];
-			_result.max_loudness_momentary = features[0][2].values[0];
-
-			_result.loudness_range = features[1][0].values[0];
-			assert (features[2][0].values.size () == 540);
-			for (int i = 0; i < 540; ++i) {
-				_result.loudness_hist[i] = features[2][0].values[i];
-				if (_result.loudness_hist[i] > _result.loudness_hist_max) {
-					_result.loudness_hist_max = _result.loudness_hist[i]; }
-			}
-			_result.have_loudness = true;
-		}
+	_result.integrated_loudness    = _meter.integrated ();
+	_result.max_loudness_short     = _meter.max_short_term ();
+	_result.max_loudness_momentary = _meter.max_momentary ();
+
+	/* -59 .. -5 LUFS */
+	_result.loudness_range = _meter.loudness_range ();
+	uint32_t const* hist = _meter.short_term_histogram ();
+	for (int i = 0; i < 540; ++i) {
+		_result.loudness_hist[i] = hist[i + 110];
+		if (_result.loudness_hist[i] > _result.loudness_hist_max) {
+			_result.loudness_hist_max = _result.loudness_hist[i]; }
 	}
+	_result.have_loudness = true;
 
-	const unsigned cmask = _result.n_channels - 1; // [0, 1]
-	for (unsigned int c = 0; c < _channels && c < _dbtp_plugins.size (); ++c) {
-		Vamp::Plugin::FeatureSet features = _dbtp_plugins.at(c)->getRemainingFeatures ();
-		if (!features.empty () && features.size () == 2) {
-			_result.have_dbtp = true;
-			float p = features[0][0].values[0];
-			if (p > _result.truepeak) { _result.truepeak = p; }
-
-			for (std::vector<float>::const_iterator i = features[1][0].values.begin();
-					i != features[1][0].values.end(); ++i) {
-				/* re-scale - silence stripping: pk = (*i) * peaks / _pos; */
-				const samplecnt_t pk = (*i) * _n_samples / (_pos * _spp);
-				const unsigned int cc = c & cmask;
-				_result.truepeakpos[cc].insert (pk);
-			}
+	_result.have_dbtp = true;
+	_result.truepeak  = std::max (_result.truepeak, _meter.true_peak ());
+
+	for (unsigned int cc = 0; cc < _result.n_channels; ++cc) {
+		for (std::vector<samplecnt_t>::const_iterator i = _truepeak_pos[cc].begin (); i != _truepeak_pos[cc].end (); ++i) {
+			/* re-scale - silence stripping: pk = (*i) * peaks / _pos; */
+			const samplecnt_t pk = (*i) * _n_samples / (_pos * _spp);
+			_result.truepeakpos[cc].insert (pk);
 		}
 	}
 
@@ -0,0 +1,480 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#ifdef COMPILER_MSVC
+#include <float.h>
+#define isfinite_local(val) (bool)_finite ((double)val)
+#else
+#define isfinite_local std::isfinite
+#endif
+
+#include "pbd/malign.h"
+
+#include "audiographer/general/loudness_meter.h"
+
+using namespace AudioGrapher;
+
+/* 4x upsampling, cosine windowed sinc. Phases 1/4, 2/4 and 3/4,
+ * phase 0 is the input sample itself. This introduces a latency of 23
+ * samples, which does not matter for a peak.
+ */
+/* clang-format off */
+static const float tp_coeff[3][48] = {
+	{
+		-2.330790e-05f, +1.321291e-04f, -3.394408e-04f, +6.562235e-04f, -1.094138e-03f, +1.665807e-03f, -2.385230e-03f, +3.268371e-03f,
+		-4.334012e-03f, +5.604985e-03f, -7.109989e-03f, +8.886314e-03f, -1.098403e-02f, +1.347264e-02f, -1.645206e-02f, +2.007155e-02f,
+		-2.456432e-02f, +3.031531e-02f, -3.800644e-02f, +4.896667e-02f, -6.616853e-02f, +9.788141e-02f, -1.788607e-01f, +9.000753e-01f,
+		+2.993829e-01f, -1.269367e-01f, +7.922398e-02f, -5.647748e-02f, +4.295093e-02f, -3.385706e-02f, +2.724946e-02f, -2.218943e-02f,
+		+1.816976e-02f, -1.489313e-02f, +1.217411e-02f, -9.891211e-03f, +7.961470e-03f, -6.326144e-03f, +4.942202e-03f, -3.777065e-03f,
+		+2.805240e-03f, -2.006106e-03f, +1.362416e-03f, -8.592768e-04f, +4.834383e-04f, -2.228007e-04f, +6.607267e-05f, -2.537056e-06f
+	}, {
+		-1.450055e-05f, +1.359163e-04f, -3.928527e-04f, +8.006445e-04f, -1.375510e-03f, +2.134915e-03f, -3.098103e-03f, +4.286860e-03f,
+		-5.726614e-03f, +7.448018e-03f, -9.489286e-03f, +1.189966e-02f, -1.474471e-02f, +1.811472e-02f, -2.213828e-02f, +2.700557e-02f,
+		-3.301023e-02f, +4.062971e-02f, -5.069345e-02f, +6.477499e-02f, -8.625619e-02f, +1.239454e-01f, -2.101678e-01f, +6.359382e-01f,
+		+6.359382e-01f, -2.101678e-01f, +1.239454e-01f, -8.625619e-02f, +6.477499e-02f, -5.069345e-02f, +4.062971e-02f, -3.301023e-02f,
+		+2.700557e-02f, -2.213828e-02f, +1.811472e-02f, -1.474471e-02f, +1.189966e-02f, -9.489286e-03f, +7.448018e-03f, -5.726614e-03f,
+		+4.286860e-03f, -3.098103e-03f, +2.134915e-03f, -1.375510e-03f, +8.006445e-04f, -3.928527e-04f, +1.359163e-04f, -1.450055e-05f
+	}, {
+		-2.537056e-06f, +6.607267e-05f, -2.228007e-04f, +4.834383e-04f, -8.592768e-04f, +1.362416e-03f, -2.006106e-03f, +2.805240e-03f,
+		-3.777065e-03f, +4.942202e-03f, -6.326144e-03f, +7.961470e-03f, -9.891211e-03f, +1.217411e-02f, -1.489313e-02f, +1.816976e-02f,
+		-2.218943e-02f, +2.724946e-02f, -3.385706e-02f, +4.295093e-02f, -5.647748e-02f, +7.922398e-02f, -1.269367e-01f, +2.993829e-01f,
+		+9.000753e-01f, -1.788607e-01f, +9.788141e-02f, -6.616853e-02f, +4.896667e-02f, -3.800644e-02f, +3.031531e-02f, -2.456432e-02f,
+		+2.007155e-02f, -1.645206e-02f, +1.347264e-02f, -1.098403e-02f, +8.886314e-03f, -7.109989e-03f, +5.604985e-03f, -4.334012e-03f,
+		+3.268371e-03f, -2.385230e-03f, +1.665807e-03f, -1.094138e-03f, +6.562235e-04f, -3.394408e-04f, +1.321291e-04f, -2.330790e-05f
+	}
+};
+/* clang-format on */
+
+LoudnessMeter::LoudnessMeter (float sample_rate, unsigned int channels)
+	: _sample_rate (sample_rate)
+	, _n_channels (channels)
+	, _n_lanes ((std::max (1u, channels) + 3) & ~3u)
+	, _frag_len (std::max<samplecnt_t> (1, lrintf (sample_rate / 10.f)))
+	, _upsample_x4 (sample_rate <= 48000)
+	, _mem (0)
+{
+	assert (channels > 0);
+
+	const size_t per_lane = 8 + 2 * tp_taps + block_size;
+	cache_aligned_malloc ((void**) &_mem, per_lane * _n_lanes * sizeof (float));
+	memset (_mem, 0, per_lane * _n_lanes * sizeof (float));
+
+	float* p = _mem;
+	_weight  = p; p += _n_lanes;
+	_z1      = p; p += _n_lanes;
+	_z2      = p; p += _n_lanes;
+	_z3      = p; p += _n_lanes;
+	_z4      = p; p += _n_lanes;
+	_pwr     = p; p += _n_lanes;
+	_tp      = p; p += _n_lanes;
+	_tp_last = p; p += _n_lanes;
+	_tp_hist = p; p += 2 * tp_taps * _n_lanes;
+	_buf     = p;
+
+	/* padding lanes have no weight */
+	for (unsigned int c = 0; c < _n_channels; ++c) {
+		_weight[c] = 1.f;
+	}
+	if (_n_channels == 5) {
+		_weight[3] = _weight[4] = 1.41f;
+	} else if (_n_channels == 6) {
+		_weight[3] = 0.f;
+		_weight[4] = _weight[5] = 1.41f;
+	}
+
+	init_filter ();
+	reset ();
+}
+
+LoudnessMeter::~LoudnessMeter ()
+{
+	cache_aligned_free (_mem);
+}
+
+void
+LoudnessMeter::init_filter ()
+{
+	/* Second order shelf and high-pass combined, see
+	 * ITU-R BS.1770-4 and Fons Adriaensen's ebu_r128_proc
+	 */
+	float a, b, c, d, r, u, w1, w2;
+
+	r  = 1 / tan (4712.3890f / _sample_rate);
+	w1 = r / 1.12201f;
+	w2 = r * 1.12201f;
+	u  = 1.4085f + 210.0f / _sample_rate;
+
+	a = u * w1;
+	b = w1 * w1;
+	c = u * w2;
+	d = w2 * w2;
+
+	r   = 1 + a + b;
+	_a0 = (1 + c + d) / r;
+	_a1 = (2 - 2 * d) / r;
+	_a2 = (1 - c + d) / r;
+	_b1 = (2 - 2 * b) / r;
+	_b2 = (1 - a + b) / r;
+
+	r = 48.0f / _sample_rate;
+	a = 4.9886075f * r;
+	b = 6.2298014f * r * r;
+	r = 1 + a + b;
+	a *= 2 / r;
+	b *= 4 / r;
+	_c3 = a + b;
+	_c4 = b;
+
+	r = 1.004995f / r;
+	_a0 *= r;
+	_a1 *= r;
+	_a2 *= r;
+}
+
+void
+LoudnessMeter::set_channel_weight (unsigned int chn, float weight)
+{
+	if (chn < _n_channels) {
+		_weight[chn] = weight;
+	}
+}
+
+void
+LoudnessMeter::reset ()
+{
+	const size_t n = _n_lanes * sizeof (float);
+	memset (_z1, 0, n);
+	memset (_z2, 0, n);
+	memset (_z3, 0, n);
+	memset (_z4, 0, n);
+	memset (_pwr, 0, n);
+	memset (_tp, 0, n);
+	memset (_tp_last, 0, n);
+	memset (_tp_hist, 0, 2 * tp_taps * n);
+	_tp_pos = 0;
+
+	_frag_pos = 0;
+	_frag_idx = 0;
+	_frag_cnt = 0;
+	memset (_frag_pwr, 0, sizeof (_frag_pwr));
+
+	_loudness_M = -200.f;
+	_loudness_S = -200.f;
+	_max_M      = -200.f;
+	_max_S      = -200.f;
+
+	memset (_hist_M, 0, sizeof (_hist_M));
+	memset (_hist_M_pwr, 0, sizeof (_hist_M_pwr));
+	memset (_hist_S, 0, sizeof (_hist_S));
+}
+
+void
+LoudnessMeter::process (float const* data, samplecnt_t n_samples)
+{
+	memset (_tp_last, 0, _n_lanes * sizeof (float));
+
+	const unsigned int nc = _n_channels;
+	while (n_samples > 0) {
+		const samplecnt_t n = std::min<samplecnt_t> (std::min<samplecnt_t> (block_size, n_samples), _frag_len - _frag_pos);
+		for (samplecnt_t i = 0; i < n; ++i) {
+			memcpy (&_buf[i * _n_lanes], &data[i * nc], nc * sizeof (float));
+		}
+		run (n);
+		data += n * nc;
+		n_samples -= n;
+	}
+}
+
+void
+LoudnessMeter::process (float const* const* data, samplecnt_t n_samples, samplecnt_t offset)
+{
+	memset (_tp_last, 0, _n_lanes * sizeof (float));
+
+	samplecnt_t pos = offset;
+	while (n_samples > 0) {
+		const samplecnt_t n = std::min<samplecnt_t> (std::min<samplecnt_t> (block_size, n_samples), _frag_len - _frag_pos);
+		for (unsigned int c = 0; c < _n_channels; ++c) {
+			float const* d = &data[c][pos];
+			for (samplecnt_t i = 0; i < n; ++i) {
+				_buf[i * _n_lanes + c] = d[i];
+			}
+		}
+		run (n);
+		pos += n;
+		n_samples -= n;
+	}
+}
+
+/* Interpolate one of the oversampling phases of four lanes,
+ * \a w holds tp_taps samples per lane, oldest first.
+ */
+static inline void
+upsample_peak (float* __restrict tp, float const* __restrict w, float const* __restrict coeff)
+{
+	/* independent partial sums, to not wait for the result of each addition */
+	float acc[4][4] = { { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } };
+	for (int k = 0; k < 48; k += 4) {
+		for (int j = 0; j < 4; ++j) {
+			for (int l = 0; l < 4; ++l) {
+				acc[j][l] += coeff[k + j] * w[4 * (k + j) + l];
+			}
+		}
+	}
+	for (int l = 0; l < 4; ++l) {
+		const float u = (acc[0][l] + acc[1][l]) + (acc[2][l] + acc[3][l]);
+		tp[l] = std::max (tp[l], fabsf (u));
+	}
+}
+
+void
+LoudnessMeter::run (samplecnt_t n)
+{
+	const unsigned int nl = _n_lanes;
+
+	const float a0 = _a0, a1 = _a1, a2 = _a2;
+	const float b1 = _b1, b2 = _b2;
+	const float c3 = _c3, c4 = _c4;
+
+	unsigned int tp_pos = _tp_pos;
+
+	/* lanes are processed in groups of four, the state is kept in
+	 * local arrays of fixed size, so that the compiler can keep it
+	 * in vector registers.
+	 */
+	for (unsigned int g = 0; g < nl; g += 4) {
+		float z1[4], z2[4], z3[4], z4[4], pwr[4], tp[4];
+
+		for (int l = 0; l < 4; ++l) {
+			z1[l]  = _z1[g + l];
+			z2[l]  = _z2[g + l];
+			z3[l]  = _z3[g + l];
+			z4[l]  = _z4[g + l];
+			pwr[l] = _pwr[g + l];
+			tp[l]  = _tp_last[g + l];
+		}
+
+		/* K-weighting */
+		for (samplecnt_t i = 0; i < n; ++i) {
+			float const* const x = &_buf[i * nl + g];
+			for (int l = 0; l < 4; ++l) {
+				const float xi = x[l] - b1 * z1[l] - b2 * z2[l] + 1e-15f;
+				float       y  = a0 * xi + a1 * z1[l] + a2 * z2[l] - c3 * z3[l] - c4 * z4[l];
+				z2[l] = z1[l];
+				z1[l] = xi;
+				z4[l] += z3[l];
+				z3[l] += y;
+				/* y * y would be denormal, -300dB do not add up to anything */
+				y = fabsf (y) > 1e-15f ? y : 0.f;
+				pwr[l] += y * y;
+			}
+		}
+
+		/* true peak, the history holds two copies of the last
+		 * tp_taps samples, so that the window is contiguous.
+		 */
+		float* const h = &_tp_hist[g * 2 * tp_taps];
+		tp_pos = _tp_pos;
+
+		for (samplecnt_t i = 0; i < n; ++i) {
+			float const* const x = &_buf[i * nl + g];
+			for (int l = 0; l < 4; ++l) {
+				h[4 * tp_pos + l]             = x[l];
+				h[4 * (tp_pos + tp_taps) + l] = x[l];
+				tp[l] = std::max (tp[l], fabsf (x[l]));
+			}
+			tp_pos = (tp_pos + 1) % tp_taps;
+
+			float const* const w = &h[4 * tp_pos];
+			if (_upsample_x4) {
+				upsample_peak (tp, w, tp_coeff[0]);
+				upsample_peak (tp, w, tp_coeff[2]);
+			}
+			upsample_peak (tp, w, tp_coeff[1]);
+		}
+
+		for (int l = 0; l < 4; ++l) {
+			_z1[g + l]      = isfinite_local (z1[l]) ? z1[l] : 0;
+			_z2[g + l]      = isfinite_local (z2[l]) ? z2[l] : 0;
+			_z3[g + l]      = isfinite_local (z3[l]) ? z3[l] : 0;
+			_z4[g + l]      = isfinite_local (z4[l]) ? z4[l] : 0;
+			_pwr[g + l]     = pwr[l];
+			_tp_last[g + l] = tp[l];
+			_tp[g + l]      = std::max (_tp[g + l], tp[l]);
+		}
+	}
+
+	_tp_pos = tp_pos;
+
+	_frag_pos += n;
+	if (_frag_pos == _frag_len) {
+		end_fragment ();
+	}
+}
+
+int
+LoudnessMeter::hist_bin (float lufs)
+{
+	return std::min (hist_size - 1, (int) floorf (10.f * lufs + 700.5f));
+}
+
+float
+LoudnessMeter::hist_bin_power (int bin)
+{
+	return powf (10.f, (bin - 700) / 100.f);
+}
+
+float
+LoudnessMeter::sum_fragments (unsigned int n) const
+{
+	float s = 0;
+	for (unsigned int i = 1; i <= n; ++i) {
+		s += _frag_pwr[(_frag_idx + 32 - i) & 31];
+	}
+	return s / n;
+}
+
+void
+LoudnessMeter::end_fragment ()
+{
+	float p = 0;
+	for (unsigned int c = 0; c < _n_channels; ++c) {
+		p += _weight[c] * _pwr[c];
+		_pwr[c] = 0;
+	}
+
+	_frag_pwr[_frag_idx] = p / _frag_len;
+	_frag_idx = (_frag_idx + 1) & 31;
+	_frag_pos = 0;
+	++_frag_cnt;
+
+	const float pwr_M = sum_fragments (4);
+	const float pwr_S = sum_fragments (30);
+
+	_loudness_M = std::max (-200.f, -0.6976f + 10.f * log10f (pwr_M + 1e-30f));
+	_loudness_S = std::max (-200.f, -0.6976f + 10.f * log10f (pwr_S + 1e-30f));
+	_max_M      = std::max (_max_M, _loudness_M);
+	_max_S      = std::max (_max_S, _loudness_S);
+
+	/* only complete blocks are gated */
+	if (_frag_cnt >= 4 && _loudness_M > -70.f) {
+		const int b = hist_bin (_loudness_M);
+		++_hist_M[b];
+		_hist_M_pwr[b] += pwr_M;
+	}
+	if (_frag_cnt >= 30 && _loudness_S > -70.f) {
+		++_hist_S[hist_bin (_loudness_S)];
+	}
+}
+
+float
+LoudnessMeter::integrated () const
+{
+	uint64_t n   = 0;
+	double   sum = 0;
+	for (int i = 0; i < hist_size; ++i) {
+		n += _hist_M[i];
+		sum += _hist_M_pwr[i];
+	}
+	if (n == 0) {
+		return -200.f;
+	}
+
+	/* relative gate */
+	const float thresh = -0.6976f + 10.f * log10f (sum / n) - 10.f;
+
+	n   = 0;
+	sum = 0;
+	for (int i = std::max (0, hist_bin (thresh)); i < hist_size; ++i) {
+		n += _hist_M[i];
+		sum += _hist_M_pwr[i];
+	}
+	if (n == 0) {
+		return -200.f;
+	}
+	return -0.6976f + 10.f * log10f (sum / n);
+}
+
+float
+LoudnessMeter::loudness_range () const
+{
+	uint64_t n   = 0;
+	double   sum = 0;
+	for (int i = 0; i < hist_size; ++i) {
+		n += _hist_S[i];
+		sum += _hist_S[i] * (double) hist_bin_power (i);
+	}
+	if (n == 0) {
+		return 0;
+	}
+
+	/* relative gate, EBU Tech 3342 */
+	const int k = std::max (0, hist_bin (10.f * log10f (sum / n) - 20.f));
+
+	n = 0;
+	for (int i = k; i < hist_size; ++i) {
+		n += _hist_S[i];
+	}
+	if (n == 0) {
+		return 0;
+	}
+
+	/* 10% and 95% percentile */
+	const double lo = 0.10 * n;
+	const double hi = 0.95 * n;
+
+	int      i0 = -1;
+	int      i1 = -1;
+	uint64_t s  = 0;
+	for (int i = k; i < hist_size; ++i) {
+		s += _hist_S[i];
+		if (i0 < 0 && s > lo) {
+			i0 = i;
+		}
+		if (i1 < 0 && s >= hi) {
+			i1 = i;
+			break;
+		}
+	}
+	assert (i0 >= 0 && i1 >= i0);
+	return (i1 - i0) / 10.f;
+}
+
+float
+LoudnessMeter::true_peak () const
+{
+	float p = 0;
+	for (unsigned int c = 0; c < _n_channels; ++c) {
+		p = std::max (p, _tp[c]);
+	}
+	return p;
+}
+
+float
+LoudnessMeter::true_peak (unsigned int chn) const
+{
+	return chn < _n_channels ? _tp[chn] : 0;
+}
+
+float
+LoudnessMeter::last_true_peak (unsigned int chn) const
+{
+	return chn < _n_channels ? _tp_last[chn] : 0;
+}
@@ -22,9 +22,12 @@
 #include "audiographer/general/sample_format_converter.h"
 
 #include "audiographer/exception.h"
+#include "audiographer/routines.h"
 #include "audiographer/type_utils.h"
 #include "private/gdither/gdither.h"
 
+#include <cstring>
+
 #include <boost/format.hpp>
 
 namespace AudioGrapher
@@ -36,7 +39,11 @@ SampleFormatConverter<TOut>::SampleFormatConverter (ChannelCount channels) :
   dither (0),
   data_out_size (0),
   data_out (0),
-  clip_floats (false)
+  clip_floats (false),
+  use_routines (false),
+  dither_type (D_None),
+  noise (0),
+  tri_noise (0)
 {
 }
 
@@ -65,6 +72,10 @@ SampleFormatConverter<int32_t>::init (samplecnt_t max_samples, int type, int dat
 
 	init_common (max_samples);
 	dither = gdither_new ((GDitherType) type, channels, GDither32bit, data_width);
+
+	if (data_width == 24) {
+		init_routines (max_samples, type);
+	}
 }
 
 template <>
@@ -78,6 +89,10 @@ SampleFormatConverter<int16_t>::init (samplecnt_t max_samples, int type, int dat
 	}
 	init_common (max_samples);
 	dither = gdither_new ((GDitherType) type, channels, GDither16bit, data_width);
+
+	if (data_width == 16) {
+		init_routines (max_samples, type);
+	}
 }
 
 template <>
@@ -107,6 +122,84 @@ SampleFormatConverter<TOut>::init_common (samplecnt_t max_samples)
 	}
 }
 
+/* Full width conversion with rectangular or triangular dither (or none)
+ * is done with Routines::float_to_int16/24 and noise generated here,
+ * noise shaping and reduced data widths still use gdither.
+ */
+template <typename TOut>
+void
+SampleFormatConverter<TOut>::init_routines (samplecnt_t max_samples, int type)
+{
+	if (type != D_None && type != D_Rect && type != D_Tri) {
+		return;
+	}
+
+	use_routines = true;
+	dither_type  = type;
+
+	if (type == D_None) {
+		return;
+	}
+
+	/* noise is generated in blocks of 8 */
+	noise = new float[(max_samples + 7) & ~7];
+
+	if (type == D_Tri) {
+		tri_noise = new float[max_samples + channels];
+		memset (tri_noise, 0, sizeof (float) * channels);
+	}
+
+	/* Each lane steps the same LCG as gdither_noise() 8 times at once,
+	 * so that the lanes together produce the sequence of the scalar generator.
+	 */
+	rnd[0] = 23232323;
+	for (int i = 1; i < 8; ++i) {
+		rnd[i] = (rnd[i - 1] * 196314165) + 907633515;
+	}
+}
+
+/* Fill the noise buffer with \a samples of dither noise in LSB units,
+ * as subtracted from the signal by gdither.
+ */
+template <typename TOut>
+float const *
+SampleFormatConverter<TOut>::dither_noise (samplecnt_t samples)
+{
+	if (dither_type == D_None) {
+		return 0;
+	}
+
+	uint32_t mul = 1;
+	uint32_t add = 0;
+	for (int i = 0; i < 8; ++i) {
+		add = (add * 196314165) + 907633515;
+		mul *= 196314165;
+	}
+
+	/* independent lanes, this loop vectorizes */
+	for (samplecnt_t x = 0; x < samples; x += 8) {
+		for (int i = 0; i < 8; ++i) {
+			rnd[i] = (rnd[i] * mul) + add;
+			noise[x + i] = rnd[i] * 2.3283064365387e-10f;
+		}
+	}
+
+	if (dither_type == D_Tri) {
+		/* high-passed triangular noise: the difference of
+		 * successive (white) noise samples of each channel */
+		float* r = tri_noise + channels;
+		for (samplecnt_t x = 0; x < samples; ++x) {
+			r[x] = noise[x] - 0.5f;
+		}
+		for (samplecnt_t x = 0; x < samples; ++x) {
+			noise[x] = r[x] - tri_noise[x];
+		}
+		memmove (tri_noise, tri_noise + samples, sizeof (float) * channels);
+	}
+
+	return noise;
+}
+
 template <typename TOut>
 SampleFormatConverter<TOut>::~SampleFormatConverter ()
 {
@@ -126,6 +219,13 @@ SampleFormatConverter<TOut>::reset()
 	data_out_size = 0;
 	data_out = 0;
 
+	delete[] noise;
+	delete[] tri_noise;
+	noise = 0;
+	tri_noise = 0;
+	use_routines = false;
+	dither_type = D_None;
+
 	clip_floats = false;
 }
 
@@ -140,8 +240,12 @@ SampleFormatConverter<TOut>::process (ProcessContext<float> const & c_in)
 
 	/* Do conversion */
 
-	for (uint32_t chn = 0; chn < c_in.channels(); ++chn) {
-		gdither_runf (dither, chn, c_in.samples_per_channel (), data, data_out);
+	if (use_routines) {
+		convert_routines (data, c_in.samples ());
+	} else {
+		for (uint32_t chn = 0; chn < c_in.channels(); ++chn) {
+			gdither_runf (dither, chn, c_in.samples_per_channel (), data, data_out);
+		}
 	}
 
 	/* Write forward */
@@ -150,6 +254,27 @@ SampleFormatConverter<TOut>::process (ProcessContext<float> const & c_in)
 	this->output (c_out);
 }
 
+/* only int16_t and int32_t set use_routines, see init() */
+template <typename TOut>
+void
+SampleFormatConverter<TOut>::convert_routines (float const *, samplecnt_t)
+{
+}
+
+template <>
+void
+SampleFormatConverter<int16_t>::convert_routines (float const * data, samplecnt_t samples)
+{
+	Routines::float_to_int16 (data_out, data, samples, dither_noise (samples));
+}
+
+template <>
+void
+SampleFormatConverter<int32_t>::convert_routines (float const * data, samplecnt_t samples)
+{
+	Routines::float_to_int24 (data_out, data, samples, dither_noise (samples));
+}
+
 /* Basic non-const version of process(), calls the const one */
 template<typename TOut>
 void
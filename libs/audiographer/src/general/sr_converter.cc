@@ -26,6 +26,8 @@
 #include <cmath>
 #include <boost/format.hpp>
 
+#include "zita-resampler/resampler.h"
+
 namespace AudioGrapher
 {
 using boost::format;
@@ -41,6 +43,9 @@ SampleRateConverter::SampleRateConverter (uint32_t channels)
   , data_out (0)
   , data_out_size (0)
   , src_state (0)
+  , zita (0)
+  , zita_in (0)
+  , zita_out (0)
 {
 	add_supported_flag (ProcessContext<>::EndOfInput);
 }
@@ -56,6 +61,39 @@ SampleRateConverter::init (samplecnt_t in_rate, samplecnt_t out_rate, int qualit
 	}
 
 	active = true;
+	src_data.src_ratio = (double) out_rate / (double) in_rate;
+
+	unsigned int hlen = 0;
+	switch (quality) {
+		case ZitaBest:
+			hlen = 96;
+			break;
+		case ZitaGood:
+			hlen = 48;
+			break;
+		case ZitaFast:
+			hlen = 16;
+			break;
+		default:
+			break;
+	}
+
+	if (hlen > 0) {
+		zita = new ArdourZita::Resampler ();
+		if (zita->setup (in_rate, out_rate, channels, hlen) == 0) {
+			/* pre-fill with silence, to align output with input */
+			zita->inp_count = zita->inpsize () / 2 - 1;
+			zita->inp_data  = 0;
+			zita->out_count = zita->inpsize ();
+			zita->out_data  = 0;
+			zita->process ();
+			return;
+		}
+		delete zita;
+		zita    = 0;
+		quality = SRC_SINC_BEST_QUALITY;
+	}
+
 	int err;
 	src_state = src_new (quality, channels, &err);
 	if (throw_level (ThrowObject) && !src_state) {
@@ -63,8 +101,6 @@ SampleRateConverter::init (samplecnt_t in_rate, samplecnt_t out_rate, int qualit
 			("Cannot initialize sample rate converter: %1%")
 			% src_strerror (err)));
 	}
-
-	src_data.src_ratio = (double) out_rate / (double) in_rate;
 }
 
 SampleRateConverter::~SampleRateConverter ()
@@ -118,6 +154,11 @@ SampleRateConverter::process (ProcessContext<float> const & c)
 			% samples % max_samples_in));
 	}
 
+	if (zita) {
+		process_zita (c);
+		return;
+	}
+
 	int err;
 	bool first_time = true;
 
@@ -204,6 +245,55 @@ SampleRateConverter::process (ProcessContext<float> const & c)
 	}
 }
 
+void
+SampleRateConverter::process_zita (ProcessContext<float> const & c)
+{
+	samplecnt_t const max_out = data_out_size / channels;
+
+	zita->inp_count = c.samples () / channels;
+	zita->inp_data  = const_cast<float *> (c.data ());
+	zita_in        += c.samples () / channels;
+
+	while (zita->inp_count > 0) {
+		zita->out_count = max_out;
+		zita->out_data  = data_out;
+		zita->process ();
+
+		samplecnt_t const n = max_out - zita->out_count;
+		zita_out += n;
+
+		ProcessContext<float> c_out (c, data_out, n * channels);
+		c_out.remove_flag (ProcessContext<float>::EndOfInput);
+		output (c_out);
+	}
+
+	if (!c.has_flag (ProcessContext<float>::EndOfInput)) {
+		return;
+	}
+
+	/* flush the filter with silence, until the output has the expected length */
+	samplecnt_t const total = (samplecnt_t) llrint (zita_in * src_data.src_ratio);
+	do {
+		samplecnt_t const n = std::min (max_out, total - zita_out);
+
+		zita->inp_count = zita->inpsize ();
+		zita->inp_data  = 0;
+		zita->out_count = n;
+		zita->out_data  = data_out;
+		while (zita->out_count > 0) {
+			zita->process ();
+			zita->inp_count = zita->inpsize ();
+		}
+		zita_out += n;
+
+		ProcessContext<float> c_out (c, data_out, n * channels);
+		if (zita_out < total) {
+			c_out.remove_flag (ProcessContext<float>::EndOfInput);
+		}
+		output (c_out);
+	} while (zita_out < total);
+}
+
 void SampleRateConverter::set_end_of_input (ProcessContext<float> const & c)
 {
 	src_data.end_of_input = true;
@@ -229,8 +319,14 @@ void SampleRateConverter::reset ()
 
 	if (src_state) {
 		src_delete (src_state);
+		src_state = 0;
 	}
 
+	delete zita;
+	zita     = 0;
+	zita_in  = 0;
+	zita_out = 0;
+
 	leftover_samples = 0;
 	max_leftover_samples = 0;
 	if (leftover_data) {
@@ -0,0 +1,169 @@
+#include "tests/utils.h"
+
+#include "audiographer/general/async_sink.h"
+
+using namespace AudioGrapher;
+
+class AsyncSinkTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE (AsyncSinkTest);
+  CPPUNIT_TEST (testProcess);
+  CPPUNIT_TEST (testSplitting);
+  CPPUNIT_TEST (testSmallBlocks);
+  CPPUNIT_TEST (testEndOfInput);
+  CPPUNIT_TEST (testBackPressure);
+  CPPUNIT_TEST (testExceptions);
+  CPPUNIT_TEST (testStop);
+  CPPUNIT_TEST_SUITE_END ();
+
+  public:
+	void setUp()
+	{
+		samples = 1024;
+		random_data = TestUtils::init_random_data (samples, 1.0);
+
+		sink.reset (new AppendingVectorSink<float>());
+		grabber.reset (new ProcessContextGrabber<float>());
+		throwing_sink.reset (new ThrowingSink<float>());
+	}
+
+	void tearDown()
+	{
+		delete [] random_data;
+	}
+
+	void testProcess()
+	{
+		AsyncSink<float> async (samples);
+		async.add_output (sink);
+
+		ProcessContext<float> c (random_data, samples, 1);
+		async.process (c);
+		async.process (c);
+		CPPUNIT_ASSERT (async.wait ());
+		CPPUNIT_ASSERT (async.idle ());
+
+		CPPUNIT_ASSERT_EQUAL ((size_t) 2 * samples, sink->get_data().size());
+		CPPUNIT_ASSERT (TestUtils::array_equals (random_data, sink->get_array(), samples));
+		CPPUNIT_ASSERT (TestUtils::array_equals (random_data, &sink->get_array()[samples], samples));
+
+		AsyncSinkBase::Stats s = async.stats ();
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 2 * samples, s.samples);
+		CPPUNIT_ASSERT_EQUAL (0u, s.queued);
+	}
+
+	void testSplitting()
+	{
+		// 100 is not a multiple of 3 channels, blocks must hold whole sample frames
+		AsyncSink<float> async (100);
+		async.add_output (grabber);
+
+		samplecnt_t const n = samples - (samples % 3);
+		ProcessContext<float> c (random_data, n, 3);
+		async.process (c);
+		async.wait ();
+
+		samplecnt_t total = 0;
+		typedef ProcessContextGrabber<float>::ContextList::iterator Iter;
+		for (Iter i = grabber->contexts.begin(); i != grabber->contexts.end(); ++i) {
+			CPPUNIT_ASSERT (i->samples() <= 99);
+			CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 0, i->samples() % 3);
+			CPPUNIT_ASSERT_EQUAL ((ChannelCount) 3, i->channels());
+			total += i->samples();
+		}
+		CPPUNIT_ASSERT_EQUAL (n, total);
+	}
+
+	void testSmallBlocks()
+	{
+		// blocks are sized to hold at least one frame
+		AsyncSink<float> async (2, 8, "AsyncSink", 4);
+		async.add_output (sink);
+
+		samplecnt_t const n = samples - (samples % 4);
+		ProcessContext<float> c (random_data, n, 4);
+		async.process (c);
+		CPPUNIT_ASSERT (async.wait ());
+		CPPUNIT_ASSERT_EQUAL ((size_t) n, sink->get_data().size());
+		CPPUNIT_ASSERT (TestUtils::array_equals (random_data, sink->get_array(), n));
+
+		// more channels than a block can hold
+		AsyncSink<float> small (2);
+		small.add_output (sink);
+		CPPUNIT_ASSERT_THROW (small.process (c), Exception);
+	}
+
+	void testEndOfInput()
+	{
+		AsyncSink<float> async (100);
+		async.add_output (grabber);
+
+		ProcessContext<float> c (random_data, samples, 1);
+		c.set_flag (ProcessContext<float>::EndOfInput);
+		async.process (c);
+		async.wait ();
+
+		// only the last block may carry EndOfInput
+		CPPUNIT_ASSERT (grabber->contexts.size() > 1);
+		typedef ProcessContextGrabber<float>::ContextList::iterator Iter;
+		for (Iter i = grabber->contexts.begin(); i != --grabber->contexts.end(); ++i) {
+			CPPUNIT_ASSERT (!i->has_flag (ProcessContext<float>::EndOfInput));
+		}
+		CPPUNIT_ASSERT (grabber->contexts.back().has_flag (ProcessContext<float>::EndOfInput));
+	}
+
+	void testBackPressure()
+	{
+		// a queue of two blocks, fed with many more blocks
+		AsyncSink<float> async (64, 2);
+		async.add_output (sink);
+
+		for (samplecnt_t pos = 0; pos < samples; pos += 64) {
+			ProcessContext<float> c (&random_data[pos], 64, 1);
+			async.process (c);
+			CPPUNIT_ASSERT (async.stats ().queued <= 2);
+		}
+		async.wait ();
+
+		CPPUNIT_ASSERT_EQUAL ((size_t) samples, sink->get_data().size());
+		CPPUNIT_ASSERT (TestUtils::array_equals (random_data, sink->get_array(), samples));
+		CPPUNIT_ASSERT (async.stats ().max_queued <= 2);
+	}
+
+	void testExceptions()
+	{
+		AsyncSink<float> async (samples);
+		async.add_output (throwing_sink);
+
+		ProcessContext<float> c (random_data, samples, 1);
+		async.process (c);
+		CPPUNIT_ASSERT_THROW (async.wait (), Exception);
+		CPPUNIT_ASSERT_THROW (async.process (c), Exception);
+	}
+
+	void testStop()
+	{
+		AsyncSink<float> async (samples);
+		async.add_output (sink);
+
+		ProcessContext<float> c (random_data, samples, 1);
+		async.process (c);
+		async.stop ();
+		CPPUNIT_ASSERT (async.idle ());
+
+		// data is discarded after stop
+		size_t n = sink->get_data().size();
+		async.process (c);
+		CPPUNIT_ASSERT_EQUAL (n, sink->get_data().size());
+	}
+
+  private:
+	std::shared_ptr<AppendingVectorSink<float> > sink;
+	std::shared_ptr<ProcessContextGrabber<float> > grabber;
+	std::shared_ptr<ThrowingSink<float> > throwing_sink;
+
+	float * random_data;
+	samplecnt_t samples;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (AsyncSinkTest);
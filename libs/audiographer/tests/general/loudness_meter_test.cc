@@ -0,0 +1,180 @@
+#include <cmath>
+
+#include "tests/utils.h"
+
+#include "audiographer/general/loudness_meter.h"
+
+using namespace AudioGrapher;
+
+/* Test signals modelled after EBU Tech 3341 (loudness)
+ * and EBU Tech 3342 (loudness range), 48kHz stereo.
+ */
+class LoudnessMeterTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE (LoudnessMeterTest);
+  CPPUNIT_TEST (testSine);
+  CPPUNIT_TEST (testGating);
+  CPPUNIT_TEST (testLoudnessRange);
+  CPPUNIT_TEST (testTruePeak);
+  CPPUNIT_TEST (testNonInterleaved);
+  CPPUNIT_TEST (testSilence);
+  CPPUNIT_TEST_SUITE_END ();
+
+  public:
+	void setUp()
+	{
+		sample_rate = 48000;
+	}
+
+	void tearDown()
+	{
+		data.clear ();
+	}
+
+	void testSine()
+	{
+		add_sine (2, 10, -23);
+		LoudnessMeter meter (sample_rate, 2);
+		meter.process (&data[0], data.size () / 2);
+
+		CPPUNIT_ASSERT_DOUBLES_EQUAL (-23.0, meter.integrated (), 0.1);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL (-23.0, meter.max_momentary (), 0.1);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL (-23.0, meter.max_short_term (), 0.1);
+
+		meter.reset ();
+		data.clear ();
+		add_sine (2, 10, -33);
+		meter.process (&data[0], data.size () / 2);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL (-33.0, meter.integrated (), 0.1);
+	}
+
+	void testGating()
+	{
+		/* relative gate, the quiet parts are ignored */
+		add_sine (2, 3, -36);
+		add_sine (2, 20, -23);
+		add_sine (2, 3, -36);
+		LoudnessMeter meter (sample_rate, 2);
+		meter.process (&data[0], data.size () / 2);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL (-23.0, meter.integrated (), 0.1);
+
+		/* absolute gate */
+		data.clear ();
+		add_sine (2, 3, -72);
+		add_sine (2, 3, -36);
+		add_sine (2, 20, -23);
+		add_sine (2, 3, -36);
+		add_sine (2, 3, -72);
+		meter.reset ();
+		meter.process (&data[0], data.size () / 2);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL (-23.0, meter.integrated (), 0.1);
+	}
+
+	void testLoudnessRange()
+	{
+		add_sine (2, 10, -20);
+		add_sine (2, 10, -30);
+		LoudnessMeter meter (sample_rate, 2);
+		meter.process (&data[0], data.size () / 2);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL (10.0, meter.loudness_range (), 1.0);
+	}
+
+	void testTruePeak()
+	{
+		/* inter-sample peaks: fs/4 at 45deg, fs/6 at 60deg, fs/8 at 67.5deg */
+		check_true_peak (0.5, 4, 0, -6.0);
+		check_true_peak (0.5, 4, 45, -6.0);
+		check_true_peak (0.5, 6, 60, -6.0);
+		check_true_peak (0.5, 8, 67.5, -6.0);
+		check_true_peak (1.41, 4, 45, 3.0);
+	}
+
+	void testNonInterleaved()
+	{
+		/* many channels, each at a different level */
+		unsigned int const n_chn = 8;
+		add_sine (n_chn, 5, -23);
+		samplecnt_t const n = data.size () / n_chn;
+		for (samplecnt_t i = 0; i < n; ++i) {
+			for (unsigned int c = 0; c < n_chn; ++c) {
+				data[i * n_chn + c] *= (c + 1.f) / n_chn;
+			}
+		}
+
+		std::vector<std::vector<float> > planar (n_chn, std::vector<float> (n));
+		float* bufs[n_chn];
+		for (unsigned int c = 0; c < n_chn; ++c) {
+			for (samplecnt_t i = 0; i < n; ++i) {
+				planar[c][i] = data[i * n_chn + c];
+			}
+			bufs[c] = &planar[c][0];
+		}
+
+		LoudnessMeter interleaved (sample_rate, n_chn);
+		interleaved.process (&data[0], n);
+
+		LoudnessMeter non_interleaved (sample_rate, n_chn);
+		non_interleaved.process (bufs, 1000);
+		non_interleaved.process (bufs, n - 1000, 1000);
+
+		CPPUNIT_ASSERT_EQUAL (interleaved.integrated (), non_interleaved.integrated ());
+		CPPUNIT_ASSERT (interleaved.integrated () > -23.f);
+		for (unsigned int c = 0; c < n_chn; ++c) {
+			CPPUNIT_ASSERT_EQUAL (interleaved.true_peak (c), non_interleaved.true_peak (c));
+		}
+		CPPUNIT_ASSERT (interleaved.true_peak (0) < interleaved.true_peak (n_chn - 1));
+	}
+
+	void testSilence()
+	{
+		data.resize (2 * sample_rate, 0.f);
+		LoudnessMeter meter (sample_rate, 2);
+		meter.process (&data[0], data.size () / 2);
+		CPPUNIT_ASSERT_EQUAL (-200.f, meter.integrated ());
+		CPPUNIT_ASSERT_EQUAL (0.f, meter.loudness_range ());
+		CPPUNIT_ASSERT_EQUAL (0.f, meter.true_peak ());
+	}
+
+  private:
+	/* append a 1kHz sine, all channels in phase */
+	void add_sine (unsigned int n_chn, double seconds, double dbfs)
+	{
+		add_sine (n_chn, seconds * sample_rate, pow (10.0, .05 * dbfs), 1000, 0, 0);
+	}
+
+	/* append a sine, with a fade in/out of \a fade samples */
+	void add_sine (unsigned int n_chn, samplecnt_t n, double gain, double freq, double phase, samplecnt_t fade)
+	{
+		size_t const off = data.size ();
+		data.resize (off + n * n_chn);
+		for (samplecnt_t i = 0; i < n; ++i) {
+			double g = gain;
+			if (fade > 0) {
+				g *= std::min (1.0, std::min (i, n - i) / (double) fade);
+			}
+			float const v = g * sin (2.0 * M_PI * freq * i / sample_rate + phase);
+			for (unsigned int c = 0; c < n_chn; ++c) {
+				data[off + i * n_chn + c] = v;
+			}
+		}
+	}
+
+	void check_true_peak (double gain, double fs_div, double phase_deg, float dbtp)
+	{
+		/* fade in/out to avoid the overshoot of a step */
+		data.clear ();
+		add_sine (2, sample_rate, gain, sample_rate / fs_div, phase_deg * M_PI / 180.0, sample_rate / 10);
+
+		LoudnessMeter meter (sample_rate, 2);
+		meter.process (&data[0], data.size () / 2);
+
+		float const tp = 20.f * log10f (meter.true_peak ());
+		CPPUNIT_ASSERT (tp <= dbtp + 0.2f);
+		CPPUNIT_ASSERT (tp >= dbtp - 0.4f);
+	}
+
+	std::vector<float> data;
+	float sample_rate;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (LoudnessMeterTest);
@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "tests/utils.h"
 
 #include "audiographer/general/sample_format_converter.h"
@@ -15,6 +17,9 @@ class SampleFormatConverterTest : public CppUnit::TestFixture
   CPPUNIT_TEST (testInt16);
   CPPUNIT_TEST (testUint8);
   CPPUNIT_TEST (testChannelCount);
+  CPPUNIT_TEST (testInt16Clip);
+  CPPUNIT_TEST (testInt24Clip);
+  CPPUNIT_TEST (testDither);
   CPPUNIT_TEST_SUITE_END ();
 
   public:
@@ -204,6 +209,91 @@ class SampleFormatConverterTest : public CppUnit::TestFixture
 		CPPUNIT_ASSERT (TestUtils::array_filled(sink->get_array(), pc.samples()));
 	}
 
+	void testInt16Clip()
+	{
+		std::shared_ptr<SampleFormatConverter<int16_t> > converter (new SampleFormatConverter<int16_t>(1));
+		std::shared_ptr<VectorSink<int16_t> > sink (new VectorSink<int16_t>());
+
+		converter->init(samples, D_None, 16);
+		converter->add_output (sink);
+
+		random_data[10] = -1.5;
+		random_data[20] = 1.5;
+		random_data[30] = 1.0;
+
+		ProcessContext<float> pc(random_data, samples, 1);
+		converter->process (pc);
+		CPPUNIT_ASSERT_EQUAL (samples, (samplecnt_t) sink->get_data().size());
+
+		for (samplecnt_t i = 0; i < samples; ++i) {
+			long r = lrintf (random_data[i] * 32768.f);
+			r = std::max (-32768L, std::min (32767L, r));
+			CPPUNIT_ASSERT_EQUAL ((int16_t) r, sink->get_data()[i]);
+		}
+	}
+
+	void testInt24Clip()
+	{
+		std::shared_ptr<SampleFormatConverter<int32_t> > converter (new SampleFormatConverter<int32_t>(1));
+		std::shared_ptr<VectorSink<int32_t> > sink (new VectorSink<int32_t>());
+
+		converter->init(samples, D_None, 24);
+		converter->add_output (sink);
+
+		random_data[10] = -1.5;
+		random_data[20] = 1.5;
+		random_data[30] = 1.0;
+
+		ProcessContext<float> pc(random_data, samples, 1);
+		converter->process (pc);
+		CPPUNIT_ASSERT_EQUAL (samples, (samplecnt_t) sink->get_data().size());
+
+		for (samplecnt_t i = 0; i < samples; ++i) {
+			long r = lrintf (random_data[i] * 8388608.f);
+			r = std::max (-8388608L, std::min (8388607L, r));
+			CPPUNIT_ASSERT_EQUAL ((int32_t) r * 256, sink->get_data()[i]);
+		}
+	}
+
+	void testDither()
+	{
+		/* dither noise is at most 1 LSB, triangular noise has no DC offset */
+		ChannelCount const channels = 3;
+		samplecnt_t const n = 3000;
+		std::vector<float> data (n * channels);
+		for (samplecnt_t i = 0; i < n * channels; ++i) {
+			data[i] = random_data[i % samples] * .5f;
+		}
+
+		int const types[] = { D_Rect, D_Tri };
+		for (int t = 0; t < 2; ++t) {
+			std::shared_ptr<SampleFormatConverter<int16_t> > converter (new SampleFormatConverter<int16_t>(channels));
+			std::shared_ptr<AppendingVectorSink<int16_t> > sink (new AppendingVectorSink<int16_t>());
+
+			converter->init (1000 * channels, types[t], 16);
+			converter->add_output (sink);
+
+			for (samplecnt_t i = 0; i < n; i += 1000) {
+				ProcessContext<float> pc (&data[i * channels], 1000 * channels, channels);
+				converter->process (pc);
+			}
+			CPPUNIT_ASSERT_EQUAL ((size_t) (n * channels), sink->get_data().size());
+
+			double sum = 0;
+			bool   differs = false;
+			for (samplecnt_t i = 0; i < n * channels; ++i) {
+				float const err = sink->get_data()[i] - data[i] * 32768.f;
+				CPPUNIT_ASSERT (fabsf (err) <= 1.5f);
+				differs |= sink->get_data()[i] != lrintf (data[i] * 32768.f);
+				sum += err;
+			}
+			CPPUNIT_ASSERT (differs);
+			if (types[t] == D_Tri) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL (0.0, sum / (n * channels), 0.05);
+			}
+		}
+	}
+
   private:
 
 	float * random_data;
@@ -0,0 +1,127 @@
+#include <boost/bind/bind.hpp>
+
+#include "tests/utils.h"
+
+#include "audiographer/general/sample_store.h"
+
+using namespace AudioGrapher;
+
+class SampleStoreTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE (SampleStoreTest);
+  CPPUNIT_TEST (testRoundTrip);
+  CPPUNIT_TEST (testEndOfInput);
+  CPPUNIT_TEST (testLargeData);
+  CPPUNIT_TEST (testRewind);
+  CPPUNIT_TEST_SUITE_END ();
+
+  public:
+	void setUp()
+	{
+		samples = 1024;
+		random_data = TestUtils::init_random_data (samples, 1.0);
+		sink.reset (new AppendingVectorSink<float>());
+		ended = 0;
+	}
+
+	void tearDown()
+	{
+		delete [] random_data;
+	}
+
+	void testRoundTrip()
+	{
+		SampleStore<float> store (2);
+		ProcessContext<float> c (random_data, samples, 2);
+		store.process (c);
+		CPPUNIT_ASSERT_EQUAL (samples, store.get_samples_written ());
+
+		float buf[256];
+		ProcessContext<float> rc (buf, 256, 2);
+		samplecnt_t total = 0;
+		samplecnt_t n;
+		store.add_output (sink);
+		while ((n = store.read (rc)) > 0) {
+			total += n;
+		}
+		CPPUNIT_ASSERT_EQUAL (samples, total);
+		CPPUNIT_ASSERT_EQUAL ((size_t) samples, sink->get_data().size());
+		CPPUNIT_ASSERT (TestUtils::array_equals (random_data, sink->get_array(), samples));
+	}
+
+	void testEndOfInput()
+	{
+		SampleStore<float> store (1);
+		PBD::ScopedConnection connection;
+		store.InputEnded.connect_same_thread (connection, boost::bind (&SampleStoreTest::input_ended, this));
+
+		ProcessContext<float> c (random_data, samples, 1);
+		store.process (c);
+		CPPUNIT_ASSERT_EQUAL (0, ended);
+		c.set_flag (ProcessContext<float>::EndOfInput);
+		store.process (c);
+		CPPUNIT_ASSERT_EQUAL (1, ended);
+
+		// only the last read is flagged
+		std::shared_ptr<ProcessContextGrabber<float> > grabber (new ProcessContextGrabber<float>());
+		store.add_output (grabber);
+		float buf[1000];
+		ProcessContext<float> rc (buf, 1000, 1);
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 1000, store.read (rc));
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 1000, store.read (rc));
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 48, store.read (rc));
+		CPPUNIT_ASSERT_EQUAL ((size_t) 3, grabber->contexts.size());
+		CPPUNIT_ASSERT (!grabber->contexts.front().has_flag (ProcessContext<float>::EndOfInput));
+		CPPUNIT_ASSERT (grabber->contexts.back().has_flag (ProcessContext<float>::EndOfInput));
+	}
+
+	void testLargeData()
+	{
+		// data spanning several chunks, written and read in odd sizes
+		SampleStore<float> store (3);
+		samplecnt_t const n = samples - (samples % 3);
+		samplecnt_t const rounds = 1000;
+		for (samplecnt_t i = 0; i < rounds; ++i) {
+			ProcessContext<float> c (random_data, n, 3);
+			store.process (c);
+		}
+		CPPUNIT_ASSERT_EQUAL (rounds * n, store.get_samples_written ());
+		CPPUNIT_ASSERT (store.size_in_bytes () >= rounds * n * sizeof (float));
+
+		store.add_output (sink);
+		float buf[999];
+		ProcessContext<float> rc (buf, 999, 3);
+		while (store.read (rc) == 999) ;
+
+		CPPUNIT_ASSERT_EQUAL ((size_t) (rounds * n), sink->get_data().size());
+		for (samplecnt_t i = 0; i < rounds; ++i) {
+			CPPUNIT_ASSERT (TestUtils::array_equals (random_data, &sink->get_array()[i * n], n));
+		}
+	}
+
+	void testRewind()
+	{
+		SampleStore<float> store (1);
+		ProcessContext<float> c (random_data, samples, 1);
+		store.process (c);
+
+		float buf[1024];
+		ProcessContext<float> rc (buf, samples, 1);
+		CPPUNIT_ASSERT_EQUAL (samples, store.read (rc));
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 0, store.read (rc));
+		store.rewind ();
+		CPPUNIT_ASSERT_EQUAL (samples, store.read (rc));
+		CPPUNIT_ASSERT (TestUtils::array_equals (random_data, buf, samples));
+	}
+
+  private:
+	void input_ended () { ++ended; }
+
+	std::shared_ptr<AppendingVectorSink<float> > sink;
+
+	float * random_data;
+	samplecnt_t samples;
+	int ended;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (SampleStoreTest);
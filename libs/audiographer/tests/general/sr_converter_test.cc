@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "tests/utils.h"
 
 #include "audiographer/general/sr_converter.h"
@@ -11,6 +13,8 @@ class SampleRateConverterTest : public CppUnit::TestFixture
   CPPUNIT_TEST (testUpsampleLength);
   CPPUNIT_TEST (testDownsampleLength);
   CPPUNIT_TEST (testRespectsEndOfInput);
+  CPPUNIT_TEST (testZitaLength);
+  CPPUNIT_TEST (testZitaSine);
   CPPUNIT_TEST_SUITE_END ();
 
   public:
@@ -117,6 +121,64 @@ class SampleRateConverterTest : public CppUnit::TestFixture
 	}
 
 
+	void testZitaLength()
+	{
+		assert (samples % 2 == 0);
+		samplecnt_t const half_samples = samples / 2;
+
+		converter->init (48000, 44100, SampleRateConverter::ZitaGood);
+		converter->allocate_buffers (half_samples);
+		converter->add_output (grabber);
+		converter->add_output (sink);
+
+		ProcessContext<float> c (random_data, half_samples, 1);
+		converter->process (c);
+		ProcessContext<float> c2 (&random_data[half_samples], half_samples, 1);
+		c2.set_flag (ProcessContext<float>::EndOfInput);
+		converter->process (c2);
+
+		/* output is flushed to the exact length */
+		samplecnt_t const expected = (samplecnt_t) llrint (samples * 44100.0 / 48000.0);
+		CPPUNIT_ASSERT_EQUAL (expected, (samplecnt_t) sink->get_data().size());
+		CPPUNIT_ASSERT (grabber->contexts.back().has_flag (ProcessContext<float>::EndOfInput));
+		CPPUNIT_ASSERT (!grabber->contexts.front().has_flag (ProcessContext<float>::EndOfInput));
+	}
+
+	void testZitaSine()
+	{
+		/* a 1kHz sine, 4 channels, the output is aligned with the input */
+		ChannelCount const channels = 4;
+		samplecnt_t const frames = 9600;
+		std::vector<float> in (frames * channels);
+		for (samplecnt_t i = 0; i < frames; ++i) {
+			for (ChannelCount c = 0; c < channels; ++c) {
+				in[i * channels + c] = sinf (2.f * M_PI * 1000.f * i / 96000.f);
+			}
+		}
+
+		converter.reset (new SampleRateConverter (channels));
+		converter->init (96000, 48000, SampleRateConverter::ZitaBest);
+		converter->allocate_buffers (1024 * channels);
+		converter->add_output (sink);
+
+		for (samplecnt_t i = 0; i < frames; i += 1024) {
+			samplecnt_t const n = std::min<samplecnt_t> (1024, frames - i);
+			ProcessContext<float> c (&in[i * channels], n * channels, channels);
+			if (i + n == frames) {
+				c.set_flag (ProcessContext<float>::EndOfInput);
+			}
+			converter->process (c);
+		}
+
+		CPPUNIT_ASSERT_EQUAL ((size_t) (frames / 2 * channels), sink->get_data().size());
+		float const* out = sink->get_array();
+		for (samplecnt_t i = 200; i < frames / 2 - 200; ++i) {
+			for (ChannelCount c = 0; c < channels; ++c) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL (sin (2.0 * M_PI * 1000.0 * i / 48000.0), out[i * channels + c], 1e-4);
+			}
+		}
+	}
+
   private:
 	std::shared_ptr<SampleRateConverter > converter;
 	std::shared_ptr<AppendingVectorSink<float> > sink;
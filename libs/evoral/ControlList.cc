@@ -40,6 +40,8 @@
 #include <iostream>
 #include <utility>
 
+#include <boost/pool/singleton_pool.hpp>
+
 #include "evoral/ControlList.h"
 #include "evoral/Curve.h"
 #include "evoral/ParameterDescriptor.h"
@@ -58,6 +60,41 @@ using namespace Temporal;
 
 namespace Evoral
 {
+
+struct ControlEventPoolTag {};
+typedef boost::singleton_pool<ControlEventPoolTag, sizeof (ControlEvent)> ControlEventPool;
+
+void*
+ControlEvent::operator new (size_t sz)
+{
+	if (sz != sizeof (ControlEvent)) {
+		return ::operator new (sz);
+	}
+
+	void* p = ControlEventPool::malloc ();
+
+	if (!p) {
+		throw std::bad_alloc ();
+	}
+
+	return p;
+}
+
+void
+ControlEvent::operator delete (void* p, size_t sz)
+{
+	if (!p) {
+		return;
+	}
+
+	if (sz != sizeof (ControlEvent)) {
+		::operator delete (p);
+		return;
+	}
+
+	ControlEventPool::free (p);
+}
+
 inline bool
 event_time_less_than (ControlEvent* a, ControlEvent* b)
 {
@@ -66,6 +103,9 @@ event_time_less_than (ControlEvent* a, ControlEvent* b)
 
 ControlList::ControlList (const Parameter& id, const ParameterDescriptor& desc, TimeDomainProvider const & tds)
 	: TimeDomainProvider (tds)
+	, _events_generation (1)
+	, _events_deferred (false)
+	, _deferred_size (0)
 	, _parameter (id)
 	, _desc (desc)
 	, _interpolation (default_interpolation ())
@@ -88,6 +128,9 @@ ControlList::ControlList (const Parameter& id, const ParameterDescriptor& desc,
 
 ControlList::ControlList (const ControlList& other)
 	: TimeDomainProvider (other)
+	, _events_generation (1)
+	, _events_deferred (false)
+	, _deferred_size (0)
 	, _parameter (other._parameter)
 	, _desc (other._desc)
 	, _interpolation (other._interpolation)
@@ -111,6 +154,9 @@ ControlList::ControlList (const ControlList& other)
 
 ControlList::ControlList (const ControlList& other, timepos_t const& start, timepos_t const& end)
 	: TimeDomainProvider (other)
+	, _events_generation (1)
+	, _events_deferred (false)
+	, _deferred_size (0)
 	, _parameter (other._parameter)
 	, _desc (other._desc)
 	, _interpolation (other._interpolation)
@@ -167,6 +213,8 @@ ControlList::operator== (const ControlList& other)
 ControlList&
 ControlList::operator= (const ControlList& other)
 {
+	ensure_events ();
+	other.ensure_events ();
 	if (this != &other) {
 		/* list should be frozen before assignment */
 		assert (_frozen > 0);
@@ -192,6 +240,8 @@ ControlList::operator= (const ControlList& other)
 void
 ControlList::copy_events (const ControlList& other)
 {
+	ensure_events ();
+	other.ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 		for (EventList::iterator x = _events.begin (); x != _events.end (); ++x) {
@@ -235,6 +285,8 @@ ControlList::default_interpolation () const
 void
 ControlList::maybe_signal_changed ()
 {
+	++_events_generation;
+
 	if (_frozen) {
 		_changed_when_thawed = true;
 	} else {
@@ -245,6 +297,7 @@ ControlList::maybe_signal_changed ()
 void
 ControlList::clear ()
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 		for (EventList::iterator x = _events.begin (); x != _events.end (); ++x) {
@@ -261,6 +314,7 @@ ControlList::clear ()
 void
 ControlList::x_scale (ratio_t const& factor)
 {
+	ensure_events ();
 	Glib::Threads::RWLock::WriterLock lm (_lock);
 	_x_scale (factor);
 }
@@ -285,6 +339,7 @@ ControlList::ensure_time_domain (timepos_t const& val) const
 bool
 ControlList::extend_to (timepos_t const& end)
 {
+	ensure_events ();
 	timepos_t actual_end = ensure_time_domain (end);
 
 	Glib::Threads::RWLock::WriterLock lm (_lock);
@@ -302,6 +357,7 @@ ControlList::extend_to (timepos_t const& end)
 void
 ControlList::y_transform (boost::function<double (double)> callback)
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 		for (iterator i = _events.begin (); i != _events.end (); ++i) {
@@ -315,6 +371,7 @@ ControlList::y_transform (boost::function<double (double)> callback)
 void
 ControlList::list_merge (ControlList const& other, boost::function<double (double, double)> callback)
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 		/* First scale existing events, copy into a new list.
@@ -379,6 +436,7 @@ struct ControlEventTimeComparator {
 void
 ControlList::thin (double thinning_factor)
 {
+	ensure_events ();
 	if (thinning_factor == 0.0 || _desc.toggled) {
 		return;
 	}
@@ -398,29 +456,31 @@ ControlList::thin (double thinning_factor)
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 
-		ControlEvent* prevprev = 0;
-		ControlEvent* cur      = 0;
-		ControlEvent* prev     = 0;
 		iterator      pprev;
 		int           counter = 0;
 
+		/* position (in samples) and interface value of the previous
+		 * two points. Converting these is comparatively expensive
+		 * (tempo map lookups, log scales), so each point is converted
+		 * once as it enters the window rather than three times.
+		 */
+		double ppw = 0;
+		double pw  = 0;
+		float  ppv = 0;
+		float  pv  = 0;
+
 		DEBUG_TRACE (DEBUG::ControlList, string_compose ("@%1 thin from %2 events\n", this, _events.size ()));
 
 		for (iterator i = _events.begin (); i != _events.end (); ++i) {
-			cur = *i;
+			ControlEvent* cur = *i;
 			counter++;
 
+			const double cw = cur->when.samples ();
+			const float  cv = _desc.to_interface (cur->value);
+
 			if (counter > 2) {
 				/* compute the area of the triangle formed by 3 points */
 
-				const double ppw = prevprev->when.samples ();
-				const double pw  = prev->when.samples ();
-				const double cw  = cur->when.samples ();
-
-				const float ppv = _desc.to_interface (prevprev->value);
-				const float cv  = _desc.to_interface (cur->value);
-				const float pv  = _desc.to_interface (prev->value);
-
 				double area = fabs ((ppw * (pv - cv)) +
 				                    (pw * (cv - ppv)) +
 				                    (cw * (ppv - pv)));
@@ -434,16 +494,20 @@ ControlList::thin (double thinning_factor)
 					 */
 
 					pprev = i;
-					prev  = cur;
+					pw    = cw;
+					pv    = cv;
+					delete *tmp;
 					_events.erase (tmp);
 					changed = true;
 					continue;
 				}
 			}
 
-			prevprev = prev;
-			prev     = cur;
-			pprev    = i;
+			ppw   = pw;
+			ppv   = pv;
+			pw    = cw;
+			pv    = cv;
+			pprev = i;
 		}
 
 		DEBUG_TRACE (DEBUG::ControlList, string_compose ("@%1 thin => %2 events\n", this, _events.size ()));
@@ -462,6 +526,7 @@ ControlList::thin (double thinning_factor)
 void
 ControlList::fast_simple_add (timepos_t const& time, double value)
 {
+	ensure_events ();
 	Glib::Threads::RWLock::WriterLock lm (_lock);
 	/* to be used only for loading pre-sorted data from saved state */
 
@@ -476,6 +541,7 @@ ControlList::fast_simple_add (timepos_t const& time, double value)
 void
 ControlList::invalidate_insert_iterator ()
 {
+	ensure_events ();
 	Glib::Threads::RWLock::WriterLock lm (_lock);
 	unlocked_invalidate_insert_iterator ();
 }
@@ -496,6 +562,7 @@ ControlList::unlocked_remove_duplicates ()
 	iterator prev = i++;
 	while (i != _events.end ()) {
 		if ((*prev)->when == (*i)->when && (*prev)->value == (*i)->value) {
+			delete *i;
 			i = _events.erase (i);
 		} else {
 			++prev;
@@ -507,6 +574,7 @@ ControlList::unlocked_remove_duplicates ()
 void
 ControlList::start_write_pass (timepos_t const& time)
 {
+	ensure_events ();
 	Glib::Threads::RWLock::WriterLock lm (_lock);
 
 	timepos_t when = ensure_time_domain (time);
@@ -540,6 +608,7 @@ ControlList::start_write_pass (timepos_t const& time)
 void
 ControlList::write_pass_finished (timepos_t const& /*when*/, double thinning_factor)
 {
+	ensure_events ();
 	DEBUG_TRACE (DEBUG::ControlList, "write pass finished\n");
 
 	if (did_write_during_pass) {
@@ -553,6 +622,7 @@ ControlList::write_pass_finished (timepos_t const& /*when*/, double thinning_fac
 void
 ControlList::set_in_write_pass (bool yn, bool add_point, timepos_t when)
 {
+	ensure_events ();
 	DEBUG_TRACE (DEBUG::ControlList, string_compose ("set_in_write_pass: in-write: %1 @ %2 add point? %3\n", yn, when, add_point));
 
 	_in_write_pass = yn;
@@ -616,6 +686,8 @@ ControlList::add_guard_point (timepos_t const& time, timecnt_t const& offset)
 
 	when += offset;
 
+	++_events_generation;
+
 	ControlEvent cp (when, 0.0);
 	most_recent_insert_iterator = lower_bound (_events.begin (), _events.end (), &cp, time_comparator);
 
@@ -667,6 +739,7 @@ ControlList::in_write_pass () const
 bool
 ControlList::editor_add (timepos_t const& time, double value, bool with_guard)
 {
+	ensure_events ();
 	/* this is for making changes from a graphical line editor */
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
@@ -718,6 +791,7 @@ ControlList::editor_add (timepos_t const& time, double value, bool with_guard)
 bool
 ControlList::editor_add_ordered (OrderedPoints const & points, bool with_guard)
 {
+	ensure_events ();
 	/* this is for making changes from a graphical line editor */
 
 	/* Note that as the name suggests, @p points must be in time
@@ -872,6 +946,7 @@ ControlList::erase_from_iterator_to (iterator iter, timepos_t const& time)
 void
 ControlList::add (timepos_t const& time, double value, bool with_guards, bool with_initial)
 {
+	ensure_events ();
 	timepos_t when = ensure_time_domain (time);
 
 	/* clamp new value to allowed range */
@@ -1025,6 +1100,7 @@ ControlList::add (timepos_t const& time, double value, bool with_guards, bool wi
 void
 ControlList::erase (iterator i)
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 		if (most_recent_insert_iterator == i) {
@@ -1039,6 +1115,7 @@ ControlList::erase (iterator i)
 void
 ControlList::erase (iterator start, iterator end)
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 		_events.erase (start, end);
@@ -1052,6 +1129,7 @@ ControlList::erase (iterator start, iterator end)
 void
 ControlList::erase (timepos_t const& time, double value)
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 
@@ -1077,6 +1155,7 @@ ControlList::erase (timepos_t const& time, double value)
 void
 ControlList::erase_range (timepos_t const& start, timepos_t const& endt)
 {
+	ensure_events ();
 	bool erased = false;
 
 	{
@@ -1135,6 +1214,7 @@ ControlList::erase_range_internal (timepos_t const& start, timepos_t const& endt
 void
 ControlList::slide (iterator before, timecnt_t const& distance)
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 
@@ -1157,6 +1237,7 @@ ControlList::slide (iterator before, timecnt_t const& distance)
 void
 ControlList::shift (timepos_t const& time, timecnt_t const& distance)
 {
+	ensure_events ();
 	timepos_t pos = time;
 
 	{
@@ -1216,6 +1297,7 @@ ControlList::shift (timepos_t const& time, timecnt_t const& distance)
 void
 ControlList::modify (iterator iter, timepos_t const& time, double val)
 {
+	ensure_events ();
 	/* note: we assume higher level logic is in place to avoid this
 	 * reordering the time-order of control events in the list. ie. all
 	 * points after *iter are later than when.
@@ -1251,6 +1333,7 @@ ControlList::modify (iterator iter, timepos_t const& time, double val)
 std::pair<ControlList::iterator, ControlList::iterator>
 ControlList::control_points_adjacent (timepos_t const& xtime)
 {
+	ensure_events ();
 	Glib::Threads::RWLock::ReaderLock lm (_lock);
 
 	timepos_t    xval = xtime;
@@ -1305,6 +1388,7 @@ ControlList::thaw ()
 			unlocked_remove_duplicates ();
 			unlocked_invalidate_insert_iterator ();
 			_sort_pending = false;
+			++_events_generation;
 		}
 	}
 	maybe_signal_changed ();
@@ -1319,6 +1403,8 @@ ControlList::mark_dirty () const
 	_search_cache.left         = timepos_t::max (time_domain());
 	_search_cache.first        = _events.end ();
 
+	++_events_generation;
+
 	if (_curve) {
 		_curve->mark_dirty ();
 	}
@@ -1327,6 +1413,7 @@ ControlList::mark_dirty () const
 void
 ControlList::truncate_end (timepos_t const& last_time)
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 
@@ -1427,6 +1514,7 @@ ControlList::truncate_end (timepos_t const& last_time)
 void
 ControlList::truncate_start (timecnt_t const& overall)
 {
+	ensure_events ();
 	{
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 
@@ -1524,6 +1612,7 @@ ControlList::truncate_start (timecnt_t const& overall)
 double
 ControlList::unlocked_eval (timepos_t const& xtime) const
 {
+	ensure_events ();
 	int32_t   npoints;
 	timepos_t lpos, upos;
 	double    lval, uval;
@@ -1597,39 +1686,25 @@ ControlList::multipoint_eval (timepos_t const& xtime) const
 	double    uval, lval;
 	double    fraction;
 
+	pair<const_iterator, const_iterator> range = unlocked_lookup_range (xtime);
+
 	/* "Stepped" lookup (no interpolation) */
-	/* FIXME: no cache.  significant? */
 	if (_interpolation == Discrete) {
-		const ControlEvent        cp (xtime, 0);
-		EventList::const_iterator i = lower_bound (_events.begin (), _events.end (), &cp, time_comparator);
+		const_iterator i = range.first;
 
 		// shouldn't have made it to multipoint_eval
 		assert (i != _events.end ());
 
-		if (i == _events.begin () || (*i)->when == xtime)
+		if (i == _events.begin () || (*i)->when == xtime) {
 			return (*i)->value;
-		else
+		} else {
 			return (*(--i))->value;
+		}
 	}
 
-	/* Only do the range lookup if xtime is in a different range than last time
-	 * this was called (or if the lookup cache has been marked "dirty" (left<0) */
-	if ((_lookup_cache.left == timepos_t::max (time_domain())) ||
-	    ((_lookup_cache.left > xtime) ||
-	     (_lookup_cache.range.first == _events.end ()) ||
-	     ((*_lookup_cache.range.second)->when < xtime))) {
-		const ControlEvent cp (xtime, 0);
-
-		_lookup_cache.range = equal_range (_events.begin (), _events.end (), &cp, time_comparator);
-	}
-
-	pair<const_iterator, const_iterator> range = _lookup_cache.range;
-
 	if (range.first == range.second) {
 		/* x does not exist within the list as a control point */
 
-		_lookup_cache.left = xtime;
-
 		if (range.first != _events.begin ()) {
 			--range.first;
 			lpos = (*range.first)->when;
@@ -1669,10 +1744,63 @@ ControlList::multipoint_eval (timepos_t const& xtime) const
 	}
 
 	/* x is a control point in the data */
-	_lookup_cache.left = timepos_t::max (time_domain());
 	return (*range.first)->value;
 }
 
+pair<ControlList::const_iterator, ControlList::const_iterator> const &
+ControlList::unlocked_lookup_range (timepos_t const& xtime) const
+{
+	ensure_events ();
+	const bool cached = (_lookup_cache.left != timepos_t::max (time_domain())) &&
+	                    (_lookup_cache.left <= xtime) &&
+	                    (_lookup_cache.range.first != _events.end ());
+
+	/* The cached range is still the equal_range() of xtime if xtime is
+	 * the control point it refers to, or if it refers to the gap between
+	 * two points and xtime still falls within that gap.
+	 */
+	if (cached) {
+		if (_lookup_cache.range.first == _lookup_cache.range.second) {
+			if (xtime < (*_lookup_cache.range.second)->when) {
+				_lookup_cache.left = xtime;
+				return _lookup_cache.range;
+			}
+		} else if ((*_lookup_cache.range.first)->when == xtime) {
+			_lookup_cache.left = xtime;
+			return _lookup_cache.range;
+		}
+	}
+
+	if (cached) {
+		/* Moving forward (the common case during playback): nothing
+		 * before the cached position can be at or after xtime, so walk
+		 * from there rather than searching from the start of the list.
+		 */
+
+		const_iterator first = _lookup_cache.range.first;
+
+		while (first != _events.end () && (*first)->when < xtime) {
+			++first;
+		}
+
+		const_iterator second = first;
+
+		while (second != _events.end () && !(xtime < (*second)->when)) {
+			++second;
+		}
+
+		_lookup_cache.range = make_pair (first, second);
+
+	} else {
+		const ControlEvent cp (xtime, 0);
+		_lookup_cache.range = equal_range (_events.begin (), _events.end (), &cp, time_comparator);
+	}
+
+	_lookup_cache.left = xtime;
+
+	return _lookup_cache.range;
+}
+
 void
 ControlList::build_search_cache_if_necessary (timepos_t const& start_time) const
 {
@@ -1711,6 +1839,7 @@ ControlList::build_search_cache_if_necessary (timepos_t const& start_time) const
 bool
 ControlList::rt_safe_earliest_event_discrete_unlocked (timepos_t const& start_time, timepos_t& x, double& y, bool inclusive) const
 {
+	ensure_events ();
 	timepos_t start = start_time;
 
 	build_search_cache_if_necessary (start);
@@ -1753,6 +1882,7 @@ ControlList::rt_safe_earliest_event_discrete_unlocked (timepos_t const& start_ti
 bool
 ControlList::rt_safe_earliest_event_linear_unlocked (Temporal::timepos_t const& start_time, Temporal::timepos_t& x, double& y, bool inclusive, Temporal::timecnt_t min_x_delta) const
 {
+	ensure_events ();
 	timepos_t start = start_time;
 
 	/* the max value is given as an out-of-bounds default value, when the
@@ -2000,18 +2130,21 @@ ControlList::cut_copy_clear (timepos_t const& start_time, timepos_t const& end_t
 std::shared_ptr<ControlList>
 ControlList::cut (timepos_t const& start, timepos_t const& end)
 {
+	ensure_events ();
 	return cut_copy_clear (start, end, 0);
 }
 
 std::shared_ptr<ControlList>
 ControlList::copy (timepos_t const& start, timepos_t const& end)
 {
+	ensure_events ();
 	return cut_copy_clear (start, end, 1);
 }
 
 void
 ControlList::clear (timepos_t const& start, timepos_t const& end)
 {
+	ensure_events ();
 	cut_copy_clear (start, end, 2);
 }
 
@@ -2019,6 +2152,8 @@ ControlList::clear (timepos_t const& start, timepos_t const& end)
 bool
 ControlList::paste (const ControlList& alist, timepos_t const& time)
 {
+	ensure_events ();
+	alist.ensure_events ();
 	if (alist._events.empty ()) {
 		return false;
 	}
@@ -2087,6 +2222,7 @@ ControlList::paste (const ControlList& alist, timepos_t const& time)
 			if ((*where)->when <= end) {
 				tmp = where;
 				++tmp;
+				delete *where;
 				_events.erase (where);
 				where = tmp;
 
@@ -2108,6 +2244,7 @@ ControlList::paste (const ControlList& alist, timepos_t const& time)
 bool
 ControlList::move_ranges (const list<RangeMove>& movements)
 {
+	ensure_events ();
 	typedef list<RangeMove> RangeMoveList;
 
 	{
@@ -2204,6 +2341,7 @@ ControlList::move_ranges (const list<RangeMove>& movements)
 bool
 ControlList::set_interpolation (InterpolationStyle s)
 {
+	ensure_events ();
 	if (_interpolation == s) {
 		return true;
 	}
@@ -2230,6 +2368,7 @@ ControlList::set_interpolation (InterpolationStyle s)
 void
 ControlList::start_domain_bounce (Temporal::DomainBounceInfo& dbi)
 {
+	ensure_events ();
 	if (time_domain() == dbi.to) {
 		return;
 	}
@@ -2246,6 +2385,7 @@ ControlList::start_domain_bounce (Temporal::DomainBounceInfo& dbi)
 void
 ControlList::finish_domain_bounce (Temporal::DomainBounceInfo& dbi)
 {
+	ensure_events ();
 	if (time_domain() == dbi.to) {
 		return;
 	}
@@ -2260,6 +2400,7 @@ ControlList::finish_domain_bounce (Temporal::DomainBounceInfo& dbi)
 			t.set_time_domain (dbi.from);
 			e->when = t;
 		}
+		++_events_generation;
 	}
 
 	maybe_signal_changed ();
@@ -2268,6 +2409,8 @@ ControlList::finish_domain_bounce (Temporal::DomainBounceInfo& dbi)
 bool
 ControlList::operator!= (ControlList const& other) const
 {
+	ensure_events ();
+	other.ensure_events ();
 	if (_events.size () != other._events.size ()) {
 		return true;
 	}
@@ -2295,6 +2438,7 @@ ControlList::operator!= (ControlList const& other) const
 bool
 ControlList::is_sorted () const
 {
+	ensure_events ();
 	Glib::Threads::RWLock::ReaderLock lm (_lock);
 	if (_events.size () == 0) {
 		return true;
@@ -205,7 +205,7 @@ Curve::_get_vector (Temporal::timepos_t x0, Temporal::timepos_t x1, float *vec,
 	x0.set_time_domain (_list.time_domain());
 	x1.set_time_domain (_list.time_domain());
 
-	double rx, lx, hx;
+	double lx, hx;
 	const double start = x0.val();
 	const double end = x1.val();
 	double max_x;
@@ -371,37 +371,185 @@ Curve::_get_vector (Temporal::timepos_t x0, Temporal::timepos_t x1, float *vec,
 		solve ();
 	}
 
-	rx = lx;
-
 	double dx = 0.;
 
 	if (veclen > 1) {
 		dx = (hx - lx) / (veclen - 1);
 	}
 
-	for (i = 0; i < veclen; ++i, rx += dx) {
-		vec[i] = multipoint_eval (x0.is_beats() ? Temporal::timepos_t::from_ticks (rx) : Temporal::timepos_t::from_superclock (rx));
+	render (lx, dx, vec, veclen);
+}
+
+/** Fill vec[n0..n1) for positions lx + i * dx that all lie strictly between
+ * @p before and @p after.
+ *
+ * Everything that only depends on the segment is computed once, leaving
+ * loops that the compiler can vectorize (linear, curved) or at least
+ * reduce to a single transcendental call per sample.
+ */
+void
+Curve::render_segment (ControlEvent const * before, ControlEvent const * after, double lx, double dx, float* vec, int32_t n0, int32_t n1) const
+{
+	const double vdelta = after->value - before->value;
+
+	if (vdelta == 0.0) {
+		const float v = before->value;
+		for (int32_t i = n0; i < n1; ++i) {
+			vec[i] = v;
+		}
+		return;
+	}
+
+	const double bw = before->when.val();
+	const double trange = after->when.val() - bw;
+
+	/* fraction along the segment is f0 + df * i */
+	const double f0 = (lx - bw) / trange;
+	const double df = dx / trange;
+
+	switch (_list.interpolation()) {
+		case ControlList::Discrete:
+			for (int32_t i = n0; i < n1; ++i) {
+				vec[i] = before->value;
+			}
+			return;
+
+		case ControlList::Logarithmic:
+			{
+				/* from * pow (to / from, fraction), see interpolate_logarithmic() */
+				assert (before->value > 0 && before->value * after->value > 0);
+				const double from = before->value;
+				const double lr = log (after->value / before->value);
+				for (int32_t i = n0; i < n1; ++i) {
+					vec[i] = from * exp (lr * (f0 + df * i));
+				}
+			}
+			return;
+
+		case ControlList::Exponential:
+			{
+				/* see interpolate_gain() */
+				const double upper = _list.descriptor().upper;
+				const double from = before->value + TINY_NUMBER;
+				const double to = after->value + TINY_NUMBER;
+
+				if (fabs (to - from) < TINY_NUMBER) {
+					for (int32_t i = n0; i < n1; ++i) {
+						vec[i] = to;
+					}
+					return;
+				}
+
+				const double g0 = gain_to_position (from * 2. / upper);
+				const double gd = gain_to_position (to * 2. / upper) - g0;
+				const double scale = upper / 2.;
+
+				for (int32_t i = n0; i < n1; ++i) {
+					vec[i] = position_to_gain (g0 + (f0 + df * i) * gd) * scale;
+				}
+			}
+			return;
+
+		case ControlList::Curved:
+			if (after->coeff) {
+				/* see multipoint_eval() for notes on the range of x */
+				const double c0 = after->coeff[0];
+				const double c1 = after->coeff[1];
+				const double c2 = after->coeff[2];
+				const double c3 = after->coeff[3];
+				for (int32_t i = n0; i < n1; ++i) {
+					const double xv = lx + dx * i;
+					vec[i] = c0 + xv * (c1 + xv * (c2 + xv * c3));
+				}
+				return;
+			}
+			/* fallthrough */
+		case ControlList::Linear:
+			{
+				const double from = before->value;
+				for (int32_t i = n0; i < n1; ++i) {
+					vec[i] = from + vdelta * (f0 + df * i);
+				}
+			}
+			return;
 	}
 }
 
-double
-Curve::multipoint_eval (Temporal::timepos_t const & x) const
+/** Fill @p vec with the values at positions lx + i * dx (lx being at or
+ * after the first point, and the last position at or before the last
+ * point), one segment between two control points at a time.
+ *
+ * This gives the same result as calling multipoint_eval() for each
+ * position, without the per-sample lookup.
+ */
+void
+Curve::render (double lx, double dx, float* vec, int32_t veclen) const
 {
-	pair<ControlList::EventList::const_iterator,ControlList::EventList::const_iterator> range;
+	ControlList::EventList const & events (_list.events());
+
+	/* start at the first point at or after lx, rather than walking the
+	 * whole list from the beginning (the lookup is cached and moves
+	 * forward during playback) */
+	const Temporal::timepos_t lpos (_list.time_domain() == Temporal::AudioTime
+	                                ? Temporal::timepos_t::from_superclock ((Temporal::superclock_t) floor (lx))
+	                                : Temporal::timepos_t::from_ticks ((int64_t) floor (lx)));
+	ControlList::const_iterator after = _list.unlocked_lookup_range (lpos).first;
+
+	int32_t i = 0;
+
+	while (i < veclen) {
+
+		const double rx = lx + dx * i;
+
+		/* first point at or after rx */
+		while (after != events.end() && (*after)->when.val() < rx) {
+			++after;
+		}
+
+		if (after == events.end()) {
+			/* we're after the last point */
+			const float v = events.back()->value;
+			for (; i < veclen; ++i) {
+				vec[i] = v;
+			}
+			break;
+		}
+
+		if ((*after)->when.val() == rx || after == events.begin()) {
+			/* rx is a control point (or before the first point) */
+			vec[i++] = (*after)->value;
+			continue;
+		}
 
-	ControlList::LookupCache& lookup_cache = _list.lookup_cache();
+		ControlList::const_iterator before = after;
+		--before;
 
-	if ((lookup_cache.left == Temporal::timepos_t::max (_list.time_domain())) ||
-	    ((lookup_cache.left > x) ||
-	     (lookup_cache.range.first == _list.events().end()) ||
-	     ((*lookup_cache.range.second)->when < x))) {
+		/* find the end of the run of positions before the next point */
 
-		ControlEvent cp (x, 0.0);
+		const double aw = (*after)->when.val();
+		int32_t n1 = veclen;
 
-		lookup_cache.range = equal_range (_list.events().begin(), _list.events().end(), &cp, ControlList::time_comparator);
+		if (dx > 0) {
+			n1 = (int32_t) std::min ((double) veclen, ceil ((aw - lx) / dx));
+			/* guard against rounding in either direction */
+			while (n1 > i + 1 && lx + dx * (n1 - 1) >= aw) {
+				--n1;
+			}
+			while (n1 < veclen && lx + dx * n1 < aw) {
+				++n1;
+			}
+			n1 = std::max (n1, i + 1);
+		}
+
+		render_segment (*before, *after, lx, dx, vec, i, n1);
+		i = n1;
 	}
+}
 
-	range = lookup_cache.range;
+double
+Curve::multipoint_eval (Temporal::timepos_t const & x) const
+{
+	pair<ControlList::EventList::const_iterator,ControlList::EventList::const_iterator> range = _list.unlocked_lookup_range (x);
 
 	/* EITHER
 
@@ -418,8 +566,6 @@ Curve::multipoint_eval (Temporal::timepos_t const & x) const
 
 		/* x does not exist within the list as a control point */
 
-		lookup_cache.left = x;
-
 		if (range.first == _list.events().begin()) {
 			/* we're before the first point */
 			// return default_value;
@@ -481,8 +627,6 @@ Curve::multipoint_eval (Temporal::timepos_t const & x) const
 	}
 
 	/* x is a control point in the data */
-	/* invalidate the cached range because its not usable */
-	lookup_cache.left = Temporal::timepos_t::max (_list.time_domain());
 	return (*range.first)->value;
 }
 
@@ -126,19 +126,23 @@ Event<Timestamp>::assign(const Event& other)
 	_id = other._id;
 	_type = other._type;
 	_time = other._time;
-	_owns_buf = other._owns_buf;
-	if (_owns_buf) {
-		if (other._buf) {
-			if (other._size > _size) {
-				_buf = (uint8_t*)::realloc(_buf, other._size);
-			}
-			memcpy(_buf, other._buf, other._size);
-		} else {
-			free(_buf);
-			_buf = NULL;
+
+	/* always copy the data, never share the buffer: \p other may
+	 * reference bytes owned by someone else (e.g. inline Note data).
+	 */
+	if (!_owns_buf) {
+		_buf      = NULL;
+		_size     = 0;
+		_owns_buf = true;
+	}
+	if (other._buf) {
+		if (!_buf || other._size > _size) {
+			_buf = (uint8_t*)::realloc(_buf, other._size);
 		}
+		memcpy(_buf, other._buf, other._size);
 	} else {
-		_buf = other._buf;
+		free(_buf);
+		_buf = NULL;
 	}
 
 	_size = other._size;
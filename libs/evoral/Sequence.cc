@@ -62,6 +62,29 @@ static Temporal::Beats const time_between_interpolated_controller_outputs = Temp
 
 namespace Evoral {
 
+/** A note used only as a key to search the note and pitch sets.
+ *
+ * The note lives on the stack and the shared_ptr aliases it without owning
+ * it (notes store their MIDI data inline), so a search performs no heap
+ * allocation.
+ */
+template<typename Time>
+class SearchNote {
+  public:
+	SearchNote (Time t, uint8_t pitch)
+		: _note (0, t, Time(), pitch, 0)
+		, _ptr (std::shared_ptr<Note<Time> > (), &_note)
+	{}
+
+	std::shared_ptr<Note<Time> > const & ptr () const { return _ptr; }
+
+  private:
+	SearchNote (SearchNote const &); /* undefined, _ptr would alias the original */
+
+	Note<Time>                   _note;
+	std::shared_ptr<Note<Time> > _ptr;
+};
+
 // Read iterator (const_iterator)
 
 template<typename Time>
@@ -505,7 +528,7 @@ Sequence<Time>::Sequence(const Sequence<Time>& other)
 	, _highest_note(other._highest_note)
 {
 	for (typename Notes::const_iterator i = other._notes.begin(); i != other._notes.end(); ++i) {
-		NotePtr n (new Note<Time> (**i));
+		NotePtr n (std::make_shared<Note<Time> > (**i));
 		_notes.insert (n);
 	}
 
@@ -846,9 +869,9 @@ Sequence<Time>::remove_note_unlocked(const constNotePtr note)
 			 * so the search_note has all other properties unset.
 			 */
 
-			NotePtr search_note (new Note<Time>(0, Time(), Time(), note->note(), 0));
+			SearchNote<Time> search_note (Time(), note->note());
 
-			for (j = p.lower_bound (search_note); j != p.end() && (*j)->note() == note->note(); ++j) {
+			for (j = p.lower_bound (search_note.ptr()); j != p.end() && (*j)->note() == note->note(); ++j) {
 
 				if ((*j) == note) {
 					DEBUG_TRACE (DEBUG::Sequence, string_compose ("%1\terasing pitch %2 @ %3\n", this, (int)(*j)->note(), (*j)->time()));
@@ -1006,7 +1029,7 @@ Sequence<Time>::append_note_on_unlocked (const Event<Time>& ev, event_id_t evid)
 	/* nascent (incoming notes without a note-off ...yet) have a duration
 	   that extends to Beats::max()
 	*/
-	NotePtr note(new Note<Time>(ev.channel(), ev.time(), std::numeric_limits<Temporal::Beats>::max() - ev.time(), ev.note(), ev.velocity()));
+	NotePtr note (std::make_shared<Note<Time> > (ev.channel(), ev.time(), std::numeric_limits<Temporal::Beats>::max() - ev.time(), ev.note(), ev.velocity()));
 	assert (note->end_time() == std::numeric_limits<Temporal::Beats>::max());
 	note->set_id (evid);
 
@@ -1158,9 +1181,9 @@ bool
 Sequence<Time>::contains_unlocked (const NotePtr& note) const
 {
 	const Pitches& p (pitches (note->channel()));
-	NotePtr search_note(new Note<Time>(0, Time(), Time(), note->note()));
+	SearchNote<Time> search_note (Time(), note->note());
 
-	for (typename Pitches::const_iterator i = p.lower_bound (search_note);
+	for (typename Pitches::const_iterator i = p.lower_bound (search_note.ptr());
 	     i != p.end() && (*i)->note() == note->note(); ++i) {
 
 		if (**i == *note) {
@@ -1187,9 +1210,9 @@ Sequence<Time>::overlaps_unlocked (const NotePtr& note, const NotePtr& without)
 	Time ea  = note->end_time();
 
 	const Pitches& p (pitches (note->channel()));
-	NotePtr search_note(new Note<Time>(0, Time(), Time(), note->note()));
+	SearchNote<Time> search_note (Time(), note->note());
 
-	for (typename Pitches::const_iterator i = p.lower_bound (search_note);
+	for (typename Pitches::const_iterator i = p.lower_bound (search_note.ptr());
 	     i != p.end() && (*i)->note() == note->note(); ++i) {
 
 		if (without && (**i) == *without) {
@@ -1224,8 +1247,8 @@ template<typename Time>
 typename Sequence<Time>::Notes::const_iterator
 Sequence<Time>::note_lower_bound (Time t) const
 {
-	NotePtr search_note(new Note<Time>(0, t, Time(), 0, 0));
-	typename Sequence<Time>::Notes::const_iterator i = _notes.lower_bound(search_note);
+	SearchNote<Time> search_note (t, 0);
+	typename Sequence<Time>::Notes::const_iterator i = _notes.lower_bound(search_note.ptr());
 	assert(i == _notes.end() || (*i)->time() >= t);
 	return i;
 }
@@ -1259,8 +1282,8 @@ template<typename Time>
 typename Sequence<Time>::Notes::iterator
 Sequence<Time>::note_lower_bound (Time t)
 {
-	NotePtr search_note(new Note<Time>(0, t, Time(), 0, 0));
-	typename Sequence<Time>::Notes::iterator i = _notes.lower_bound(search_note);
+	SearchNote<Time> search_note (t, 0);
+	typename Sequence<Time>::Notes::iterator i = _notes.lower_bound(search_note.ptr());
 	assert(i == _notes.end() || (*i)->time() >= t);
 	return i;
 }
@@ -1321,7 +1344,8 @@ Sequence<Time>::get_notes_by_pitch (Notes& n, NoteOperator op, uint8_t val, int
 		}
 
 		const Pitches& p (pitches (c));
-		NotePtr search_note(new Note<Time>(0, Time(), Time(), val, 0));
+		SearchNote<Time> search (Time(), val);
+		NotePtr const & search_note (search.ptr());
 		typename Pitches::const_iterator i;
 		switch (op) {
 		case PitchEqual:
@@ -23,6 +23,7 @@
 #ifndef EVORAL_CONTROL_LIST_HPP
 #define EVORAL_CONTROL_LIST_HPP
 
+#include <atomic>
 #include <cassert>
 #include <list>
 #include <stdint.h>
@@ -71,6 +72,12 @@ public:
 
 	~ControlEvent() { if (coeff) delete[] coeff; }
 
+	/* Lists can hold millions of events, so they are allocated from a
+	 * chunked pool rather than individually from the heap.
+	 */
+	static void* operator new (size_t);
+	static void  operator delete (void*, size_t);
+
 	void create_coeffs() {
 		if (!coeff)
 			coeff = new double[4];
@@ -118,10 +125,14 @@ public:
 	const ParameterDescriptor& descriptor() const                           { return _desc; }
 	void                       set_descriptor(const ParameterDescriptor& d) { _desc = d; }
 
-	EventList::size_type size() const { return _events.size(); }
+	EventList::size_type size() const {
+		/* known without loading deferred events */
+		return _events_deferred.load (std::memory_order_acquire) ? _deferred_size : _events.size();
+	}
 
 	/** @return time-stamp of first or last event in the list */
 	Temporal::timepos_t when (bool at_start) const {
+		ensure_events ();
 		Glib::Threads::RWLock::ReaderLock lm (_lock);
 		if (_events.empty()) {
 			return std::numeric_limits<Temporal::timepos_t>::min();
@@ -130,10 +141,11 @@ public:
 	}
 
 	Temporal::timecnt_t length() const {
+		ensure_events ();
 		Glib::Threads::RWLock::ReaderLock lm (_lock);
 		return _events.empty() ? std::numeric_limits<Temporal::timecnt_t>::min() : Temporal::timecnt_t (_events.back()->when);
 	}
-	bool empty() const { return _events.empty(); }
+	bool empty() const { return size () == 0; }
 
 	/** Remove all events from this list. */
 	void clear ();
@@ -233,22 +245,23 @@ public:
 	 */
 	void truncate_start (Temporal::timecnt_t const & overall_length);
 
-	iterator            begin()       { return _events.begin(); }
-	const_iterator      begin() const { return _events.begin(); }
-	iterator            end()         { return _events.end(); }
-	const_iterator      end()   const { return _events.end(); }
-	reverse_iterator            rbegin()       { return _events.rbegin(); }
-	const_reverse_iterator      rbegin() const { return _events.rbegin(); }
-	reverse_iterator            rend()         { return _events.rend(); }
-	const_reverse_iterator      rend()   const { return _events.rend(); }
-	ControlEvent*       back()        { return _events.back(); }
-	const ControlEvent* back()  const { return _events.back(); }
-	ControlEvent*       front()       { return _events.front(); }
-	const ControlEvent* front() const { return _events.front(); }
+	iterator            begin()       { ensure_events (); return _events.begin(); }
+	const_iterator      begin() const { ensure_events (); return _events.begin(); }
+	iterator            end()         { ensure_events (); return _events.end(); }
+	const_iterator      end()   const { ensure_events (); return _events.end(); }
+	reverse_iterator            rbegin()       { ensure_events (); return _events.rbegin(); }
+	const_reverse_iterator      rbegin() const { ensure_events (); return _events.rbegin(); }
+	reverse_iterator            rend()         { ensure_events (); return _events.rend(); }
+	const_reverse_iterator      rend()   const { ensure_events (); return _events.rend(); }
+	ControlEvent*       back()        { ensure_events (); return _events.back(); }
+	const ControlEvent* back()  const { ensure_events (); return _events.back(); }
+	ControlEvent*       front()       { ensure_events (); return _events.front(); }
+	const ControlEvent* front() const { ensure_events (); return _events.front(); }
 
 	std::pair<ControlList::iterator,ControlList::iterator> control_points_adjacent (Temporal::timepos_t const & when);
 
 	template<class T> void apply_to_points (T& obj, void (T::*method)(const ControlList&)) {
+		ensure_events ();
 		Glib::Threads::RWLock::WriterLock lm (_lock);
 		(obj.*method)(*this);
 	}
@@ -301,7 +314,19 @@ public:
 	};
 
 	/** @return the list of events */
-	const EventList& events() const { return _events; }
+	const EventList& events() const { ensure_events (); return _events; }
+
+	/** Load event data whose decoding a subclass deferred until the
+	 * list is first used. A no-op otherwise. Not realtime safe.
+	 */
+	void ensure_events () const {
+		if (_events_deferred.load (std::memory_order_acquire)) {
+			load_deferred_events ();
+		}
+	}
+
+	/** @return true if event data has not been loaded yet */
+	bool events_deferred () const { return _events_deferred.load (std::memory_order_acquire); }
 
 	// FIXME: const violations for Curve
 	Glib::Threads::RWLock& lock()       const { return _lock; }
@@ -315,6 +340,12 @@ public:
 	 */
 	double unlocked_eval (Temporal::timepos_t const & x) const;
 
+	/** Update the lookup cache for @p x and return its range (as if by
+	 * std::equal_range). Moving forward from the previous lookup walks
+	 * from the cached position instead of searching the whole list.
+	 */
+	std::pair<const_iterator,const_iterator> const & unlocked_lookup_range (Temporal::timepos_t const & x) const;
+
 	bool rt_safe_earliest_event_discrete_unlocked (Temporal::timepos_t const & start, Temporal::timepos_t & x, double& y, bool inclusive) const;
 	bool rt_safe_earliest_event_linear_unlocked (Temporal::timepos_t const & start, Temporal::timepos_t & x, double& y, bool inclusive, Temporal::timecnt_t min_x_delta = Temporal::timecnt_t::max()) const;
 
@@ -326,6 +357,12 @@ public:
 
 	void mark_dirty () const;
 
+	/** @return a counter that changes whenever the event list may have
+	 * changed. Used to cache data derived from the events, such as their
+	 * serialized form.
+	 */
+	uint64_t events_generation () const { return _events_generation.load (); }
+
 	enum InterpolationStyle {
 		Discrete,
 		Linear,
@@ -391,12 +428,20 @@ public:
 
 	virtual void maybe_signal_changed ();
 
+	/** Fill _events and clear _events_deferred, called by ensure_events().
+	 * Must not call any method that ensures events itself.
+	 */
+	virtual void load_deferred_events () const {}
+
 	void _x_scale (Temporal::ratio_t const &);
 
 	mutable LookupCache   _lookup_cache;
 	mutable SearchCache   _search_cache;
 
 	mutable Glib::Threads::RWLock _lock;
+	mutable std::atomic<uint64_t> _events_generation;
+	mutable std::atomic<bool>     _events_deferred;
+	size_t                        _deferred_size;
 
 	Parameter             _parameter;
 	ParameterDescriptor   _desc;
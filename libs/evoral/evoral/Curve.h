@@ -28,6 +28,7 @@
 
 namespace Evoral {
 
+class ControlEvent;
 class ControlList;
 
 class LIBEVORAL_API Curve : public boost::noncopyable
@@ -45,6 +46,9 @@ public:
 private:
 	double multipoint_eval (Temporal::timepos_t const & x) const;
 
+	void render (double lx, double dx, float* vec, int32_t veclen) const;
+	void render_segment (ControlEvent const * before, ControlEvent const * after, double lx, double dx, float* vec, int32_t n0, int32_t n1) const;
+
 	void _get_vector (Temporal::timepos_t x0, Temporal::timepos_t x1, float *arg, int32_t veclen) const;
 
 	mutable bool       _dirty;
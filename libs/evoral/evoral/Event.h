@@ -68,6 +68,9 @@ public:
 
 	~Event();
 
+	/** Copy type, time, id and data of \a other into this event's own
+	 * buffer, which is (re)allocated as needed. NOT REALTIME SAFE.
+	 */
 	void assign(const Event& other);
 
 	void set(const uint8_t* buf, uint32_t size, Time t);
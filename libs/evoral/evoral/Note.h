@@ -109,7 +109,11 @@ public:
 	inline const Event<Time>& off_event() const { return _off_event; }
 
 private:
-	// Event buffers are self-contained
+	/* Event buffers are self-contained: the (fixed size) MIDI data lives
+	 * in the note itself rather than in per-event heap allocations.
+	 */
+	uint8_t     _on_buf[3];
+	uint8_t     _off_buf[3];
 	Event<Time> _on_event;
 	Event<Time> _off_event;
 };
@@ -122,16 +122,22 @@ public:
 		return a->time() < b->time();
 	}
 
+	/* The comparators take their (shared_ptr) arguments by reference:
+	 * converting a NotePtr to a shared_ptr<const Note> by value costs two
+	 * atomic reference count operations per comparison, and the note
+	 * sets perform a lot of comparisons.
+	 */
+
 	struct NoteNumberComparator {
-		inline bool operator()(const std::shared_ptr< const Note<Time> > a,
-		                       const std::shared_ptr< const Note<Time> > b) const {
+		template<typename A, typename B>
+		inline bool operator()(A const & a, B const & b) const {
 			return a->note() < b->note();
 		}
 	};
 
 	struct EarlierNoteComparator {
-		inline bool operator()(const std::shared_ptr< const Note<Time> > a,
-		                       const std::shared_ptr< const Note<Time> > b) const {
+		template<typename A, typename B>
+		inline bool operator()(A const & a, B const & b) const {
 			return a->time() < b->time();
 		}
 	};
@@ -148,8 +154,8 @@ public:
 
 	struct LaterNoteEndComparator {
 		typedef const Note<Time>* value_type;
-		inline bool operator()(const std::shared_ptr< const Note<Time> > a,
-		                       const std::shared_ptr< const Note<Time> > b) const {
+		template<typename A, typename B>
+		inline bool operator()(A const & a, B const & b) const {
 			return a->end_time() > b->end_time();
 		}
 	};
@@ -193,7 +199,8 @@ public:
 	typedef std::shared_ptr<const Event<Time> > constSysExPtr;
 
 	struct EarlierSysExComparator {
-		inline bool operator() (constSysExPtr a, constSysExPtr b) const {
+		template<typename A, typename B>
+		inline bool operator() (A const & a, B const & b) const {
 			return a->time() < b->time();
 		}
 	};
@@ -206,7 +213,8 @@ public:
 	typedef std::shared_ptr<const PatchChange<Time> > constPatchChangePtr;
 
 	struct EarlierPatchChangeComparator {
-		inline bool operator() (constPatchChangePtr a, constPatchChangePtr b) const {
+		template<typename A, typename B>
+		inline bool operator() (A const & a, B const & b) const {
 			return a->time() < b->time();
 		}
 	};
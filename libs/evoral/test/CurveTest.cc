@@ -523,3 +523,39 @@ CurveTest::constrainedCubic ()
 		CPPUNIT_ASSERT_DOUBLES_EQUAL(v, g[x], 0.000008);
 	}
 }
+
+void
+CurveTest::multiPointVector ()
+{
+	float vec[1024];
+
+	std::shared_ptr<Evoral::ControlList> cl = TestCtrlList();
+	cl->create_curve ();
+
+	/* irregularly spaced points, some of which coincide with vector positions */
+	for (int i = 0; i < 100; ++i) {
+		cl->fast_simple_add (timepos_t::from_superclock (i * 700 + (i % 3) * 64), 0.25 + (i % 7) / 8.0);
+	}
+
+	const ControlList::InterpolationStyle styles[] = { ControlList::Linear, ControlList::Exponential, ControlList::Logarithmic };
+
+	for (size_t s = 0; s < sizeof (styles) / sizeof (styles[0]); ++s) {
+
+		if (styles[s] == ControlList::Logarithmic) {
+			ParameterDescriptor desc;
+			desc.lower = 0.1;
+			desc.upper = 2.0;
+			cl->set_descriptor (desc);
+		}
+
+		CPPUNIT_ASSERT (cl->set_interpolation (styles[s]));
+
+		/* the batch renderer must match per-position evaluation */
+		cl->curve ().get_vector (timepos_t::from_superclock (500), timepos_t::from_superclock (500 + 1023 * 64), vec, 1024);
+
+		for (int i = 0; i < 1024; ++i) {
+			const double expected = cl->unlocked_eval (timepos_t::from_superclock (500 + i * 64));
+			CPPUNIT_ASSERT_DOUBLES_EQUAL (expected, vec[i], 1e-5);
+		}
+	}
+}
@@ -16,6 +16,15 @@ NoteTest::copyTest ()
 	Note<Time> b(a);
 	CPPUNIT_ASSERT (a == b);
 
+	// MIDI data is stored in each note, not shared
+	CPPUNIT_ASSERT (a.on_event().buffer() != b.on_event().buffer());
+	CPPUNIT_ASSERT (a.off_event().buffer() != b.off_event().buffer());
+	b.set_note (62);
+	b.set_velocity (0x20);
+	CPPUNIT_ASSERT_EQUAL ((uint8_t) 60, a.note());
+	CPPUNIT_ASSERT_EQUAL ((uint8_t) 0x40, a.velocity());
+	CPPUNIT_ASSERT_EQUAL ((uint8_t) 62, b.off_event().note());
+
 	// Broken due to event double free!
 	// Note<Time> c(1, Beats(3.0), Beats(4.0), 61, 0x41);
 	// c = a;
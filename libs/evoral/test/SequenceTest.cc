@@ -195,3 +195,22 @@ SequenceTest::controlInterpolationTest ()
 		last_value = i->second;
 	}
 }
+
+void
+SequenceTest::iteratorCopiesEventsTest ()
+{
+	seq->clear();
+
+	for (Notes::const_iterator i = test_notes.begin(); i != test_notes.end(); ++i) {
+		seq->notes().insert(*i);
+	}
+
+	/* notes keep their bytes inline, the iterator must not alias them */
+	for (Sequence<Time>::const_iterator i = seq->begin(); i != seq->end(); ++i) {
+		CPPUNIT_ASSERT(i->owns_buffer());
+		for (Notes::const_iterator n = test_notes.begin(); n != test_notes.end(); ++n) {
+			CPPUNIT_ASSERT(i->buffer() != (*n)->on_event().buffer());
+			CPPUNIT_ASSERT(i->buffer() != (*n)->off_event().buffer());
+		}
+	}
+}
@@ -21,6 +21,9 @@
 #include <iomanip>
 #endif
 
+#include <algorithm>
+
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include <cstdio>
@@ -33,9 +36,11 @@
 
 #include <curl/curl.h>
 
+#include "pbd/cpus.h"
 #include "pbd/failed_constructor.h"
 #include "pbd/file_archive.h"
 #include "pbd/file_utils.h"
+#include "pbd/md5.h"
 #include "pbd/pthread_utils.h"
 #include "pbd/progress.h"
 
@@ -485,8 +490,331 @@ FileArchive::create (const std::string& srcdir, CompressionLevel compression_lev
 	return create (filemap, compression_level);
 }
 
+namespace {
+
+/* Source files are read by a separate thread, a few blocks ahead of the
+ * writer, so that disk I/O overlaps with compression.
+ */
+class ReadAhead
+{
+public:
+	struct Block {
+		Block () : data (0), len (0) {}
+		uint8_t* data;
+		ssize_t  len; /* 0: end of file, -1: the file could not be read */
+	};
+
+	ReadAhead (std::vector<std::string> const& files)
+		: _files (files)
+		, _head (0)
+		, _tail (0)
+		, _stop (false)
+		, _running (true)
+	{
+		for (size_t i = 0; i < n_blocks; ++i) {
+			_blocks[i].data = (uint8_t*) malloc (block_size);
+		}
+		pthread_mutex_init (&_lock, NULL);
+		pthread_cond_init (&_cond, NULL);
+		_joinable = 0 == pthread_create_and_store ("FileArchiveRead", &_tid, _run, this);
+		if (!_joinable) {
+			_running = false;
+		}
+	}
+
+	~ReadAhead ()
+	{
+		stop ();
+		if (_joinable) {
+			pthread_join (_tid, NULL);
+		}
+		pthread_mutex_destroy (&_lock);
+		pthread_cond_destroy (&_cond);
+		for (size_t i = 0; i < n_blocks; ++i) {
+			free (_blocks[i].data);
+		}
+	}
+
+	/* next block of the current file, blocks until it is available */
+	Block const& front ()
+	{
+		pthread_mutex_lock (&_lock);
+		while (_head == _tail && _running) {
+			pthread_cond_wait (&_cond, &_lock);
+		}
+		if (_head == _tail) {
+			/* thread failed to start or ended early */
+			_blocks[_head % n_blocks].len = -1;
+		}
+		pthread_mutex_unlock (&_lock);
+		return _blocks[_head % n_blocks];
+	}
+
+	void pop ()
+	{
+		pthread_mutex_lock (&_lock);
+		if (_head != _tail) {
+			++_head;
+		}
+		pthread_cond_broadcast (&_cond);
+		pthread_mutex_unlock (&_lock);
+	}
+
+	void stop ()
+	{
+		pthread_mutex_lock (&_lock);
+		_stop = true;
+		pthread_cond_broadcast (&_cond);
+		pthread_mutex_unlock (&_lock);
+	}
+
+private:
+	static const size_t n_blocks   = 4;
+	static const size_t block_size = 1048576;
+
+	static void* _run (void* arg)
+	{
+		static_cast<ReadAhead*> (arg)->run ();
+		return 0;
+	}
+
+	void run ()
+	{
+		bool failed = false;
+		for (std::vector<std::string>::const_iterator f = _files.begin (); f != _files.end () && !failed; ++f) {
+			int fd = g_open (f->c_str (), O_RDONLY, 0444);
+#ifdef POSIX_FADV_SEQUENTIAL
+			if (fd >= 0) {
+				posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+			}
+#endif
+			for (;;) {
+				pthread_mutex_lock (&_lock);
+				while (_tail - _head == n_blocks && !_stop) {
+					pthread_cond_wait (&_cond, &_lock);
+				}
+				bool stop = _stop;
+				pthread_mutex_unlock (&_lock);
+
+				if (stop) {
+					if (fd >= 0) {
+						close (fd);
+					}
+					return;
+				}
+
+				/* _tail is only modified by this thread */
+				Block& b (_blocks[_tail % n_blocks]);
+				b.len = fd >= 0 ? read (fd, b.data, block_size) : -1;
+				if (b.len < 0) {
+					/* the reader aborts, there is nothing more to read ahead */
+					b.len  = -1;
+					failed = true;
+				}
+
+				pthread_mutex_lock (&_lock);
+				++_tail;
+				pthread_cond_broadcast (&_cond);
+				pthread_mutex_unlock (&_lock);
+
+				if (b.len <= 0) {
+					break;
+				}
+			}
+			if (fd >= 0) {
+				close (fd);
+			}
+		}
+
+		pthread_mutex_lock (&_lock);
+		_running = false;
+		pthread_cond_broadcast (&_cond);
+		pthread_mutex_unlock (&_lock);
+	}
+
+	std::vector<std::string> const& _files;
+
+	Block           _blocks[n_blocks];
+	size_t          _head;
+	size_t          _tail;
+	bool            _stop;
+	bool            _running;
+	bool            _joinable;
+	pthread_t       _tid;
+	pthread_mutex_t _lock;
+	pthread_cond_t  _cond;
+};
+
+static std::string
+size_key (off_t size)
+{
+	char buf[32];
+	snprintf (buf, sizeof (buf), "%" PRId64 ":", (int64_t) size);
+	return buf;
+}
+
+/* Content hashes of files which may be identical. The first pass only
+ * hashes a few probes of each file, the second pass hashes the complete
+ * files for which the probes match.
+ */
+struct HashJob {
+	HashJob (bool p) : probe (p), next (0) {}
+
+	bool                     probe;
+	std::vector<std::string> files;
+	std::vector<std::string> digests;
+	std::atomic<size_t>      next;
+
+	static std::string probe_digest (std::string const& path)
+	{
+		static const size_t probe_size = 65536;
+
+		int fd = g_open (path.c_str (), O_RDONLY, 0444);
+		if (fd < 0) {
+			return "";
+		}
+
+		GStatBuf statbuf;
+		if (g_fstat (fd, &statbuf)) {
+			close (fd);
+			return "";
+		}
+
+		/* start, middle and end of the file */
+		std::vector<uint8_t> buf (3 * probe_size);
+		const off_t off[3] = { 0, (off_t) statbuf.st_size / 2, std::max<off_t> (0, statbuf.st_size - probe_size) };
+		size_t len = 0;
+		for (int i = 0; i < 3; ++i) {
+			if (lseek (fd, off[i], SEEK_SET) != off[i]) {
+				break;
+			}
+			ssize_t n = read (fd, &buf[len], probe_size);
+			if (n <= 0) {
+				break;
+			}
+			len += n;
+		}
+		close (fd);
+
+		MD5 md5;
+		return size_key (statbuf.st_size) + md5.digestMemory (&buf[0], len);
+	}
+
+	static void* run (void* arg)
+	{
+		HashJob* self = static_cast<HashJob*> (arg);
+		for (size_t i = self->next.fetch_add (1); i < self->files.size (); i = self->next.fetch_add (1)) {
+			if (self->probe) {
+				self->digests[i] = probe_digest (self->files[i]);
+				continue;
+			}
+			if (g_access (self->files[i].c_str (), R_OK) != 0) {
+				continue;
+			}
+			MD5 md5;
+			self->digests[i] = md5.digestFile (const_cast<char*> (self->files[i].c_str ()));
+		}
+		return 0;
+	}
+
+	void process ()
+	{
+		digests.clear ();
+		digests.resize (files.size ());
+
+		std::vector<pthread_t> threads;
+		const size_t n_threads = std::min<size_t> (std::min<uint32_t> (hardware_concurrency (), 8), files.size ());
+		for (size_t t = 1; t < n_threads; ++t) {
+			pthread_t tid;
+			if (0 == pthread_create_and_store ("FileArchiveHash", &tid, run, this)) {
+				threads.push_back (tid);
+			}
+		}
+
+		run (this);
+
+		for (std::vector<pthread_t>::iterator t = threads.begin (); t != threads.end (); ++t) {
+			pthread_join (*t, NULL);
+		}
+	}
+};
+
+} // anonymous namespace
+
+/* keep files of which there is more than one with the same key */
+static std::vector<std::string>
+candidates (std::map<std::string, std::vector<std::string> > const& groups)
+{
+	std::vector<std::string> rv;
+	for (std::map<std::string, std::vector<std::string> >::const_iterator i = groups.begin (); i != groups.end (); ++i) {
+		if (i->second.size () > 1) {
+			rv.insert (rv.end (), i->second.begin (), i->second.end ());
+		}
+	}
+	/* restore filemap order */
+	std::sort (rv.begin (), rv.end ());
+	return rv;
+}
+
+/** Find files that have the same content as a file that is archived
+ *  earlier, and return a map of [duplicate] -> [first file].
+ *  Only files of identical size are hashed.
+ */
+static std::map<std::string, std::string>
+find_duplicates (const std::map<std::string, std::string>& filemap)
+{
+	std::map<std::string, std::vector<std::string> > groups;
+
+	for (std::map<std::string, std::string>::const_iterator f = filemap.begin (); f != filemap.end (); ++f) {
+		GStatBuf statbuf;
+		if (g_stat (f->first.c_str(), &statbuf) || statbuf.st_size < 4096) {
+			continue;
+		}
+		groups[size_key (statbuf.st_size)].push_back (f->first);
+	}
+
+	std::map<std::string, std::string> dups;
+
+	HashJob probe (true);
+	probe.files = candidates (groups);
+	if (probe.files.empty ()) {
+		return dups;
+	}
+	probe.process ();
+
+	groups.clear ();
+	for (size_t i = 0; i < probe.files.size (); ++i) {
+		if (!probe.digests[i].empty ()) {
+			groups[probe.digests[i]].push_back (probe.files[i]);
+		}
+	}
+
+	HashJob full (false);
+	full.files = candidates (groups);
+	if (full.files.empty ()) {
+		return dups;
+	}
+	full.process ();
+
+	/* files are archived in order of the filemap, the first one is kept */
+	std::map<std::string, std::string> first;
+	for (size_t i = 0; i < full.files.size (); ++i) {
+		if (full.digests[i].empty ()) {
+			continue;
+		}
+		std::map<std::string, std::string>::const_iterator f = first.find (full.digests[i]);
+		if (f == first.end ()) {
+			first[full.digests[i]] = full.files[i];
+		} else {
+			dups[full.files[i]] = f->second;
+		}
+	}
+
+	return dups;
+}
+
 int
-FileArchive::create (const std::map<std::string, std::string>& filemap, CompressionLevel compression_level)
+FileArchive::create (const std::map<std::string, std::string>& filemap, CompressionLevel compression_level, bool deduplicate)
 {
 	if (_req.is_remote ()) {
 		return -1;
@@ -498,12 +826,23 @@ FileArchive::create (const std::map<std::string, std::string>& filemap, Compress
 	size_t read_bytes = 0;
 	size_t total_bytes = 0;
 
+	std::map<std::string, std::string> dups;
+	if (deduplicate) {
+		dups = find_duplicates (filemap);
+	}
+
+	std::vector<std::string> to_read;
+
 	for (std::map<std::string, std::string>::const_iterator f = filemap.begin (); f != filemap.end (); ++f) {
 		GStatBuf statbuf;
 		if (g_stat (f->first.c_str(), &statbuf)) {
 			continue;
 		}
+		if (dups.find (f->first) != dups.end ()) {
+			continue;
+		}
 		total_bytes += statbuf.st_size;
+		to_read.push_back (f->first);
 	}
 
 	if (total_bytes == 0) {
@@ -527,18 +866,29 @@ FileArchive::create (const std::map<std::string, std::string>& filemap, Compress
 	archive_write_open_filename (a, _req.url);
 	entry = archive_entry_new ();
 
-#ifndef NDEBUG
-	  const int64_t archive_start_time = g_get_monotonic_time();
-#endif
+	const int64_t archive_start_time = g_get_monotonic_time();
+
+	ReadAhead reader (to_read);
+	std::vector<std::string>::const_iterator next_read = to_read.begin ();
+	bool failed = false;
 
 	for (std::map<std::string, std::string>::const_iterator f = filemap.begin (); f != filemap.end (); ++f) {
-		char buf[8192];
 		const char* filepath = f->first.c_str ();
 		const char* filename = f->second.c_str ();
 
+		std::map<std::string, std::string>::const_iterator dup = dups.find (f->first);
+
+		if (dup == dups.end ()) {
+			if (next_read == to_read.end () || *next_read != f->first) {
+				/* stat failed above */
+				continue;
+			}
+			++next_read;
+		}
+
 		GStatBuf statbuf;
 		if (g_stat (filepath, &statbuf)) {
-			continue;
+			statbuf.st_size = 0;
 		}
 
 		archive_entry_clear (entry);
@@ -556,33 +906,56 @@ FileArchive::create (const std::map<std::string, std::string>& filemap, Compress
 		archive_entry_set_filetype (entry, AE_IFREG);
 		archive_entry_set_perm (entry, 0644);
 
-		archive_write_header (a, entry);
+		if (dup != dups.end ()) {
+			/* identical content, store a hard link to the first copy */
+			archive_entry_set_hardlink (entry, filemap.find (dup->second)->second.c_str ());
+			archive_entry_set_size (entry, 0);
+			archive_write_header (a, entry);
+			continue;
+		}
 
-		int fd = g_open (filepath, O_RDONLY, 0444);
-		assert (fd >= 0);
+		archive_write_header (a, entry);
 
-		ssize_t len = read (fd, buf, sizeof (buf));
-		while (len > 0) {
-			read_bytes += len;
-			archive_write_data (a, buf, len);
+		off_t written = 0;
+		for (;;) {
+			ReadAhead::Block const& b (reader.front ());
+			if (b.len <= 0) {
+				/* the header promises st_size bytes */
+				failed = b.len < 0 || written < statbuf.st_size;
+				reader.pop ();
+				break;
+			}
+			written    += b.len;
+			read_bytes += b.len;
+			archive_write_data (a, b.data, b.len);
+			reader.pop ();
 			if (_progress) {
+				const int64_t elapsed = g_get_monotonic_time() - archive_start_time;
+				if (elapsed > 0) {
+					_progress->set_rate (read_bytes * 1e6 / elapsed);
+				}
 				_progress->set_progress ((float)read_bytes / total_bytes);
 				if (_progress->cancelled ()) {
 					break;
 				}
 			}
-			len = read (fd, buf, sizeof (buf));
 		}
-		close (fd);
-		if (_progress && _progress->cancelled ()) {
+		if (failed || (_progress && _progress->cancelled ())) {
 			break;
 		}
 	}
 
+	reader.stop ();
+
 	archive_entry_free (entry);
 	archive_write_close (a);
 	archive_write_free (a);
 
+	if (failed) {
+		g_unlink (_req.url);
+		return -1;
+	}
+
 	if (_progress) {
 		if (_progress->cancelled ()) {
 			g_unlink (_req.url);
@@ -593,7 +966,11 @@ FileArchive::create (const std::map<std::string, std::string>& filemap, Compress
 
 #ifndef NDEBUG
 	const int64_t elapsed_time_us = g_get_monotonic_time() - archive_start_time;
-	std::cerr << "archived in " << std::fixed << std::setprecision (2) << elapsed_time_us / 1000000. << " sec\n";
+	std::cerr << "archived in " << std::fixed << std::setprecision (2) << elapsed_time_us / 1000000. << " sec";
+	if (!dups.empty ()) {
+		std::cerr << ", " << dups.size () << " duplicate files stored as links";
+	}
+	std::cerr << "\n";
 #endif
 
 	return 0;
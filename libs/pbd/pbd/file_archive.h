@@ -56,7 +56,13 @@ class LIBPBD_API FileArchive
 		};
 
 		int create (const std::string& srcdir, CompressionLevel compression_level = CompressGood);
-		int create (const std::map <std::string, std::string>& filemap, CompressionLevel compression_level = CompressGood);
+		/** Archive the given files [source path] -> [name in archive].
+		 *
+		 * With @a deduplicate, files with identical content are stored once,
+		 * and later copies are stored as hard links to the first one.
+		 * Archives created this way should be unpacked using inflate().
+		 */
+		int create (const std::map <std::string, std::string>& filemap, CompressionLevel compression_level = CompressGood, bool deduplicate = false);
 
 		struct MemPipe {
 			public:
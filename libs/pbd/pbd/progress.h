@@ -33,6 +33,11 @@ public:
 	virtual ~Progress () {}
 	void set_progress (float);
 
+	/** Report the rate at which data is currently processed
+	 *  [bytes/sec], for tasks that copy or convert files.
+	 */
+	virtual void set_rate (double /* bytes_per_sec */) {}
+
 	void ascend ();
 	void descend (float);
 
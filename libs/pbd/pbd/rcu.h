@@ -21,6 +21,7 @@
 #define __pbd_rcu_h__
 
 #include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <memory>
 
@@ -159,15 +160,7 @@ public:
 
 		// clean out any dead wood
 
-		typename std::list<std::shared_ptr<T> >::iterator i;
-
-		for (i = _dead_wood.begin (); i != _dead_wood.end ();) {
-			if ((*i).unique ()) {
-				i = _dead_wood.erase (i);
-			} else {
-				++i;
-			}
-		}
+		collect ();
 
 		/* store the current so that we can do compare and exchange
 		 * when someone calls update(). Notice that we hold
@@ -220,36 +213,7 @@ public:
 				boost::detail::yield (i);
 			}
 
-#if 0 // TODO find a good solition here...
-			/* if we are not the only user, put the old value into dead_wood.
-			 * if we are the only user, then it is safe to drop it here.
-			 */
-
-			if (!_current_write_old->unique ()) {
-				_dead_wood.push_back (*_current_write_old);
-			}
-#else
-			/* above ->unique() condition is subject to a race condition.
-			 *
-			 * Particulalry with JACK2 graph-order callbacks arriving
-			 * concurrently to processing, which can lead to heap-use-after-free
-			 * of the RouteList.
-			 *
-			 * std::shared_ptr<T>::use_count documetation reads:
-			 * > In multithreaded environment, the value returned by use_count is approximate
-			 * > (typical implementations use a memory_order_relaxed load).
-			 */
-			_dead_wood.push_back (*_current_write_old);
-#endif
-
-			/* now delete it - if we are the only user, this deletes the
-			 * underlying object. If other users existed, then there will
-			 * be an extra reference in _dead_wood, ensuring that the
-			 * underlying object lives on even when the other users
-			 * are done with it
-			 */
-
-			delete _current_write_old;
+			retire (_current_write_old);
 		}
 
 		/* unlock, allowing other writers to proceed */
@@ -272,12 +236,226 @@ public:
 		_dead_wood.clear ();
 	}
 
-private:
+protected:
+	/** Called with the write lock held, after @a old was replaced by a new value */
+	virtual void retire (typename RCUManager<T>::PtrToSharedPtr old)
+	{
+#if 0 // TODO find a good solition here...
+		/* if we are not the only user, put the old value into dead_wood.
+		 * if we are the only user, then it is safe to drop it here.
+		 */
+
+		if (!old->unique ()) {
+			_dead_wood.push_back (*old);
+		}
+#else
+		/* above ->unique() condition is subject to a race condition.
+		 *
+		 * Particulalry with JACK2 graph-order callbacks arriving
+		 * concurrently to processing, which can lead to heap-use-after-free
+		 * of the RouteList.
+		 *
+		 * std::shared_ptr<T>::use_count documetation reads:
+		 * > In multithreaded environment, the value returned by use_count is approximate
+		 * > (typical implementations use a memory_order_relaxed load).
+		 */
+		_dead_wood.push_back (*old);
+#endif
+
+		/* now delete it - if we are the only user, this deletes the
+		 * underlying object. If other users existed, then there will
+		 * be an extra reference in _dead_wood, ensuring that the
+		 * underlying object lives on even when the other users
+		 * are done with it
+		 */
+
+		delete old;
+	}
+
+	/** Called with the write lock held, drops dead wood that is no longer in use */
+	virtual void collect ()
+	{
+		typename std::list<std::shared_ptr<T> >::iterator i;
+
+		for (i = _dead_wood.begin (); i != _dead_wood.end ();) {
+			if ((*i).unique ()) {
+				i = _dead_wood.erase (i);
+			} else {
+				++i;
+			}
+		}
+	}
+
 	std::mutex                             _lock;
+
+private:
 	typename RCUManager<T>::PtrToSharedPtr _current_write_old;
 	std::list<std::shared_ptr<T> >         _dead_wood;
 };
 
+/** Epoch based protection of lock-free readers, shared by all EpochRCUManager
+ * instances.
+ *
+ * A reader publishes the current global epoch in a per-thread slot while it
+ * uses a value (see EpochRCUManager::ReadPtr), and clears it again when done.
+ * Neither involves a read-modify-write of a shared counter. A writer stamps a
+ * value it replaced with a new epoch; the value may be reclaimed once no
+ * thread is still reading in an older epoch.
+ *
+ * Read sections nest, and must be entered and left by the same thread.
+ */
+class LIBPBD_API RCUEpoch
+{
+public:
+	static void enter ();
+	static void leave ();
+
+	/** Start a new epoch, and return it. Values replaced before this call
+	 * can be reclaimed as soon as quiescent() returns true for the epoch.
+	 */
+	static uint64_t advance ();
+
+	/** @return true if no thread is reading in an epoch older than @a epoch */
+	static bool quiescent (uint64_t epoch);
+
+	/** Wait until quiescent (@a epoch). Must not be called in a read section */
+	static void synchronize (uint64_t epoch);
+};
+
+/** EpochRCUManager extends SerializedRCUManager with a reader for realtime
+ * threads that does not touch any reference count: ReadPtr only publishes the
+ * current epoch of the calling thread (see RCUEpoch).
+ *
+ * Replaced values are kept, together with the epoch in which they were
+ * replaced, until no ReadPtr can refer to them and the manager holds the
+ * last reference. reclaim() drops them and is expected to be called
+ * regularly from a non-realtime thread (e.g. the butler). write_copy() does
+ * the same. flush() waits for the remaining readers, and then drops all
+ * replaced values unconditionally.
+ *
+ * reader() can be used alongside ReadPtr, as with SerializedRCUManager.
+ */
+template <class T>
+class /*LIBPBD_API*/ EpochRCUManager : public SerializedRCUManager<T>
+{
+public:
+	EpochRCUManager (T* new_managed_object)
+		: SerializedRCUManager<T> (new_managed_object)
+	{
+	}
+
+	~EpochRCUManager ()
+	{
+		for (typename std::list<Retired>::iterator i = _retired.begin (); i != _retired.end (); ++i) {
+			delete i->value;
+		}
+	}
+
+	/** A pointer to the managed object, valid for the lifetime of the ReadPtr.
+	 * ReadPtrs must not be passed between threads.
+	 */
+	class ReadPtr
+	{
+	public:
+		ReadPtr () : _obj (0) {}
+
+		ReadPtr (EpochRCUManager const& mgr)
+			: _obj (0)
+		{
+			reset (mgr);
+		}
+
+		~ReadPtr ()
+		{
+			reset ();
+		}
+
+		void reset (EpochRCUManager const& mgr)
+		{
+			RCUEpoch::enter ();
+			T const* obj = mgr.managed_object.load ()->get ();
+			reset ();
+			if (obj) {
+				_obj = obj;
+			} else {
+				RCUEpoch::leave ();
+			}
+		}
+
+		void reset ()
+		{
+			if (_obj) {
+				_obj = 0;
+				RCUEpoch::leave ();
+			}
+		}
+
+		T const* get () const        { return _obj; }
+		T const& operator* () const  { return *_obj; }
+		T const* operator-> () const { return _obj; }
+		explicit operator bool () const { return _obj != 0; }
+
+	private:
+		ReadPtr (ReadPtr const&);
+		ReadPtr& operator= (ReadPtr const&);
+
+		T const* _obj;
+	};
+
+	/** Drop replaced values that are no longer in use, without blocking. */
+	void reclaim ()
+	{
+		std::unique_lock<std::mutex> lm (SerializedRCUManager<T>::_lock, std::try_to_lock);
+		if (lm.owns_lock ()) {
+			collect ();
+		}
+	}
+
+	void flush ()
+	{
+		std::lock_guard<std::mutex> lm (SerializedRCUManager<T>::_lock);
+		if (!_retired.empty ()) {
+			RCUEpoch::synchronize (_retired.back ().epoch);
+		}
+		for (typename std::list<Retired>::iterator i = _retired.begin (); i != _retired.end (); ++i) {
+			delete i->value;
+		}
+		_retired.clear ();
+	}
+
+protected:
+	void retire (typename RCUManager<T>::PtrToSharedPtr old)
+	{
+		/* a ReadPtr may still be using *old, keep it as is */
+		_retired.push_back (Retired (old, RCUEpoch::advance ()));
+	}
+
+	void collect ()
+	{
+		for (typename std::list<Retired>::iterator i = _retired.begin (); i != _retired.end ();) {
+			if (!RCUEpoch::quiescent (i->epoch)) {
+				/* later entries were retired in a later epoch */
+				break;
+			}
+			if (i->value->unique ()) {
+				delete i->value;
+				i = _retired.erase (i);
+			} else {
+				++i;
+			}
+		}
+	}
+
+private:
+	struct Retired {
+		Retired (typename RCUManager<T>::PtrToSharedPtr v, uint64_t e) : value (v), epoch (e) {}
+		typename RCUManager<T>::PtrToSharedPtr value;
+		uint64_t                               epoch;
+	};
+
+	std::list<Retired> _retired;
+};
+
 /** RCUWriter is a convenience object that implements write_copy/update via
  * lifetime management. Creating the object obtains a writable copy, which can
  * be obtained via the get_copy() method; deleting the object will update
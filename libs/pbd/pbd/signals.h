@@ -24,8 +24,10 @@
 
 #include <csignal>
 
+#include <cstdint>
 #include <list>
 #include <map>
+#include <memory>
 
 #ifdef nil
 #undef nil
@@ -63,6 +65,8 @@ class LIBPBD_API SignalBase
 public:
 	SignalBase ()
 	: _in_dtor (false)
+	, _disconnects (0)
+	, _coalesce_cross_thread (false)
 #ifdef DEBUG_PBD_SIGNAL_CONNECTIONS
 	, _debug_connection (false)
 #endif
@@ -73,9 +77,22 @@ public:
 	void set_debug_connection (bool yn) { _debug_connection = yn; }
 #endif
 
+	/** Allow emissions to a cross-thread connection to be merged into a
+	 * request of that connection which is still queued, see CrossThreadCall.
+	 * Only suitable for signals whose slots do not depend on being called
+	 * once per emission. Off by default, applies to connections made after
+	 * the call.
+	 */
+	void set_cross_thread_coalescing (bool yn) { _coalesce_cross_thread.store (yn); }
+
 protected:
 	mutable Glib::Threads::Mutex _mutex;
 	std::atomic<bool>            _in_dtor;
+	/* incremented on every disconnection, lets emission skip the check
+	 * whether a slot is still connected while nothing was disconnected
+	 */
+	std::atomic<unsigned int>    _disconnects;
+	std::atomic<bool>            _coalesce_cross_thread;
 #ifdef DEBUG_PBD_SIGNAL_CONNECTIONS
 	bool _debug_connection;
 #endif
@@ -223,6 +240,97 @@ class LIBPBD_API ScopedConnectionList  : public boost::noncopyable
 	ConnectionList _scoped_connection_list;
 };
 
+/** Counters for cross-thread signal delivery */
+class LIBPBD_API SignalStats
+{
+public:
+	/** requests queued to an event loop */
+	static std::atomic<uint64_t> queued;
+	/** emissions merged into a request that was still pending */
+	static std::atomic<uint64_t> coalesced;
+
+	static void reset ();
+};
+
+class LIBPBD_TEMPLATE_API PropertyChange;
+
+/** Delivery of the emissions of one cross-thread connection to its event
+ * loop. This generic version queues one request per emission.
+ *
+ * For signals that opted in with SignalBase::set_cross_thread_coalescing()
+ * the specializations merge an emission into a request of the same
+ * connection that is still queued: signals without arguments call the slot
+ * once, PropertyChanged-style signals are delivered once with the union of
+ * the changes. create() returns a null pointer for connections that do not
+ * coalesce, which post() then queues one request per emission for.
+ */
+template <typename... A>
+class CrossThreadCall
+{
+public:
+	static std::shared_ptr<CrossThreadCall> create (bool) { return std::shared_ptr<CrossThreadCall> (); }
+
+	static void post (std::shared_ptr<CrossThreadCall> const&, boost::function<void(A...)> const& f,
+	                  EventLoop* event_loop, EventLoop::InvalidationRecord* ir, A... a)
+	{
+		SignalStats::queued.fetch_add (1, std::memory_order_relaxed);
+		event_loop->call_slot (ir, boost::bind (f, a...));
+	}
+};
+
+template <>
+class LIBPBD_API CrossThreadCall<>
+{
+public:
+	CrossThreadCall () : _pending (false) {}
+
+	static std::shared_ptr<CrossThreadCall> create (bool coalesce);
+	static void post (std::shared_ptr<CrossThreadCall> const&, boost::function<void()> const&,
+	                  EventLoop*, EventLoop::InvalidationRecord*);
+
+private:
+	/* The queued request. If it is destroyed without being delivered,
+	 * because it was invalidated or could not be queued, later emissions
+	 * must queue a new one.
+	 */
+	struct Request {
+		Request (std::shared_ptr<CrossThreadCall> const& c) : call (c), delivered (false) {}
+		~Request ();
+		std::shared_ptr<CrossThreadCall> call;
+		bool delivered;
+	};
+
+	static void deliver (std::shared_ptr<Request>, boost::function<void()>);
+
+	std::atomic<bool> _pending;
+};
+
+template <>
+class LIBPBD_API CrossThreadCall<PropertyChange const&>
+{
+public:
+	CrossThreadCall ();
+	~CrossThreadCall ();
+
+	static std::shared_ptr<CrossThreadCall> create (bool coalesce);
+	static void post (std::shared_ptr<CrossThreadCall> const&, boost::function<void(PropertyChange const&)> const&,
+	                  EventLoop*, EventLoop::InvalidationRecord*, PropertyChange const&);
+
+private:
+	/* see CrossThreadCall<>::Request */
+	struct Request {
+		Request (std::shared_ptr<CrossThreadCall> const& c) : call (c), delivered (false) {}
+		~Request ();
+		std::shared_ptr<CrossThreadCall> call;
+		bool delivered;
+	};
+
+	static void deliver (std::shared_ptr<Request>, boost::function<void(PropertyChange const&)>);
+
+	Glib::Threads::Mutex _lock;
+	PropertyChange*      _pending; /* changes not yet delivered, 0 if no request is queued */
+};
+
 #include "pbd/signals_generated.h"
 
 } /* namespace */
@@ -101,9 +101,13 @@ def signal(f, n, v):
     print("private:", file=f)
 
     print("""
-\t/** The slots that this signal will call on emission */
+\t/** The slots that this signal will call on emission. Emission holds a
+\t  * reference to the map rather than copying it; while it does, connect
+\t  * and disconnect replace the map instead of modifying it.
+\t  * Null until the first connection is made.
+\t  */
 \ttypedef std::map<std::shared_ptr<Connection>, slot_function_type> Slots;
-\tSlots _slots;
+\tstd::shared_ptr<Slots> _slots;
 """, file=f)
 
     print("public:", file=f)
@@ -113,7 +117,10 @@ def signal(f, n, v):
     print("\t\t_in_dtor.store (true, std::memory_order_release);", file=f)
     print("\t\tGlib::Threads::Mutex::Lock lm (_mutex);", file=f)
     print("\t\t/* Tell our connection objects that we are going away, so they don't try to call us */", file=f)
-    print("\t\tfor (%sSlots::const_iterator i = _slots.begin(); i != _slots.end(); ++i) {" % typename, file=f)
+    print("\t\tif (!_slots) {", file=f)
+    print("\t\t\treturn;", file=f)
+    print("\t\t}", file=f)
+    print("\t\tfor (%sSlots::const_iterator i = _slots->begin(); i != _slots->end(); ++i) {" % typename, file=f)
 
     print("\t\t\ti->first->signal_going_away ();", file=f)
     print("\t\t}", file=f)
@@ -127,8 +134,10 @@ def signal(f, n, v):
         p = ", %s" % comma_separated(Anan)
         q = ", %s" % comma_separated(an)
 
-    print("\tstatic void compositor (%sboost::function<void(%s)> f, EventLoop* event_loop, EventLoop::InvalidationRecord* ir%s) {" % (typename, comma_separated(An), p), file=f)
-    print("\t\tevent_loop->call_slot (ir, boost::bind (f%s));" % q, file=f)
+    print("\ttypedef CrossThreadCall<%s> CrossThreadCallType;" % comma_separated(An), file=f)
+    print("", file=f)
+    print("\tstatic void compositor (%sboost::function<void(%s)> f, EventLoop* event_loop, EventLoop::InvalidationRecord* ir, std::shared_ptr<CrossThreadCallType> ctc%s) {" % (typename, comma_separated(An), p), file=f)
+    print("\t\tCrossThreadCallType::post (ctc, f, event_loop, ir%s);" % q, file=f)
     print("\t}", file=f)
 
     print("""
@@ -197,7 +206,7 @@ def signal(f, n, v):
     else:
         p = ", %s" % comma_separated(u)
 
-    print("\t\tclist.add_connection (_connect (ir, boost::bind (&compositor, slot, event_loop, ir%s)));" % p, file=f)
+    print("\t\tclist.add_connection (_connect (ir, boost::bind (&compositor, slot, event_loop, ir, CrossThreadCallType::create (_coalesce_cross_thread.load ())%s)));" % p, file=f)
 
     print("""
 \t}
@@ -216,7 +225,7 @@ def signal(f, n, v):
 \t\t\tir->event_loop = event_loop;
 \t\t}
 """, file=f)
-    print("\t\tc = _connect (ir, boost::bind (&compositor, slot, event_loop, ir%s));" % p, file=f)
+    print("\t\tc = _connect (ir, boost::bind (&compositor, slot, event_loop, ir, CrossThreadCallType::create (_coalesce_cross_thread.load ())%s));" % p, file=f)
     print("\t}", file=f)
 
     print("""
@@ -231,27 +240,38 @@ def signal(f, n, v):
     else:
         print("\ttypename C::result_type operator() (%s)" % comma_separated(Anan), file=f)
     print("\t{", file=f)
-    print("\t\t/* First, take a copy of our list of slots as it is now */", file=f)
+    print("\t\t/* First, take a reference to our list of slots as it is now */", file=f)
     print("", file=f)
-    print("\t\tSlots s;", file=f)
+    print("\t\tstd::shared_ptr<Slots> s;", file=f)
+    print("\t\tunsigned int disconnects;", file=f)
     print("\t\t{", file=f)
     print("\t\t\tGlib::Threads::Mutex::Lock lm (_mutex);", file=f)
     print("\t\t\ts = _slots;", file=f)
+    print("\t\t\tdisconnects = _disconnects.load (std::memory_order_relaxed);", file=f)
     print("\t\t}", file=f)
     print("", file=f)
     if not v:
         print("\t\tstd::list<R> r;", file=f)
-    print("\t\tfor (%sSlots::const_iterator i = s.begin(); i != s.end(); ++i) {" % typename, file=f)
+        print("\t\tif (!s) {", file=f)
+        print("\t\t\tC c;", file=f)
+        print("\t\t\treturn c (r.begin(), r.end());", file=f)
+        print("\t\t}", file=f)
+    else:
+        print("\t\tif (!s) {", file=f)
+        print("\t\t\treturn;", file=f)
+        print("\t\t}", file=f)
+    print("\t\tfor (%sSlots::const_iterator i = s->begin(); i != s->end(); ++i) {" % typename, file=f)
     print("""
 \t\t\t/* We may have just called a slot, and this may have resulted in
-\t\t\t * disconnection of other slots from us.  The list copy means that
-\t\t\t * this won't cause any problems with invalidated iterators, but we
-\t\t\t * must check to see if the slot we are about to call is still on the list.
+\t\t\t * disconnection of other slots from us.  Holding a reference to the
+\t\t\t * map means that this won't cause any problems with invalidated
+\t\t\t * iterators, but we must check to see if the slot we are about to
+\t\t\t * call is still on the list, unless nothing was disconnected since.
 \t\t\t */
-\t\t\tbool still_there = false;
-\t\t\t{
+\t\t\tbool still_there = true;
+\t\t\tif (_disconnects.load (std::memory_order_acquire) != disconnects) {
 \t\t\t\tGlib::Threads::Mutex::Lock lm (_mutex);
-\t\t\t\tstill_there = _slots.find (i->first) != _slots.end ();
+\t\t\t\tstill_there = _slots && _slots->find (i->first) != _slots->end ();
 \t\t\t}
 
 \t\t\tif (still_there) {""", file=f)
@@ -271,13 +291,13 @@ def signal(f, n, v):
     print("""
 \tbool empty () const {
 \t\tGlib::Threads::Mutex::Lock lm (_mutex);
-\t\treturn _slots.empty ();
+\t\treturn !_slots || _slots->empty ();
 \t}
 """, file=f)
     print("""
 \tsize_t size () const {
 \t\tGlib::Threads::Mutex::Lock lm (_mutex);
-\t\treturn _slots.size ();
+\t\treturn _slots ? _slots->size () : 0;
 \t}
 """, file=f)
 
@@ -295,10 +315,16 @@ def signal(f, n, v):
 \t{
 \t\tstd::shared_ptr<Connection> c (new Connection (this, ir));
 \t\tGlib::Threads::Mutex::Lock lm (_mutex);
-\t\t_slots[c] = f;
+\t\tif (!_slots) {
+\t\t\t_slots.reset (new Slots);
+\t\t} else if (_slots.use_count () > 1) {
+\t\t\t/* an emission is using the current map */
+\t\t\t_slots.reset (new Slots (*_slots));
+\t\t}
+\t\t(*_slots)[c] = f;
 #ifdef DEBUG_PBD_SIGNAL_CONNECTIONS
 \t\tif (_debug_connection) {
-\t\t\tstd::cerr << "+++++++ CONNECT " << this << " size now " << _slots.size() << std::endl;
+\t\t\tstd::cerr << "+++++++ CONNECT " << this << " size now " << _slots->size() << std::endl;
 \t\t\tPBD::stacktrace (std::cerr, 10);
 \t\t}
 #endif
@@ -318,13 +344,20 @@ def signal(f, n, v):
 \t\t\t/* Spin */
 \t\t\tlm.try_acquire ();
 \t\t}
-\t\t_slots.erase (c);
+\t\tif (_slots) {
+\t\t\tif (_slots.use_count () > 1) {
+\t\t\t\t/* an emission is using the current map */
+\t\t\t\t_slots.reset (new Slots (*_slots));
+\t\t\t}
+\t\t\t_slots->erase (c);
+\t\t}
+\t\t_disconnects.fetch_add (1, std::memory_order_release);
 \t\tlm.release ();
 
 \t\tc->disconnected ();
 #ifdef DEBUG_PBD_SIGNAL_CONNECTIONS
 \t\tif (_debug_connection) {
-\t\t\tstd::cerr << "------- DISCCONNECT " << this << " size now " << _slots.size() << std::endl;
+\t\t\tstd::cerr << "------- DISCCONNECT " << this << " size now " << size () << std::endl;
 \t\t\tPBD::stacktrace (std::cerr, 10);
 \t\t}
 #endif
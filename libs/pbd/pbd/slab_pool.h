@@ -0,0 +1,161 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef _pbd_slab_pool_h_
+#define _pbd_slab_pool_h_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifndef LIBPBD_API
+#include "pbd/libpbd_visibility.h"
+#endif
+
+#include "pbd/spinlock.h"
+#include "pbd/tlsf.h"
+
+namespace PBD {
+
+/** A realtime-safe allocator for many small objects (e.g. a Lua state).
+ *
+ * Memory is allocated and locked once, at construction. Requests of up to
+ * max_slab_size bytes are served from size classes: the pool is divided
+ * into fixed-size spans, each span holds blocks of one class only, and
+ * freed blocks are reused by the same class. Blocks carry no header, the
+ * class of a block is looked up from its span.
+ *
+ * Each class has a central free list, and there are a few per-thread
+ * magazines, small caches of free blocks that a thread can use without
+ * touching the central lists. A thread that cannot get its magazine (it
+ * is shared with a concurrently running thread) uses the central lists.
+ *
+ * Larger requests are passed on to a TLSF pool of the given size, spans
+ * use another half of it. Spans are never returned once assigned to a class, stats()
+ * reports how much of the assigned memory is actually in use.
+ */
+class LIBPBD_API SlabPool
+{
+public:
+	SlabPool (std::string name, size_t bytes);
+	~SlabPool ();
+
+	void set_name (const std::string& n) { _name = n; }
+
+	static void* lalloc (void* pool, void* ptr, size_t /* oldsize */, size_t newsize) {
+		return static_cast<SlabPool*>(pool)->_realloc (ptr, newsize);
+	}
+
+	void* malloc (size_t size) { return _realloc (NULL, size); }
+	void* realloc (void* ptr, size_t newsize) { return _realloc (ptr, newsize); }
+	void  free (void* ptr) { _free (ptr); }
+
+	struct Stats {
+		size_t pool_size;   ///< total size of the pool [bytes]
+		size_t reserved;    ///< spans assigned to a size class, plus large blocks [bytes]
+		size_t used;        ///< currently allocated [bytes, rounded to the size class]
+		size_t peak_used;   ///< maximum of used
+		size_t n_alloc;
+		size_t n_free;
+		size_t n_failed;    ///< requests that could not be served
+
+		/** share of reserved memory not in use */
+		float fragmentation () const {
+			return reserved > 0 ? 1.f - used / (float) reserved : 0.f;
+		}
+	};
+
+	Stats stats () const;
+	void  printstats () const;
+
+	size_t get_used_size () const { return _used.load (std::memory_order_relaxed); }
+	size_t get_max_size () const { return _peak_used.load (std::memory_order_relaxed); }
+
+	static const size_t max_slab_size = 1024;
+
+private:
+	enum {
+		n_classes    = 20,
+		n_magazines  = 4,
+		magazine_len = 16,
+		span_shift   = 14, /* 16 KiB spans */
+	};
+
+	static const size_t span_size = (size_t) 1 << span_shift;
+	static const uint8_t no_class = 0xff;
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	struct Magazine {
+		Magazine () : count (0) {}
+		unsigned count;
+		void*    blocks[magazine_len];
+	};
+
+	struct MagazineSet {
+		spinlock_t lock;
+		Magazine   mag[n_classes];
+	};
+
+	struct Central {
+		Central () : free_list (0), carve (0), carve_end (0) {}
+		FreeBlock* free_list;
+		char*      carve;     /* next never used block in the current span */
+		char*      carve_end;
+	};
+
+	std::string _name;
+	char*       _mem;
+	char*       _base;    /* first span, span_size aligned */
+	size_t      _n_spans;
+	size_t      _next_span;
+	uint8_t*    _span_class;
+	TLSF*       _large;
+	size_t      _large_size;
+
+	spinlock_t  _lock;    /* protects _central and _next_span */
+	Central     _central[n_classes];
+	MagazineSet _magazines[n_magazines];
+
+	std::atomic<size_t> _reserved;
+	std::atomic<size_t> _used;
+	std::atomic<size_t> _peak_used;
+	std::atomic<size_t> _n_alloc;
+	std::atomic<size_t> _n_free;
+	std::atomic<size_t> _n_failed;
+
+	static size_t const _class_size[n_classes];
+	static int size_class (size_t);
+
+	int   block_class (void const*) const;
+	void* _realloc (void*, size_t);
+	void* _malloc (size_t);
+	void  _free (void*);
+
+	void* alloc_block (int cls);
+	void  free_block (void*, int cls);
+	void* central_alloc (int cls);
+	void  central_free (void*, int cls);
+
+	void* alloc_large (size_t);
+	void  free_large (void*);
+
+	void add_used (size_t);
+};
+
+} /* namespace */
+#endif // _pbd_slab_pool_h_
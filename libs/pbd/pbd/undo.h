@@ -23,10 +23,14 @@
 #ifndef __lib_pbd_undo_h__
 #define __lib_pbd_undo_h__
 
+#include <cstdio>
+#include <deque>
 #include <list>
 #include <map>
 #include <string>
 
+#include <boost/function.hpp>
+
 #include <sigc++/bind.h>
 #include <sigc++/slot.h>
 
@@ -90,7 +94,9 @@ class LIBPBD_API UndoHistory : public PBD::ScopedConnectionList
 {
 public:
 	UndoHistory ();
-	~UndoHistory () {}
+	~UndoHistory ();
+
+	typedef boost::function<UndoTransaction* (XMLNode const&)> TransactionFactory;
 
 	void add (UndoTransaction* ut);
 	void undo (unsigned int n);
@@ -98,7 +104,7 @@ public:
 
 	unsigned long undo_depth () const
 	{
-		return UndoList.size ();
+		return UndoList.size () + _spilled.size ();
 	}
 	unsigned long redo_depth () const
 	{
@@ -107,7 +113,10 @@ public:
 
 	std::string next_undo () const
 	{
-		return (UndoList.empty () ? std::string () : UndoList.back ()->name ());
+		if (UndoList.empty ()) {
+			return (_spilled.empty () ? std::string () : _spilled.back ().name);
+		}
+		return UndoList.back ()->name ();
 	}
 	std::string next_redo () const
 	{
@@ -129,8 +138,25 @@ public:
 	XMLNode& get_state (int32_t depth = 0);
 	void     save_state ();
 
+	/* write the same as get_state() to @p path, copying spilled
+	 * transactions verbatim from the log instead of re-creating them.
+	 */
+	bool write_state (std::string const& path, int32_t depth);
+
 	void set_depth (uint32_t);
 
+	/* keep at most @p ram_depth undo transactions in memory. Older
+	 * ones are serialized to an append-only log at @p path and are
+	 * re-created by @p factory when they are undone again.
+	 * A @p ram_depth of 0 keeps the complete history in memory.
+	 */
+	void set_spill (std::string const& path, uint32_t ram_depth, TransactionFactory factory);
+
+	unsigned long spilled_depth () const
+	{
+		return _spilled.size ();
+	}
+
 	PBD::Signal0<void> Changed;
 	PBD::Signal0<void> BeginUndoRedo;
 	PBD::Signal0<void> EndUndoRedo;
@@ -141,7 +167,26 @@ private:
 	std::list<UndoTransaction*> UndoList;
 	std::list<UndoTransaction*> RedoList;
 
+	struct SpilledTransaction {
+		std::string name;
+		int64_t     offset;
+		size_t      length;
+	};
+
+	std::deque<SpilledTransaction> _spilled; /* older than UndoList.front () */
+	std::string                    _spill_path;
+	FILE*                          _spill_file;
+	int64_t                        _spill_end;
+	uint32_t                       _ram_depth;
+	TransactionFactory             _factory;
+
 	void remove (UndoTransaction*);
+	void trim (uint32_t);
+	void maybe_spill ();
+	bool page_in ();
+	UndoTransaction* create (XMLNode const&) const;
+	bool read_spilled (SpilledTransaction const&, std::string&) const;
+	void close_spill ();
 };
 
 } /* namespace */
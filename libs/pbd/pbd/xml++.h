@@ -104,11 +104,12 @@ public:
 
 private:
 	bool read_internal(bool validate);
+	xmlDocPtr read_document(bool validate) const;
 
-	std::string _filename;
-	XMLNode*    _root;
-	xmlDocPtr   _doc;
-	int         _compression;
+	std::string       _filename;
+	XMLNode*          _root;
+	mutable xmlDocPtr _doc; ///< only created on demand (for ::find) when reading files
+	int               _compression;
 };
 
 class LIBPBD_API XMLNode {
@@ -197,6 +198,15 @@ public:
 	void dump (std::ostream &, std::string p = "") const;
 
 private:
+	friend class XMLTree;
+
+	/* used when reading documents: reserve space for exactly as many
+	 * properties as the element has, and add them without checking
+	 * for duplicates (which XML does not allow)
+	 */
+	XMLNode(const char* name, int n_properties);
+	void append_property(const char* name, const char* value);
+
 	std::string         _name;
 	bool                _is_content;
 	std::string         _content;
@@ -0,0 +1,125 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "pbd/rcu.h"
+
+/* Readers publish their epoch in one of a fixed set of slots, each on its own
+ * cache line. A thread claims a slot when it first enters a read section and
+ * returns it when it exits. Should all slots be taken, the thread is counted
+ * in _overflow instead, which holds back all reclamation while it reads.
+ */
+
+namespace {
+
+static const size_t max_readers = 128;
+
+struct alignas(64) ReaderSlot {
+	ReaderSlot () : epoch (0), used (false) {}
+
+	std::atomic<uint64_t> epoch; /* 0: not reading */
+	std::atomic<bool>     used;
+};
+
+static ReaderSlot            _slots[max_readers];
+static std::atomic<uint64_t> _epoch (1);
+static std::atomic<int>      _overflow (0);
+
+struct ThreadReader {
+	ThreadReader () : slot (0), depth (0)
+	{
+		for (size_t i = 0; i < max_readers; ++i) {
+			bool expected = false;
+			if (_slots[i].used.compare_exchange_strong (expected, true)) {
+				slot = &_slots[i];
+				break;
+			}
+		}
+	}
+
+	~ThreadReader ()
+	{
+		if (slot) {
+			slot->epoch.store (0);
+			slot->used.store (false);
+		}
+	}
+
+	ReaderSlot* slot;
+	unsigned    depth;
+};
+
+static thread_local ThreadReader _reader;
+
+} /* anon namespace */
+
+void
+RCUEpoch::enter ()
+{
+	if (_reader.depth++ > 0) {
+		return;
+	}
+	if (_reader.slot) {
+		/* sequentially consistent, so that the store is visible before
+		 * the managed object is loaded.
+		 */
+		_reader.slot->epoch.store (_epoch.load ());
+	} else {
+		_overflow.fetch_add (1);
+	}
+}
+
+void
+RCUEpoch::leave ()
+{
+	if (--_reader.depth > 0) {
+		return;
+	}
+	if (_reader.slot) {
+		_reader.slot->epoch.store (0, std::memory_order_release);
+	} else {
+		_overflow.fetch_sub (1);
+	}
+}
+
+uint64_t
+RCUEpoch::advance ()
+{
+	return _epoch.fetch_add (1) + 1;
+}
+
+bool
+RCUEpoch::quiescent (uint64_t epoch)
+{
+	if (_overflow.load () > 0) {
+		return false;
+	}
+	for (size_t i = 0; i < max_readers; ++i) {
+		uint64_t e = _slots[i].epoch.load ();
+		if (e != 0 && e < epoch) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void
+RCUEpoch::synchronize (uint64_t epoch)
+{
+	for (unsigned i = 0; !quiescent (epoch); ++i) {
+		/* spin being nice to the scheduler/CPU */
+		boost::detail::yield (i);
+	}
+}
@@ -19,9 +19,136 @@
 
 #include "pbd/signals.h"
 #include "pbd/demangle.h"
+#include "pbd/property_basics.h"
 
 using namespace PBD;
 
+std::atomic<uint64_t> SignalStats::queued (0);
+std::atomic<uint64_t> SignalStats::coalesced (0);
+
+void
+SignalStats::reset ()
+{
+	queued.store (0);
+	coalesced.store (0);
+}
+
+std::shared_ptr<CrossThreadCall<> >
+CrossThreadCall<>::create (bool coalesce)
+{
+	if (!coalesce) {
+		return std::shared_ptr<CrossThreadCall> ();
+	}
+	return std::shared_ptr<CrossThreadCall> (new CrossThreadCall);
+}
+
+void
+CrossThreadCall<>::post (std::shared_ptr<CrossThreadCall> const& self, boost::function<void()> const& f, EventLoop* event_loop, EventLoop::InvalidationRecord* ir)
+{
+	if (!self) {
+		SignalStats::queued.fetch_add (1, std::memory_order_relaxed);
+		event_loop->call_slot (ir, f);
+		return;
+	}
+
+	if (self->_pending.exchange (true)) {
+		/* the slot has not been called for the previous emission yet */
+		SignalStats::coalesced.fetch_add (1, std::memory_order_relaxed);
+		return;
+	}
+
+	SignalStats::queued.fetch_add (1, std::memory_order_relaxed);
+
+	/* if the request is lost or dropped, ~Request resets _pending */
+	event_loop->call_slot (ir, boost::bind (&CrossThreadCall::deliver, std::shared_ptr<Request> (new Request (self)), f));
+}
+
+void
+CrossThreadCall<>::deliver (std::shared_ptr<Request> req, boost::function<void()> f)
+{
+	/* emissions from now on need a new request */
+	req->delivered = true;
+	req->call->_pending.store (false);
+	f ();
+}
+
+CrossThreadCall<>::Request::~Request ()
+{
+	if (!delivered) {
+		call->_pending.store (false);
+	}
+}
+
+CrossThreadCall<PropertyChange const&>::CrossThreadCall ()
+	: _pending (0)
+{
+}
+
+CrossThreadCall<PropertyChange const&>::~CrossThreadCall ()
+{
+	delete _pending;
+}
+
+std::shared_ptr<CrossThreadCall<PropertyChange const&> >
+CrossThreadCall<PropertyChange const&>::create (bool coalesce)
+{
+	if (!coalesce) {
+		return std::shared_ptr<CrossThreadCall> ();
+	}
+	return std::shared_ptr<CrossThreadCall> (new CrossThreadCall);
+}
+
+void
+CrossThreadCall<PropertyChange const&>::post (std::shared_ptr<CrossThreadCall> const& self, boost::function<void(PropertyChange const&)> const& f,
+                                              EventLoop* event_loop, EventLoop::InvalidationRecord* ir, PropertyChange const& what)
+{
+	if (!self) {
+		SignalStats::queued.fetch_add (1, std::memory_order_relaxed);
+		event_loop->call_slot (ir, boost::bind (f, what));
+		return;
+	}
+
+	{
+		Glib::Threads::Mutex::Lock lm (self->_lock);
+		if (self->_pending) {
+			self->_pending->add (what);
+			SignalStats::coalesced.fetch_add (1, std::memory_order_relaxed);
+			return;
+		}
+		self->_pending = new PropertyChange (what);
+	}
+
+	SignalStats::queued.fetch_add (1, std::memory_order_relaxed);
+
+	/* if the request is lost or dropped, ~Request discards the changes */
+	event_loop->call_slot (ir, boost::bind (&CrossThreadCall::deliver, std::shared_ptr<Request> (new Request (self)), f));
+}
+
+void
+CrossThreadCall<PropertyChange const&>::deliver (std::shared_ptr<Request> req, boost::function<void(PropertyChange const&)> f)
+{
+	std::unique_ptr<PropertyChange> what;
+	{
+		Glib::Threads::Mutex::Lock lm (req->call->_lock);
+		req->delivered = true;
+		what.reset (req->call->_pending);
+		req->call->_pending = 0;
+	}
+
+	if (what) {
+		f (*what);
+	}
+}
+
+CrossThreadCall<PropertyChange const&>::Request::~Request ()
+{
+	if (!delivered) {
+		Glib::Threads::Mutex::Lock lm (call->_lock);
+		delete call->_pending;
+		call->_pending = 0;
+	}
+}
+
 ScopedConnectionList::ScopedConnectionList()
 {
 }
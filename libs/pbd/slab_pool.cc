@@ -0,0 +1,367 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef PLATFORM_WINDOWS
+#include <sys/mman.h>
+#endif
+
+#include "pbd/slab_pool.h"
+
+//#define SLAB_POOL_STATS // print stats() when the pool is destroyed
+
+using namespace PBD;
+
+/* 16 byte steps up to 128, then four steps per power of two */
+size_t const SlabPool::_class_size[SlabPool::n_classes] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256,
+	320, 384, 448, 512,
+	640, 768, 896, 1024
+};
+
+/* large blocks are prefixed with their size */
+static const size_t large_header = 16;
+
+static std::atomic<unsigned> _thread_count (0);
+static thread_local unsigned _thread_id = _thread_count.fetch_add (1);
+
+SlabPool::SlabPool (std::string name, size_t bytes)
+	: _name (name)
+	, _next_span (0)
+	, _reserved (0)
+	, _used (0)
+	, _peak_used (0)
+	, _n_alloc (0)
+	, _n_free (0)
+	, _n_failed (0)
+{
+	/* large requests get the full budget, as they would with a plain TLSF
+	 * pool of the same size; spans for small objects come on top of that.
+	 */
+	size_t large_bytes = std::max<size_t> (bytes, 65536);
+	size_t slab_bytes  = bytes / 2;
+
+	_n_spans = std::max<size_t> (slab_bytes >> span_shift, n_classes);
+
+	_mem = (char*) ::malloc ((_n_spans + 1) * span_size);
+	assert (_mem);
+
+	memset (_mem, 0, (_n_spans + 1) * span_size); // make resident
+#ifndef PLATFORM_WINDOWS
+	mlock (_mem, (_n_spans + 1) * span_size);
+#endif
+
+	_base = (char*) (((uintptr_t) _mem + span_size - 1) & ~(uintptr_t) (span_size - 1));
+
+	_span_class = new uint8_t[_n_spans];
+	memset (_span_class, no_class, _n_spans);
+
+	_large      = new TLSF (name + " (large)", large_bytes);
+	_large_size = large_bytes;
+}
+
+SlabPool::~SlabPool ()
+{
+#ifdef SLAB_POOL_STATS
+	printstats ();
+#endif
+	delete _large;
+	delete [] _span_class;
+	::free (_mem);
+}
+
+int
+SlabPool::size_class (size_t s)
+{
+	assert (s > 0 && s <= max_slab_size);
+	if (s <= 128) {
+		return (s - 1) >> 4;
+	}
+	/* s - 1 is in [2^e, 2^(e+1)) */
+	size_t   v = s - 1;
+	unsigned e = 7;
+	while (((size_t) 2 << e) <= v) {
+		++e;
+	}
+	return 8 + (e - 7) * 4 + ((v - ((size_t) 1 << e)) >> (e - 2));
+}
+
+int
+SlabPool::block_class (void const* ptr) const
+{
+	char const* p = (char const*) ptr;
+	if (p < _base || p >= _base + _n_spans * span_size) {
+		return -1;
+	}
+	return _span_class[(p - _base) >> span_shift];
+}
+
+void
+SlabPool::add_used (size_t s)
+{
+	size_t u    = _used.fetch_add (s, std::memory_order_relaxed) + s;
+	size_t peak = _peak_used.load (std::memory_order_relaxed);
+	while (u > peak && !_peak_used.compare_exchange_weak (peak, u, std::memory_order_relaxed)) ;
+}
+
+/* ****************************************************************************/
+
+void*
+SlabPool::central_alloc (int cls)
+{
+	/* call with _lock held */
+	Central& c (_central[cls]);
+
+	if (c.free_list) {
+		FreeBlock* b = c.free_list;
+		c.free_list  = b->next;
+		return b;
+	}
+
+	size_t const sz = _class_size[cls];
+
+	if (c.carve + sz > c.carve_end) {
+		if (_next_span == _n_spans) {
+			return 0;
+		}
+		_span_class[_next_span] = cls;
+		c.carve     = _base + (_next_span << span_shift);
+		c.carve_end = c.carve + span_size;
+		++_next_span;
+		_reserved.fetch_add (span_size, std::memory_order_relaxed);
+	}
+
+	void* rv = c.carve;
+	c.carve += sz;
+	return rv;
+}
+
+void
+SlabPool::central_free (void* ptr, int cls)
+{
+	/* call with _lock held */
+	FreeBlock* b = (FreeBlock*) ptr;
+	b->next = _central[cls].free_list;
+	_central[cls].free_list = b;
+}
+
+void*
+SlabPool::alloc_block (int cls)
+{
+	void* rv = 0;
+	MagazineSet& ms (_magazines[_thread_id % n_magazines]);
+
+	if (ms.lock.try_lock ()) {
+		Magazine& m (ms.mag[cls]);
+		if (m.count == 0) {
+			/* refill half of the magazine */
+			_lock.lock ();
+			while (m.count < magazine_len / 2) {
+				void* b = central_alloc (cls);
+				if (!b) {
+					break;
+				}
+				m.blocks[m.count++] = b;
+			}
+			_lock.unlock ();
+		}
+		if (m.count > 0) {
+			rv = m.blocks[--m.count];
+		}
+		ms.lock.unlock ();
+	} else {
+		_lock.lock ();
+		rv = central_alloc (cls);
+		_lock.unlock ();
+	}
+
+	return rv;
+}
+
+void
+SlabPool::free_block (void* ptr, int cls)
+{
+	MagazineSet& ms (_magazines[_thread_id % n_magazines]);
+
+	if (ms.lock.try_lock ()) {
+		Magazine& m (ms.mag[cls]);
+		if (m.count == magazine_len) {
+			/* return half of the magazine */
+			_lock.lock ();
+			while (m.count > magazine_len / 2) {
+				central_free (m.blocks[--m.count], cls);
+			}
+			_lock.unlock ();
+		}
+		m.blocks[m.count++] = ptr;
+		ms.lock.unlock ();
+	} else {
+		_lock.lock ();
+		central_free (ptr, cls);
+		_lock.unlock ();
+	}
+}
+
+/* ****************************************************************************/
+
+void*
+SlabPool::alloc_large (size_t s)
+{
+	char* p = (char*) _large->malloc (s + large_header);
+	if (!p) {
+		return 0;
+	}
+	*((size_t*) p) = s;
+	_reserved.fetch_add (s + large_header, std::memory_order_relaxed);
+	add_used (s);
+	return p + large_header;
+}
+
+void
+SlabPool::free_large (void* ptr)
+{
+	char*  p = (char*) ptr - large_header;
+	size_t s = *((size_t*) p);
+	_reserved.fetch_sub (s + large_header, std::memory_order_relaxed);
+	_used.fetch_sub (s, std::memory_order_relaxed);
+	_large->free (p);
+}
+
+void*
+SlabPool::_malloc (size_t s)
+{
+	void* rv;
+
+	if (s > max_slab_size) {
+		rv = alloc_large (s);
+	} else {
+		int cls = size_class (s);
+		if ((rv = alloc_block (cls))) {
+			add_used (_class_size[cls]);
+		}
+	}
+
+	if (rv) {
+		_n_alloc.fetch_add (1, std::memory_order_relaxed);
+	} else {
+		_n_failed.fetch_add (1, std::memory_order_relaxed);
+	}
+	return rv;
+}
+
+void
+SlabPool::_free (void* ptr)
+{
+	if (!ptr) {
+		return;
+	}
+
+	_n_free.fetch_add (1, std::memory_order_relaxed);
+
+	int cls = block_class (ptr);
+	if (cls < 0) {
+		free_large (ptr);
+	} else {
+		assert (cls != no_class);
+		_used.fetch_sub (_class_size[cls], std::memory_order_relaxed);
+		free_block (ptr, cls);
+	}
+}
+
+void*
+SlabPool::_realloc (void* ptr, size_t newsize)
+{
+	if (!ptr) {
+		return newsize > 0 ? _malloc (newsize) : 0;
+	}
+
+	if (newsize == 0) {
+		_free (ptr);
+		return 0;
+	}
+
+	int    cls = block_class (ptr);
+	size_t cur;
+
+	if (cls < 0) {
+		cur = *((size_t*) ((char*) ptr - large_header));
+		if (newsize > max_slab_size) {
+			/* large to large */
+			char* p = (char*) _large->realloc ((char*) ptr - large_header, newsize + large_header);
+			if (!p) {
+				_n_failed.fetch_add (1, std::memory_order_relaxed);
+				return 0;
+			}
+			*((size_t*) p) = newsize;
+			_reserved.fetch_add (newsize - cur, std::memory_order_relaxed);
+			if (newsize > cur) {
+				add_used (newsize - cur);
+			} else {
+				_used.fetch_sub (cur - newsize, std::memory_order_relaxed);
+			}
+			return p + large_header;
+		}
+	} else {
+		cur = _class_size[cls];
+		if (newsize <= cur && (cls == 0 || newsize > _class_size[cls - 1])) {
+			/* same size class */
+			return ptr;
+		}
+	}
+
+	void* rv = _malloc (newsize);
+
+	if (!rv) {
+		/* Lua expects shrinking to always succeed */
+		return newsize <= cur ? ptr : 0;
+	}
+
+	memcpy (rv, ptr, std::min (cur, newsize));
+	_free (ptr);
+	return rv;
+}
+
+/* ****************************************************************************/
+
+SlabPool::Stats
+SlabPool::stats () const
+{
+	Stats s;
+	s.pool_size = _n_spans * span_size + _large_size;
+	s.reserved  = _reserved.load (std::memory_order_relaxed);
+	s.used      = _used.load (std::memory_order_relaxed);
+	s.peak_used = _peak_used.load (std::memory_order_relaxed);
+	s.n_alloc   = _n_alloc.load (std::memory_order_relaxed);
+	s.n_free    = _n_free.load (std::memory_order_relaxed);
+	s.n_failed  = _n_failed.load (std::memory_order_relaxed);
+	return s;
+}
+
+void
+SlabPool::printstats () const
+{
+	Stats s (stats ());
+	printf ("SlabPool '%s': used: %zu, peak: %zu, reserved: %zu of %zu spans [bytes] fragmentation: %.1f%%\n",
+			_name.c_str (), s.used, s.peak_used, s.reserved, _n_spans * span_size, 100.f * s.fragmentation ());
+	printf ("SlabPool '%s': alloc: %zu, free: %zu, failed: %zu\n",
+			_name.c_str (), s.n_alloc, s.n_free, s.n_failed);
+}
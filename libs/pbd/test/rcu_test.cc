@@ -7,6 +7,8 @@ using namespace std;
 RCUTest::RCUTest ()
 	: CppUnit::TestFixture ()
 	, _values (new Values)
+	, _epoch_values (new Values)
+	, _use_epoch (false)
 {
 }
 
@@ -65,6 +67,50 @@ RCUTest::race ()
 #endif
 }
 
+void
+RCUTest::epoch_race ()
+{
+	_use_epoch = true;
+	race ();
+	_use_epoch = false;
+}
+
+void
+RCUTest::epoch_reclaim ()
+{
+	EpochRCUManager<Values> values (new Values);
+	std::weak_ptr<Value> old_value;
+
+	{
+		RCUWriter<Values> writer (values);
+		std::shared_ptr<Value> v (new Value ("foo"));
+		writer.get_copy ()->insert (make_pair ("foo", v));
+		old_value = v;
+	}
+
+	{
+		EpochRCUManager<Values>::ReadPtr reader (values);
+		CPPUNIT_ASSERT (reader->find ("foo") != reader->end ());
+
+		{
+			RCUWriter<Values> writer (values);
+			writer.get_copy ()->clear ();
+		}
+
+		/* the reader still uses the old list */
+		values.reclaim ();
+		CPPUNIT_ASSERT (!old_value.expired ());
+		CPPUNIT_ASSERT (reader->find ("foo") != reader->end ());
+
+		/* nested read sections see the current list */
+		EpochRCUManager<Values>::ReadPtr nested (values);
+		CPPUNIT_ASSERT (nested->empty ());
+	}
+
+	values.reclaim ();
+	CPPUNIT_ASSERT (old_value.expired ());
+}
+
 /* ****************************************************************************/
 
 void
@@ -83,6 +129,16 @@ RCUTest::read_thread ()
 	pthread_barrier_wait (&_barrier);
 #endif
 
+	if (_use_epoch) {
+		for (int i = 0; i < 15000; ++i) {
+			EpochRCUManager<Values>::ReadPtr reader (_epoch_values);
+			for (Values::const_iterator i = reader->begin (); i != reader->end(); ++i) {
+				CPPUNIT_ASSERT (i->first == i->second->val);
+			}
+		}
+		return;
+	}
+
 	for (int i = 0; i < 15000; ++i) {
 		std::shared_ptr<Values const> reader  = _values.reader ();
 		for (Values::const_iterator i = reader->begin (); i != reader->end(); ++i) {
@@ -107,8 +163,10 @@ RCUTest::write_thread ()
 	pthread_barrier_wait (&_barrier);
 #endif
 
+	RCUManager<Values>& values (_use_epoch ? static_cast<RCUManager<Values>&> (_epoch_values) : static_cast<RCUManager<Values>&> (_values));
+
 	for (int i = 0; i < 10000; ++i) {
-		RCUWriter<Values> writer (_values);
+		RCUWriter<Values> writer (values);
 		std::shared_ptr<Values> w = writer.get_copy ();
 		char tmp [64];
 		sprintf (tmp, "foo %d", i);
@@ -117,7 +175,7 @@ RCUTest::write_thread ()
 
 	/* replace */
 	for (int i = 0; i < 2500; ++i) {
-		RCUWriter<Values> writer (_values);
+		RCUWriter<Values> writer (values);
 		std::shared_ptr<Values> w = writer.get_copy ();
 
 		char tmp [64];
@@ -133,9 +191,14 @@ RCUTest::write_thread ()
 
 	/* clear */
 	{
-		RCUWriter<Values> writer (_values);
+		RCUWriter<Values> writer (values);
 		std::shared_ptr<Values> w = writer.get_copy ();
 		w->clear ();
 	}
-	_values.flush ();
+
+	if (_use_epoch) {
+		_epoch_values.flush ();
+	} else {
+		_values.flush ();
+	}
 }
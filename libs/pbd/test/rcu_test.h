@@ -9,12 +9,16 @@ class RCUTest : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE (RCUTest);
 	CPPUNIT_TEST (race);
+	CPPUNIT_TEST (epoch_race);
+	CPPUNIT_TEST (epoch_reclaim);
 	CPPUNIT_TEST_SUITE_END ();
 
 public:
 	RCUTest ();
 	void setUp ();
 	void race ();
+	void epoch_race ();
+	void epoch_reclaim ();
 
 	void read_thread ();
 	void write_thread ();
@@ -31,6 +35,8 @@ private:
 	typedef std::map<std::string, std::shared_ptr<Value> > Values;
 
 	SerializedRCUManager<Values> _values;
+	EpochRCUManager<Values>      _epoch_values;
+	bool                         _use_epoch;
 
 #ifdef __APPLE__
 	pthread_mutex_t _mutex;
@@ -2,6 +2,8 @@
 
 #include "signals_test.h"
 #include "pbd/signals.h"
+#include "pbd/event_loop.h"
+#include "pbd/property_basics.h"
 
 using namespace std;
 
@@ -89,3 +91,125 @@ SignalsTest::testScopedConnectionList ()
 
 	CPPUNIT_ASSERT_EQUAL (1, N);
 }
+
+/** An event loop that queues requests until it is told to run them */
+class QueueingEventLoop : public PBD::EventLoop
+{
+public:
+	QueueingEventLoop () : PBD::EventLoop ("queue") {}
+
+	bool call_slot (InvalidationRecord*, const boost::function<void()>& f) {
+		queue.push_back (f);
+		return true;
+	}
+
+	Glib::Threads::RWLock& slot_invalidation_rwlock () { return lock; }
+
+	void run () {
+		std::list<boost::function<void()> > q;
+		q.swap (queue);
+		for (std::list<boost::function<void()> >::iterator i = q.begin(); i != q.end(); ++i) {
+			(*i) ();
+		}
+	}
+
+	std::list<boost::function<void()> > queue;
+	Glib::Threads::RWLock lock;
+};
+
+static PBD::PropertyChange received_change;
+
+static PBD::PropertyChange
+change (PBD::PropertyID id)
+{
+	PBD::PropertyChange c;
+	c.insert (id);
+	return c;
+}
+
+static void
+change_receiver (PBD::PropertyChange const& what)
+{
+	++N;
+	received_change.add (what);
+}
+
+void
+SignalsTest::testCrossThreadCoalescing ()
+{
+	QueueingEventLoop loop;
+	PBD::ScopedConnectionList connections;
+
+	Emitter e;
+
+	/* without opting in, every emission is delivered */
+	e.Fred.connect (connections, MISSING_INVALIDATOR, boost::bind (&receiver), &loop);
+	N = 0;
+	e.emit ();
+	e.emit ();
+	CPPUNIT_ASSERT_EQUAL (size_t (2), loop.queue.size ());
+	loop.run ();
+	CPPUNIT_ASSERT_EQUAL (2, N);
+	connections.drop_connections ();
+
+	e.Fred.set_cross_thread_coalescing (true);
+	e.Fred.connect (connections, MISSING_INVALIDATOR, boost::bind (&receiver), &loop);
+
+	PBD::SignalStats::reset ();
+	N = 0;
+	e.emit ();
+	e.emit ();
+	e.emit ();
+	CPPUNIT_ASSERT_EQUAL (size_t (1), loop.queue.size ());
+	CPPUNIT_ASSERT_EQUAL (uint64_t (1), PBD::SignalStats::queued.load ());
+	CPPUNIT_ASSERT_EQUAL (uint64_t (2), PBD::SignalStats::coalesced.load ());
+
+	loop.run ();
+	CPPUNIT_ASSERT_EQUAL (1, N);
+
+	/* an emission after delivery needs a new request */
+	e.emit ();
+	loop.run ();
+	CPPUNIT_ASSERT_EQUAL (2, N);
+
+	/* a request that is dropped without delivery (e.g. invalidated)
+	 * does not hold back later emissions */
+	e.emit ();
+	loop.queue.clear ();
+	e.emit ();
+	CPPUNIT_ASSERT_EQUAL (size_t (1), loop.queue.size ());
+	loop.run ();
+	CPPUNIT_ASSERT_EQUAL (3, N);
+
+	/* property changes are merged */
+	PBD::Signal1<void, PBD::PropertyChange const&> changed;
+	changed.set_cross_thread_coalescing (true);
+	changed.connect (connections, MISSING_INVALIDATOR, boost::bind (&change_receiver, _1), &loop);
+
+	N = 0;
+	changed (change (1));
+	changed (change (2));
+	CPPUNIT_ASSERT_EQUAL (size_t (1), loop.queue.size ());
+
+	loop.run ();
+	CPPUNIT_ASSERT_EQUAL (1, N);
+	CPPUNIT_ASSERT (received_change.contains (change (1)));
+	CPPUNIT_ASSERT (received_change.contains (change (2)));
+
+	/* changes of a dropped request are not delivered later */
+	received_change.clear ();
+	changed (change (3));
+	loop.queue.clear ();
+	changed (change (4));
+	loop.run ();
+	CPPUNIT_ASSERT (!received_change.contains (change (3)));
+	CPPUNIT_ASSERT (received_change.contains (change (4)));
+
+	/* other signatures are queued once per emission */
+	PBD::Signal1<void, int> value;
+	value.connect (connections, MISSING_INVALIDATOR, boost::bind (&receiver), &loop);
+	value (1);
+	value (2);
+	CPPUNIT_ASSERT_EQUAL (size_t (2), loop.queue.size ());
+	loop.run ();
+}
@@ -7,6 +7,7 @@ class SignalsTest : public CppUnit::TestFixture
 	CPPUNIT_TEST (testEmission);
 	CPPUNIT_TEST (testDestruction);
 	CPPUNIT_TEST (testScopedConnectionList);
+	CPPUNIT_TEST (testCrossThreadCoalescing);
 	CPPUNIT_TEST_SUITE_END ();
 
 public:
@@ -14,4 +15,5 @@ public:
 	void testEmission ();
 	void testDestruction ();
 	void testScopedConnectionList ();
+	void testCrossThreadCoalescing ();
 };
@@ -0,0 +1,61 @@
+#include <string.h>
+#include <stdlib.h>
+#include "slab_pool_test.h"
+#include "pbd/slab_pool.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION (SlabPoolTest);
+
+using namespace std;
+
+void
+SlabPoolTest::testBasic ()
+{
+	::srand (0);
+	PBD::SlabPool m ("TestPool", 256 * 1024);
+
+	for (int l = 0; l < 64 * 1024; ++l) {
+		void *x[32];
+		size_t s[32];
+		int cnt = ::rand() % 32;
+		for (int i = 0; i < cnt; ++i) {
+			s[i] = 1 + ::rand() % 2048;
+			x[i] = m.malloc (s[i]);
+			CPPUNIT_ASSERT (x[i]);
+			memset (x[i], 0xa5, s[i]);
+		}
+		for (int i = 0; i < cnt; ++i) {
+			m.free (x[i]);
+		}
+	}
+
+	PBD::SlabPool::Stats s (m.stats ());
+	CPPUNIT_ASSERT_EQUAL (size_t (0), s.used);
+	CPPUNIT_ASSERT_EQUAL (size_t (0), s.n_failed);
+	CPPUNIT_ASSERT_EQUAL (s.n_alloc, s.n_free);
+}
+
+/* a Lua table grows its array part by doubling (luaM_realloc),
+ * this must be served up to the size a plain TLSF pool could hold.
+ */
+void
+SlabPoolTest::testLargeTable ()
+{
+	size_t const pool_size = 3145728;
+	PBD::SlabPool m ("TestPool", pool_size);
+
+	void*  t = 0;
+	size_t s;
+	for (s = 16; s <= pool_size / 4; s *= 2) {
+		t = m.realloc (t, s);
+		CPPUNIT_ASSERT (t);
+		memset (t, 0x5a, s);
+	}
+	m.free (t);
+
+	/* a single block of more than half the pool */
+	t = m.malloc (pool_size / 2 + 65536);
+	CPPUNIT_ASSERT (t);
+	m.free (t);
+
+	CPPUNIT_ASSERT_EQUAL (size_t (0), m.stats ().n_failed);
+}
@@ -0,0 +1,14 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class SlabPoolTest : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE (SlabPoolTest);
+	CPPUNIT_TEST (testBasic);
+	CPPUNIT_TEST (testLargeTable);
+	CPPUNIT_TEST_SUITE_END ();
+
+public:
+	void testBasic ();
+	void testLargeTable ();
+};
@@ -0,0 +1,104 @@
+#include <glibmm/miscutils.h>
+
+#include "pbd/compose.h"
+#include "pbd/undo.h"
+#include "pbd/xml++.h"
+
+#include "undo_test.h"
+#include "test_common.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION (UndoTest);
+
+using namespace std;
+using namespace PBD;
+
+static int total = 0;
+
+/** A command that adds a value to total, and can be re-created from its state */
+class AddCommand : public Command
+{
+public:
+	AddCommand (int v) : _value (v) {}
+	~AddCommand () { drop_references (); }
+
+	void operator() () { total += _value; }
+	void undo () { total -= _value; }
+
+	XMLNode& get_state () const {
+		XMLNode* node = new XMLNode ("AddCommand");
+		node->set_property ("value", _value);
+		return *node;
+	}
+
+private:
+	int _value;
+};
+
+static UndoTransaction*
+make_transaction (XMLNode const& node)
+{
+	UndoTransaction* ut = new UndoTransaction ();
+	ut->set_name (node.property ("name")->value ());
+
+	for (XMLNodeConstIterator i = node.children ().begin (); i != node.children ().end (); ++i) {
+		int v;
+		if ((*i)->get_property ("value", v)) {
+			ut->add_command (new AddCommand (v));
+		}
+	}
+	return ut;
+}
+
+void
+UndoTest::testSpill ()
+{
+	std::string const dir = test_output_directory ("undo");
+
+	UndoHistory history;
+	history.set_spill (Glib::build_filename (dir, "test.undo-log"), 2, &make_transaction);
+
+	total = 0;
+
+	for (int i = 1; i <= 10; ++i) {
+		UndoTransaction* ut = new UndoTransaction ();
+		ut->set_name (string_compose ("add %1", i));
+		AddCommand* c = new AddCommand (i);
+		(*c) ();
+		ut->add_command (c);
+		history.add (ut);
+	}
+
+	CPPUNIT_ASSERT_EQUAL (55, total);
+	CPPUNIT_ASSERT_EQUAL (10UL, history.undo_depth ());
+	CPPUNIT_ASSERT_EQUAL (8UL, history.spilled_depth ());
+
+	std::string const path = Glib::build_filename (dir, "test.history");
+	CPPUNIT_ASSERT (history.write_state (path, -1));
+
+	XMLTree tree;
+	CPPUNIT_ASSERT (tree.read (path));
+	CPPUNIT_ASSERT_EQUAL ((size_t) 10, tree.root ()->children ().size ());
+	CPPUNIT_ASSERT_EQUAL (std::string ("add 1"), tree.root ()->children ().front ()->property ("name")->value ());
+
+	/* undo pages spilled transactions back in, in order */
+	history.undo (5);
+	CPPUNIT_ASSERT_EQUAL (15, total);
+	CPPUNIT_ASSERT_EQUAL (std::string ("add 5"), history.next_undo ());
+
+	history.undo (5);
+	CPPUNIT_ASSERT_EQUAL (0, total);
+	CPPUNIT_ASSERT_EQUAL (0UL, history.undo_depth ());
+
+	history.redo (10);
+	CPPUNIT_ASSERT_EQUAL (55, total);
+	CPPUNIT_ASSERT_EQUAL (8UL, history.spilled_depth ());
+
+	/* trimming forgets the oldest spilled transactions */
+	history.set_depth (4);
+	CPPUNIT_ASSERT_EQUAL (4UL, history.undo_depth ());
+	history.undo (4);
+	CPPUNIT_ASSERT_EQUAL (55 - 10 - 9 - 8 - 7, total);
+	CPPUNIT_ASSERT_EQUAL (0UL, history.undo_depth ());
+
+	history.clear ();
+}
@@ -83,6 +83,41 @@ XMLTest::testXMLFilenameEncoding ()
 	}
 }
 
+void
+XMLTest::testStreamedRead ()
+{
+	/* reading a file streams it into XMLNodes, reading a buffer goes
+	 * through a libxml2 document. Both must produce the same tree.
+	 */
+	const char* files[] = { "TestSession.ardour", "RosegardenPatchFile.xml", "ProtoolsPatchFile.midnam" };
+
+	for (size_t i = 0; i < sizeof (files) / sizeof (files[0]); ++i) {
+		std::string path;
+		CPPUNIT_ASSERT (find_file (test_search_path (), files[i], path));
+
+		XMLTree streamed;
+		CPPUNIT_ASSERT (streamed.read (path));
+
+		std::string contents = Glib::file_get_contents (path);
+		XMLTree parsed;
+		CPPUNIT_ASSERT (parsed.read_buffer (contents.c_str ()));
+
+		CPPUNIT_ASSERT (*streamed.root () == *parsed.root ());
+
+		std::stringstream s0, s1;
+		streamed.root ()->dump (s0);
+		parsed.root ()->dump (s1);
+		CPPUNIT_ASSERT_EQUAL (s1.str (), s0.str ());
+	}
+
+	std::string output_dir = test_output_directory ("XMLStreamedRead");
+	std::string bad = Glib::build_filename (output_dir, "bad.xml");
+	Glib::file_set_contents (bad, "<a><b x=\"1\"></a>");
+
+	XMLTree tree;
+	CPPUNIT_ASSERT (!tree.read (bad));
+	CPPUNIT_ASSERT (tree.root () == 0);
+}
 
 static const char * const root_node_name = "Session";
 static const char * const child_node_name = "Child";
@@ -21,13 +21,22 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <cerrno>
+#include <exception>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <time.h>
 
+#include <glib/gstdio.h>
+
+#include "pbd/compose.h"
+#include "pbd/error.h"
 #include "pbd/undo.h"
 #include "pbd/xml++.h"
 
+#include "pbd/i18n.h"
+
 using namespace std;
 using namespace sigc;
 using namespace PBD;
@@ -176,39 +185,48 @@ private:
 };
 
 UndoHistory::UndoHistory ()
+	: _spill_file (0)
+	, _spill_end (0)
+	, _ram_depth (0)
 {
 	_clearing = false;
 	_depth    = 0;
 }
 
+UndoHistory::~UndoHistory ()
+{
+	close_spill ();
+}
+
+/** Forget the oldest transactions until at most @p keep are left */
 void
-UndoHistory::set_depth (uint32_t d)
+UndoHistory::trim (uint32_t keep)
 {
-	uint32_t current_depth = UndoList.size ();
+	while (undo_depth () > keep) {
+		if (!_spilled.empty ()) {
+			/* the log is append-only, the record is just forgotten */
+			_spilled.pop_front ();
+			continue;
+		}
+		UndoTransaction* ut = UndoList.front ();
+		UndoList.pop_front ();
+		delete ut;
+	}
+}
 
+void
+UndoHistory::set_depth (uint32_t d)
+{
 	_depth = d;
 
-	if (d > current_depth) {
-		/* not even transactions to meet request */
-		return;
-	}
-
 	if (_depth > 0) {
-		uint32_t cnt = current_depth - d;
-
-		while (cnt--) {
-			UndoTransaction* ut = UndoList.front ();
-			UndoList.pop_front ();
-			delete ut;
-		}
+		trim (_depth);
 	}
 }
 
 void
 UndoHistory::add (UndoTransaction* const ut)
 {
-	uint32_t current_depth = UndoList.size ();
-
 	ut->DropReferences.connect_same_thread (*this, boost::bind (&UndoHistory::remove, this, ut));
 
 	/* if the current undo history is larger than or equal to the currently
@@ -216,15 +234,8 @@ UndoHistory::add (UndoTransaction* const ut)
 		 at the back for new one.
 		 */
 
-	if ((_depth > 0) && current_depth && (current_depth >= _depth)) {
-		uint32_t cnt = 1 + (current_depth - _depth);
-
-		while (cnt--) {
-			UndoTransaction* ut;
-			ut = UndoList.front ();
-			UndoList.pop_front ();
-			delete ut;
-		}
+	if (_depth > 0) {
+		trim (_depth - 1);
 	}
 
 	UndoList.push_back (ut);
@@ -238,6 +249,8 @@ UndoHistory::add (UndoTransaction* const ut)
 
 	/* we are now owners of the transaction and must delete it when finished with it */
 
+	maybe_spill ();
+
 	Changed (); /* EMIT SIGNAL */
 }
 
@@ -254,6 +267,174 @@ UndoHistory::remove (UndoTransaction* const ut)
 	Changed (); /* EMIT SIGNAL */
 }
 
+static int
+spill_seek (FILE* f, int64_t pos)
+{
+#ifdef PLATFORM_WINDOWS
+	return _fseeki64 (f, pos, SEEK_SET);
+#else
+	return fseeko (f, pos, SEEK_SET);
+#endif
+}
+
+void
+UndoHistory::set_spill (std::string const& path, uint32_t ram_depth, TransactionFactory factory)
+{
+	if (path != _spill_path || ram_depth == 0) {
+		/* spilled transactions cannot be moved, bring them back first */
+		while (!_spilled.empty () && page_in ()) ;
+		close_spill ();
+		_spill_path = path;
+	}
+
+	_ram_depth = ram_depth;
+	_factory   = factory;
+
+	maybe_spill ();
+}
+
+void
+UndoHistory::close_spill ()
+{
+	_spilled.clear ();
+
+	if (_spill_file) {
+		fclose (_spill_file);
+		_spill_file = 0;
+		::g_unlink (_spill_path.c_str ());
+	}
+
+	_spill_path.clear ();
+	_spill_end = 0;
+}
+
+/** Move the oldest in-memory transactions to the log until at most
+ * _ram_depth remain in memory.
+ */
+void
+UndoHistory::maybe_spill ()
+{
+	if (_ram_depth == 0 || _spill_path.empty () || UndoList.size () <= _ram_depth) {
+		return;
+	}
+
+	if (!_spill_file) {
+		/* the log is only created once it is needed */
+		_spill_end  = 0;
+		_spill_file = g_fopen (_spill_path.c_str (), "w+b");
+		if (!_spill_file) {
+			error << string_compose (_("Cannot open undo log %1 (%2), keeping all of the undo history in memory"), _spill_path, strerror (errno)) << endmsg;
+			_ram_depth = 0;
+			return;
+		}
+	}
+
+	while (UndoList.size () > _ram_depth) {
+
+		UndoTransaction* ut = UndoList.front ();
+
+		XMLTree tree;
+		tree.set_root (&ut->get_state ());
+		std::string const buf = tree.write_buffer ();
+
+		/* only spill what can be re-created. The log must stay in
+		 * order, so a transaction that cannot be spilled keeps all
+		 * later ones in memory as well.
+		 */
+		UndoTransaction* check = create (*tree.root ());
+		const bool restorable = check && check->size () == ut->size ();
+		delete check;
+
+		if (!restorable) {
+			break;
+		}
+
+		if (spill_seek (_spill_file, _spill_end) != 0 || fwrite (buf.c_str (), 1, buf.size (), _spill_file) != buf.size ()) {
+			error << string_compose (_("Cannot write undo log %1 (%2), keeping all of the undo history in memory"), _spill_path, strerror (errno)) << endmsg;
+			_ram_depth = 0;
+			break;
+		}
+
+		SpilledTransaction st;
+		st.name   = ut->name ();
+		st.offset = _spill_end;
+		st.length = buf.size ();
+		_spilled.push_back (st);
+		_spill_end += buf.size ();
+
+		UndoList.pop_front ();
+		_clearing = true;
+		delete ut;
+		_clearing = false;
+	}
+
+	fflush (_spill_file);
+}
+
+UndoTransaction*
+UndoHistory::create (XMLNode const& node) const
+{
+	if (!_factory) {
+		return 0;
+	}
+
+	try {
+		return _factory (node);
+	} catch (std::exception const& e) {
+		error << string_compose (_("Cannot restore undo transaction from log (%1)"), e.what ()) << endmsg;
+	}
+
+	return 0;
+}
+
+bool
+UndoHistory::read_spilled (SpilledTransaction const& st, std::string& buf) const
+{
+	buf.resize (st.length);
+
+	if (!_spill_file || spill_seek (_spill_file, st.offset) != 0 || fread (&buf[0], 1, st.length, _spill_file) != st.length) {
+		error << string_compose (_("Cannot read undo log %1 (%2)"), _spill_path, strerror (errno)) << endmsg;
+		return false;
+	}
+
+	return true;
+}
+
+/** Re-create the most recently spilled transaction and put it back at
+ * the front of the undo list.
+ * @return false if there was nothing that could be re-created.
+ */
+bool
+UndoHistory::page_in ()
+{
+	while (!_spilled.empty ()) {
+
+		SpilledTransaction st (_spilled.back ());
+		_spilled.pop_back ();
+
+		std::string buf;
+		XMLTree     tree;
+
+		if (!read_spilled (st, buf) || !tree.read_buffer (buf.c_str ())) {
+			continue;
+		}
+
+		UndoTransaction* ut = create (*tree.root ());
+
+		if (!ut || ut->empty ()) {
+			/* the objects it referred to are gone */
+			delete ut;
+			continue;
+		}
+
+		ut->DropReferences.connect_same_thread (*this, boost::bind (&UndoHistory::remove, this, ut));
+		UndoList.push_front (ut);
+		return true;
+	}
+
+	return false;
+}
+
 /** Undo some transactions.
  * @param n Number of transactions to undo.
  */
@@ -268,7 +449,7 @@ UndoHistory::undo (unsigned int n)
 		UndoRedoSignaller exception_safe_signaller (*this);
 
 		while (n--) {
-			if (UndoList.size () == 0) {
+			if (UndoList.size () == 0 && !page_in ()) {
 				return;
 			}
 			UndoTransaction* ut = UndoList.back ();
@@ -302,6 +483,8 @@ UndoHistory::redo (unsigned int n)
 		}
 	}
 
+	maybe_spill ();
+
 	Changed (); /* EMIT SIGNAL */
 }
 
@@ -328,6 +511,10 @@ UndoHistory::clear_undo ()
 	UndoList.clear ();
 	_clearing = false;
 
+	/* nothing refers to the log any more, later writes reuse it */
+	_spilled.clear ();
+	_spill_end = 0;
+
 	Changed (); /* EMIT SIGNAL */
 }
 
@@ -347,27 +534,106 @@ UndoHistory::get_state (int32_t depth)
 
 	if (depth == 0) {
 		return (*node);
+	}
+
+	/* everything, or just the last "depth" transactions */
 
-	} else if (depth < 0) {
-		/* everything */
+	unsigned long skip = 0;
+
+	if (depth > 0 && (unsigned long) depth < undo_depth ()) {
+		skip = undo_depth () - depth;
+	}
 
-		for (list<UndoTransaction*>::iterator it = UndoList.begin (); it != UndoList.end (); ++it) {
-			node->add_child_nocopy ((*it)->get_state ());
+	for (std::deque<SpilledTransaction>::const_iterator it = _spilled.begin (); it != _spilled.end (); ++it) {
+		if (skip) {
+			--skip;
+			continue;
 		}
+		std::string buf;
+		XMLTree     tree;
+		if (read_spilled (*it, buf) && tree.read_buffer (buf.c_str ())) {
+			node->add_child_copy (*tree.root ());
+		}
+	}
 
-	} else {
-		/* just the last "depth" transactions */
+	for (list<UndoTransaction*>::iterator it = UndoList.begin (); it != UndoList.end (); ++it) {
+		if (skip) {
+			--skip;
+			continue;
+		}
+		node->add_child_nocopy ((*it)->get_state ());
+	}
 
-		list<UndoTransaction*> in_order;
+	return *node;
+}
 
-		for (list<UndoTransaction*>::reverse_iterator it = UndoList.rbegin (); it != UndoList.rend () && depth; ++it, depth--) {
-			in_order.push_front (*it);
+/** strip the XML declaration written by XMLTree::write_buffer() */
+static void
+write_element (FILE* f, std::string const& buf)
+{
+	std::string::size_type start = 0;
+
+	if (buf.compare (0, 5, "<?xml") == 0) {
+		start = buf.find ("?>");
+		start = (start == std::string::npos) ? 0 : start + 2;
+		while (start < buf.size () && (buf[start] == '\n' || buf[start] == '\r')) {
+			++start;
 		}
+	}
+
+	fwrite (buf.c_str () + start, 1, buf.size () - start, f);
+}
 
-		for (list<UndoTransaction*>::iterator it = in_order.begin (); it != in_order.end (); it++) {
-			node->add_child_nocopy ((*it)->get_state ());
+bool
+UndoHistory::write_state (std::string const& path, int32_t depth)
+{
+	FILE* f = g_fopen (path.c_str (), "wb");
+
+	if (!f) {
+		return false;
+	}
+
+	fputs ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<UndoHistory>\n", f);
+
+	/* same selection as ::get_state() */
+	unsigned long skip = 0;
+
+	if (depth == 0) {
+		skip = undo_depth ();
+	} else if (depth > 0 && (unsigned long) depth < undo_depth ()) {
+		skip = undo_depth () - depth;
+	}
+
+	bool ok = true;
+
+	for (std::deque<SpilledTransaction>::const_iterator it = _spilled.begin (); it != _spilled.end () && ok; ++it) {
+		if (skip) {
+			--skip;
+			continue;
+		}
+		std::string buf;
+		if ((ok = read_spilled (*it, buf))) {
+			write_element (f, buf);
 		}
 	}
 
-	return *node;
+	for (list<UndoTransaction*>::iterator it = UndoList.begin (); it != UndoList.end () && ok; ++it) {
+		if (skip) {
+			--skip;
+			continue;
+		}
+		XMLTree tree;
+		tree.set_root (&(*it)->get_state ());
+		write_element (f, tree.write_buffer ());
+	}
+
+	fputs ("</UndoHistory>\n", f);
+
+	ok = !ferror (f) && ok;
+
+	if (fclose (f) != 0) {
+		ok = false;
+	}
+
+	return ok;
 }
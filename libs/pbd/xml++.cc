@@ -13,6 +13,7 @@
 #include "pbd/xml++.h"
 
 #include <libxml/debugXML.h>
+#include <libxml/xmlreader.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 
@@ -73,19 +74,10 @@ XMLTree::set_compression(int c)
 	return _compression;
 }
 
-bool
-XMLTree::read_internal(bool validate)
+xmlDocPtr
+XMLTree::read_document(bool validate) const
 {
-	//shouldnt be used anywhere ATM, remove if so!
-	assert(!validate);
-
-	delete _root;
-	_root = 0;
-
-	if (_doc) {
-		xmlFreeDoc (_doc);
-		_doc = 0;
-	}
+	xmlDocPtr doc;
 
 	/* Calling this prevents libxml2 from treating whitespace as active
 	   nodes. It needs to be called before we create a parser context.
@@ -95,32 +87,139 @@ XMLTree::read_internal(bool validate)
 	/* create a parser context */
 	xmlParserCtxtPtr ctxt = xmlNewParserCtxt();
 	if (ctxt == NULL) {
-		return false;
+		return NULL;
 	}
 
 	/* parse the file, activating the DTD validation option */
 	if (validate) {
-		_doc = xmlCtxtReadFile(ctxt, _filename.c_str(), NULL, XML_PARSE_DTDVALID);
+		doc = xmlCtxtReadFile(ctxt, _filename.c_str(), NULL, XML_PARSE_DTDVALID);
 	} else {
-		_doc = xmlCtxtReadFile(ctxt, _filename.c_str(), NULL, XML_PARSE_HUGE);
+		doc = xmlCtxtReadFile(ctxt, _filename.c_str(), NULL, XML_PARSE_HUGE);
 	}
 
-	/* check if parsing succeeded */
-	if (_doc == NULL) {
+	/* check if validation succeeded */
+	if (doc && validate && ctxt->valid == 0) {
 		xmlFreeParserCtxt(ctxt);
+		xmlFreeDoc(doc);
+		throw XMLException("Failed to validate document " + _filename);
+	}
+
+	/* free up the parser context */
+	xmlFreeParserCtxt(ctxt);
+
+	return doc;
+}
+
+bool
+XMLTree::read_internal(bool validate)
+{
+	//shouldnt be used anywhere ATM, remove if so!
+	assert(!validate);
+
+	delete _root;
+	_root = 0;
+
+	if (_doc) {
+		xmlFreeDoc (_doc);
+		_doc = 0;
+	}
+
+	if (validate) {
+		if ((_doc = read_document (true)) == NULL) {
+			return false;
+		}
+		_root = readnode(xmlDocGetRootElement(_doc));
+		return true;
+	}
+
+	/* Build XMLNodes directly while streaming through the file, rather
+	 * than having libxml2 build a complete document first and copying
+	 * that (which doubles peak memory use for large sessions). The same
+	 * nodes are created that readnode() would create from the document:
+	 * everything below (and including) the root element, with blanks
+	 * removed.
+	 */
+	xmlTextReaderPtr reader = xmlReaderForFile (_filename.c_str(), NULL, XML_PARSE_HUGE | XML_PARSE_NOBLANKS);
+	if (reader == NULL) {
 		return false;
-	} else {
-		/* check if validation succeeded */
-		if (validate && ctxt->valid == 0) {
-			xmlFreeParserCtxt(ctxt);
-			throw XMLException("Failed to validate document " + _filename);
+	}
+
+	std::vector<XMLNode*> parents;
+	int rv;
+
+	while ((rv = xmlTextReaderRead (reader)) == 1) {
+
+		const int type = xmlTextReaderNodeType (reader);
+		XMLNode*  node;
+		bool      is_parent = false;
+
+		if (type == XML_READER_TYPE_END_ELEMENT) {
+			if (!parents.empty ()) {
+				parents.pop_back ();
+			}
+			continue;
+		}
+
+		if (parents.empty () && (type != XML_READER_TYPE_ELEMENT || _root)) {
+			/* DTD, comments etc. outside of the root element */
+			continue;
+		}
+
+		switch (type) {
+		case XML_READER_TYPE_ELEMENT:
+			node = new XMLNode ((const char*) xmlTextReaderConstLocalName (reader), xmlTextReaderAttributeCount (reader));
+			if (xmlTextReaderMoveToFirstAttribute (reader) == 1) {
+				do {
+					if (xmlTextReaderIsNamespaceDecl (reader) == 1) {
+						continue;
+					}
+					node->append_property ((const char*) xmlTextReaderConstLocalName (reader), (const char*) xmlTextReaderConstValue (reader));
+				} while (xmlTextReaderMoveToNextAttribute (reader) == 1);
+				xmlTextReaderMoveToElement (reader);
+			}
+			is_parent = !xmlTextReaderIsEmptyElement (reader);
+			break;
+		case XML_READER_TYPE_TEXT:
+		case XML_READER_TYPE_WHITESPACE:
+		case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+			node = new XMLNode ("text", 0);
+			node->set_content ((const char*) xmlTextReaderConstValue (reader));
+			break;
+		case XML_READER_TYPE_CDATA:
+			node = new XMLNode ("", 0);
+			node->set_content ((const char*) xmlTextReaderConstValue (reader));
+			break;
+		case XML_READER_TYPE_COMMENT:
+			node = new XMLNode ("comment", 0);
+			node->set_content ((const char*) xmlTextReaderConstValue (reader));
+			break;
+		case XML_READER_TYPE_PROCESSING_INSTRUCTION:
+			node = new XMLNode ((const char*) xmlTextReaderConstName (reader), 0);
+			node->set_content ((const char*) xmlTextReaderConstValue (reader));
+			break;
+		default:
+			continue;
+		}
+
+		if (parents.empty ()) {
+			_root = node;
+		} else {
+			parents.back ()->add_child_nocopy (*node);
+		}
+
+		if (is_parent) {
+			parents.push_back (node);
 		}
 	}
 
-	_root = readnode(xmlDocGetRootElement(_doc));
+	xmlFreeTextReader (reader);
 
-	/* free up the parser context */
-	xmlFreeParserCtxt(ctxt);
+	if (rv != 0 || !_root) {
+		/* parse error */
+		delete _root;
+		_root = 0;
+		return false;
+	}
 
 	return true;
 }
@@ -247,6 +346,15 @@ XMLNode::XMLNode(const string& n, const string& c)
 	_proplist.reserve (PROPERTY_RESERVE_COUNT);
 }
 
+XMLNode::XMLNode(const char* n, int n_properties)
+	: _name(n)
+	, _is_content(false)
+{
+	if (n_properties > 0) {
+		_proplist.reserve (n_properties);
+	}
+}
+
 XMLNode::XMLNode(const XMLNode& from)
 {
 	_proplist.reserve (PROPERTY_RESERVE_COUNT);
@@ -448,7 +556,9 @@ XMLNode::children(const string& n) const
 XMLNode*
 XMLNode::add_child(const char* n)
 {
-	return add_child_copy(XMLNode (n));
+	XMLNode* node = new XMLNode(n);
+	_children.insert(_children.end(), node);
+	return node;
 }
 
 void
@@ -476,6 +586,10 @@ XMLTree::find(const string xpath, XMLNode* node) const
 		writenode(doc, node, doc->children, 1);
 		ctxt = xmlXPathNewContext(doc);
 	} else {
+		if (!_doc && !_filename.empty()) {
+			/* ::read() does not keep a document around */
+			_doc = read_document (false);
+		}
 		ctxt = xmlXPathNewContext(_doc);
 	}
 
@@ -617,6 +731,12 @@ XMLNode::set_property(const char* name, const string& value)
 	return new_property;
 }
 
+void
+XMLNode::append_property(const char* name, const char* value)
+{
+	_proplist.push_back (new XMLProperty (name, value));
+}
+
 bool
 XMLNode::get_property(const char* name, std::string& value) const
 {
@@ -17,6 +17,7 @@
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <vector>
 
@@ -49,6 +50,42 @@ std::string Meter::xml_node_name = X_("Meter");
 
 SerializedRCUManager<TempoMap> TempoMap::_map_mgr (0);
 thread_local TempoMap::SharedPtr TempoMap::_tempo_map_p;
+
+/* Per-thread memo of the tempo segment used by the most recent
+ * superclock <=> beat conversion. See TempoMap::begin_conversion_cycle().
+ */
+struct ConversionMemo {
+	ConversionMemo ()
+		: enabled (false)
+		, map (0)
+		, generation (0)
+		, tempo (0)
+		, sc_start (0)
+		, sc_end (0)
+		, hits (0)
+		, misses (0)
+	{}
+
+	bool              enabled;
+	TempoMap const *  map;
+	uint64_t          generation;
+	TempoPoint const* tempo;
+	superclock_t      sc_start;
+	superclock_t      sc_end;
+	Beats             qn_start;
+	Beats             qn_end;
+	uint64_t          hits;
+	uint64_t          misses;
+
+	bool valid_for (TempoMap const * m, uint64_t g) const {
+		return enabled && g != 0 && map == m && generation == g;
+	}
+};
+
+static thread_local ConversionMemo conversion_memo;
+static std::atomic<uint64_t> map_generation (0);
+static std::atomic<uint64_t> conversion_memo_hits (0);
+static std::atomic<uint64_t> conversion_memo_misses (0);
 PBD::Signal0<void> TempoMap::MapChanged;
 
 #ifndef NDEBUG
@@ -814,6 +851,7 @@ GridIterator::valid_for (TempoMap const & m, superclock_t start, uint32_t bmod,
 /* TEMPOMAP */
 
 TempoMap::TempoMap (Tempo const & initial_tempo, Meter const & initial_meter)
+	: _generation (0)
 {
 	TempoPoint* tp = new TempoPoint (*this, initial_tempo, 0, Beats(), BBT_Time());
 	MeterPoint* mp = new MeterPoint (*this, initial_meter, 0, Beats(), BBT_Time());
@@ -830,11 +868,13 @@ TempoMap::~TempoMap()
 }
 
 TempoMap::TempoMap (XMLNode const & node, int version)
+	: _generation (0)
 {
 	set_state (node, version);
 }
 
 TempoMap::TempoMap (TempoMap const & other)
+	: _generation (0)
 {
 	copy_points (other);
 }
@@ -842,6 +882,8 @@ TempoMap::TempoMap (TempoMap const & other)
 TempoMap&
 TempoMap::operator= (TempoMap const & other)
 {
+	/* a map that is being assigned to is by definition not published */
+	_generation = 0;
 	copy_points (other);
 	return *this;
 }
@@ -2353,7 +2395,22 @@ TempoMap::bbt_at (Temporal::Beats const & qn) const
 superclock_t
 TempoMap::superclock_at (Temporal::Beats const & qn) const
 {
-	return metric_at (qn).superclock_at (qn);
+	ConversionMemo& memo (conversion_memo);
+
+	if (!memo.valid_for (this, _generation)) {
+		return metric_at (qn).superclock_at (qn);
+	}
+
+	if (qn >= memo.qn_start && qn < memo.qn_end) {
+		++memo.hits;
+		return memo.tempo->superclock_at (qn);
+	}
+
+	++memo.misses;
+
+	TempoMetric metric (metric_at (qn));
+	memoize_segment (metric.tempo());
+	return metric.superclock_at (qn);
 }
 
 superclock_t
@@ -3279,7 +3336,92 @@ TempoMap::quarters_at (Temporal::BBT_Argument const & bbt) const
 Temporal::Beats
 TempoMap::quarters_at_superclock (superclock_t pos) const
 {
-	return metric_at (pos).quarters_at_superclock (pos);
+	ConversionMemo& memo (conversion_memo);
+
+	if (!memo.valid_for (this, _generation)) {
+		return metric_at (pos).quarters_at_superclock (pos);
+	}
+
+	if (pos >= memo.sc_start && pos < memo.sc_end) {
+		++memo.hits;
+		return memo.tempo->quarters_at_superclock (pos);
+	}
+
+	++memo.misses;
+
+	TempoMetric metric (metric_at (pos));
+	memoize_segment (metric.tempo());
+	return metric.quarters_at_superclock (pos);
+}
+
+void
+TempoMap::memoize_segment (TempoPoint const & tp) const
+{
+	ConversionMemo& memo (conversion_memo);
+
+	/* The tempo in effect at a given time is the last one at or before
+	 * it (or the first one, for times before it), so the segment extends
+	 * up to (but not including) the position of the next tempo.
+	 */
+
+	memo.tempo = &tp;
+
+	if (&tp == &_tempos.front()) {
+		memo.sc_start = std::numeric_limits<superclock_t>::min();
+		memo.qn_start = std::numeric_limits<Beats>::lowest();
+	} else {
+		memo.sc_start = tp.sclock();
+		memo.qn_start = tp.beats();
+	}
+
+	TempoPoint const * nxt = next_tempo (tp);
+
+	if (nxt) {
+		memo.sc_end = nxt->sclock();
+		memo.qn_end = nxt->beats();
+	} else {
+		memo.sc_end = std::numeric_limits<superclock_t>::max();
+		memo.qn_end = std::numeric_limits<Beats>::max();
+	}
+}
+
+void
+TempoMap::begin_conversion_cycle ()
+{
+	ConversionMemo& memo (conversion_memo);
+
+	/* publish this thread's counters once per cycle rather than touching
+	 * shared atomics for every conversion.
+	 */
+
+	if (memo.hits) {
+		conversion_memo_hits.fetch_add (memo.hits, std::memory_order_relaxed);
+		memo.hits = 0;
+	}
+
+	if (memo.misses) {
+		conversion_memo_misses.fetch_add (memo.misses, std::memory_order_relaxed);
+		memo.misses = 0;
+	}
+
+	memo.enabled = true;
+
+	TempoMap const * current = _tempo_map_p.get();
+
+	if (!current || memo.map != current || memo.generation != current->_generation) {
+		/* map changed: rekey, and force the next lookup to miss */
+		memo.map = current;
+		memo.generation = current ? current->_generation : 0;
+		memo.sc_start = memo.sc_end = 0;
+		memo.qn_start = memo.qn_end = Beats();
+	}
+}
+
+void
+TempoMap::conversion_memo_stats (uint64_t& hits, uint64_t& misses)
+{
+	hits = conversion_memo_hits.load (std::memory_order_relaxed);
+	misses = conversion_memo_misses.load (std::memory_order_relaxed);
 }
 
 XMLNode&
@@ -4249,6 +4391,7 @@ void
 TempoMap::init ()
 {
 	WritableSharedPtr new_map (new TempoMap ());
+	new_map->_generation = ++map_generation;
 	_map_mgr.init (new_map);
 	fetch ();
 }
@@ -4262,7 +4405,13 @@ TempoMap::write_copy()
 int
 TempoMap::update (TempoMap::WritableSharedPtr m)
 {
+	/* assign the generation before publication: once published, the
+	 * map is immutable and may be memoized by conversion caches.
+	 */
+	m->_generation = ++map_generation;
+
 	if (!_map_mgr.update (m)) {
+		m->_generation = 0;
 		return -1;
 	}
 
@@ -756,6 +756,21 @@ class /*LIBTEMPORAL_API*/ TempoMap : public PBD::StatefulDestructible
 	 */
 	LIBTEMPORAL_API static void      set (SharedPtr new_map) { _tempo_map_p = new_map; }
 
+	/* Realtime threads convert between superclock and beat time many
+	 * times per process cycle, and almost always within the same tempo
+	 * segment. A thread that calls begin_conversion_cycle() (after
+	 * updating its thread-local map) enables a per-thread memo of the
+	 * tempo segment used by the most recent conversion. The memo is keyed
+	 * on the generation of the map (assigned when a map is published via
+	 * ::update()), so conversions within that segment skip the map search
+	 * until the map changes. Unpublished (writable) maps are never
+	 * memoized.
+	 */
+	LIBTEMPORAL_API static void begin_conversion_cycle ();
+	LIBTEMPORAL_API static void conversion_memo_stats (uint64_t& hits, uint64_t& misses);
+
+	uint64_t generation () const { return _generation; }
+
 	/* API for typical tempo map changes */
 
 	LIBTEMPORAL_API static WritableSharedPtr write_copy();
@@ -768,7 +783,7 @@ class /*LIBTEMPORAL_API*/ TempoMap : public PBD::StatefulDestructible
 	/* and now on with the rest of the show ... */
 
   public:
-	LIBTEMPORAL_API TempoMap () {}
+	LIBTEMPORAL_API TempoMap () : _generation (0) {}
 	LIBTEMPORAL_API TempoMap (Tempo const& initial_tempo, Meter const& initial_meter);
 	LIBTEMPORAL_API TempoMap (TempoMap const&);
 	LIBTEMPORAL_API TempoMap (XMLNode const&, int version);
@@ -1002,6 +1017,9 @@ class /*LIBTEMPORAL_API*/ TempoMap : public PBD::StatefulDestructible
 	Meters       _meters;
 	MusicTimes   _bartimes;
 	Points       _points;
+	uint64_t     _generation;
+
+	void memoize_segment (TempoPoint const &) const;
 
 	int set_tempos_from_state (XMLNode const &);
 	int set_meters_from_state (XMLNode const &);
@@ -55,3 +55,70 @@ TempoMapTest::convertTest()
 {
 }
 
+
+void
+TempoMapTest::memoTest()
+{
+	TempoMap::WritableSharedPtr tmap (TempoMap::write_copy());
+	TempoPoint& tp = tmap->set_tempo (Tempo (90, 4), BBT_Argument (5, 1, 0));
+	TempoMap::update (tmap);
+
+	TempoMap::SharedPtr published (TempoMap::use());
+
+	/* an unpublished copy is never memoized, so use it as the reference */
+	TempoMap reference (*published);
+
+	CPPUNIT_ASSERT (published->generation() != 0);
+	CPPUNIT_ASSERT (reference.generation() == 0);
+
+	uint64_t hits_before;
+	uint64_t misses_before;
+
+	TempoMap::begin_conversion_cycle ();
+	TempoMap::conversion_memo_stats (hits_before, misses_before);
+
+	const superclock_t step = superclock_ticks_per_second() / 10;
+
+	for (superclock_t sc = 0; sc < superclock_ticks_per_second() * 30; sc += step) {
+		CPPUNIT_ASSERT (reference.quarters_at_superclock (sc) == published->quarters_at_superclock (sc));
+	}
+
+	for (Beats b; b < Beats (64, 0); b += Beats (0, 240)) {
+		CPPUNIT_ASSERT (reference.superclock_at (b) == published->superclock_at (b));
+	}
+
+	/* publishes the counters of this thread */
+	TempoMap::begin_conversion_cycle ();
+
+	uint64_t hits;
+	uint64_t misses;
+
+	TempoMap::conversion_memo_stats (hits, misses);
+
+	CPPUNIT_ASSERT (hits > hits_before);
+	CPPUNIT_ASSERT (misses > misses_before);
+	CPPUNIT_ASSERT (hits - hits_before > misses - misses_before);
+
+	/* the first segment extends to the start of time: after one
+	 * conversion in it, all others (including before zero) are hits,
+	 * in either direction
+	 */
+	TempoMap::begin_conversion_cycle ();
+	TempoMap::conversion_memo_stats (hits_before, misses_before);
+
+	CPPUNIT_ASSERT (reference.superclock_at (Beats (4, 0)) == published->superclock_at (Beats (4, 0)));
+	CPPUNIT_ASSERT (reference.superclock_at (Beats ()) == published->superclock_at (Beats ()));
+	CPPUNIT_ASSERT (reference.superclock_at (Beats (0, 1)) == published->superclock_at (Beats (0, 1)));
+	CPPUNIT_ASSERT (reference.quarters_at_superclock (step) == published->quarters_at_superclock (step));
+	CPPUNIT_ASSERT (reference.quarters_at_superclock (-step) == published->quarters_at_superclock (-step));
+
+	TempoMap::begin_conversion_cycle ();
+	TempoMap::conversion_memo_stats (hits, misses);
+
+	CPPUNIT_ASSERT_EQUAL (uint64_t (1), misses - misses_before);
+	CPPUNIT_ASSERT_EQUAL (uint64_t (4), hits - hits_before);
+
+	tmap = TempoMap::write_copy ();
+	tmap->remove_tempo (tmap->tempo_at (tp.beats()));
+	TempoMap::update (tmap);
+}
@@ -66,7 +66,22 @@ struct TemporalStatistics
 
 static TemporalStatistics stats;
 
-void Temporal::dump_stats (std::ostream& o) { stats.dump (o); }
+void
+Temporal::dump_stats (std::ostream& o)
+{
+	stats.dump (o);
+
+	uint64_t hits;
+	uint64_t misses;
+
+	TempoMap::conversion_memo_stats (hits, misses);
+
+	o << "Conversion memo hits " << hits << " misses " << misses;
+	if (hits + misses) {
+		o << " (" << (100.0 * hits) / (hits + misses) << "% hit rate)";
+	}
+	o << std::endl;
+}
 
 /* timecnt */
 
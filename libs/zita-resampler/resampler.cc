@@ -195,7 +195,25 @@ Resampler::process (void)
 			inp_count--;
 		} else {
 			if (out_data) {
-				if (nz < 2 * hl) {
+				if (nz < 2 * hl && _nchan >= 4) {
+					/* accumulate all channels for each tap,
+					 * this vectorizes across channels */
+					const float *c1 = _table->_ctab + hl * ph;
+					const float *c2 = _table->_ctab + hl * (np - ph);
+					const float *q1 = p1;
+					const float *q2 = p2;
+					float *__restrict s = out_data;
+					for (c = 0; c < _nchan; c++) s [c] = 1e-20f;
+					for (i = 0; i < hl; i++) {
+						q2 -= _nchan;
+						const float a = c1 [i];
+						const float b = c2 [i];
+						for (c = 0; c < _nchan; c++) s [c] += q1 [c] * a + q2 [c] * b;
+						q1 += _nchan;
+					}
+					for (c = 0; c < _nchan; c++) s [c] -= 1e-20f;
+					out_data += _nchan;
+				} else if (nz < 2 * hl) {
 					float *c1 = _table->_ctab + hl * ph;
 					float *c2 = _table->_ctab + hl * (np - ph);
 					for (c = 0; c < _nchan; c++) {
@@ -16,15 +16,35 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <atomic>
+#include <fstream>
 #include <iostream>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
 #include <getopt.h>
 #include <glibmm.h>
+#include <sndfile.h>
+
+#include <boost/bind/bind.hpp>
 
 #include "common.h"
 
 #include "pbd/basename.h"
+#include "pbd/compose.h"
 #include "pbd/enumwriter.h"
+#include "pbd/file_utils.h"
+#include "pbd/gstdio_compat.h"
+#include "pbd/pthread_utils.h"
+#include "pbd/string_convert.h"
+
+#include "temporal/tempo.h"
+
+#include "ardour/automation_control.h"
+#include "ardour/automation_list.h"
 
 #include "ardour/broadcast_info.h"
 #include "ardour/export_handler.h"
@@ -33,9 +53,18 @@
 #include "ardour/export_channel_configuration.h"
 #include "ardour/export_format_specification.h"
 #include "ardour/export_filename.h"
+#include "ardour/file_source.h"
+#include "ardour/pannable.h"
+#include "ardour/playlist.h"
+#include "ardour/plugin.h"
+#include "ardour/plugin_insert.h"
+#include "ardour/region.h"
 #include "ardour/route.h"
+#include "ardour/session_directory.h"
 #include "ardour/session_metadata.h"
-#include "ardour/broadcast_info.h"
+#include "ardour/track.h"
+#include "ardour/vca.h"
+#include "ardour/vca_manager.h"
 
 #include "pbd/i18n.h"
 
@@ -50,6 +79,8 @@ struct ExportSettings
 		, _sample_format (ExportFormatBase::SF_16)
 		, _normalize (false)
 		, _bwf (false)
+		, _start (0)
+		, _end (0)
 	{}
 
 	std::string samplerate () const
@@ -78,6 +109,8 @@ struct ExportSettings
 	ExportFormatBase::SampleFormat _sample_format;
 	bool _normalize;
 	bool _bwf;
+	samplepos_t _start; // 0, 0: session range
+	samplepos_t _end;
 };
 
 static int export_session (Session *session,
@@ -130,6 +163,10 @@ static int export_session (Session *session,
 	samplepos_t start, end;
 	start = session->current_start_sample();
 	end   = session->current_end_sample();
+	if (settings._end > settings._start) {
+		start = settings._start;
+		end   = settings._end;
+	}
 	tsp->set_range (start, end);
 	tsp->set_range_id ("session");
 
@@ -206,12 +243,661 @@ static int export_session (Session *session,
 	}
 	printf("\n");
 
+	bool const aborted = status->aborted ();
 	status->finish (TRS_UI);
 
+	if (aborted) {
+		return -1;
+	}
+
 	printf ("* Done.\n");
 	return 0;
 }
 
+/* Parallel export: the range is split into slices, each rendered by a
+ * separate process (this tool with --range) including some pre-roll to
+ * bring reverb tails, compressors etc. into the same state as a serial
+ * render. The slices are then stitched, and the pre-roll of each slice
+ * is compared with the end of the previous one.
+ */
+
+struct Slice
+{
+	samplepos_t start;   // first sample used in the output
+	samplepos_t end;
+	samplecnt_t preroll; // rendered before start, discarded
+	std::string path;
+	bool        ok;      // rendered, or taken from the cache
+	std::string log;
+	std::string key;     // cache key, see block_key()
+};
+
+static void
+render_slice (Slice* slice, std::string const& self, std::string const& dir, std::string const& name)
+{
+	std::vector<std::string> argv;
+	argv.push_back (self);
+	argv.push_back ("--bitdepth");
+	argv.push_back ("float");
+	argv.push_back ("--range");
+	argv.push_back (PBD::to_string (slice->start - slice->preroll) + "," + PBD::to_string (slice->end));
+	argv.push_back ("--output");
+	argv.push_back (slice->path);
+	argv.push_back (dir);
+	argv.push_back (name);
+
+	std::string out;
+	int exit_status = -1;
+	try {
+		Glib::spawn_sync ("", argv, Glib::SPAWN_SEARCH_PATH, Glib::SlotSpawnChildSetup (), &out, &slice->log, &exit_status);
+	} catch (Glib::SpawnError const& e) {
+		slice->log = e.what ();
+	}
+	slice->ok = exit_status == 0;
+}
+
+/* render all slices that are not yet ok, slices are distributed
+ * among the worker threads as they become available */
+static void
+render_slices (std::vector<Slice>* slices, std::atomic<size_t>* next, std::string self, std::string dir, std::string name)
+{
+	size_t i;
+	while ((i = (*next)++) < slices->size ()) {
+		if (!(*slices)[i].ok) {
+			render_slice (&(*slices)[i], self, dir, name);
+		}
+	}
+}
+
+/* Export cache: the range is split into blocks of fixed length, aligned
+ * to the range start. Each block is keyed by a hash of everything its
+ * render depends on: the session state that applies to the whole timeline
+ * (routes, plugins, tempo-map, configuration) and the regions and
+ * automation events between the start of the block's pre-roll and the
+ * end of the block plus the worst-case latency.
+ * A block whose key is found in the cache is not rendered again, but
+ * taken from the previous export. Each cached block is stored along
+ * with a hash of its content, to detect stale or truncated files.
+ */
+
+static void
+strip_state (XMLNode& node)
+{
+	/* GUI state and ordering do not change the audio, automation
+	 * events are hashed per block. The plugin state-hash is
+	 * redundant with the plugin state itself. */
+	node.remove_nodes_and_delete (X_("Extra"));
+	node.remove_property (X_("state-hash"));
+	node.remove_nodes_and_delete (PresentationInfo::state_node_name);
+	if (node.name () == X_("AutomationList")) {
+		node.remove_nodes_and_delete (X_("events"));
+	}
+	XMLNodeList const& children (node.children ());
+	for (XMLNodeConstIterator i = children.begin (); i != children.end (); ++i) {
+		strip_state (**i);
+	}
+}
+
+static void
+hash_state (Glib::Checksum& cs, XMLNode& node)
+{
+	strip_state (node);
+	XMLTree tree;
+	tree.set_root (&node); // takes ownership
+	cs.update (tree.write_buffer ());
+}
+
+static std::string
+global_state_hash (Session* session)
+{
+	Glib::Checksum cs (Glib::Checksum::CHECKSUM_SHA1);
+
+	hash_state (cs, session->config.get_state ());
+	hash_state (cs, Temporal::TempoMap::use ()->get_state ());
+	hash_state (cs, session->vca_manager ().get_state ());
+
+	std::map<PBD::ID, std::shared_ptr<Route> > routes;
+	std::shared_ptr<RouteList const> rl = session->get_routes ();
+	for (RouteList::const_iterator i = rl->begin (); i != rl->end (); ++i) {
+		routes[(*i)->id ()] = *i;
+	}
+	for (std::map<PBD::ID, std::shared_ptr<Route> >::const_iterator i = routes.begin (); i != routes.end (); ++i) {
+		hash_state (cs, i->second->get_state ());
+	}
+
+	return cs.get_string ();
+}
+
+/* hash automation events in [a, b], and the events on either side,
+ * which define the interpolated value within the range */
+static void
+hash_automation (Glib::Checksum& cs, Automatable const& automatable, samplepos_t a, samplepos_t b)
+{
+	Evoral::ControlSet::Controls const& controls (automatable.controls ());
+	for (Evoral::ControlSet::Controls::const_iterator c = controls.begin (); c != controls.end (); ++c) {
+		std::shared_ptr<AutomationControl> ac = std::dynamic_pointer_cast<AutomationControl> (c->second);
+		if (!ac || !ac->alist () || ac->alist ()->empty ()) {
+			continue;
+		}
+		std::shared_ptr<AutomationList> al = ac->alist ();
+
+		cs.update (string_compose ("%1 %2 %3\n", c->first.type (), c->first.id (), (int) c->first.channel ()));
+
+		Evoral::ControlList::const_iterator prev = al->end ();
+		for (Evoral::ControlList::const_iterator e = al->begin (); e != al->end (); ++e) {
+			samplepos_t const when = (*e)->when.samples ();
+			if (when < a) {
+				prev = e;
+				continue;
+			}
+			if (prev != al->end ()) {
+				cs.update (string_compose ("%1 %2\n", (*prev)->when.samples (), PBD::to_string ((*prev)->value)));
+				prev = al->end ();
+			}
+			cs.update (string_compose ("%1 %2\n", when, PBD::to_string ((*e)->value)));
+			if (when > b) {
+				break;
+			}
+		}
+		if (prev != al->end ()) {
+			cs.update (string_compose ("%1 %2\n", (*prev)->when.samples (), PBD::to_string ((*prev)->value)));
+		}
+	}
+}
+
+static std::string
+block_key (Session* session, std::string const& global, Slice const& s, samplecnt_t tail, samplecnt_t latency)
+{
+	Glib::Checksum cs (Glib::Checksum::CHECKSUM_SHA1);
+
+	samplepos_t const a = s.start - s.preroll;
+	samplepos_t const b = s.end + latency;
+
+	cs.update (string_compose ("ardour-export-cache 1\n%1\n%2 %3 %4 %5 %6\n", global, session->nominal_sample_rate (), s.start, s.end, s.preroll, latency));
+
+	std::map<PBD::ID, std::shared_ptr<Route> > routes;
+	std::shared_ptr<RouteList const> rl = session->get_routes ();
+	for (RouteList::const_iterator i = rl->begin (); i != rl->end (); ++i) {
+		routes[(*i)->id ()] = *i;
+	}
+
+	for (std::map<PBD::ID, std::shared_ptr<Route> >::const_iterator i = routes.begin (); i != routes.end (); ++i) {
+		std::shared_ptr<Route> r = i->second;
+		cs.update (r->id ().to_s ());
+
+		hash_automation (cs, *r, a, b);
+		if (r->pannable ()) {
+			hash_automation (cs, *r->pannable (), a, b);
+		}
+		std::shared_ptr<Processor> p;
+		for (uint32_t n = 0; (p = r->nth_processor (n)); ++n) {
+			hash_automation (cs, *p, a, b);
+		}
+
+		std::shared_ptr<Track> t = std::dynamic_pointer_cast<Track> (r);
+		if (!t || !t->playlist ()) {
+			continue;
+		}
+
+		/* region effects may ring past the end of a region */
+		std::shared_ptr<RegionList> regions = t->playlist ()->regions_touched (timepos_t (std::max<samplepos_t> (0, a - tail)), timepos_t (b));
+		for (RegionList::const_iterator j = regions->begin (); j != regions->end (); ++j) {
+			hash_state (cs, (*j)->get_state ());
+			if ((*j)->data_type () != DataType::MIDI) {
+				continue;
+			}
+			/* MIDI edits modify the source, which is saved with the session */
+			SourceList const& sources ((*j)->sources ());
+			for (SourceList::const_iterator k = sources.begin (); k != sources.end (); ++k) {
+				std::shared_ptr<FileSource> fs = std::dynamic_pointer_cast<FileSource> (*k);
+				GStatBuf statbuf;
+				if (fs && g_stat (fs->path ().c_str (), &statbuf) == 0) {
+					cs.update (string_compose ("%1 %2 %3\n", fs->path (), (int64_t) statbuf.st_size, (int64_t) statbuf.st_mtime));
+				}
+			}
+		}
+	}
+
+	VCAList vcas = session->vca_manager ().vcas ();
+	for (VCAList::const_iterator i = vcas.begin (); i != vcas.end (); ++i) {
+		hash_automation (cs, **i, a, b);
+	}
+
+	return cs.get_string ();
+}
+
+/* hash of a file's content, empty if it cannot be read */
+static std::string
+content_hash (std::string const& path)
+{
+	std::ifstream f (path.c_str (), std::ios::binary);
+	if (!f) {
+		return "";
+	}
+	Glib::Checksum cs (Glib::Checksum::CHECKSUM_SHA1);
+	std::vector<char> buf (65536);
+	while (f) {
+		f.read (&buf[0], buf.size ());
+		cs.update ((guchar const*) &buf[0], f.gcount ());
+	}
+	return cs.get_string ();
+}
+
+/* the sum of plugin tail-times along the longest chain, an estimate of
+ * how long a signal change may still be heard. */
+static samplecnt_t
+worst_tailtime (Session* session)
+{
+	samplecnt_t route_tail  = 0;
+	samplecnt_t master_tail = 0;
+
+	std::shared_ptr<RouteList const> rl = session->get_routes ();
+	for (RouteList::const_iterator i = rl->begin (); i != rl->end (); ++i) {
+		samplecnt_t tail = 0;
+		for (uint32_t n = 0; ; ++n) {
+			std::shared_ptr<PluginInsert> pi = std::dynamic_pointer_cast<PluginInsert> ((*i)->nth_plugin (n));
+			if (!pi) {
+				break;
+			}
+			tail += pi->plugin ()->signal_tailtime ();
+		}
+		if ((*i)->is_master ()) {
+			master_tail = tail;
+		} else {
+			route_tail = std::max (route_tail, tail);
+		}
+	}
+	return route_tail + master_tail;
+}
+
+static int
+sndfile_format (ExportFormatBase::SampleFormat sf)
+{
+	switch (sf) {
+		case ExportFormatBase::SF_24:
+			return SF_FORMAT_WAV | SF_FORMAT_PCM_24;
+		case ExportFormatBase::SF_32:
+			return SF_FORMAT_WAV | SF_FORMAT_PCM_32;
+		case ExportFormatBase::SF_Float:
+			return SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+		default:
+			return SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+	}
+}
+
+/* read \a n frames at \a pos, returns false on short read */
+static bool
+read_frames (SNDFILE* sf, sf_count_t pos, float* buf, sf_count_t n)
+{
+	return sf_seek (sf, pos, SEEK_SET) == pos && sf_readf_float (sf, buf, n) == n;
+}
+
+static double
+to_dbfs (float v)
+{
+	return v > 0 ? 20. * log10 (v) : -std::numeric_limits<double>::infinity ();
+}
+
+static int
+stitch_slices (std::vector<Slice> const& slices, std::string const& outfile, std::string const& serial,
+               ExportSettings const& settings, int sample_rate)
+{
+	/* validate length of each slice, and compare overlaps */
+	int         n_chn = 0;
+	float       peak  = 0;
+	samplecnt_t const block = 8192;
+
+	for (size_t i = 0; i < slices.size (); ++i) {
+		SF_INFO info;
+		memset (&info, 0, sizeof (info));
+		SNDFILE* sf = sf_open (slices[i].path.c_str (), SFM_READ, &info);
+		if (!sf) {
+			cerr << "Error: cannot open slice " << i + 1 << ": " << sf_strerror (0) << "\n";
+			return -1;
+		}
+		samplecnt_t const expected = slices[i].end - slices[i].start + slices[i].preroll;
+		if (info.frames != expected || (n_chn > 0 && info.channels != n_chn)) {
+			cerr << "Error: slice " << i + 1 << " has " << info.frames << " samples, expected " << expected << "\n";
+			sf_close (sf);
+			return -1;
+		}
+		n_chn = info.channels;
+
+		std::vector<float> buf (block * n_chn);
+		for (sf_count_t pos = slices[i].preroll; pos < info.frames; pos += block) {
+			sf_count_t const n = std::min<sf_count_t> (block, info.frames - pos);
+			if (!read_frames (sf, pos, &buf[0], n)) {
+				cerr << "Error: cannot read slice " << i + 1 << "\n";
+				sf_close (sf);
+				return -1;
+			}
+			for (sf_count_t s = 0; s < n * n_chn; ++s) {
+				peak = std::max (peak, fabsf (buf[s]));
+			}
+		}
+		sf_close (sf);
+
+		if (i == 0 || slices[i].preroll == 0) {
+			continue;
+		}
+
+		/* compare the end of the pre-roll with the end of the previous slice */
+		samplecnt_t const n = std::min<samplecnt_t> (std::min<samplecnt_t> (sample_rate / 10, slices[i].preroll), slices[i - 1].end - slices[i - 1].start);
+
+		SF_INFO info_p;
+		memset (&info_p, 0, sizeof (info_p));
+		SNDFILE* prev = sf_open (slices[i - 1].path.c_str (), SFM_READ, &info_p);
+		sf = sf_open (slices[i].path.c_str (), SFM_READ, &info);
+		std::vector<float> a (n * n_chn);
+		std::vector<float> b (n * n_chn);
+		bool ok = prev && sf && read_frames (prev, info_p.frames - n, &a[0], n) && read_frames (sf, slices[i].preroll - n, &b[0], n);
+		if (prev) {
+			sf_close (prev);
+		}
+		if (sf) {
+			sf_close (sf);
+		}
+		if (!ok) {
+			cerr << "Error: cannot compare slice " << i << " and " << i + 1 << "\n";
+			return -1;
+		}
+		float diff = 0;
+		for (samplecnt_t s = 0; s < n * n_chn; ++s) {
+			diff = std::max (diff, fabsf (a[s] - b[s]));
+		}
+		if (diff > 0) {
+			printf ("* Warning: slice %d and %d differ by %.1f dBFS at the boundary, pre-roll may be too short.\n", (int) i, (int) i + 1, to_dbfs (diff));
+		}
+	}
+
+	/* write output */
+	float gain = 1.f;
+	if (settings._normalize && peak > 0) {
+		gain = 1.f / peak;
+	}
+
+	SF_INFO info_out;
+	memset (&info_out, 0, sizeof (info_out));
+	info_out.samplerate = sample_rate;
+	info_out.channels   = n_chn;
+	info_out.format     = sndfile_format (settings._sample_format);
+
+	SNDFILE* out = sf_open (outfile.c_str (), SFM_WRITE, &info_out);
+	if (!out) {
+		cerr << "Error: cannot write '" << outfile << "': " << sf_strerror (0) << "\n";
+		return -1;
+	}
+	sf_command (out, SFC_SET_CLIPPING, NULL, SF_TRUE);
+
+	SF_INFO info_s;
+	memset (&info_s, 0, sizeof (info_s));
+	SNDFILE* ref = serial.empty () ? 0 : sf_open (serial.c_str (), SFM_READ, &info_s);
+	if (!serial.empty () && (!ref || info_s.channels != n_chn)) {
+		cerr << "Error: cannot read serial render for verification\n";
+		if (ref) {
+			sf_close (ref);
+		}
+		sf_close (out);
+		return -1;
+	}
+
+	std::vector<float> buf (block * n_chn);
+	std::vector<float> rbuf (block * n_chn);
+	samplepos_t written = 0;
+	int         rv      = 0;
+
+	for (size_t i = 0; i < slices.size () && rv == 0; ++i) {
+		SF_INFO info;
+		memset (&info, 0, sizeof (info));
+		SNDFILE* sf = sf_open (slices[i].path.c_str (), SFM_READ, &info);
+		if (!sf || sf_seek (sf, slices[i].preroll, SEEK_SET) != slices[i].preroll) {
+			rv = -1;
+			break;
+		}
+		sf_count_t n;
+		while ((n = sf_readf_float (sf, &buf[0], block)) > 0) {
+			if (ref) {
+				if (sf_readf_float (ref, &rbuf[0], n) != n) {
+					cerr << "Error: serial render is shorter than parallel render\n";
+					rv = -1;
+					break;
+				}
+				/* both are float renders before gain is applied, they must match exactly */
+				for (sf_count_t s = 0; s < n * n_chn; ++s) {
+					if (buf[s] != rbuf[s]) {
+						printf ("* Verify: parallel render differs from serial render by %.1f dBFS.\n", to_dbfs (fabsf (buf[s] - rbuf[s])));
+						cout << "* Verify: first difference at sample " << written + s / n_chn << " of the export range, channel " << s % n_chn + 1 << ".\n";
+						rv = -1;
+						break;
+					}
+				}
+				if (rv != 0) {
+					break;
+				}
+			}
+			if (gain != 1.f) {
+				for (sf_count_t s = 0; s < n * n_chn; ++s) {
+					buf[s] *= gain;
+				}
+			}
+			if (sf_writef_float (out, &buf[0], n) != n) {
+				cerr << "Error: cannot write '" << outfile << "'\n";
+				rv = -1;
+				break;
+			}
+			written += n;
+		}
+		sf_close (sf);
+	}
+
+	sf_close (out);
+
+	if (ref) {
+		if (rv == 0 && sf_readf_float (ref, &rbuf[0], 1) > 0) {
+			cerr << "Error: serial render is longer than parallel render\n";
+			rv = -1;
+		}
+		sf_close (ref);
+		if (rv == 0) {
+			printf ("* Verify: parallel render is bit-exact with the serial render.\n");
+		}
+	}
+
+	return rv;
+}
+
+static int
+export_parallel (Session* session, std::string const& self, std::string const& dir, std::string const& name,
+                 std::string outfile, ExportSettings const& settings, int jobs, double preroll_sec, bool verify,
+                 std::string const& cache, double block_sec)
+{
+	samplepos_t start = session->current_start_sample ();
+	samplepos_t end   = session->current_end_sample ();
+	if (settings._end > settings._start) {
+		start = settings._start;
+		end   = settings._end;
+	}
+
+	int const         sample_rate = session->nominal_sample_rate ();
+	samplecnt_t const tail        = worst_tailtime (session);
+	samplecnt_t       preroll     = preroll_sec * sample_rate;
+	samplecnt_t       len;
+	int               n_slices;
+
+	if (tail > preroll) {
+		printf ("* Extending pre-roll to the plugin tail-time of %.1f sec\n", tail / (double) sample_rate);
+		preroll = tail;
+	}
+
+	if (cache.empty ()) {
+		n_slices = jobs;
+		len      = (end - start) / n_slices;
+		if (len < sample_rate) {
+			cerr << "Error: slices would be shorter than one second, use fewer jobs\n";
+			return -1;
+		}
+	} else {
+		/* fixed block boundaries, so that an edit only affects nearby blocks */
+		len      = std::max<samplecnt_t> (sample_rate, block_sec * sample_rate);
+		n_slices = (end - start + len - 1) / len;
+	}
+
+	if (outfile.empty ()) {
+		outfile = Glib::build_filename (session->session_directory ().export_path (), "session.wav");
+	} else if (outfile.size () <= 4 || outfile.compare (outfile.size () - 4, 4, ".wav")) {
+		outfile += ".wav";
+	}
+
+	/* slices can be large, keep them next to the output */
+	std::string tmp = Glib::build_filename (Glib::path_get_dirname (outfile), ".export-XXXXXX");
+	std::vector<char> tmp_buf (tmp.begin (), tmp.end ());
+	tmp_buf.push_back ('\0');
+	if (!g_mkdtemp (&tmp_buf[0])) {
+		cerr << "Error: cannot create temporary folder next to '" << outfile << "'\n";
+		return -1;
+	}
+	tmp = &tmp_buf[0];
+
+	if (!cache.empty () && g_mkdir_with_parents (cache.c_str (), 0755)) {
+		cerr << "Error: cannot create cache folder '" << cache << "'\n";
+		PBD::remove_directory (tmp);
+		return -1;
+	}
+
+	std::string global;
+	if (!cache.empty ()) {
+		global = global_state_hash (session);
+	}
+
+	std::vector<Slice> slices (n_slices);
+	int n_cached = 0;
+	for (int i = 0; i < n_slices; ++i) {
+		Slice& s (slices[i]);
+		s.start   = start + i * len;
+		s.end     = (i + 1 == n_slices) ? end : s.start + len;
+		s.preroll = std::min (preroll, s.start - start); // a serial render starts at the range start, too
+		s.path    = Glib::build_filename (tmp, string_compose ("slice-%1.wav", i));
+		s.ok      = false;
+
+		if (cache.empty ()) {
+			continue;
+		}
+
+		s.key  = block_key (session, global, s, tail, session->worst_latency_preroll ());
+		s.path = Glib::build_filename (cache, s.key + ".wav");
+
+		std::string const sum_path = Glib::build_filename (cache, s.key + ".sum");
+		std::string sum;
+		try {
+			sum = Glib::file_get_contents (sum_path);
+		} catch (Glib::FileError const&) {
+		}
+		if (!sum.empty () && sum == content_hash (s.path)) {
+			s.ok = true;
+			++n_cached;
+		} else {
+			/* re-render, the sum is written when done */
+			::g_unlink (sum_path.c_str ());
+		}
+	}
+
+	if (cache.empty ()) {
+		printf ("* Rendering %d slices with %.1f sec pre-roll\n", n_slices, preroll / (double) sample_rate);
+	} else {
+		printf ("* Rendering %d of %d blocks with %.1f sec pre-roll, %d unchanged blocks are cached\n",
+		        n_slices - n_cached, n_slices, preroll / (double) sample_rate, n_cached);
+	}
+
+	std::atomic<size_t> next (0);
+	std::vector<PBD::Thread*> threads;
+	for (int i = 0; i < std::min (jobs, n_slices - n_cached); ++i) {
+		threads.push_back (PBD::Thread::create (boost::bind (&render_slices, &slices, &next, self, dir, name), string_compose ("slice-%1", i)));
+	}
+
+	for (size_t i = 0; i < threads.size (); ++i) {
+		if (threads[i]) {
+			threads[i]->join ();
+			delete threads[i];
+		}
+	}
+
+	int rv = 0;
+	for (int i = 0; i < n_slices; ++i) {
+		if (!slices[i].ok) {
+			cerr << "Error: rendering slice " << i + 1 << " failed\n" << slices[i].log << "\n";
+			rv = -1;
+		} else if (!cache.empty ()) {
+			std::string const sum = Glib::build_filename (cache, slices[i].key + ".sum");
+			if (!Glib::file_test (sum, Glib::FILE_TEST_EXISTS)) {
+				try {
+					Glib::file_set_contents (sum, content_hash (slices[i].path));
+				} catch (Glib::FileError const& e) {
+					cerr << "Error: cannot update export cache: " << e.what () << "\n";
+					rv = -1;
+				}
+			}
+		}
+	}
+
+	if (rv == 0 && verify && !cache.empty ()) {
+		/* an unchanged session must produce the same keys again,
+		 * otherwise the next export cannot reuse any block */
+		std::string const global2 = global_state_hash (session);
+		int n_stable = 0;
+		for (int i = 0; i < n_slices; ++i) {
+			if (block_key (session, global2, slices[i], tail, session->worst_latency_preroll ()) == slices[i].key) {
+				++n_stable;
+			}
+		}
+		if (n_stable == n_slices) {
+			printf ("* Verify: all %d block keys are stable, an unchanged re-export reuses every block.\n", n_slices);
+		} else {
+			cerr << "Error: " << n_slices - n_stable << " of " << n_slices << " block keys changed without an edit, the cache cannot be reused\n";
+			rv = -1;
+		}
+	}
+
+	std::string serial;
+	if (rv == 0 && verify) {
+		printf ("* Rendering serial reference\n");
+		ExportSettings ref;
+		ref._sample_format = ExportFormatBase::SF_Float;
+		ref._samplerate    = sample_rate;
+		ref._start         = start;
+		ref._end           = end;
+		serial = Glib::build_filename (tmp, "serial.wav");
+		rv = export_session (session, serial, ref);
+	}
+
+	if (rv == 0) {
+		printf ("* Writing %s\n", outfile.c_str ());
+		rv = stitch_slices (slices, outfile, serial, settings, sample_rate);
+	}
+
+	PBD::remove_directory (tmp);
+
+	if (rv == 0 && !cache.empty ()) {
+		/* only keep the blocks of this export */
+		std::set<std::string> keep;
+		for (int i = 0; i < n_slices; ++i) {
+			keep.insert (slices[i].key + ".wav");
+			keep.insert (slices[i].key + ".sum");
+		}
+		Glib::Dir d (cache);
+		for (Glib::DirIterator f = d.begin (); f != d.end (); ++f) {
+			std::string const fn (*f);
+			if (keep.find (fn) == keep.end () && (fn.size () == 44) && (!fn.compare (40, 4, ".wav") || !fn.compare (40, 4, ".sum"))) {
+				::g_unlink (Glib::build_filename (cache, fn).c_str ());
+			}
+		}
+	}
+
+	if (rv == 0) {
+		printf ("* Done.\n");
+	}
+	return rv;
+}
+
 static void usage () {
 	// help2man compatible format (standard GNU help-text)
 	printf (UTILNAME " - export an ardour session from the commandline.\n\n");
@@ -219,10 +905,16 @@ static void usage () {
 	printf ("Options:\n\
   -b, --bitdepth <depth>     set export-format (16, 24, 32, float)\n\
   -B, --broadcast            include broadcast wave header\n\
+  -c, --cache <dir>          re-use unchanged blocks of a previous export\n\
   -h, --help                 display this help and exit\n\
+  -j, --jobs <N>             render the range in N parallel slices\n\
+  -l, --block-length <sec>   length of cached blocks (default 30)\n\
   -n, --normalize            normalize signal level (to 0dBFS)\n\
   -o, --output  <file>       export output file name\n\
+  -p, --preroll <sec>        pre-roll of each parallel slice (default 10)\n\
+  -r, --range <start>,<end>  export the given sample range only\n\
   -s, --samplerate <rate>    samplerate to use\n\
+  -v, --verify               compare a parallel export with a serial one\n\
   -V, --version              print version information and exit\n\
 \n");
 	printf ("\n\
@@ -231,6 +923,25 @@ using the master-bus outputs.\n\
 By default a 16bit signed .wav file at session-rate is exported.\n\
 If the no output-file is given, the session's export dir is used.\n\
 \n\
+With --jobs the export-range is split into N slices which are rendered\n\
+concurrently by separate processes, and joined afterwards. Each slice starts\n\
+rendering --preroll seconds early, so that reverb-tails and other effect\n\
+state crossing a slice boundary are reproduced. Plugins whose state depends\n\
+on more than the pre-roll (or on the transport position in other ways) can\n\
+still differ from a serial export; --verify renders serially as well and\n\
+reports any difference. Parallel export is only available at session-rate\n\
+without broadcast-wave header.\n\
+\n\
+With --cache the export-range is split into blocks of --block-length seconds,\n\
+which are kept in the given folder. On subsequent exports only blocks whose\n\
+input changed are rendered again (using up to --jobs processes), all others\n\
+are taken from the cache. A block depends on the regions and automation from\n\
+the start of its pre-roll to its end plus the session's worst-case latency;\n\
+changes to routes, plugins, tempo-map or session configuration invalidate all\n\
+blocks. The pre-roll is extended to the plugin tail-time, if that is longer.\n\
+Use --verify to compare the result with a full serial export, and to check\n\
+that an unchanged session yields the same blocks again (cache hits).\n\
+\n\
 Note: the tool expects a session-name without .ardour file-name extension.\n\
 \n");
 
@@ -243,16 +954,27 @@ int main (int argc, char* argv[])
 {
 	ExportSettings settings;
 	std::string outfile;
+	std::string cache;
+	int         jobs    = 1;
+	double      preroll = 10;
+	double      block   = 30;
+	bool        verify  = false;
 
-	const char *optstring = "b:Bhno:s:V";
+	const char *optstring = "b:Bc:hj:l:no:p:r:s:vV";
 
 	const struct option longopts[] = {
 		{ "bitdepth",   1, 0, 'b' },
 		{ "broadcast",  0, 0, 'B' },
+		{ "cache",      1, 0, 'c' },
 		{ "help",       0, 0, 'h' },
+		{ "jobs",       1, 0, 'j' },
+		{ "block-length", 1, 0, 'l' },
 		{ "normalize",  0, 0, 'n' },
 		{ "output",     1, 0, 'o' },
+		{ "preroll",    1, 0, 'p' },
+		{ "range",      1, 0, 'r' },
 		{ "samplerate", 1, 0, 's' },
+		{ "verify",     0, 0, 'v' },
 		{ "version",    0, 0, 'V' },
 	};
 
@@ -288,6 +1010,26 @@ int main (int argc, char* argv[])
 				settings._bwf = true;
 				break;
 
+			case 'c':
+				cache = optarg;
+				break;
+
+			case 'j':
+				jobs = atoi (optarg);
+				if (jobs < 1 || jobs > 64) {
+					fprintf(stderr, "Invalid number of jobs\n");
+					jobs = 1;
+				}
+				break;
+
+			case 'l':
+				block = atof (optarg);
+				if (block < 1) {
+					fprintf(stderr, "Invalid block-length\n");
+					block = 30;
+				}
+				break;
+
 			case 'n':
 				settings._normalize = true;
 				break;
@@ -296,6 +1038,26 @@ int main (int argc, char* argv[])
 				outfile = optarg;
 				break;
 
+			case 'p':
+				preroll = atof (optarg);
+				if (preroll < 0) {
+					fprintf(stderr, "Invalid pre-roll\n");
+					preroll = 10;
+				}
+				break;
+
+			case 'r':
+				{
+					long long start, end;
+					if (2 == sscanf (optarg, "%lld,%lld", &start, &end) && start >= 0 && end > start) {
+						settings._start = start;
+						settings._end   = end;
+					} else {
+						fprintf(stderr, "Invalid Range\n");
+					}
+				}
+				break;
+
 			case 's':
 				{
 					const int sr = atoi (optarg);
@@ -307,6 +1069,10 @@ int main (int argc, char* argv[])
 				}
 				break;
 
+			case 'v':
+				verify = true;
+				break;
+
 			case 'V':
 				printf ("ardour-utils version %s\n\n", VERSIONSTRING);
 				printf ("Copyright (C) GPL 2015,2017 Robin Gareus <robin@gareus.org>\n");
@@ -338,10 +1104,21 @@ int main (int argc, char* argv[])
 		settings._samplerate = s->nominal_sample_rate ();
 	}
 
-	export_session (s, outfile, settings);
+	if ((jobs > 1 || !cache.empty ()) && (settings._samplerate != s->nominal_sample_rate () || settings._bwf)) {
+		cerr << "Warning: parallel and cached export require session-rate and no broadcast header, exporting serially.\n";
+		jobs = 1;
+		cache.clear ();
+	}
+
+	int rv;
+	if (jobs > 1 || !cache.empty ()) {
+		rv = export_parallel (s, argv[0], argv[optind], argv[optind+1], outfile, settings, jobs, preroll, verify, cache, block);
+	} else {
+		rv = export_session (s, outfile, settings);
+	}
 
 	SessionUtils::unload_session(s);
 	SessionUtils::cleanup();
 
-	return 0;
+	return rv == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }